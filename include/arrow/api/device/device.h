@@ -33,6 +33,10 @@ enum {
 int arrow_register_device(arrow_gateway_t *gateway, arrow_device_t *device);
 // find device information by some parameters, 'n' is the number of the find arguments
 int arrow_device_find_by(device_info_t **list, int n, ...);
+// the same by the callback: the devices come one by one as they are received,
+// the next pages are requested while there are ones;
+// return the number of the devices or the negative value
+int arrow_device_find_by_each(device_info_cb cb, void *arg, int n, ...);
 // find device information by HID
 int arrow_device_find_by_hid(device_info_t *list, const char *hid);
 // update existing device
@@ -41,6 +45,8 @@ int arrow_update_device(arrow_gateway_t *gateway, arrow_device_t *device);
 int arrow_list_device_events(device_event_t **list, arrow_device_t *device, int n, ...);
 // list device audit logs
 int arrow_list_device_logs(log_t **list, arrow_device_t *device, int n, ...);
+// list device audit logs by the callback, page by page
+int arrow_list_device_logs_each(arrow_device_t *device, log_cb cb, void *arg, int n, ...);
 // error request
 int arrow_error_device(arrow_device_t *device, const char *error);
 
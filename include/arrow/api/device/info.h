@@ -35,6 +35,15 @@ void device_info_free(device_info_t *gd);
 void device_info_move(device_info_t *dst, device_info_t *src);
 int device_info_parse(device_info_t **list, const char *s);
 
+// the device of the list, it's freed after the callback (device_info_move keeps it)
+typedef int (*device_info_cb)(device_info_t *info, void *arg);
+typedef struct _device_info_each_ {
+    device_info_cb cb;
+    void *arg;
+} device_info_each_t;
+// the page_item_cb of the device lists, the arg is device_info_each_t
+int device_info_item(JsonNode *item, void *arg);
+
 #if defined(__cplusplus)
 }
 #endif
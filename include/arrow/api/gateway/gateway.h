@@ -52,6 +52,8 @@ int arrow_gateway_find_by(gateway_info_t **info, int n, ...);
 int arrow_gateway_logs_list(log_t **logs, arrow_gateway_t *gateway, int n, ...);
 // list gateway devices
 int arrow_gateway_devices_list(device_info_t **list, const char *hid);
+// the gateway devices by the callback, page by page
+int arrow_gateway_devices_each(const char *hid, device_info_cb cb, void *arg);
 // send command and payload to gateway and device
 int arrow_gateway_device_send_command(const char *gHid, const char *dHid, const char *cmd, const char *payload);
 // update existing gateway
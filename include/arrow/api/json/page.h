@@ -0,0 +1,73 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#if !defined(ACN_SDK_C_API_JSON_PAGE_H_)
+#define ACN_SDK_C_API_JSON_PAGE_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <arrow/api/json/parse.h>
+#include <http/request.h>
+#include <data/find_by.h>
+
+// The list answer {"size":..,"page":..,"totalSize":..,"totalPages":..,"data":[...]}
+// is cut by the elements of the "data" array as it comes from the socket:
+// every element is decoded by the streaming JSON machine and passed to the
+// callback, only the current element is kept in the memory.
+
+#if !defined(PAGE_KEY_LEN)
+#define PAGE_KEY_LEN 12
+#endif
+
+// the element is deleted after the callback, it may take the nodes it needs;
+// the negative value stops the list
+typedef int (*page_item_cb)(JsonNode *item, void *arg);
+
+typedef struct _page_stream_ {
+    page_item_cb cb;
+    void *arg;
+    page_size_t ps;
+    int items;
+    int num;
+    int16_t depth;
+    uint8_t str:1;
+    uint8_t esc:1;
+    uint8_t value:1;
+    uint8_t data:1;
+    uint8_t elem:1;
+    uint8_t stopped:1;
+    uint8_t done:1;
+    uint8_t field;
+    uint8_t klen;
+    char key[PAGE_KEY_LEN];
+    json_parse_machine_t sm;
+} page_stream_t;
+
+void page_stream_init(page_stream_t *s, page_item_cb cb, void *arg);
+// -1 if the text is broken or the callback stopped the list
+int page_stream_part(page_stream_t *s, const char *text, int len);
+// -1 if the answer isn't complete
+int page_stream_finish(page_stream_t *s);
+
+// the response payload handler, the _p_arg is the page_stream_t
+int page_stream_payload_handler(void *r, property_t payload);
+
+// Request the pages one by one and pass every element of them to the callback,
+// the init prepares the request as for the one page, the "_page" query is set
+// here (the "_page" from the init is the first one).
+// Return the number of the passed elements or the negative value
+int page_stream_routine(void (*init)(http_request_t *, void *), void *i_arg,
+                        page_item_cb cb, void *cb_arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // ACN_SDK_C_API_JSON_PAGE_H_
@@ -23,6 +23,16 @@ typedef struct _log_ {
 } log_t;
 void log_init(log_t *gi);
 void log_free(log_t *gi);
+int _log_parse(log_t *gl, JsonNode *tmp);
 int log_parse(log_t **list, const char *text);
 
+// the log of the list, it's freed after the callback
+typedef int (*log_cb)(log_t *log, void *arg);
+typedef struct _log_each_ {
+    log_cb cb;
+    void *arg;
+} log_each_t;
+// the page_item_cb of the log lists, the arg is log_each_t
+int log_item(JsonNode *item, void *arg);
+
 #endif  // ACN_SDK_C_API_LOG_H_
@@ -43,6 +43,9 @@ int arrow_mqtt_event_proc(void);
 
 int arrow_mqtt_api_wait(int num);
 int arrow_mqtt_api_has_events(void);
+// requestId of the first answer in the queue
+const char *arrow_mqtt_api_event_id(void);
+// take the first answer into the res (drop it if res is NULL)
 int arrow_mqtt_api_event_proc(http_response_t *res);
 int process_http_payload(const char *s);
 
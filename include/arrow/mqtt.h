@@ -17,6 +17,7 @@ extern "C" {
 #include "device.h"
 #include <data/linkedlist.h>
 #include <MQTTClient.h>
+#include <arrow/supervisor.h>
 
 enum _mqtt_mask_ {
     ACN_num = 1<<0,
@@ -32,6 +33,20 @@ enum _mqtt_init {
     MQTT_COMMANDS_INIT  = 1<<5
 };
 
+typedef enum {
+    mqtt_payload_json = 0,
+    mqtt_payload_cbor
+} mqtt_payload_format_t;
+
+// bounded queue of the telemetry samples sent as one JSON array
+typedef struct _mqtt_batch_ {
+    JsonNode *samples;
+    int count;
+    int max_samples;
+    int max_age;
+    TimerInterval timer;
+} mqtt_batch_t;
+
 typedef struct _pstring {
     unsigned char *buf;
     size_t size;
@@ -53,6 +68,9 @@ typedef struct _mqtt_env_ {
     property_t addr;
     short port;
     short init;
+    uint8_t format;
+    mqtt_batch_t batch;
+    conn_supervisor_t sv;
     int timeout;
     uint32_t mask;
     arrow_linked_list_head_node;
@@ -82,6 +100,8 @@ int mqtt_telemetry_connect(arrow_gateway_t *gateway,
                            arrow_gateway_config_t *config);
 
 int mqtt_is_telemetry_connect(void);
+// the reconnection backoff, the keepalive and the metrics of the channel
+conn_supervisor_t *mqtt_telemetry_supervisor(void);
 
 // Terminate MQTT connection
 int mqtt_telemetry_disconnect(void);
@@ -89,15 +109,42 @@ int mqtt_telemetry_terminate(void);
 
 // Send the telemetry data to the cloud
 // there is extremely needed the telemetry_serialize function implementation to serealize 'data' correctly
+// if the device has a registered telemetry filter the unchanged sample is skipped (return 0)
 int mqtt_publish(arrow_device_t *device, void *data);
 int mqtt_api_publish(JsonNode *data);
 
+// Choose the telemetry payload encoding of the telemetry channel
+// JSON is used by default, CBOR reduces the size and encoding time
+int mqtt_telemetry_set_payload_format(mqtt_payload_format_t format);
+
+// Collect the samples and send them together as one JSON array
+// when there are max_samples of them or the oldest one is older than max_age msec
+// (a negative value takes MQTT_BATCH_MAX_SAMPLES or MQTT_BATCH_MAX_AGE)
+int mqtt_batch_init(mqtt_batch_t *b, int max_samples, int max_age);
+void mqtt_batch_free(mqtt_batch_t *b);
+// take the sample (it is deleted on the failure), return 1 if the batch should be sent
+int mqtt_batch_add(mqtt_batch_t *b, JsonNode *sample);
+int mqtt_batch_is_ready(mqtt_batch_t *b);
+int mqtt_batch_publish(MQTTClient *c,
+                       const char *topic,
+                       mqtt_batch_t *b,
+                       mqtt_payload_format_t format);
+
+// Switch on the telemetry batching for the mqtt_publish (max_samples <= 1 switch off)
+// the queued samples are sent by the threshold or by the mqtt_publish_flush
+int mqtt_telemetry_set_batch(int max_samples, int max_age);
+int mqtt_publish_flush(void);
+// send the batch if it is old enough, mqtt_yield and mqtt_receive call it
+// (and the telemetry routine between the samples)
+int mqtt_publish_poll(void);
+
 #if !defined(NO_EVENTS)
 int mqtt_subscribe_connect(arrow_gateway_t *gateway,
                            arrow_device_t *device,
                            arrow_gateway_config_t *config);
 
 int mqtt_is_subscribe_connect(void);
+conn_supervisor_t *mqtt_subscribe_supervisor(void);
 int mqtt_subscribe_disconnect(void);
 int mqtt_subscribe_terminate(void);
 
@@ -111,6 +158,12 @@ int mqtt_subscribe(void);
 // The user's command or software update command
 int mqtt_yield(int timeout_ms);
 int mqtt_receive(int timeout_ms);
+#if defined(ARROW_REACTOR)
+// Serve the connected channels by the event loop (arrow/reactor.h),
+// the mqtt_yield runs the loop then
+int mqtt_reactor_attach(void);
+void mqtt_reactor_detach(void);
+#endif
 // Terminate all connections
 void mqtt_disconnect(void);
 void mqtt_terminate(void);
@@ -0,0 +1,63 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_ARROW_OTA_VERIFY_H_
+#define ACN_SDK_C_ARROW_OTA_VERIFY_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+#include <ssl/crypt.h>
+#include <wolfssl/wolfcrypt/md5.h>
+
+// The firmware image is hashed by the pieces as they come from the socket,
+// the context is owned by the caller (one per download).
+// The hash is chosen by the expected checksum: 32 hex digits - MD5,
+// 64 - SHA-256. The image is bounded by max_size (0 - no bound) and
+// by the announced size (0 - unknown), the overflow is rejected at once.
+
+enum ota_hash {
+    ota_hash_md5 = 0,
+    ota_hash_sha256
+};
+
+typedef struct _ota_verify_ {
+    uint8_t hash;
+    uint8_t digest_size;
+    uint32_t max_size;
+    uint32_t size;
+    uint32_t received;
+    union {
+        Md5 md5;
+        acn_sha256_ctx sha256;
+    } ctx;
+    char expected[32];
+} ota_verify_t;
+
+// -1 if the checksum is not a MD5 or SHA-256 hex string
+int ota_verify_init(ota_verify_t *v, const char *checksum, uint32_t max_size);
+// start the image of size bytes (0 - unknown), -1 if it's too large
+int ota_verify_begin(ota_verify_t *v, uint32_t size);
+// -1 if the image is longer than expected
+int ota_verify_update(ota_verify_t *v, const char *data, int len);
+// 0 - ok, -1 - the size mismatch, -2 - the checksum mismatch,
+// -3 - the signature check failed
+int ota_verify_final(ota_verify_t *v);
+
+// called for the image with the right checksum,
+// override it to check the image signature over the digest
+int ota_verify_signature(const char *digest, int size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_ARROW_OTA_VERIFY_H_
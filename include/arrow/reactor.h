@@ -0,0 +1,109 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_ARROW_REACTOR_H_
+#define ACN_SDK_C_ARROW_REACTOR_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <bsd/sockpoll.h>
+#include <http/client.h>
+#include <http/response.h>
+#include <MQTTClient.h>
+#include <mqtt/client/client.h>
+
+// The single thread event loop (sockpoll.h is the platform part),
+// built with the ARROW_REACTOR.
+// A socket is served when it is ready and a timer when it is due,
+// so one thread drives several MQTT channels and the REST calls
+// without waiting on an idle connection.
+// The MQTT sockets don't block (socket_nonblock, the TLS WANT_READ and
+// WANT_WRITE of the wolfSSL): the bytes are gathered till the packet is
+// whole and the writes are queued till the socket is ready.
+// The REST socket stays blocking: once the first bytes are there
+// the callback reads the whole HTTP answer (bounded by cli->timeout).
+
+#if !defined(ARROW_REACTOR_SOCKETS)
+#define ARROW_REACTOR_SOCKETS 8
+#endif
+
+#if !defined(ARROW_REACTOR_TIMERS)
+#define ARROW_REACTOR_TIMERS  8
+#endif
+
+// the MQTT channels served at once
+#if !defined(ARROW_REACTOR_MQTT)
+#define ARROW_REACTOR_MQTT 4
+#endif
+
+// the in and out buffers of the MQTT channel, the largest packet
+#if !defined(ARROW_REACTOR_MQTT_BUF)
+#define ARROW_REACTOR_MQTT_BUF ( MQTT_CLIENT_MAX_MSG_LEN + 5 )
+#endif
+
+// the MQTT keepalive check period (ms)
+#if !defined(ARROW_REACTOR_KEEPALIVE_TICK)
+#define ARROW_REACTOR_KEEPALIVE_TICK 1000
+#endif
+
+// return < 0 to remove the socket from the loop,
+// > 0 if more data is buffered (TLS) and the callback should go on
+typedef int (*arrow_reactor_io_f)(int sock, uint32_t events, void *arg);
+// return < 0 to stop the timer (so the one-shot timer returns -1)
+typedef int (*arrow_reactor_timer_f)(void *arg);
+// the packet of the type rc is processed or the channel failed (rc < 0)
+typedef void (*arrow_reactor_mqtt_f)(MQTTClient *c, int rc, void *arg);
+// the REST call is done, the status is 0 or -1
+typedef void (*arrow_reactor_http_f)(int status,
+                                     http_client_t *cli,
+                                     http_response_t *res,
+                                     void *arg);
+
+int arrow_reactor_init(void);
+void arrow_reactor_done(void);
+
+int arrow_reactor_add(int sock, uint32_t events, arrow_reactor_io_f cb, void *arg);
+int arrow_reactor_mod(int sock, uint32_t events);
+int arrow_reactor_del(int sock);
+
+// return the timer handle or -1
+int arrow_reactor_timer_add(int period_ms, arrow_reactor_timer_f cb, void *arg);
+void arrow_reactor_timer_del(int timer);
+
+// read the packets of the connected client and send the keepalive pings,
+// the socket doesn't block till the arrow_reactor_del_mqtt
+int arrow_reactor_add_mqtt(MQTTClient *c, arrow_reactor_mqtt_f cb, void *arg);
+int arrow_reactor_del_mqtt(MQTTClient *c);
+int arrow_reactor_has_mqtt(MQTTClient *c);
+
+// send the request opened by the http_client_open, the callback is called
+// when the answer is received or the cli->timeout is expired;
+// the api_via_mqtt client sends it over the MQTT (HTTP_VIA_MQTT)
+int arrow_reactor_http(http_client_t *cli,
+                       http_response_t *res,
+                       arrow_reactor_http_f cb,
+                       void *arg);
+
+// one loop step, wait for the sockets up to the timeout_ms or the next timer
+// return the number of the served sockets and timers or -1
+int arrow_reactor_run_once(int timeout_ms);
+// serve the loop for the timeout_ms instead of the sleep,
+// -1 if the loop isn't initialized or it's called from its callback
+int arrow_reactor_run_for(int timeout_ms);
+// loop until the arrow_reactor_stop or there is nothing to serve
+int arrow_reactor_run(void);
+void arrow_reactor_stop(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_ARROW_REACTOR_H_
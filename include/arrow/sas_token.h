@@ -0,0 +1,73 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_ARROW_SAS_TOKEN_H_
+#define ACN_SDK_C_ARROW_SAS_TOKEN_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <ssl/crypt.h>
+#include <time/time.h>
+
+// The shared access signature of the Azure IoT hub:
+// SharedAccessSignature sr=<resource>&sig=<HMAC-SHA256(key, resource\nexpiry)>&se=<expiry>
+// The key is decoded and the HMAC pads are hashed once by the init,
+// the token is kept until it is close to the expiry,
+// so a reconnection takes the ready string.
+
+#if !defined(SAS_TOKEN_LEN)
+#define SAS_TOKEN_LEN       320
+#endif
+
+#if !defined(SAS_RESOURCE_LEN)
+#define SAS_RESOURCE_LEN    128
+#endif
+
+// the token life time (s)
+#if !defined(SAS_TOKEN_TTL)
+#define SAS_TOKEN_TTL       3600
+#endif
+
+// the token is built again when it expires in less than this (s)
+#if !defined(SAS_TOKEN_MARGIN)
+#define SAS_TOKEN_MARGIN    300
+#endif
+
+// the period of the sas_token_timer in the reactor (ms)
+#if !defined(SAS_TOKEN_CHECK_MS)
+#define SAS_TOKEN_CHECK_MS  60000
+#endif
+
+typedef struct _sas_token_ {
+    acn_hmac_ctx key;
+    char resource[SAS_RESOURCE_LEN];
+    uint32_t ttl;
+    uint32_t margin;
+    time_t expiry;
+    int len;
+    char token[SAS_TOKEN_LEN];
+} sas_token_t;
+
+// the key is Base64 as the device primary key
+int sas_token_init(sas_token_t *t, const char *resource, const char *key, uint32_t ttl);
+// 1 if the token is built again, 0 if the current one is good yet, -1 if failed
+int sas_token_refresh(sas_token_t *t, time_t now);
+// the token good for the margin at least or NULL
+const char *sas_token_get(sas_token_t *t, time_t now);
+// the arrow_reactor_timer_f to keep the token fresh out of the connection
+int sas_token_timer(void *arg);
+void sas_token_free(sas_token_t *t);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_ARROW_SAS_TOKEN_H_
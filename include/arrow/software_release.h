@@ -11,7 +11,9 @@ extern "C" {
 
 enum arrow_ota_result {
     FW_SUCCESS = 0x00,
-    FW_MD5SUM
+    FW_MD5SUM,      // the checksum (MD5 or SHA-256) mismatch
+    FW_SIZE,        // the image is larger than ARROW_OTA_MAX_SIZE or truncated
+    FW_SIGNATURE    // ota_verify_signature failed
 };
 
 enum arrow_ota_init {
@@ -53,6 +55,7 @@ int arrow_software_releases_trans_start(const char *hid);
 // DeviceSoftwareRelease event handler
 int ev_DeviceSoftwareRelease(void *_ev, JsonNode *_parameters);
 
+// the checksum is the MD5 or SHA-256 hex string (arrow/ota_verify.h)
 int arrow_software_release_download(const char *token, const char *tr_hid, const char *checksum);
 
 // set software release download callback
@@ -32,6 +32,12 @@ void arrow_device_state_free(void);
 int arrow_state_receive(arrow_device_t *device);
 int arrow_post_state_request(arrow_device_t *device);
 int arrow_post_state_update(arrow_device_t *device);
+// post the states changed since the last post only, 0 if there is nothing to post
+int arrow_post_state_delta(arrow_device_t *device);
+// the set_* calls in the ARROW_STATE_COALESCE_MS window go in one delta post:
+// call it from the main loop, it returns the ms to wait for the window end,
+// 0 if the changes were posted (or there are no changes) and < 0 on error
+int arrow_device_state_sync(arrow_device_t *device);
 
 // allow to use
 int arrow_state_mqtt_run(arrow_device_t *device);
@@ -0,0 +1,75 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_ARROW_SUPERVISOR_H_
+#define ACN_SDK_C_ARROW_SUPERVISOR_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+
+// The connection supervisor decides when to try the connection again.
+// The delay after the n-th failure in a row is random in
+// [0, min(ARROW_RETRY_MAX_DELAY, ARROW_RETRY_DELAY * 2^(n-1))] (the full jitter),
+// so the devices don't come back all at once after the broker restart.
+// ARROW_BREAKER_FAILURES in a row open the circuit for ARROW_BREAKER_OPEN ms,
+// then one probe attempt closes it or opens it again.
+// The MQTT keepalive goes up after a long session and down if the link is lost
+// about one keepalive interval after the last traffic (the dropped idle link).
+// The time is passed by the caller (time_mono_ms) to drive it by the fake clock.
+
+typedef enum {
+    conn_state_retry = 0,
+    conn_state_up,
+    conn_state_open
+} conn_state_t;
+
+typedef struct _conn_metrics_ {
+    uint32_t attempts;        // all the connection attempts
+    uint32_t reconnects;      // the connections restored after a loss
+    uint32_t trips;           // the circuit breaker openings
+    uint32_t last_attempts;   // attempts of the last reconnection
+    uint32_t last_latency;    // ms from the loss to the last reconnection
+    uint32_t max_latency;
+} conn_metrics_t;
+
+typedef struct _conn_supervisor_ {
+    uint8_t state;
+    uint8_t was_up;
+    uint16_t keepalive;       // sec, for the next MQTT connect (0 - not adapted)
+    uint32_t failures;        // in a row
+    uint32_t attempts;        // since the loss
+    uint32_t next_at;
+    uint32_t down_since;
+    uint32_t up_since;
+    uint32_t traffic_at;      // the last packet from the peer
+    uint32_t rnd;
+    conn_metrics_t metrics;
+} conn_supervisor_t;
+
+void conn_supervisor_init(conn_supervisor_t *s, uint16_t keepalive, uint32_t now);
+// 0 if the attempt may be done now, or the ms to wait
+int conn_supervisor_wait_ms(conn_supervisor_t *s, uint32_t now);
+// the attempt failed, return the ms to the next one
+int conn_supervisor_failed(conn_supervisor_t *s, uint32_t now);
+void conn_supervisor_connected(conn_supervisor_t *s, uint32_t now);
+// the packet from the peer came at the time 'at'
+void conn_supervisor_traffic(conn_supervisor_t *s, uint32_t at);
+// the established connection is broken
+void conn_supervisor_lost(conn_supervisor_t *s, uint32_t now);
+#define conn_supervisor_keepalive(s) ( (s)->keepalive )
+#define conn_supervisor_metrics(s)   ( &(s)->metrics )
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_ARROW_SUPERVISOR_H_
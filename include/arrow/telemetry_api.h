@@ -23,6 +23,8 @@ typedef struct _telemetry_response_data_list_ {
   int totalSize;
   int totalPages;
   telemetry_data_info_t *data;
+  // the last one of the data to add the next one
+  telemetry_data_info_t *_last;
 } telemetry_response_data_list_t;
 
 // initialize the data list object for telemetry requests
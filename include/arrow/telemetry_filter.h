@@ -0,0 +1,102 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_TELEMETRY_FILTER_H_
+#define ACN_SDK_C_TELEMETRY_FILTER_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <arrow/device.h>
+#include <data/linkedlist.h>
+
+// Per-field deadband for one telemetry key.
+// The field is treated as changed if it moved away from the last sent value
+// more than max(abs_deadband, rel_deadband * |last|).
+// With both bands equal to zero any difference is a change.
+// String values are compared by hash.
+
+enum {
+    telemetry_value_number = 0,   // compared by the deadbands
+    telemetry_value_exact         // a bool or a string hash, compared exactly
+};
+
+// The value of the key in the raw sample (the data passed to mqtt_publish
+// and telemetry_serialize_json): telemetry_value_number or
+// telemetry_value_exact, -1 if there isn't such a value.
+typedef int (*telemetry_filter_value_t)(void *data, const char *key, double *val);
+
+typedef struct _telemetry_filter_rule_ {
+    const char *key;
+    double abs_deadband;
+    double rel_deadband;
+    // runtime state
+    double last;
+    uint8_t valid;
+    // the checked sample, it becomes the last one on the commit
+    double next;
+    uint8_t update;
+    uint8_t unchanged;
+} telemetry_filter_rule_t;
+
+typedef struct _telemetry_filter_ {
+    property_t hid;
+    telemetry_filter_rule_t *rules;
+    int count;
+    uint32_t max_silence;   // msec, force a full sample after it (0 - never)
+    uint8_t changed_only;   // drop the unchanged ruled keys from a sample
+    telemetry_filter_value_t value;   // the raw sample reader, NULL - by the JSON
+    uint8_t started;
+    uint8_t pending;
+    uint32_t last_sent;
+    uint32_t next_sent;
+    arrow_linked_list_head_node;
+} telemetry_filter_t;
+
+#define TELEMETRY_FILTER_RULE(k, abs, rel) { (k), (abs), (rel), 0.0, 0 }
+
+int telemetry_filter_init(telemetry_filter_t *f,
+                          telemetry_filter_rule_t *rules,
+                          int count,
+                          uint32_t max_silence,
+                          int changed_only);
+// forget the sent values, the next sample passes anyway
+void telemetry_filter_reset(telemetry_filter_t *f);
+
+// Check the serialized sample at 'now' msec.
+// Return 0 if the sample should be sent (in the changed_only mode
+// the unchanged ruled keys are removed from it), 1 if it should be skipped.
+// Keys without a rule are carried as is but never trigger a sending.
+// The filter keeps the sent values only on the commit, so the sample
+// which isn't delivered is compared again with the same reference.
+int telemetry_filter_check(telemetry_filter_t *f, JsonNode *sample, uint32_t now);
+// Check the raw sample by the f->value reader before it is serialized,
+// return 0 if it should be sent (then telemetry_filter_strip removes the
+// unchanged keys from its JSON in the changed_only mode) or 1.
+// Without the reader every sample passes.
+int telemetry_filter_check_data(telemetry_filter_t *f, void *data, uint32_t now);
+void telemetry_filter_strip(telemetry_filter_t *f, JsonNode *sample);
+// the checked sample is sent
+void telemetry_filter_commit(telemetry_filter_t *f);
+// check and commit at once
+int telemetry_filter_apply(telemetry_filter_t *f, JsonNode *sample, uint32_t now);
+
+// per-device filter table used by the mqtt_publish
+int telemetry_filter_register(arrow_device_t *device, telemetry_filter_t *f);
+int telemetry_filter_unregister(arrow_device_t *device);
+telemetry_filter_t *telemetry_filter_find(arrow_device_t *device);
+
+// msec clock for the filter
+uint32_t telemetry_filter_now(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_TELEMETRY_FILTER_H_
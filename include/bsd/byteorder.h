@@ -0,0 +1,71 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_BSD_BYTEORDER_H_
+#define ACN_SDK_C_BSD_BYTEORDER_H_
+
+#include <sys/type.h>
+
+// The byte order is known at the compile time: config.h sets __LE_MODE__ or
+// __BE_MODE__ by the compiler macros, so the conversion is the one bswap
+// instruction or nothing. BYTE_ORDER_PROBE makes the check by the first byte
+// of the constant 1 (the compiler folds it as well) if the target macros lie.
+
+#if ( ( defined(__GNUC__) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 8 ) ) ) || \
+      defined(__clang__) ) && !defined(BYTE_ORDER_NO_BUILTIN)
+# define byteorder_bswap16(n) __builtin_bswap16((uint16_t)(n))
+# define byteorder_bswap32(n) __builtin_bswap32((uint32_t)(n))
+#else
+# define byteorder_bswap16(n) \
+    ((uint16_t)( ( ( (uint16_t)(n) & 0xffU ) << 8 ) | ( ( (uint16_t)(n) & 0xff00U ) >> 8 ) ))
+# define byteorder_bswap32(n) \
+    ((uint32_t)( ( ( (uint32_t)(n) & 0xffUL ) << 24 ) | \
+                 ( ( (uint32_t)(n) & 0xff00UL ) << 8 ) | \
+                 ( ( (uint32_t)(n) & 0xff0000UL ) >> 8 ) | \
+                 ( ( (uint32_t)(n) & 0xff000000UL ) >> 24 ) ))
+#endif
+
+#if defined(__LE_MODE__) && !defined(BYTE_ORDER_PROBE)
+# define byteorder_htons(n) byteorder_bswap16(n)
+# define byteorder_htonl(n) byteorder_bswap32(n)
+#elif defined(__BE_MODE__) && !defined(BYTE_ORDER_PROBE)
+# define byteorder_htons(n) ((uint16_t)(n))
+# define byteorder_htonl(n) ((uint32_t)(n))
+#else
+# define byteorder_is_be() ( ((const union { uint32_t v; uint8_t b[4]; }){ 1U }).b[0] == 0 )
+# define byteorder_htons(n) ( byteorder_is_be() ? (uint16_t)(n) : byteorder_bswap16(n) )
+# define byteorder_htonl(n) ( byteorder_is_be() ? (uint32_t)(n) : byteorder_bswap32(n) )
+#endif
+
+#define byteorder_ntohs(n) byteorder_htons(n)
+#define byteorder_ntohl(n) byteorder_htonl(n)
+
+// the big endian fields of the packets (MQTT, NTP) by the bytes,
+// so the buffer may be unaligned
+#define be16_put(p, v) do { \
+    (p)[0] = (uint8_t)( (uint16_t)(v) >> 8 ); \
+    (p)[1] = (uint8_t)(v); \
+  } while (0)
+
+#define be32_put(p, v) do { \
+    (p)[0] = (uint8_t)( (uint32_t)(v) >> 24 ); \
+    (p)[1] = (uint8_t)( (uint32_t)(v) >> 16 ); \
+    (p)[2] = (uint8_t)( (uint32_t)(v) >> 8 ); \
+    (p)[3] = (uint8_t)(v); \
+  } while (0)
+
+#define be16_get(p) \
+  ((uint16_t)( ( (uint16_t)((const uint8_t *)(p))[0] << 8 ) | ((const uint8_t *)(p))[1] ))
+
+#define be32_get(p) \
+  ((uint32_t)( ( (uint32_t)((const uint8_t *)(p))[0] << 24 ) | \
+               ( (uint32_t)((const uint8_t *)(p))[1] << 16 ) | \
+               ( (uint32_t)((const uint8_t *)(p))[2] << 8 ) | \
+               (uint32_t)((const uint8_t *)(p))[3] ))
+
+#endif  // ACN_SDK_C_BSD_BYTEORDER_H_
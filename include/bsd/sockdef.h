@@ -120,5 +120,12 @@
 #if !defined(SO_NO_CHECK)
 #define SO_NO_CHECK  0x100a    /* don't create UDP checksum */
 #endif
+
+#if !defined(MSG_PEEK)
+#define MSG_PEEK     0x01      /* peek at an incoming message */
+#endif
+#if !defined(MSG_DONTWAIT)
+#define MSG_DONTWAIT 0x08      /* nonblocking i/o for this operation only */
+#endif
     
 #endif  // ACN_SDK_C_BSD_SOCKDEF_H_
@@ -31,7 +31,18 @@ extern "C" {
 
 #include <bsd/sockdef.h>
 
+typedef struct socket_iovec {
+    const void *base;
+    size_t len;
+} socket_iovec_t;
+
 int socket_connect_done(int sock);
+// gather send: the number of the sent bytes (may be less than all vectors) or -1
+ssize_t socket_sendv(int sock, const socket_iovec_t *iov, int iovcnt);
+// the event loop sockets don't block (on != 0), 0 or -1
+int socket_nonblock(int sock, int on);
+// the last recv/send failed because the non-blocking socket isn't ready
+int socket_would_block(int sock);
 
 #if defined(__cplusplus)
 }
@@ -0,0 +1,46 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_BSD_SOCKPOLL_H_
+#define ACN_SDK_C_BSD_SOCKPOLL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <sys/type.h>
+
+// The socket readiness for the event loop.
+// It is epoll on Linux, another platform should implement these functions
+// (the default ones return -1).
+
+enum {
+    SOCK_POLL_IN  = 1 << 0,
+    SOCK_POLL_OUT = 1 << 1,
+    SOCK_POLL_ERR = 1 << 2   // the error or the peer hangup, always reported
+};
+
+typedef struct _sock_poll_event_ {
+    int sock;
+    uint32_t events;
+} sock_poll_event_t;
+
+// return the poll set handle or -1
+int sock_poll_create(int size);
+int sock_poll_add(int ps, int sock, uint32_t events);
+int sock_poll_mod(int ps, int sock, uint32_t events);
+int sock_poll_del(int ps, int sock);
+// return the number of the ready sockets, 0 on timeout, -1 on error
+int sock_poll_wait(int ps, sock_poll_event_t *ev, int max, int timeout_ms);
+void sock_poll_close(int ps);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_BSD_SOCKPOLL_H_
@@ -48,7 +48,7 @@
     defined(__XTENSA_EB__)
 #define __BE_MODE__ 1
 #else
-#warning "Undefined endian mode __LE_MODE__/__BE_MODE__ [little by default]"
+#warning "Undefined endian mode __LE_MODE__/__BE_MODE__ [probed by bsd/byteorder.h]"
 #endif
 
 #if !defined(__NO_STD__)
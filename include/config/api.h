@@ -17,6 +17,23 @@
 # define HTTP_CIPHER
 #endif
 
+// keep-alive connections (HTTP_CONN_POOL)
+#if !defined(HTTP_POOL_SIZE)
+# define HTTP_POOL_SIZE 2
+#endif
+#if !defined(HTTP_POOL_IDLE_TIMEOUT)
+# define HTTP_POOL_IDLE_TIMEOUT 30000
+#endif
+
+// independent HTTP clients for the parallel API calls (HTTP_THREAD)
+#if !defined(HTTP_CLIENTS)
+# if defined(HTTP_THREAD)
+#  define HTTP_CLIENTS 4
+# else
+#  define HTTP_CLIENTS 1
+# endif
+#endif
+
 /* cloud connectivity */
 #if defined(HTTP_CIPHER)
 # define ARROW_SCH "https"
@@ -88,4 +105,31 @@
 #define ARROW_RETRY_DELAY 3000
 #endif
 
+// the reconnection backoff (arrow/supervisor.h): the delay is random
+// up to the ARROW_RETRY_DELAY doubled by every failure in a row
+#if !defined(ARROW_RETRY_MAX_DELAY)
+#define ARROW_RETRY_MAX_DELAY     120000
+#endif
+// the failures in a row that open the circuit breaker for ARROW_BREAKER_OPEN ms
+#if !defined(ARROW_BREAKER_FAILURES)
+#define ARROW_BREAKER_FAILURES    10
+#endif
+#if !defined(ARROW_BREAKER_OPEN)
+#define ARROW_BREAKER_OPEN        900000
+#endif
+
+// the firmware image limit in bytes, 0 - no limit
+#if !defined(ARROW_OTA_MAX_SIZE)
+#define ARROW_OTA_MAX_SIZE        0
+#endif
+
+// the device state table buckets (a power of 2)
+#if !defined(ARROW_STATE_HASH_SIZE)
+#define ARROW_STATE_HASH_SIZE     64
+#endif
+// arrow_device_state_sync posts the changed states once in this window (ms)
+#if !defined(ARROW_STATE_COALESCE_MS)
+#define ARROW_STATE_COALESCE_MS   500
+#endif
+
 #endif // ACN_SDK_C_API_CONFIG_H_
@@ -94,6 +94,34 @@
 
 #define ARROW_MQTT_URL MQTT_SCH "://" MQTT_ADDR ":" #MQTT_PORT
 
+// telemetry batching thresholds (see mqtt_telemetry_set_batch)
+#if !defined(MQTT_BATCH_MAX_SAMPLES)
+#define MQTT_BATCH_MAX_SAMPLES 50
+#endif
+#if !defined(MQTT_BATCH_MAX_AGE)
+#define MQTT_BATCH_MAX_AGE 200
+#endif
+
+// API requests in flight over MQTT (HTTP_VIA_MQTT)
+#if !defined(HTTP_MQTT_MAX_PENDING)
+#define HTTP_MQTT_MAX_PENDING 16
+#endif
+
+// the keepalive (sec) of the next connection is adapted in this range,
+// a session that lasted MQTT_KEEPALIVE_STABLE ms proves the current one
+#if !defined(MQTT_KEEPALIVE)
+#define MQTT_KEEPALIVE        10
+#endif
+#if !defined(MQTT_KEEPALIVE_MIN)
+#define MQTT_KEEPALIVE_MIN    5
+#endif
+#if !defined(MQTT_KEEPALIVE_MAX)
+#define MQTT_KEEPALIVE_MAX    120
+#endif
+#if !defined(MQTT_KEEPALIVE_STABLE)
+#define MQTT_KEEPALIVE_STABLE 1800000
+#endif
+
 #if !defined(MQTT_QOS)
 #define MQTT_QOS        1
 #endif
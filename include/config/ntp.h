@@ -14,4 +14,43 @@
 #define NTP_DEFAULT_PORT    123
 #define NTP_DEFAULT_TIMEOUT 4000
 
+/* the event loop client (ntp/sync.h) */
+#if !defined(NTP_SYNC_SERVERS)
+#define NTP_SYNC_SERVERS      4
+#endif
+// the last samples of a server, the one of the least delay is taken
+#if !defined(NTP_SYNC_SAMPLES)
+#define NTP_SYNC_SAMPLES      8
+#endif
+#if !defined(NTP_SYNC_POLL_MS)
+#define NTP_SYNC_POLL_MS      64000
+#endif
+// the next poll if no server answered
+#if !defined(NTP_SYNC_RETRY_MS)
+#define NTP_SYNC_RETRY_MS     8000
+#endif
+#if !defined(NTP_SYNC_TIMEOUT_MS)
+#define NTP_SYNC_TIMEOUT_MS   2000
+#endif
+// the reactor timer of the client
+#if !defined(NTP_SYNC_TICK_MS)
+#define NTP_SYNC_TICK_MS      250
+#endif
+// the larger offset is stepped, the less one is slewed
+#if !defined(NTP_SYNC_STEP_MS)
+#define NTP_SYNC_STEP_MS      128
+#endif
+// the slew rate limit, as the adjtime one
+#if !defined(NTP_SYNC_SLEW_PPM)
+#define NTP_SYNC_SLEW_PPM     500
+#endif
+// the drift of the ticks is trusted up to
+#if !defined(NTP_SYNC_MAX_PPM)
+#define NTP_SYNC_MAX_PPM      500
+#endif
+// the least interval to measure the drift
+#if !defined(NTP_SYNC_DRIFT_MIN_MS)
+#define NTP_SYNC_DRIFT_MIN_MS 16000
+#endif
+
 #endif // ACN_SDK_C_NTP_CONFIG_H_
@@ -90,6 +90,59 @@ doubly_linked_list_t *doubly_linked_list_del(
   } \
 }
 
+// The list with the first and the last node and the length,
+// the nodes aren't circular here: first->prev and last->next are NULL.
+// The append, the removal and the count are O(1).
+typedef struct _doubly_linked_list_head_ {
+  doubly_linked_list_t *first;
+  doubly_linked_list_t *last;
+  int count;
+} doubly_linked_list_head_t;
+
+#define DOUBLY_LINKED_LIST_HEAD_INIT { NULL, NULL, 0 }
+
+void doubly_linked_list_head_init(doubly_linked_list_head_t *head);
+void doubly_linked_list_head_add(doubly_linked_list_head_t *head, doubly_linked_list_t *el);
+void doubly_linked_list_head_add_first(doubly_linked_list_head_t *head, doubly_linked_list_t *el);
+// the node should be in the list
+void doubly_linked_list_head_del(doubly_linked_list_head_t *head, doubly_linked_list_t *el);
+
+#define doubly_linked_list_head_first(head, type) \
+  ( (head)->first ? container_of((head)->first, type, node) : (type *)NULL )
+
+#define doubly_linked_list_head_last(head, type) \
+  ( (head)->last ? container_of((head)->last, type, node) : (type *)NULL )
+
+#define doubly_linked_list_head_size(head) ((head)->count)
+
+#define doubly_linked_list_head_add_node_last(head, el) \
+  doubly_linked_list_head_add((head), &(el)->node)
+
+#define doubly_linked_list_head_add_node_first(head, el) \
+  doubly_linked_list_head_add_first((head), &(el)->node)
+
+#define doubly_linked_list_head_del_node(head, el) \
+  doubly_linked_list_head_del((head), &(el)->node)
+
+#define dl_head_for_each_node(p, head, type) \
+  doubly_linked_list_t *UN(base_p) = NULL; \
+  for ( UN(base_p) = (head)->first, \
+        (p) = doubly_linked_list_head_first(head, type) ; \
+        UN(base_p) != NULL ; \
+        UN(base_p) = UN(base_p)->next, \
+        (p) = UN(base_p) ? container_of(UN(base_p), type, node) : (p) )
+
+#define dl_head_for_each_node_safe(p, head, type) \
+  doubly_linked_list_t *UN(base_p) = NULL; \
+  doubly_linked_list_t *UN(next_p) = NULL; \
+  for ( UN(base_p) = (head)->first, \
+        UN(next_p) = UN(base_p) ? UN(base_p)->next : NULL, \
+        (p) = doubly_linked_list_head_first(head, type) ; \
+        UN(base_p) != NULL ; \
+        UN(base_p) = UN(next_p), \
+        UN(next_p) = UN(base_p) ? UN(base_p)->next : NULL, \
+        (p) = UN(base_p) ? container_of(UN(base_p), type, node) : NULL )
+
 #if defined(__cplusplus)
 }
 #endif
@@ -62,6 +62,8 @@ typedef struct _find_by {
 
 const char *get_find_by_name(int num);
 int find_by_validate_key(find_by_t *fb);
+// free the list of the find_by_collect
+void find_by_free(find_by_t **params);
 
 #define find_by_collect(params, n) \
   do { \
@@ -101,6 +101,51 @@ arrow_linked_list_t *arrow_linked_list_del_last(arrow_linked_list_t *root);
     else tmp = NULL; \
   }
 
+// The list with the cached last node and the length:
+// the append and the count are O(1), the nodes are the same.
+typedef struct _arrow_linked_list_head_ {
+  arrow_linked_list_t *first;
+  arrow_linked_list_t *last;
+  int count;
+} arrow_linked_list_head_t;
+
+#define ARROW_LINKED_LIST_HEAD_INIT { NULL, NULL, 0 }
+
+void arrow_linked_list_head_init(arrow_linked_list_head_t *head);
+// take the list of the root node (it's walked once)
+void arrow_linked_list_head_set(arrow_linked_list_head_t *head, arrow_linked_list_t *root);
+void arrow_linked_list_head_add(arrow_linked_list_head_t *head, arrow_linked_list_t *el);
+void arrow_linked_list_head_add_first(arrow_linked_list_head_t *head, arrow_linked_list_t *el);
+arrow_linked_list_t *arrow_linked_list_head_del_first(arrow_linked_list_head_t *head);
+// -1 if the node isn't in the list
+int arrow_linked_list_head_del(arrow_linked_list_head_t *head, arrow_linked_list_t *el);
+
+#define arrow_linked_list_head_first(head, type) \
+  ( (head)->first ? container_of((head)->first, type, node) : (type *)NULL )
+
+#define arrow_linked_list_head_last(head, type) \
+  ( (head)->last ? container_of((head)->last, type, node) : (type *)NULL )
+
+#define arrow_linked_list_head_size(head) ((head)->count)
+
+#define arrow_linked_list_head_add_node_last(head, el) \
+  arrow_linked_list_head_add((head), &(el)->node)
+
+#define arrow_linked_list_head_add_node_first(head, el) \
+  arrow_linked_list_head_add_first((head), &(el)->node)
+
+#define arrow_linked_list_head_del_node(head, el) \
+  arrow_linked_list_head_del((head), &(el)->node)
+
+#define arrow_linked_list_head_del_node_first(head) \
+  arrow_linked_list_head_del_first((head))
+
+#define arrow_linked_list_head_for_each(p, head, type) \
+  arrow_linked_list_for_each(p, arrow_linked_list_head_first(head, type), type)
+
+#define arrow_linked_list_head_for_each_safe(p, head, type) \
+  arrow_linked_list_for_each_safe(p, arrow_linked_list_head_first(head, type), type)
+
 #if defined(__cplusplus)
 }
 #endif
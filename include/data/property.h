@@ -17,10 +17,13 @@ extern "C" {
 #include <data/property_const.h>
 #include <data/property_dynamic.h>
 #include <data/property_stack.h>
+#include <data/property_intern.h>
 
 void property_types_init();
 void property_types_deinit();
 void property_type_add(property_dispetcher_t *disp);
+void property_type_del(uint8_t index);
+property_handler_t *get_property_type(property_t *src);
 
 void property_init(property_t *dst);
 void property_copy(property_t *dst, property_t src);
@@ -22,6 +22,10 @@ enum prop_flags {
 };
 
 #define PROPERTY_BASE_MASK 0x3f
+// the type table size: the type index (the flags base bits) is less than this
+#if !defined(PROPERTY_TYPES_MAX)
+# define PROPERTY_TYPES_MAX 8
+#endif
 
 typedef struct __attribute_packed__ _property {
   char *value;
@@ -58,6 +62,7 @@ typedef struct _property_handler_ {
 typedef struct _property_dispetcher_ {
     uint8_t index;
     property_handler_t handler;
+    // not used, the types are in the table by the index
     arrow_linked_list_head_node;
 } property_dispetcher_t;
 
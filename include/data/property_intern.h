@@ -0,0 +1,53 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef _ACN_SDK_C_PROPERTY_INTERN_H_
+#define _ACN_SDK_C_PROPERTY_INTERN_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <data/property_base.h>
+
+#define PROPERTY_INTERN_TAG     5
+
+// The interned strings are shared by all the properties with the same text:
+// one refcounted immutable copy in the pool, the copy of the property
+// is the reference only. The JSON keys and the HTTP header names are
+// interned unless the PROPERTY_NO_INTERN is defined.
+
+// the pool hash table size (a power of 2)
+#if !defined(PROPERTY_INTERN_BUCKETS)
+# define PROPERTY_INTERN_BUCKETS 64
+#endif
+// the longer strings aren't interned
+#if !defined(PROPERTY_INTERN_MAX_LEN)
+# define PROPERTY_INTERN_MAX_LEN 32
+#endif
+// the pool size with the STATIC_DYNAMIC_PROPERTY (no heap)
+#if !defined(PROPERTY_INTERN_STATIC_BUFFER_SIZE)
+# define PROPERTY_INTERN_STATIC_BUFFER_SIZE 2048
+#endif
+
+int property_intern_init(void);
+void property_intern_deinit(void);
+
+// the owner property of the interned copy of the str (len bytes),
+// p_null() if the string is too long or there is no memory
+property_t property_intern(const char *str, int len);
+// the strings in the pool
+int property_intern_count(void);
+
+property_dispetcher_t *property_type_get_intern();
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // _ACN_SDK_C_PROPERTY_INTERN_H_
@@ -28,6 +28,22 @@ void dbg_line(const char *fmt, ...);
 # define DBG(...) dbg_line(__VA_ARGS__);
 
 void hex_dump(const char *data, int size);
+
+# if defined(DBG_RING)
+// DBG only puts the format pointer and the arguments into the ring
+// (the strings are copied), dbg_flush formats and prints them.
+// The full ring drops the new lines, they are counted by dbg_dropped.
+#  if !defined(DBG_RING_SIZE)
+#   define DBG_RING_SIZE 64
+#  endif
+#  if !defined(DBG_RING_ARGS)
+#   define DBG_RING_ARGS 112
+#  endif
+// print the logged lines, return the number of them;
+// call it from the one thread (the idle loop or a log task)
+int dbg_flush(void);
+unsigned int dbg_dropped(void);
+# endif
 #endif
 
 #else
@@ -36,6 +52,11 @@ void hex_dump(const char *data, int size);
 # define ERR(...)
 #endif
 
+#if !defined(DEBUG) || defined(ARCH_DEBUG) || !defined(DBG_RING)
+# define dbg_flush() 0
+# define dbg_dropped() 0
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
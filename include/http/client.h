@@ -14,6 +14,7 @@
 #include <data/ringbuffer.h>
 
 #define LINE_CHUNK 40
+#define HTTP_CHUNK_SIZE (RINGBUFFER_SIZE/2)
 #define HTTP_VERS " HTTP/1.1\r\n"
 
 #define api_via_http 0
@@ -21,6 +22,9 @@
 typedef struct __session_flags {
   uint8_t _close;
   uint8_t _cipher;
+  uint8_t _reused;      // the socket was taken from the keep-alive pool
+  uint8_t _peer_close;  // the server answered "Connection: close"
+  uint8_t _drained;     // the whole answer is read, the socket may be reused
 } __session_flags_t;
 
 typedef struct {
@@ -33,8 +37,14 @@ typedef struct {
 #endif
   ring_buffer_t  *queue;
   http_request_t *request;
+#if defined(HTTP_THREAD)
+  // the parallel clients don't share the scratch space
+  uint8_t tmpbuffer[HTTP_CHUNK_SIZE];
+  uint8_t linebuffer[RINGBUFFER_SIZE];
+#endif
 
   uint32_t protocol;
+  int pool_slot;
 } http_client_t;
 
 int http_session_is_open(http_client_t *cli);
@@ -48,4 +58,21 @@ int http_client_close(http_client_t *cli);
 
 int http_client_do(http_client_t *cli, http_response_t *res);
 
+int default_http_client_open(http_client_t *cli, http_request_t *req);
+int default_http_client_close(http_client_t *cli);
+int default_http_client_do(http_client_t *cli, http_response_t *res);
+// the two halves of the default_http_client_do for the event loop:
+// send the opened request, then take the answer when the socket is readable
+int default_http_client_send(http_client_t *cli, http_response_t *res);
+int default_http_client_receive(http_client_t *cli, http_response_t *res);
+
+// HTTP/1.1 pipelining: send all the requests through the opened session
+// and then read the answers in the same order.
+// Only the idempotent methods (GET, HEAD) to the same host are allowed.
+// Return the number of the received responses or -1
+int http_client_do_pipeline(http_client_t *cli,
+                            http_request_t *req,
+                            http_response_t *res,
+                            int count);
+
 #endif /* ACN_SDK_C_HTTP_CLIENT_H_ */
@@ -15,12 +15,43 @@
 #include <http/client.h>
 #include <http/request.h>
 #include <http/response.h>
+#include <json/json.h>
 
 #define api_via_mqtt 1
 
+#if !defined(HTTP_MQTT_REQ_ID_LEN)
+#define HTTP_MQTT_REQ_ID_LEN 40
+#endif
+
 int http_mqtt_client_open(http_client_t *cli, http_request_t *req);
 int http_mqtt_client_close(http_client_t *cli);
+// send the request and wait for the answer
 int http_mqtt_client_do(http_client_t *cli, http_response_t *res);
 
+// Up to HTTP_MQTT_MAX_PENDING requests may be in flight over the one
+// connection, the answers are matched by the requestId.
+// The status is 0 for the "OK" answer, -1 for the error or the timeout.
+typedef void (*http_mqtt_done_f)(int status, http_response_t *res, void *arg);
+
+// publish the opened request, the answer comes into the res;
+// with the callback it is called on the completion,
+// otherwise the handle is for the http_mqtt_client_wait.
+// return the handle or -1
+int http_mqtt_client_send(http_client_t *cli, http_response_t *res,
+                          http_mqtt_done_f cb, void *arg);
+// yield once and complete the answered or expired requests,
+// return the number of the requests in flight
+int http_mqtt_client_poll(int timeout_ms);
+// the same without the yield, the answers are received by someone else
+// (the event loop reads the MQTT channel)
+int http_mqtt_client_dispatch(void);
+// wait for the request sent without the callback, return its status
+int http_mqtt_client_wait(int handle);
+int http_mqtt_client_pending(void);
+
+// the transport, mqtt_api_publish and mqtt_yield by default
+int http_mqtt_publish(JsonNode *msg);
+int http_mqtt_yield(int timeout_ms);
+
 #endif  // HTTP_VIA_MQTT
 #endif  // ACN_SDK_C_HTTP_CLIENT_MQTT_H_
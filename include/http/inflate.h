@@ -0,0 +1,80 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_HTTP_INFLATE_H_
+#define ACN_SDK_C_HTTP_INFLATE_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+
+// Streaming decoder of the "gzip" and "deflate" content codings (RFC 1951/1950/1952).
+// The compressed bytes are pushed in pieces of any size, the decoded data
+// comes out through the callback by the window pieces, so the memory is
+// the state and the HTTP_INFLATE_WINDOW bytes of the sliding window.
+// A stream referring further back than the window is rejected.
+
+#if !defined(HTTP_INFLATE_WINDOW)
+#define HTTP_INFLATE_WINDOW 32768
+#endif
+
+enum http_content_coding {
+    http_coding_identity = 0,
+    http_coding_gzip,
+    http_coding_deflate,  // zlib wrapped or raw, detected by the first bytes
+    http_coding_raw
+};
+
+typedef int (*http_inflate_out_f)(void *arg, uint8_t *buf, size_t len);
+
+typedef struct _http_inflate_ {
+    uint8_t format;
+    uint8_t state;
+    uint8_t last;
+    uint8_t flags;
+    uint64_t bitbuf;
+    int bitcnt;
+    int step;
+    int count;
+    // the dynamic block header
+    int nlen;
+    int ndist;
+    int ncode;
+    uint8_t lengths[320];
+    // the length/literal (or the code lengths) and distance codes
+    uint16_t lencnt[16];
+    uint16_t lensym[288];
+    uint16_t distcnt[16];
+    uint16_t distsym[30];
+    int copy_len;
+    int copy_dist;
+    // the output window
+    uint8_t *window;
+    uint32_t total;
+    uint32_t flushed;
+    uint32_t check;
+    http_inflate_out_f out;
+    void *arg;
+} http_inflate_t;
+
+// parse the Content-Encoding header value
+int http_content_coding(const char *value);
+
+int http_inflate_init(http_inflate_t *z, int format, http_inflate_out_f out, void *arg);
+// return 0 if needs more data, 1 if the stream is done, -1 on error
+int http_inflate_part(http_inflate_t *z, const uint8_t *in, size_t len);
+void http_inflate_fin(http_inflate_t *z);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_HTTP_INFLATE_H_
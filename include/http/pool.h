@@ -0,0 +1,59 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_HTTP_POOL_H_
+#define ACN_SDK_C_HTTP_POOL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <http/client.h>
+
+#if !defined(HTTP_POOL_HOST_LEN)
+#define HTTP_POOL_HOST_LEN 64
+#endif
+
+// Keep-alive sockets keyed by host:port:scheme.
+// The HTTP client takes a slot on the open and returns the socket
+// into the pool on the close instead of the disconnection.
+// The idle socket is checked for the peer close before the reuse
+// and is closed after HTTP_POOL_IDLE_TIMEOUT msec.
+
+// the pool lock (HTTP_THREAD), http_pool_deinit closes all idle sockets
+int http_pool_init(void);
+void http_pool_deinit(void);
+
+// take an idle socket for this request if there is one,
+// return 1 if the socket is reused, 0 otherwise
+int http_pool_acquire(http_client_t *cli, http_request_t *req);
+// put the client socket into the pool, return 0 if it's done
+// (the client doesn't own the socket anymore)
+int http_pool_release(http_client_t *cli);
+// forget the slot of this client
+void http_pool_drop(http_client_t *cli);
+// close the sockets idle more than HTTP_POOL_IDLE_TIMEOUT
+void http_pool_evict(void);
+// close all idle sockets
+void http_pool_clear(void);
+int http_pool_idle_count(void);
+
+// http_client_open/do/close with the keep-alive pool (see HTTP_CONN_POOL)
+int http_pool_client_open(http_client_t *cli, http_request_t *req);
+int http_pool_client_do(http_client_t *cli, http_response_t *res);
+int http_pool_client_close(http_client_t *cli);
+
+// return 0 if the peer closed this idle socket
+int http_pool_sock_alive(int sock);
+uint32_t http_pool_now(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_HTTP_POOL_H_
@@ -41,10 +41,12 @@ typedef property_t http_payload_t;
 // the payload handler for response
 // for OTA firmware update
 // if it's impossible to allocate memory for binary file
+// (_p_arg is the handler's own state, the response keeps it)
 typedef int(*__payload_handler)(void *, property_t);
 typedef struct __payload_meth {
   __payload_handler _p_set_handler;
   __payload_handler _p_add_handler;
+  void *_p_arg;
 } _payload_meth_t;
 
 typedef struct __attribute_packed__ {
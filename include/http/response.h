@@ -16,6 +16,7 @@
 typedef struct {
     uint16_t m_httpResponseCode;
     uint16_t is_chunked;
+    uint16_t content_coding;
     uint32_t recvContentLength;
     property_map_t *header;
     property_map_t content_type;
@@ -0,0 +1,60 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_JSON_CBOR_H_
+#define ACN_SDK_C_JSON_CBOR_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <json/json.h>
+
+// Compact binary (RFC 7049) form of the JsonNode tree.
+// Numbers are written as the shortest integer if there is no fraction,
+// as float32 if it is exact, or as float64 otherwise.
+
+#if !defined(CBOR_MAX_DEPTH)
+#define CBOR_MAX_DEPTH 16
+#endif
+
+enum cbor_encode_states {
+    cem_encode_state_key,
+    cem_encode_state_key_data,
+    cem_encode_state_value,
+    cem_encode_state_value_data,
+    cem_encode_state_next,
+    cem_encode_state_done
+};
+
+typedef struct _cbor_encode_machine_ {
+    uint16_t state;
+    uint8_t head[9];
+    uint8_t head_len;
+    const uint8_t *seg;
+    size_t seg_len;
+    size_t start;
+    JsonNode *root;
+    JsonNode *ptr;
+} cbor_encode_machine_t;
+
+size_t      cbor_size           (JsonNode *node);
+
+int         cbor_encode_init    (cbor_encode_machine_t *cem, JsonNode *node);
+int         cbor_encode_part    (cbor_encode_machine_t *cem, char *s, int len);
+int         cbor_encode_fin     (cbor_encode_machine_t *cem);
+
+// encode the whole tree into the buffer, return the size or -1
+int         cbor_encode         (JsonNode *node, uint8_t *buf, size_t len);
+JsonNode   *cbor_decode         (const uint8_t *buf, size_t len);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_JSON_CBOR_H_
@@ -151,9 +151,14 @@ char       *json_encode         (const JsonNode *node);
 char       *json_encode_string  (const char *str);
 property_t  json_encode_property(const JsonNode *node);
 char       *json_stringify      (const JsonNode *node, const char *space);
+// the quoted string and the number as they are encoded, into the buffer
+void        json_emit_string    (SB *out, const char *str);
+void        json_emit_number    (SB *out, double num);
 void        json_delete         (JsonNode *node);
 char       *json_strdup         (const char *str);
 property_t  json_strdup_property(const char *str);
+// the parsed key (the SB string) as the interned property, the key is freed then
+property_t  json_key_property   (char *key, int len);
 void        json_delete_string  (char *json_str);
 
 int         fill_string_from_json(JsonNode *_node, property_t name, property_t *p);
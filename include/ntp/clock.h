@@ -0,0 +1,56 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_NTP_CLOCK_H_
+#define ACN_SDK_C_NTP_CLOCK_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+#include <time/time.h>
+
+// The clock of the NTP client (ntp/sync.h) over the monotonic ticks:
+// the time is the base and the ticks since the base tick corrected by
+// the drift, the offset goes in by the slew at NTP_SYNC_SLEW_PPM at most.
+
+typedef struct _ntp_clock_ {
+    int64_t base_us;    // the time (us from the epoch) at the base tick
+    uint32_t base_ms;
+    int64_t slew_us;    // the correction which is not applied yet
+    int32_t freq_ppb;   // the drift of the ticks
+    int64_t last_us;    // the server time at the last tick for the drift
+    uint32_t last_ms;
+    uint8_t drift;      // the drift is measured
+    uint8_t synced;
+} ntp_clock_t;
+
+void ntp_clock_init(ntp_clock_t *c, int64_t now_us, uint32_t mono_ms);
+int64_t ntp_clock_now(const ntp_clock_t *c, uint32_t mono_ms);
+// the time the clock is heading to, the slew is applied in full
+int64_t ntp_clock_target(const ntp_clock_t *c, uint32_t mono_ms);
+// move the base to the tick so the elapsed ticks don't overflow
+void ntp_clock_rebase(ntp_clock_t *c, uint32_t mono_ms);
+// apply the offset to the target measured at the sample tick
+// return 1 if the clock is stepped, 0 if it is slewed
+int ntp_clock_adjust(ntp_clock_t *c, int64_t offset_us,
+                     uint32_t sample_ms, uint32_t mono_ms);
+
+// the time source for the timestamp: the synced clock,
+// the gettimeofday until it is synced or if there is no source
+void ntp_clock_set_source(ntp_clock_t *c);
+int ntp_clock_gettimeofday(struct timeval *tv);
+void ntp_clock_timestamp(timestamp_t *ts);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_NTP_CLOCK_H_
@@ -0,0 +1,97 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_NTP_SYNC_H_
+#define ACN_SDK_C_NTP_SYNC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <sys/type.h>
+#include <bsd/socket.h>
+#include <ntp/clock.h>
+
+// The NTP client for the event loop. The requests go to all the servers at
+// once and the answers are read when the socket is ready, so nothing waits.
+// A server keeps the last NTP_SYNC_SAMPLES samples and the one of the least
+// round trip delay gives its offset (RFC 5905 clock filter); the server of
+// the least delay wins.
+// The wall clock isn't set: the client keeps its own clock over the
+// monotonic ticks, the offset is slewed into it (or stepped if it is larger
+// than NTP_SYNC_STEP_MS) and the drift of the ticks is tracked.
+
+#define NTP_PACKET_LEN 48
+
+typedef struct _ntp_sample_ {
+    int64_t offset_us;
+    int32_t delay_us;
+    uint32_t tick;
+    uint32_t seq;
+} ntp_sample_t;
+
+typedef struct _ntp_server_ {
+    const char *host;
+    struct sockaddr_in addr;
+    uint16_t port;
+    uint8_t resolved;
+    uint8_t pending;
+    uint8_t reach;      // the answered polls, one bit per poll
+    uint8_t count;
+    uint8_t next;
+    uint8_t org[8];     // the sent transmit time, the answer returns it
+    int64_t t1_us;
+    ntp_sample_t sample[NTP_SYNC_SAMPLES];
+} ntp_server_t;
+
+typedef struct _ntp_sync_ {
+    ntp_server_t server[NTP_SYNC_SERVERS];
+    int servers;
+    int sock;
+    int timer;
+    uint32_t poll_ms;
+    uint32_t timeout_ms;
+    uint32_t next_ms;   // the tick of the next poll or the poll timeout
+    uint32_t seq;       // the samples of all the servers are numbered
+    uint32_t used_seq;  // the last applied sample
+    uint8_t polling;
+    uint8_t used;
+    ntp_clock_t clock;
+} ntp_sync_t;
+
+void ntp_sync_init(ntp_sync_t *s);
+// the host isn't copied, it is resolved once by the first poll
+int ntp_sync_add_server(ntp_sync_t *s, const char *host, uint16_t port);
+// open the UDP socket, return it or -1
+int ntp_sync_open(ntp_sync_t *s);
+// send the requests to all the servers without waiting for the answers
+int ntp_sync_poll(ntp_sync_t *s);
+// read the answers there are, return the number of them or -1
+int ntp_sync_input(ntp_sync_t *s);
+// the poll timeout and the next poll by the tick,
+// return the ms to the next event
+int ntp_sync_step(ntp_sync_t *s, uint32_t mono_ms);
+void ntp_sync_close(ntp_sync_t *s);
+int ntp_sync_is_synced(ntp_sync_t *s);
+
+#if defined(ARROW_REACTOR)
+// serve the client by the reactor (arrow/reactor.h): the socket is read when
+// it is ready and the timer polls the servers every s->poll_ms
+int ntp_sync_attach(ntp_sync_t *s);
+void ntp_sync_detach(ntp_sync_t *s);
+#endif
+
+// the client clock is the time source (ntp/clock.h), NULL drops it
+void ntp_sync_set_source(ntp_sync_t *s);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_NTP_SYNC_H_
@@ -9,13 +9,40 @@
 #ifndef _ARROW_INCLUDE_CRYPT_SHA256_H_
 #define _ARROW_INCLUDE_CRYPT_SHA256_H_
 
+#include "wolfssl/wolfcrypt/sha256.h"
+
+// The caller owns the context, so the hashes may be calculated
+// from several threads or interleaved in one.
+// With CRYPT_SHA_NI the blocks are hashed by the x86 SHA extensions
+// if the CPU has them (checked at runtime), by wolfCrypt otherwise.
+typedef struct _acn_sha256_ctx_ {
+  Sha256 sh;
+} acn_sha256_ctx;
+
+// HMAC-SHA256 over the contexts above
+typedef struct _acn_hmac_ctx_ {
+  acn_sha256_ctx inner;
+  acn_sha256_ctx outer;
+} acn_hmac_ctx;
+
+void acn_sha256_init(acn_sha256_ctx *ctx);
+void acn_sha256_update(acn_sha256_ctx *ctx, const char *buf, int size);
+void acn_sha256_final(acn_sha256_ctx *ctx, char *shasum);
+// 1 if the blocks are hashed by the SHA extensions
+int acn_sha256_accel(void);
+
+void acn_hmac256_init(acn_hmac_ctx *ctx, const char *key, int key_size);
+void acn_hmac256_update(acn_hmac_ctx *ctx, const char *buf, int buf_size);
+void acn_hmac256_final(acn_hmac_ctx *ctx, char *hmacdig);
+
 void sha256(char *shasum, char *buf, int size);
+void hmac256(char *hmacdig, const char *key, int key_size, const char *buf, int buf_size);
+
+// these ones use the one shared context: not reentrant
 void sha256_init();
 void sha256_chunk(const char *buf, int size);
 void sha256_fin(char *shasum);
 
-void hmac256(char *hmacdig, const char *key, int key_size, const char *buf, int buf_size);
-
 void hmac256_init(const char *key, int key_size);
 void hmac256_chunk(const char *buf, int buf_size);
 void hmac256_fin(char *hmacdig);
@@ -9,9 +9,18 @@
 #ifndef ARROW_SSL_H_
 #define ARROW_SSL_H_
 
+// the session list lock (HTTP_THREAD)
+int ssl_init(void);
+void ssl_deinit(void);
+
 int ssl_connect(int sock);
 int ssl_recv(int sock, char *data, int len);
 int ssl_send(int sock, char* data, int length);
+// the decrypted bytes are buffered, the socket may be not readable
+int ssl_pending(int sock);
+// the ret of the ssl_recv/ssl_send is the non-blocking socket not ready
+// (WANT_READ/WANT_WRITE), call it again with the same data
+int ssl_would_block(int sock, int ret);
 int ssl_close(int sock);
 
 #endif
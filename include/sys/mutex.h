@@ -11,7 +11,7 @@
 
 #include <config.h>
 
-#if defined(ARROW_THREAD)
+#if defined(ARROW_THREAD) || defined(HTTP_THREAD)
 typedef void arrow_mutex;
 
 int arrow_mutex_init(arrow_mutex **mutex);
@@ -0,0 +1,32 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_TIME_MONOTONIC_H_
+#define ACN_SDK_C_TIME_MONOTONIC_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <sys/type.h>
+
+// The millisecond clock for the timeouts. Unlike the gettimeofday it doesn't
+// jump with the ntp_set_time or stime.
+// It is CLOCK_MONOTONIC_COARSE by default (the TIME_MONO_PRECISE define
+// switches to CLOCK_MONOTONIC), another platform should return its tick counter.
+uint32_t time_mono_ms(void);
+
+// the ticks wrap in 49 days, so compare them by the difference only
+// (the intervals up to 24 days)
+#define time_mono_diff(a, b) ((int32_t)((uint32_t)(a) - (uint32_t)(b)))
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_TIME_MONOTONIC_H_
@@ -0,0 +1,59 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#ifndef ACN_SDK_C_TIME_TIMER_WHEEL_H_
+#define ACN_SDK_C_TIME_TIMER_WHEEL_H_
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <config.h>
+#include <time/monotonic.h>
+
+// The hashed timer wheel: a timer goes to the slot of its due tick,
+// so the add and del are O(1) and the expire step looks at the passed
+// slots only. The timer_node_t is embedded as the first member
+// of the user structure; the due time is kept exactly (time_mono_ms).
+
+// the power of 2
+#if !defined(TIMER_WHEEL_SLOTS)
+#define TIMER_WHEEL_SLOTS      128
+#endif
+
+// the slot width is (1 << TIMER_WHEEL_TICK_SHIFT) ms
+#if !defined(TIMER_WHEEL_TICK_SHIFT)
+#define TIMER_WHEEL_TICK_SHIFT 3
+#endif
+
+typedef struct _timer_node_ {
+  struct _timer_node_ *next;
+  struct _timer_node_ **pprev;
+  uint32_t due;
+} timer_node_t;
+
+typedef struct _timer_wheel_ {
+  uint32_t tick;
+  int count;
+  timer_node_t *slot[TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *w, uint32_t now);
+void timer_wheel_add(timer_wheel_t *w, timer_node_t *n, uint32_t due);
+void timer_wheel_del(timer_wheel_t *w, timer_node_t *n);
+#define timer_wheel_pending(n) ( (n)->pprev != NULL )
+// take out one timer due by the now or return NULL
+timer_node_t *timer_wheel_expired(timer_wheel_t *w, uint32_t now);
+// the ms to the nearest due timer, up to the max_ms
+int timer_wheel_next_ms(timer_wheel_t *w, uint32_t now, int max_ms);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif  // ACN_SDK_C_TIME_TIMER_WHEEL_H_
@@ -2,6 +2,7 @@
 #include <http/routine.h>
 #include <debug.h>
 #include <data/chunk.h>
+#include <arrow/api/json/page.h>
 
 #define URI_LEN sizeof(ARROW_API_DEVICE_ENDPOINT) + 50
 #define DEVICE_MSG "Device %d"
@@ -58,6 +59,17 @@ int arrow_device_find_by(device_info_t **list, int n, ...) {
               DEVICE_MSG, DEVICE_FINDBY_ERROR);
 }
 
+int arrow_device_find_by_each(device_info_cb cb, void *arg, int n, ...) {
+  find_by_t *params = NULL;
+  find_by_collect(params, n);
+  device_info_each_t de = { cb, arg };
+  int ret = page_stream_routine(_device_find_by_init, (void*)params,
+                                device_info_item, &de);
+  if ( ret < 0 ) DBG("Error:" DEVICE_MSG, DEVICE_FINDBY_ERROR);
+  find_by_free(&params);
+  return ret;
+}
+
 static void _device_find_by_hid_init(http_request_t *request, void *arg) {
   char *hid = (char *)arg;
   CREATE_CHUNK(uri, URI_LEN);
@@ -175,6 +187,18 @@ int arrow_list_device_logs(log_t **list, arrow_device_t *device, int n, ...) {
               DEVICE_MSG, DEVICE_LOGS_ERROR);
 }
 
+int arrow_list_device_logs_each(arrow_device_t *device, log_cb cb, void *arg, int n, ...) {
+  find_by_t *params = NULL;
+  find_by_collect(params, n);
+  dev_param_t dp = { device, params };
+  log_each_t le = { cb, arg };
+  int ret = page_stream_routine(_device_list_logs_init, &dp,
+                                log_item, &le);
+  if ( ret < 0 ) DBG("Error:" DEVICE_MSG, DEVICE_LOGS_ERROR);
+  find_by_free(&params);
+  return ret;
+}
+
 typedef struct _device_error {
   arrow_device_t *device;
   const char *error;
@@ -29,6 +29,8 @@ int device_event_parse(device_event_t **list, const char *text) {
     if ( !_main ) return -1;
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
+        arrow_linked_list_head_t head;
+        arrow_linked_list_head_set(&head, *list ? &(*list)->node : NULL);
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             device_event_t *de = alloc_type(device_event_t);
@@ -37,8 +39,9 @@ int device_event_parse(device_event_t **list, const char *text) {
             json_fill_property(tmp, de, criteria);
             json_fill_property(tmp, de, deviceActionTypeName);
             json_fill_property(tmp, de, status);
-            arrow_linked_list_add_node_last(*list, device_event_t, de);
+            arrow_linked_list_head_add_node_last(&head, de);
         }
+        *list = arrow_linked_list_head_first(&head, device_event_t);
     }
     json_delete(_main);
     return 0;
@@ -76,13 +76,25 @@ int device_info_parse(device_info_t **list, const char *s) {
     if ( !_main ) return -1;
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
+        arrow_linked_list_head_t head;
+        arrow_linked_list_head_set(&head, *list ? &(*list)->node : NULL);
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             device_info_t *gd = alloc_type(device_info_t);
             _device_info_parse(gd, tmp);
-            arrow_linked_list_add_node_last(*list, device_info_t, gd);
+            arrow_linked_list_head_add_node_last(&head, gd);
         }
+        *list = arrow_linked_list_head_first(&head, device_info_t);
     }
     json_delete(_main);
     return 0;
 }
+
+int device_info_item(JsonNode *item, void *arg) {
+    device_info_each_t *de = (device_info_each_t *)arg;
+    device_info_t info;
+    _device_info_parse(&info, item);
+    int ret = de->cb(&info, de->arg);
+    device_info_free(&info);
+    return ret;
+}
@@ -11,6 +11,7 @@
 #include <arrow/sign.h>
 #include <debug.h>
 #include <data/chunk.h>
+#include <arrow/api/json/page.h>
 
 #define URI_LEN sizeof(ARROW_API_GATEWAY_ENDPOINT) + 100
 #define GATEWAY_MSG "Gateway %d"
@@ -273,6 +274,14 @@ int arrow_gateway_devices_list(device_info_t **list, const char *hid) {
               GATEWAY_MSG, GATEWAY_DEVLIST_ERROR);
 }
 
+int arrow_gateway_devices_each(const char *hid, device_info_cb cb, void *arg) {
+  device_info_each_t de = { cb, arg };
+  int ret = page_stream_routine(_gateway_devices_list_init, (void*)hid,
+                                device_info_item, &de);
+  if ( ret < 0 ) DBG("Error:" GATEWAY_MSG, GATEWAY_DEVLIST_ERROR);
+  return ret;
+}
+
 typedef struct _gate_dev_cmd_ {
   const char *g_hid;
   const char *d_hid;
@@ -64,6 +64,8 @@ int gateway_info_parse(gateway_info_t **list, const char *s) {
     if ( !_main ) return -1;
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
+        arrow_linked_list_head_t head;
+        arrow_linked_list_head_set(&head, *list ? &(*list)->node : NULL);
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             gateway_info_t *gi = alloc_type(gateway_info_t);
@@ -82,8 +84,9 @@ int gateway_info_parse(gateway_info_t **list, const char *s) {
             json_fill_property(tmp, gi, sdkVersion);
             json_fill_property(tmp, gi, softwareName);
             json_fill_property(tmp, gi, softwareVersion);
-            arrow_linked_list_add_node_last(*list, gateway_info_t, gi);
+            arrow_linked_list_head_add_node_last(&head, gi);
         }
+        *list = arrow_linked_list_head_first(&head, gateway_info_t);
     }
     json_delete(_main);
     return 0;
@@ -0,0 +1,218 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include <arrow/api/json/page.h>
+#include <http/routine.h>
+#include <http/response.h>
+#include <debug.h>
+
+enum page_fields {
+    page_field_none = 0,
+    page_field_size,
+    page_field_page,
+    page_field_totalSize,
+    page_field_totalPages,
+    page_field_data,
+    page_field_count
+};
+
+static const char *page_field_names[page_field_count] = {
+    "", "size", "page", "totalSize", "totalPages", "data"
+};
+
+static uint8_t page_field(page_stream_t *s) {
+    int i;
+    if ( s->klen >= PAGE_KEY_LEN ) return page_field_none;
+    s->key[s->klen] = 0x0;
+    for ( i = page_field_size; i < page_field_count; i++ ) {
+        if ( strcmp(s->key, page_field_names[i]) == 0 ) return (uint8_t)i;
+    }
+    return page_field_none;
+}
+
+static void page_field_end(page_stream_t *s) {
+    switch ( s->field ) {
+    case page_field_size:       s->ps.size = s->num; break;
+    case page_field_page:       s->ps.page = s->num; break;
+    case page_field_totalSize:  s->ps.totalSize = s->num; break;
+    case page_field_totalPages: s->ps.totalPages = s->num; break;
+    default: break;
+    }
+    s->field = page_field_none;
+    s->value = 0;
+}
+
+// the structure of the answer: the strings, the depth and the top level fields
+static int page_stream_byte(page_stream_t *s, char c) {
+    int depth = s->depth;
+    if ( s->str ) {
+        if ( s->esc ) s->esc = 0;
+        else if ( c == '\\' ) s->esc = 1;
+        else if ( c == '"' ) s->str = 0;
+        else if ( depth == 1 && !s->value ) {
+            if ( s->klen < PAGE_KEY_LEN - 1 ) s->key[s->klen++] = c;
+            else s->klen = PAGE_KEY_LEN;
+        }
+        return 0;
+    }
+    switch ( c ) {
+    case '"':
+        s->str = 1;
+        if ( depth == 1 && !s->value ) s->klen = 0;
+        break;
+    case '[':
+        if ( depth == 1 && s->field == page_field_data ) s->data = 1;
+        // fall through
+    case '{':
+        if ( s->done ) return -1;
+        s->depth++;
+        break;
+    case ']':
+    case '}':
+        if ( depth <= 0 ) return -1;
+        if ( depth == 1 ) {
+            page_field_end(s);
+            s->done = 1;
+        }
+        if ( depth == 2 ) s->data = 0;
+        s->depth--;
+        break;
+    case ':':
+        if ( depth == 1 ) {
+            s->field = page_field(s);
+            s->value = 1;
+            s->num = 0;
+        }
+        break;
+    case ',':
+        if ( depth == 1 ) page_field_end(s);
+        break;
+    default:
+        if ( depth == 1 && s->value && is_digit(c) ) s->num = s->num * 10 + ( c - '0' );
+        break;
+    }
+    return 0;
+}
+
+static int page_stream_item(page_stream_t *s) {
+    JsonNode *item = json_decode_finish(&s->sm);
+    s->elem = 0;
+    if ( !item ) return -1;
+    s->items++;
+    int ret = s->cb(item, s->arg);
+    json_delete(item);
+    if ( ret < 0 ) {
+        s->stopped = 1;
+        return -1;
+    }
+    return 0;
+}
+
+void page_stream_init(page_stream_t *s, page_item_cb cb, void *arg) {
+    memset(s, 0x0, sizeof(page_stream_t));
+    s->cb = cb;
+    s->arg = arg;
+}
+
+int page_stream_part(page_stream_t *s, const char *text, int len) {
+    int from = 0;
+    int i;
+    for ( i = 0; i < len; i++ ) {
+        int depth = s->depth;
+        int data = s->data;
+        if ( page_stream_byte(s, text[i]) < 0 ) return -1;
+        if ( s->elem ) {
+            if ( s->depth > 2 ) continue;
+            // the element is closed, the machine gets the whole of it
+            if ( json_decode_part(&s->sm, text + from, i - from + 1) < 0 ) return -1;
+            if ( page_stream_item(s) < 0 ) return -1;
+        } else if ( data && depth == 2 ) {
+            if ( s->depth == 3 ) {
+                json_decode_init(&s->sm);
+                s->elem = 1;
+                from = i;
+            } else if ( s->depth == 2 && !is_space(text[i]) && text[i] != ',' ) {
+                // the list of the objects only
+                return -1;
+            }
+        }
+    }
+    if ( s->elem && from < len ) {
+        if ( json_decode_part(&s->sm, text + from, len - from) < 0 ) return -1;
+    }
+    return len;
+}
+
+int page_stream_finish(page_stream_t *s) {
+    if ( s->elem ) {
+        json_delete(json_decode_finish(&s->sm));
+        s->elem = 0;
+        return -1;
+    }
+    return s->done ? 0 : -1;
+}
+
+int page_stream_payload_handler(void *r, property_t payload) {
+    http_response_t *res = (http_response_t *)r;
+    page_stream_t *s = (page_stream_t *)res->_p_meth._p_arg;
+    if ( !s ) return -1;
+    if ( !res->processed_payload_chunk && res->m_httpResponseCode != 200 ) return -1;
+    if ( page_stream_part(s, P_VALUE(payload), (int)property_size(&payload)) < 0 ) return -1;
+    return 0;
+}
+
+typedef struct _page_walk_ {
+    void (*init)(http_request_t *, void *);
+    void *arg;
+    int page;
+    page_stream_t s;
+} page_walk_t;
+
+static void page_request_init(http_request_t *request, void *arg) {
+    page_walk_t *w = (page_walk_t *)arg;
+    char page[12];
+    w->init(request, w->arg);
+    property_map_t *p = property_map_find(request->query, p_const(get_find_by_name(f_page)));
+    if ( p && w->page < 0 ) w->page = atoi(P_VALUE(p->value));
+    if ( w->page < 0 ) w->page = 0;
+    snprintf(page, sizeof(page), "%d", w->page);
+    if ( p ) {
+        property_free(&p->value);
+        property_copy(&p->value, p_stack(page));
+    } else {
+        http_request_add_query(request, p_const(get_find_by_name(f_page)), p_stack(page));
+    }
+    request->_response_payload_meth._p_add_handler = page_stream_payload_handler;
+    request->_response_payload_meth._p_arg = &w->s;
+}
+
+static int page_response_proc(http_response_t *response, void *arg) {
+    SSP_PARAMETER_NOT_USED(arg);
+    if ( response->m_httpResponseCode != 200 ) return -1;
+    return 0;
+}
+
+int page_stream_routine(void (*init)(http_request_t *, void *), void *i_arg,
+                        page_item_cb cb, void *cb_arg) {
+    page_walk_t w;
+    int total = 0;
+    w.init = init;
+    w.arg = i_arg;
+    w.page = -1;
+    do {
+        page_stream_init(&w.s, cb, cb_arg);
+        int ret = __http_routine(page_request_init, &w, page_response_proc, &w);
+        int fin = page_stream_finish(&w.s);
+        total += w.s.items;
+        if ( w.s.stopped ) break;
+        if ( ret < 0 ) return ret;
+        if ( fin < 0 ) return -1;
+        w.page++;
+    } while ( w.s.items && w.page < w.s.ps.totalPages );
+    return total;
+}
@@ -61,36 +61,124 @@ int who_when_parse(JsonNode *tmp, who_when_t *ww, const char *date, const char *
     return 0;
 }
 
-// pasre this for ex "2018-05-21T13:40:32.173Z"
-int timestamp_parse(timestamp_t *t, const char *s) {
-    // parse year
-    int tmp;
-    char *p = copy_till_to_int(s, "-", &tmp);
-    if ( !p ) return -1;
-    t->year = tmp;
-    // mon
-    p = copy_till_to_int(p, "-", &tmp);
-    if ( !p ) return -1;
-    t->mon = tmp;
-    // day
-    p = copy_till_to_int(p, "T", &tmp);
-    if ( !p ) return -1;
-    t->day = tmp;
-    // hour
-    p = copy_till_to_int(p, ":", &tmp);
-    if ( !p ) return -1;
-    t->hour = tmp;
-    // min
-    p = copy_till_to_int(p, ":", &tmp);
-    if ( !p ) return -1;
-    t->min = tmp;
-    // sec
-    p = copy_till_to_int(p, ".", &tmp);
-    if ( !p ) return -1;
-    t->sec = tmp;
-    // msec
-    p = copy_till_to_int(p, "Z", &tmp);
-    if ( !p ) return -1;
-    t->msec = tmp;
+#define dig(p, i)   ( (p)[i] - '0' )
+#define dig2(p)     ( dig(p, 0) * 10 + dig(p, 1) )
+#define dig4(p)     ( dig2(p) * 100 + dig2((p) + 2) )
+
+// the layout of the timestamps the SDK and the cloud send
+static const char _ts_layout[] = "dddd-dd-ddTdd:dd:dd.dddZ";
+#define TS_LAYOUT_LEN ( sizeof(_ts_layout) - 1 )
+
+// the days from 1970-01-01 of the proleptic Gregorian date
+static int32_t days_from_civil(int32_t y, int32_t m, int32_t d) {
+    int32_t era, yoe, doy, doe;
+    y -= m <= 2;
+    era = ( y >= 0 ? y : y - 399 ) / 400;
+    yoe = y - era * 400;
+    doy = ( 153 * ( m + ( m > 2 ? -3 : 9 ) ) + 2 ) / 5 + d - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(int32_t z, int32_t *y, int32_t *m, int32_t *d) {
+    int32_t era, doe, yoe, doy, mp;
+    z += 719468;
+    era = ( z >= 0 ? z : z - 146096 ) / 146097;
+    doe = z - era * 146097;
+    yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    mp = ( 5 * doy + 2 ) / 153;
+    *d = doy - ( 153 * mp + 2 ) / 5 + 1;
+    *m = mp + ( mp < 10 ? 3 : -9 );
+    *y = yoe + era * 400 + ( *m <= 2 );
+}
+
+static int timestamp_set(timestamp_t *t, int year, int mon, int day,
+                         int hour, int min, int sec, int msec) {
+    if ( mon < 1 || mon > 12 || day < 1 || day > 31 ||
+         hour > 23 || min > 59 || sec > 60 ) return -1;
+    t->year = (uint32_t)year;
+    t->mon = (uint32_t)mon;
+    t->day = (uint32_t)day;
+    t->hour = (uint32_t)hour;
+    t->min = (uint32_t)min;
+    t->sec = (uint32_t)sec;
+    t->msec = (uint32_t)msec;
     return 0;
 }
+
+// any fraction of the second and the time zone offset (+hh:mm, +hhmm, +hh)
+static int timestamp_parse_iso(timestamp_t *t, const char *s) {
+    int year, mon, day, hour, min, sec;
+    int msec = 0;
+    int zone = 0;
+    int scale = 100;
+    int i;
+    for ( i = 0; i < 19; i++ ) {
+        if ( _ts_layout[i] == 'd' ? !is_digit(s[i]) : s[i] != _ts_layout[i] ) return -1;
+    }
+    year = dig4(s);
+    mon = dig2(s + 5);
+    day = dig2(s + 8);
+    hour = dig2(s + 11);
+    min = dig2(s + 14);
+    sec = dig2(s + 17);
+    s += 19;
+    if ( *s == '.' || *s == ',' ) {
+        s++;
+        if ( !is_digit(*s) ) return -1;
+        // the ms are the first three digits, the rest is cut
+        for ( ; is_digit(*s); s++ ) {
+            msec += dig(s, 0) * scale;
+            scale /= 10;
+        }
+    }
+    if ( *s == 'Z' ) {
+        s++;
+    } else if ( *s == '+' || *s == '-' ) {
+        int sign = *s++ == '-' ? -1 : 1;
+        if ( !is_digit(s[0]) || !is_digit(s[1]) ) return -1;
+        zone = dig2(s) * 60;
+        s += 2;
+        if ( *s == ':' ) s++;
+        if ( is_digit(s[0]) && is_digit(s[1]) ) {
+            zone += dig2(s);
+            s += 2;
+        }
+        if ( zone > 18 * 60 ) return -1;
+        zone *= sign;
+    } else {
+        return -1;
+    }
+    if ( *s ) return -1;
+    if ( zone ) {
+        int32_t days;
+        int32_t m;
+        if ( mon < 1 || mon > 12 || day < 1 || day > 31 || hour > 23 || min > 59 ) return -1;
+        days = days_from_civil(year, mon, day);
+        m = hour * 60 + min - zone;
+        if ( m < 0 ) {
+            m += 24 * 60;
+            days--;
+        } else if ( m >= 24 * 60 ) {
+            m -= 24 * 60;
+            days++;
+        }
+        civil_from_days(days, &year, &mon, &day);
+        hour = m / 60;
+        min = m % 60;
+    }
+    return timestamp_set(t, year, mon, day, hour, min, sec, msec);
+}
+
+// "2018-05-21T13:40:32.173Z", the other ISO 8601 forms go by the slow way
+int timestamp_parse(timestamp_t *t, const char *s) {
+    int i;
+    for ( i = 0; i < (int)TS_LAYOUT_LEN; i++ ) {
+        if ( _ts_layout[i] == 'd' ? !is_digit(s[i]) : s[i] != _ts_layout[i] ) break;
+    }
+    if ( i < (int)TS_LAYOUT_LEN || s[TS_LAYOUT_LEN] ) return timestamp_parse_iso(t, s);
+    return timestamp_set(t, dig4(s), dig2(s + 5), dig2(s + 8),
+                         dig2(s + 11), dig2(s + 14), dig2(s + 17),
+                         dig(s, 20) * 100 + dig2(s + 21));
+}
@@ -25,25 +25,42 @@ void log_free(log_t *gi) {
     if (gi->parameters) json_delete(gi->parameters);
 }
 
+int _log_parse(log_t *gl, JsonNode *tmp) {
+    log_init(gl);
+    who_when_parse(tmp, &gl->created, "createdDate", "createdBy");
+    json_fill_property(tmp, gl, productName);
+    json_fill_property(tmp, gl, type);
+    json_fill_property(tmp, gl, objectHid);
+    JsonNode *t = json_find_member(tmp, p_const("parameters"));
+    json_remove_from_parent(t);
+    gl->parameters = t;
+    return 0;
+}
+
 int log_parse(log_t **list, const char *text) {
     JsonNode *_main = json_decode(text);
     if ( !_main ) return -1;
     JsonNode *_data = parse_size_data(_main, NULL);
     if ( _data ) {
+        arrow_linked_list_head_t head;
+        arrow_linked_list_head_set(&head, *list ? &(*list)->node : NULL);
         JsonNode *tmp = NULL;
         json_foreach(tmp, _data) {
             log_t *gl = alloc_type(log_t);
-            log_init(gl);
-            who_when_parse(tmp, &gl->created, "createdDate", "createdBy");
-            json_fill_property(tmp, gl, productName);
-            json_fill_property(tmp, gl, type);
-            json_fill_property(tmp, gl, objectHid);
-            JsonNode *t = json_find_member(tmp, p_const("parameters"));
-            json_remove_from_parent(t);
-            gl->parameters = t;
-            arrow_linked_list_add_node_last(*list, log_t, gl);
+            _log_parse(gl, tmp);
+            arrow_linked_list_head_add_node_last(&head, gl);
         }
+        *list = arrow_linked_list_head_first(&head, log_t);
     }
     json_delete(_main);
     return 0;
 }
+
+int log_item(JsonNode *item, void *arg) {
+    log_each_t *le = (log_each_t *)arg;
+    log_t gl;
+    _log_parse(&gl, item);
+    int ret = le->cb(&gl, le->arg);
+    log_free(&gl);
+    return ret;
+}
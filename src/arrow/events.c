@@ -159,8 +159,8 @@ static int check_signature(const char *vers, const char *sing, mqtt_event_base_t
   return -1;
 }
 
-static mqtt_event_t *__event_queue = NULL;
-static mqtt_api_event_t *__api_event_queue = NULL;
+static arrow_linked_list_head_t __event_queue = ARROW_LINKED_LIST_HEAD_INIT;
+static arrow_linked_list_head_t __api_event_queue = ARROW_LINKED_LIST_HEAD_INIT;
 #if defined(ARROW_THREAD)
 static arrow_mutex *_event_mutex = NULL;
 #endif
@@ -178,19 +178,14 @@ void arrow_mqtt_events_init(void) {
 int arrow_mqtt_has_events(void) {
     int ret = -1;
     MQTT_EVENTS_QUEUE_LOCK;
-    if ( !__event_queue ) return 0;
-    ret = 0;
-    mqtt_event_t *tmp = NULL;
-    arrow_linked_list_for_each(tmp, __event_queue, mqtt_event_t) {
-        ret++;
-    }
+    ret = arrow_linked_list_head_size(&__event_queue);
     MQTT_EVENTS_QUEUE_UNLOCK;
     return ret;
 }
 
 int arrow_mqtt_event_proc(void) {
     mqtt_event_t *tmp = NULL;
-    tmp = __event_queue;
+    tmp = arrow_linked_list_head_first(&__event_queue, mqtt_event_t);
     if ( !tmp ) {
         return -1;
     }
@@ -211,7 +206,7 @@ int arrow_mqtt_event_proc(void) {
     }
 mqtt_event_proc_error:
     MQTT_EVENTS_QUEUE_LOCK;
-    arrow_linked_list_del_node_first(__event_queue, mqtt_event_t);
+    arrow_linked_list_head_del_node_first(&__event_queue);
     MQTT_EVENTS_QUEUE_UNLOCK;
     mqtt_event_free(tmp);
 #if defined(STATIC_MQTT_ENV)
@@ -219,30 +214,36 @@ mqtt_event_proc_error:
 #else
     free(tmp);
 #endif
-    if ( __event_queue && !ret ) ret = 1;
+    if ( arrow_linked_list_head_size(&__event_queue) && !ret ) ret = 1;
     return ret;
 }
 
 int arrow_mqtt_api_has_events(void) {
     int ret = -1;
     MQTT_EVENTS_QUEUE_LOCK;
-    if ( !__api_event_queue ) return 0;
-    ret = 0;
-    mqtt_api_event_t *tmp = NULL;
-    arrow_linked_list_for_each(tmp, __api_event_queue, mqtt_api_event_t) {
-        ret++;
-    }
+    ret = arrow_linked_list_head_size(&__api_event_queue);
     MQTT_EVENTS_QUEUE_UNLOCK;
     return ret;
 }
 
+const char *arrow_mqtt_api_event_id(void) {
+    const char *id = NULL;
+    MQTT_EVENTS_QUEUE_LOCK;
+    mqtt_api_event_t *first = arrow_linked_list_head_first(&__api_event_queue, mqtt_api_event_t);
+    if ( first ) id = P_VALUE(first->base.id);
+    MQTT_EVENTS_QUEUE_UNLOCK;
+    return id;
+}
+
 int arrow_mqtt_api_event_proc(http_response_t *res) {
     mqtt_api_event_t *tmp = NULL;
     int ret = -1;
-    tmp = __api_event_queue;
+    tmp = arrow_linked_list_head_first(&__api_event_queue, mqtt_api_event_t);
     if ( !tmp ) {
         return -1;
     }
+    // nobody waits for this answer
+    if ( !res ) goto mqtt_api_error;
 
     JsonNode *_parameters = tmp->base.parameters;
     JsonNode *status = json_find_member(_parameters, p_const("status"));
@@ -262,13 +263,13 @@ int arrow_mqtt_api_event_proc(http_response_t *res) {
 
     JsonNode *payload = json_find_member(_parameters, p_const("payload"));
     if ( payload ) {
-        http_response_add_payload(res, p_stack(payload));
+        http_response_add_payload(res, p_stack(payload->string_));
     }
     ret = 0;
 
 mqtt_api_error:
     MQTT_EVENTS_QUEUE_LOCK;
-    arrow_linked_list_del_node_first(__api_event_queue, mqtt_api_event_t);
+    arrow_linked_list_head_del_node_first(&__api_event_queue);
     MQTT_EVENTS_QUEUE_UNLOCK;
     mqtt_api_event_free(tmp);
 #if defined(STATIC_MQTT_ENV)
@@ -276,7 +277,7 @@ mqtt_api_error:
 #else
     free(tmp);
 #endif
-    if ( __api_event_queue ) ret = 1;
+    if ( !ret && arrow_linked_list_head_size(&__api_event_queue) ) ret = 1;
     return ret;
 }
 
@@ -287,8 +288,7 @@ static int api_mqtt_max_capacity = 0;
 int arrow_mqtt_api_wait(int num) {
     api_mqtt_max_capacity = num;
     while ( arrow_mqtt_api_has_events() > api_mqtt_max_capacity ) {
-        http_response_t dummy;
-        arrow_mqtt_api_event_proc(&dummy);
+        arrow_mqtt_api_event_proc(NULL);
     }
     return 0;
 }
@@ -407,7 +407,7 @@ int process_http_finish() {
         goto error;
     }
 
-    arrow_linked_list_add_node_last(__api_event_queue, mqtt_api_event_t, api_e);
+    arrow_linked_list_head_add_node_last(&__api_event_queue, api_e);
     DBG("http queue size %d", arrow_mqtt_api_has_events());
     ret = 0;
 error:
@@ -487,7 +487,7 @@ int process_event_finish() {
       goto error;
   }
   ret = 0;
-  arrow_linked_list_add_node_last(__event_queue, mqtt_event_t, mqtt_e);
+  arrow_linked_list_head_add_node_last(&__event_queue, mqtt_e);
 
 error:
   if ( ret < 0 ) {
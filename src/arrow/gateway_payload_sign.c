@@ -190,18 +190,20 @@ int gateway_payload_sign(char *signature,
                          const char *signatureVersion) {
   int ret = -1;
   // step 1
-  sha256_init();
-  sha256_chunk(hid, strlen(hid));
-  sha256_chunk("\n", 1);
-  sha256_chunk(name, strlen(name));
-  sha256_chunk("\n", 1);
+  acn_sha256_ctx sh;
+  acn_hmac_ctx hmac;
+  acn_sha256_init(&sh);
+  acn_sha256_update(&sh, hid, strlen(hid));
+  acn_sha256_update(&sh, "\n", 1);
+  acn_sha256_update(&sh, name, strlen(name));
+  acn_sha256_update(&sh, "\n", 1);
   if ( encrypted ) {
-      sha256_chunk("true\n", 5);
+      acn_sha256_update(&sh, "true\n", 5);
   } else {
-      sha256_chunk("false\n", 6);
+      acn_sha256_update(&sh, "false\n", 6);
   }
-  sha256_chunk(canParString, strlen(canParString));
-  sha256_chunk("\n", 1);
+  acn_sha256_update(&sh, canParString, strlen(canParString));
+  acn_sha256_update(&sh, "\n", 1);
 
   CREATE_CHUNK(hex_canreq, 66);
   CHECK_CHUNK(hex_canreq, goto hex_tmp_error);
@@ -209,7 +211,7 @@ int gateway_payload_sign(char *signature,
   CREATE_CHUNK(tmp, 34);
   CHECK_CHUNK(tmp, goto tmp_error);
 
-  sha256_fin(tmp);
+  acn_sha256_final(&sh, tmp);
   hex_encode(hex_canreq, tmp, 32);
   hex_canreq[64] = '\0';
 #if defined(DEBUG_GATEWAY_PAYLOAD_SIGN)
@@ -238,13 +240,13 @@ int gateway_payload_sign(char *signature,
 #if defined(DEBUG_GATEWAY_PAYLOAD_SIGN)
   DBG("hex2: [%d]%s", strlen(hex_tmp), hex_tmp);
 #endif
-  hmac256_init(hex_tmp, strlen(hex_tmp));
-  hmac256_chunk(hex_canreq, strlen(hex_canreq));
-  hmac256_chunk("\n", 1);
-  hmac256_chunk(get_api_key(), strlen(get_api_key()));
-  hmac256_chunk("\n", 1);
-  hmac256_chunk(signatureVersion, strlen(signatureVersion));
-  hmac256_fin(tmp);
+  acn_hmac256_init(&hmac, hex_tmp, strlen(hex_tmp));
+  acn_hmac256_update(&hmac, hex_canreq, strlen(hex_canreq));
+  acn_hmac256_update(&hmac, "\n", 1);
+  acn_hmac256_update(&hmac, get_api_key(), strlen(get_api_key()));
+  acn_hmac256_update(&hmac, "\n", 1);
+  acn_hmac256_update(&hmac, signatureVersion, strlen(signatureVersion));
+  acn_hmac256_final(&hmac, tmp);
 
   hex_encode(signature, tmp, 32);
   signature[64] = 0x0;
@@ -10,8 +10,12 @@
 #include <config.h>
 #include <mqtt/client/client.h>
 #include <json/telemetry.h>
+#include <json/cbor.h>
+#include <arrow/telemetry_filter.h>
 #include <data/property.h>
 #include <arrow/events.h>
+#include <arrow/reactor.h>
+#include <time/monotonic.h>
 #include <debug.h>
 
 #define MQTT_DBG(...)
@@ -69,13 +73,14 @@ extern mqtt_driver_t iot_driver;
 #endif
 #if defined(__AZURE__)
   extern mqtt_driver_t azure_driver;
+  extern int mqtt_password_refresh_azure(mqtt_env_t *env);
 #endif
 
 static void data_prep(MQTTPacket_connectData *data) {
   MQTTPacket_connectData d = MQTTPacket_connectData_initializer;
   *data = d;
   data->cleansession = MQTT_CLEAN_SESSION;
-  data->keepAliveInterval = 10;
+  data->keepAliveInterval = MQTT_KEEPALIVE;
 }
 
 static int _mqtt_init_common(mqtt_env_t *env) {
@@ -97,6 +102,9 @@ static int _mqtt_init_common(mqtt_env_t *env) {
   env->timeout = DEFAULT_MQTT_TIMEOUT;
   env->port = MQTT_PORT;
   env->init = 0;
+  env->format = mqtt_payload_json;
+  conn_supervisor_init(&env->sv, MQTT_KEEPALIVE, time_mono_ms());
+  mqtt_batch_init(&env->batch, 0, 0);
   arrow_linked_list_init(env);
   return 0;
 }
@@ -113,6 +121,7 @@ static int _mqtt_deinit_common(mqtt_env_t *env) {
 #endif
   property_free(&env->username);
   property_free(&env->addr);
+  mqtt_batch_free(&env->batch);
 #if !defined(STATIC_MQTT_ENV)
   free(env->buf.buf);
   free(env->readbuf.buf);
@@ -138,8 +147,35 @@ static void _mqtt_env_unset_init(mqtt_env_t *env, uint32_t init_mask) {
   env->init &= ~init_mask;
 }
 
+static int _mqtt_env_failed(mqtt_env_t *env, int ret) {
+  conn_supervisor_failed(&env->sv, time_mono_ms());
+  return ret;
+}
+
+// the client counts the keepalive down from the last packet of the broker,
+// the supervisor tells the dropped idle link by it; the Timer of the port
+// is read by its API only, an expired one is the whole keepalive ago
+static void _mqtt_env_lost(mqtt_env_t *env) {
+  uint32_t now = time_mono_ms();
+  if ( env->sv.state == conn_state_up && env->client.keepAliveInterval ) {
+    uint32_t idle = env->client.keepAliveInterval * 1000 -
+                    TimerLeftMS(&env->client.last_received);
+    conn_supervisor_traffic(&env->sv, now - idle);
+  }
+  conn_supervisor_lost(&env->sv, now);
+}
+
 static int _mqtt_env_connect(mqtt_env_t *env) {
   int ret = -1;
+  // connect again, so the previous session was lost
+  _mqtt_env_lost(env);
+  env->data.keepAliveInterval = conn_supervisor_keepalive(&env->sv);
+#if defined(__AZURE__)
+  // the SAS token is cached, a new one is made close to the expiry only
+  if ( env->mask == Azure_num && mqtt_password_refresh_azure(env) < 0 ) {
+    return _mqtt_env_failed(env, -1);
+  }
+#endif
   NetworkInit(&env->net);
   ret = NetworkConnect(&env->net,
                        P_VALUE(env->addr),
@@ -150,7 +186,7 @@ static int _mqtt_env_connect(mqtt_env_t *env) {
         P_VALUE(env->addr),
         env->port,
         ret);
-    return -1;
+    return _mqtt_env_failed(env, -1);
   }
   MQTTClientInit(&env->client,
                  &env->net,
@@ -161,13 +197,17 @@ static int _mqtt_env_connect(mqtt_env_t *env) {
   if ( ret != MQTT_SUCCESS ) {
     DBG("MQTT Connect fail %d", ret);
     NetworkDisconnect(&env->net);
-    return -1;
+    return _mqtt_env_failed(env, -1);
   }
+  conn_supervisor_connected(&env->sv, time_mono_ms());
   _mqtt_env_set_init(env, MQTT_CLIENT_INIT);
   return 0;
 }
 
 static int _mqtt_env_close(mqtt_env_t *env) {
+#if defined(ARROW_REACTOR)
+  arrow_reactor_del_mqtt(&env->client);
+#endif
   MQTTDisconnect(&env->client);
   NetworkDisconnect(&env->net);
   _mqtt_env_unset_init(env, MQTT_CLIENT_INIT);
@@ -271,13 +311,13 @@ int mqtt_telemetry_connect(arrow_gateway_t *gateway,
     int ret = drv->telemetry_init(tmp, &args);
     if ( ret < 0 ) {
       DBG("MQTT telemetry setting fail");
-      return ret;
+      return _mqtt_env_failed(tmp, ret);
     }
 #if defined(HTTP_VIA_MQTT)
     ret = drv->api_publish_init(tmp, &args);
     if ( ret < 0 ) {
       DBG("MQTT API publish setting fail");
-      return ret;
+      return _mqtt_env_failed(tmp, ret);
     }
 #endif
     _mqtt_env_set_init(tmp, MQTT_TELEMETRY_INIT);
@@ -325,7 +365,7 @@ static JsonNode *mqtt_pub_pay = NULL;
 static json_encode_machine_t em;
 
 
-int p_init() {
+static int p_init(void) {
     int len = json_size(mqtt_pub_pay);
     if ( json_encode_init(&em, mqtt_pub_pay) < 0 ) {
         return -1;
@@ -333,33 +373,205 @@ int p_init() {
     return len;
 }
 
-int p_part(char *ptr, int len) {
+static int p_part(char *ptr, int len) {
     int r = json_encode_part(&em, ptr, len);
     return r;
 }
 
-int p_fin() {
+static int p_fin(void) {
     int r = json_encode_fin(&em);
     return r;
 }
 
-mqtt_payload_drive_t mqtt_json_drive = {
+static mqtt_payload_drive_t mqtt_json_drive = {
     p_init,
     p_part,
     p_fin
 };
 
+static cbor_encode_machine_t cm;
+
+static int c_init(void) {
+    int len = cbor_size(mqtt_pub_pay);
+    if ( cbor_encode_init(&cm, mqtt_pub_pay) < 0 ) {
+        return -1;
+    }
+    return len;
+}
+
+static int c_part(char *ptr, int len) {
+    return cbor_encode_part(&cm, ptr, len);
+}
+
+static int c_fin(void) {
+    return cbor_encode_fin(&cm);
+}
+
+static mqtt_payload_drive_t mqtt_cbor_drive = {
+    c_init,
+    c_part,
+    c_fin
+};
+
+static mqtt_payload_drive_t *get_payload_drive(mqtt_env_t *env) {
+    switch(env->format) {
+    case mqtt_payload_cbor:
+        return &mqtt_cbor_drive;
+    default:
+        return &mqtt_json_drive;
+    }
+}
+
+int mqtt_telemetry_set_payload_format(mqtt_payload_format_t format) {
+    mqtt_env_t *tmp = get_telemetry_env();
+    if ( !tmp ) {
+        return -1;
+    }
+    tmp->format = (uint8_t)format;
+    return 0;
+}
+
+int mqtt_batch_init(mqtt_batch_t *b, int max_samples, int max_age) {
+    if ( !b ) return -1;
+    if ( max_samples < 0 ) max_samples = MQTT_BATCH_MAX_SAMPLES;
+    if ( max_age < 0 ) max_age = MQTT_BATCH_MAX_AGE;
+    b->samples = NULL;
+    b->count = 0;
+    b->max_samples = max_samples;
+    b->max_age = max_age;
+    TimerInit(&b->timer);
+    return 0;
+}
+
+void mqtt_batch_free(mqtt_batch_t *b) {
+    if ( b->samples ) json_delete(b->samples);
+    b->samples = NULL;
+    b->count = 0;
+}
+
+int mqtt_batch_is_ready(mqtt_batch_t *b) {
+    if ( !b->count ) return 0;
+    if ( b->count >= b->max_samples ) return 1;
+    if ( b->max_age > 0 && TimerIsExpired(&b->timer) ) return 1;
+    return 0;
+}
+
+int mqtt_batch_add(mqtt_batch_t *b, JsonNode *sample) {
+    if ( !sample ) return -1;
+    if ( !b->samples ) {
+        b->samples = json_mkarray();
+        if ( !b->samples ) {
+            json_delete(sample);
+            return -1;
+        }
+    }
+    if ( b->count && b->count >= b->max_samples ) {
+        // the last sending was failed, drop the oldest sample
+        json_delete(json_first_child(b->samples));
+        b->count--;
+    }
+    if ( !b->count ) TimerCountdownMS(&b->timer, b->max_age);
+    json_append_element(b->samples, sample);
+    b->count++;
+    return mqtt_batch_is_ready(b);
+}
+
+int mqtt_batch_publish(MQTTClient *c,
+                       const char *topic,
+                       mqtt_batch_t *b,
+                       mqtt_payload_format_t format) {
+    MQTTMessage msg = {MQTT_QOS, MQTT_RETAINED, MQTT_DUP, 0, NULL, 0};
+    if ( !b->count ) return 0;
+    mqtt_pub_pay = b->samples;
+    int ret = MQTTPublish_part(c,
+                               topic,
+                               &msg,
+                               format == mqtt_payload_cbor ?
+                                   &mqtt_cbor_drive : &mqtt_json_drive);
+    mqtt_pub_pay = NULL;
+    if ( ret < 0 ) {
+        // keep the samples for the next try
+        return ret;
+    }
+    mqtt_batch_free(b);
+    return ret;
+}
+
+int mqtt_telemetry_set_batch(int max_samples, int max_age) {
+    mqtt_env_t *tmp = get_telemetry_env();
+    if ( !tmp ) {
+        return -1;
+    }
+    mqtt_batch_free(&tmp->batch);
+    return mqtt_batch_init(&tmp->batch, max_samples, max_age);
+}
+
+int mqtt_publish_flush(void) {
+    mqtt_env_t *tmp = get_telemetry_env();
+    if ( !tmp ) {
+        return -1;
+    }
+    return mqtt_batch_publish(&tmp->client,
+                              P_VALUE(tmp->p_topic),
+                              &tmp->batch,
+                              (mqtt_payload_format_t)tmp->format);
+}
+
+int mqtt_publish_poll(void) {
+    mqtt_env_t *tmp = NULL;
+    // don't make the channel here, only the connected one has a batch to send
+    linked_list_find_node(tmp,
+                          __mqtt_channels,
+                          mqtt_env_t,
+                          mqttchannelseq,
+                          get_telemetry_mask() );
+    if ( !tmp || !_mqtt_env_is_init(tmp, MQTT_CLIENT_INIT) ) return 0;
+    if ( !mqtt_batch_is_ready(&tmp->batch) ) return 0;
+    return mqtt_batch_publish(&tmp->client,
+                              P_VALUE(tmp->p_topic),
+                              &tmp->batch,
+                              (mqtt_payload_format_t)tmp->format);
+}
+
 int mqtt_publish(arrow_device_t *device, void *d) {
     MQTTMessage msg = {MQTT_QOS, MQTT_RETAINED, MQTT_DUP, 0, NULL, 0};
     int ret = -1;
     mqtt_env_t *tmp = get_telemetry_env();
     if ( tmp ) {
-        mqtt_pub_pay = telemetry_serialize_json(device, d);
+        telemetry_filter_t *filter = telemetry_filter_find(device);
+        JsonNode *sample = NULL;
+        if ( filter && filter->value ) {
+            // nothing new in the raw sample, it isn't serialized
+            if ( telemetry_filter_check_data(filter, d, telemetry_filter_now()) ) return 0;
+            sample = telemetry_serialize_json(device, d);
+            telemetry_filter_strip(filter, sample);
+        } else {
+            sample = telemetry_serialize_json(device, d);
+            if ( filter &&
+                 telemetry_filter_check(filter, sample, telemetry_filter_now()) ) {
+                // nothing new in this sample
+                json_delete(sample);
+                return 0;
+            }
+        }
+        if ( tmp->batch.max_samples > 1 ) {
+            ret = mqtt_batch_add(&tmp->batch, sample);
+            if ( ret < 0 ) return ret;
+            // the batch keeps the sample until it is sent
+            telemetry_filter_commit(filter);
+            if ( ret > 0 ) {
+                ret = mqtt_publish_flush();
+            }
+            return ret;
+        }
+        mqtt_pub_pay = sample;
         ret = MQTTPublish_part(&tmp->client,
                                P_VALUE(tmp->p_topic),
                                &msg,
-                               &mqtt_json_drive);
-        json_delete(mqtt_pub_pay);
+                               get_payload_drive(tmp));
+        json_delete(sample);
+        mqtt_pub_pay = NULL;
+        if ( ret >= 0 ) telemetry_filter_commit(filter);
     }
     return ret;
 }
@@ -386,6 +598,11 @@ int mqtt_api_publish(JsonNode *data) {
 }
 #endif
 
+conn_supervisor_t *mqtt_telemetry_supervisor(void) {
+  mqtt_env_t *tmp = get_telemetry_env();
+  return tmp ? &tmp->sv : NULL;
+}
+
 int mqtt_is_telemetry_connect(void) {
   mqtt_env_t *tmp = get_telemetry_env();
   if ( tmp ) {
@@ -465,13 +682,13 @@ int mqtt_subscribe_connect(arrow_gateway_t *gateway,
     int ret = drv->commands_init(tmp, &args);
     if ( ret < 0 ) {
       DBG("MQTT subscribe setting fail");
-      return ret;
+      return _mqtt_env_failed(tmp, ret);
     }
 #if defined(HTTP_VIA_MQTT)
     ret = drv->api_subscribe_init(tmp, &args);
     if ( ret < 0 ) {
       DBG("MQTT API subscribe setting fail");
-      return ret;
+      return _mqtt_env_failed(tmp, ret);
     }
 #endif
     _mqtt_env_set_init(tmp, MQTT_SUBSCRIBE_INIT);
@@ -557,6 +774,11 @@ int mqtt_subscribe(void) {
   return 0;
 }
 
+conn_supervisor_t *mqtt_subscribe_supervisor(void) {
+  mqtt_env_t *tmp = get_event_env();
+  return tmp ? &tmp->sv : NULL;
+}
+
 int mqtt_is_subscribe_connect(void) {
   mqtt_env_t *tmp = get_event_env();
   if ( tmp ) {
@@ -568,13 +790,51 @@ int mqtt_is_subscribe_connect(void) {
 }
 #endif
 
+#if defined(ARROW_REACTOR)
+static void mqtt_reactor_event(MQTTClient *c, int rc, void *arg) {
+  mqtt_env_t *env = (mqtt_env_t *)arg;
+  if ( rc < 0 ) {
+    // the next publish fails and the routine reconnects
+    DBG("MQTT channel %08x is broken", (unsigned int)env->mask);
+    c->isconnected = 0;
+    _mqtt_env_lost(env);
+  }
+}
+
+int mqtt_reactor_attach(void) {
+  int ret = 0;
+  mqtt_env_t *curr = NULL;
+  arrow_linked_list_for_each(curr, __mqtt_channels, mqtt_env_t) {
+    if ( !_mqtt_env_is_init(curr, MQTT_CLIENT_INIT) ) continue;
+    if ( arrow_reactor_add_mqtt(&curr->client, mqtt_reactor_event, curr) < 0 ) ret = -1;
+  }
+  return ret;
+}
+
+void mqtt_reactor_detach(void) {
+  mqtt_env_t *curr = NULL;
+  arrow_linked_list_for_each(curr, __mqtt_channels, mqtt_env_t) {
+    arrow_reactor_del_mqtt(&curr->client);
+  }
+}
+#endif
+
 int mqtt_yield(int timeout_ms) {
+  // the batch could be old enough without the new samples
+  mqtt_publish_poll();
 #if !defined(NO_EVENTS)
   int ret = -1;
   mqtt_env_t *tmp = get_event_env();
   if ( tmp &&
        _mqtt_env_is_init(tmp, MQTT_SUBSCRIBE_INIT) &&
        _mqtt_env_is_init(tmp, MQTT_CLIENT_INIT) ) {
+#if defined(ARROW_REACTOR)
+    // the loop reads the attached channel and queues the events
+    if ( arrow_reactor_has_mqtt(&tmp->client) &&
+         arrow_reactor_run_for(timeout_ms) >= 0 ) {
+      return arrow_mqtt_has_events() ? MQTT_SUCCESS : FAILURE;
+    }
+#endif
     ret = MQTTYield(&tmp->client, timeout_ms);
     return ret;
   }
@@ -596,7 +856,14 @@ int mqtt_receive(int timeout_ms) {
   if ( tmp &&
        _mqtt_env_is_init(tmp, MQTT_SUBSCRIBE_INIT) &&
        _mqtt_env_is_init(tmp, MQTT_CLIENT_INIT) ) {
+#if defined(ARROW_REACTOR)
+    if ( arrow_reactor_has_mqtt(&tmp->client) &&
+         arrow_reactor_run_for(timeout_ms) >= 0 ) {
+      return arrow_mqtt_has_events() ? MQTT_SUCCESS : FAILURE;
+    }
+#endif
     do {
+      mqtt_publish_poll();
       ret = MQTTYield(&tmp->client, TimerLeftMS(&timer));
     } while (!TimerIsExpired(&timer));
     return ret;
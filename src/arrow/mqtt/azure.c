@@ -7,110 +7,103 @@
  */
 #if defined(__AZURE__)
 #include <arrow/mqtt.h>
-#include <arrow/sign.h>
+#include <arrow/sas_token.h>
+#include <arrow/reactor.h>
 #include <debug.h>
-#include <time/time.h>
-#include <arrow/utf8.h>
-#include <ssl/crypt.h>
-#include "wolfssl/wolfcrypt/coding.h"
 
 #define USE_STATIC
 #include <data/chunk.h>
 
-#ifndef SHA256_DIGEST_SIZE
-#define SHA256_DIGEST_SIZE 32
-#endif
-
-static int sas_token_gen(char *sas, char *devname, char *key, char *time_exp) {
-  char *dev = MQTT_ADDR "/devices/";
-  char common[256];
-  strcpy(common, dev);
-  strcat(common, devname);
-  strcat(common, "\n");
-  strcat(common, time_exp);
-  DBG("common string <%s>", common);
-  char hmacdig[SHA256_DIGEST_SIZE];
-
-  char decoded_key[100];
-  int decoded_key_len = 100;
-  DBG("decode key %d {%s}\r\n", strlen(key), key);
-  int ret = Base64_Decode((byte*)key, (word32)strlen(key), (byte*)decoded_key, (word32*)&decoded_key_len);
-  if ( ret ) return -1;
-
-  hmac256(hmacdig, decoded_key, decoded_key_len, common, strlen(common));
-
-  decoded_key_len = 100;
-  ret = Base64_Encode((byte*)hmacdig, SHA256_DIGEST_SIZE, (byte*)decoded_key, (word32*)&decoded_key_len);
-  if ( ret ) return -1;
-  decoded_key[decoded_key_len] = 0x0;
+#define AZURE_USERNAME_LEN  ( SAS_RESOURCE_LEN + 80 )
+#define AZURE_TOPIC_LEN     100
+#define AZURE_API_VERSION   "api-version=2016-11-14&DeviceClientType=iothubclient%2F1.1.7"
 
-  urlencode(sas, decoded_key, decoded_key_len-1);
+// the reconnections take the token from here
+static sas_token_t azure_sas;
+#if defined(ARROW_REACTOR)
+static int azure_sas_timer = -1;
+#endif
 
-  DBG("enc hmac [%s]\r\n", decoded_key);
-  return 0;
+static const char *azure_host(i_args *args) {
+    char *host = P_VALUE(args->config->host);
+    return host && *host ? host : MQTT_TELEMETRY_ADDR;
 }
 
-int mqtt_common_init_azure(mqtt_env_t *env, i_args *args) {
-    char username[100];
-    strcpy(username, config->host);
-    strcat(username, "/");
-    strcat(username, gateway->uid);
-    strcat(username, "/");
-    strcat(username, "api-version=2016-11-14&DeviceClientType=iothubclient%2F1.1.7");
-    DBG("qmtt.username %s", username);
-    property_copy(&env->username, p_stack(username));
-
-    char time_exp[32];
-    int time_len = sprintf(time_exp, "%ld", time(NULL) + 3600);
-    time_exp[time_len] = '\0';
-
-    char pass[256];
-    char sas[128];
-    if ( sas_token_gen(sas, gateway->uid, config->accessKey, time_exp) < 0) {
-      DBG("Fail SAS");
-      return -2;
+int mqtt_password_refresh_azure(mqtt_env_t *env) {
+    const char *token = sas_token_get(&azure_sas, time(NULL));
+    if ( !token ) {
+        DBG("Fail SAS");
+        return -1;
     }
+    env->data.password.cstring = (char *)token;
+    return 0;
+}
 
-    DBG("SAS: {%s}\r\n", sas);
-    strcpy(pass, "SharedAccessSignature sr=");
-    strcat(pass, config->host);
-    strcat(pass, "/devices/");
-    strcat(pass, gateway->uid);
-    strcat(pass, "&sig=");
-    strcat(pass, sas);
-    strcat(pass, "&se=");
-    strcat(pass, time_exp);
-    strcat(pass, "&skn=");
-
-    DBG("pass: %s\r\n", pass);
+static int mqtt_common_init_azure(mqtt_env_t *env, i_args *args) {
+    CREATE_CHUNK(username, AZURE_USERNAME_LEN);
+    const char *host = azure_host(args);
+    char *uid = P_VALUE(args->gateway->uid);
+    int ret = snprintf(username, AZURE_USERNAME_LEN,
+                       "%s/devices/%s", host, uid);
+    if ( ret < 0 || ret >= AZURE_USERNAME_LEN ) goto common_init_error;
+    // the key is decoded once for all the tokens of the device
+    if ( strcmp(azure_sas.resource, username) != 0 &&
+         sas_token_init(&azure_sas, username,
+                        P_VALUE(args->config->accessKey), SAS_TOKEN_TTL) < 0 ) {
+        goto common_init_error;
+    }
+    if ( mqtt_password_refresh_azure(env) < 0 ) goto common_init_error;
+#if defined(ARROW_REACTOR)
+    // the next token is made before the expiry out of the connection
+    if ( azure_sas_timer < 0 )
+        azure_sas_timer = arrow_reactor_timer_add(SAS_TOKEN_CHECK_MS, sas_token_timer, &azure_sas);
+#endif
 
-    data.willFlag = 0;
-    data.will.qos = 1;
-    data.MQTTVersion = 4;
-    data.clientID.cstring = gateway->uid;
-    data.username.cstring = username;
-    data.password.cstring = pass;
-    data.keepAliveInterval = 240;
-    data.cleansession = 0;
+    ret = snprintf(username, AZURE_USERNAME_LEN,
+                   "%s/%s/%s", host, uid, AZURE_API_VERSION);
+    if ( ret < 0 || ret >= AZURE_USERNAME_LEN ) goto common_init_error;
+    property_copy(&env->username, p_stack(username));
+    DBG("qmtt.username %s", username);
 
-    int rc;
-    NetworkInit(&mqtt_net);
-    char mqtt_addr[100];
-    strcpy(mqtt_addr, MQTT_ADDR);
-    DBG("azure addr: (%d)%s", strlen(mqtt_addr), mqtt_addr);
+    env->data.clientID.cstring = uid;
+    env->data.username.cstring = P_VALUE(env->username);
+    property_copy(&env->addr, p_stack(host));
+    FREE_CHUNK(username);
+    return 0;
 
+common_init_error:
+    FREE_CHUNK(username);
+    return -1;
 }
 
-int mqtt_telemetry_init_azure(mqtt_env_t *env, i_args *args) {
-    strcpy(p_topic, "devices/");
-    strcat(p_topic, gateway->uid);
-    strcat(p_topic, "/messages/events/");
+static int mqtt_telemetry_init_azure(mqtt_env_t *env, i_args *args) {
+    CREATE_CHUNK(p_topic, AZURE_TOPIC_LEN);
+    int ret = snprintf(p_topic, AZURE_TOPIC_LEN,
+                       "devices/%s/messages/events/",
+                       P_VALUE(args->gateway->uid));
+    if ( ret < 0 || ret >= AZURE_TOPIC_LEN ) {
+        FREE_CHUNK(p_topic);
+        return -1;
+    }
+    property_copy(&env->p_topic, p_stack(p_topic));
+    FREE_CHUNK(p_topic);
+    return 0;
 }
 
-int mqtt_subscribe_init_ibm(mqtt_env_t *env, i_args *args) {
-    strcpy(s_topic, "devices/");
-    strcat(s_topic, gateway->uid);
-    strcat(s_topic, "/messages/events/");
+// the commands come by the cloud-to-device topic; the old code subscribed
+// to its own messages/events/ (device-to-cloud) and never got them
+static int mqtt_subscribe_init_azure(mqtt_env_t *env, i_args *args) {
+    CREATE_CHUNK(s_topic, AZURE_TOPIC_LEN);
+    int ret = snprintf(s_topic, AZURE_TOPIC_LEN,
+                       "devices/%s/messages/devicebound/#",
+                       P_VALUE(args->gateway->uid));
+    if ( ret < 0 || ret >= AZURE_TOPIC_LEN ) {
+        FREE_CHUNK(s_topic);
+        return -1;
+    }
+    property_copy(&env->s_topic, p_stack(s_topic));
+    FREE_CHUNK(s_topic);
+    return 0;
 }
 
 mqtt_driver_t azure_driver = {
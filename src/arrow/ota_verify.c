@@ -0,0 +1,81 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "arrow/ota_verify.h"
+#include <sys/mem.h>
+#include <arrow/utf8.h>
+#include <debug.h>
+
+int ota_verify_init(ota_verify_t *v, const char *checksum, uint32_t max_size) {
+  memset(v, 0x0, sizeof(ota_verify_t));
+  if ( !checksum ) return -1;
+  switch ( strlen(checksum) ) {
+    case 2 * MD5_DIGEST_SIZE:
+      v->hash = ota_hash_md5;
+      v->digest_size = MD5_DIGEST_SIZE;
+      wc_InitMd5(&v->ctx.md5);
+    break;
+    case 2 * SHA256_DIGEST_SIZE:
+      v->hash = ota_hash_sha256;
+      v->digest_size = SHA256_DIGEST_SIZE;
+      acn_sha256_init(&v->ctx.sha256);
+    break;
+    default:
+      DBG("ota: unknown checksum [%s]", checksum);
+      return -1;
+  }
+  hex_decode(v->expected, checksum, v->digest_size);
+  v->max_size = max_size;
+  return 0;
+}
+
+int ota_verify_begin(ota_verify_t *v, uint32_t size) {
+  if ( v->max_size && size > v->max_size ) {
+    DBG("ota: image %u > %u", (unsigned int)size, (unsigned int)v->max_size);
+    return -1;
+  }
+  v->size = size;
+  return 0;
+}
+
+int ota_verify_update(ota_verify_t *v, const char *data, int len) {
+  v->received += (uint32_t)len;
+  if ( ( v->size && v->received > v->size ) ||
+       ( v->max_size && v->received > v->max_size ) ) {
+    DBG("ota: image overflow %u", (unsigned int)v->received);
+    return -1;
+  }
+  if ( v->hash == ota_hash_md5 ) wc_Md5Update(&v->ctx.md5, (const byte*)data, (word32)len);
+  else acn_sha256_update(&v->ctx.sha256, data, len);
+  return 0;
+}
+
+int ota_verify_final(ota_verify_t *v) {
+  char digest[32];
+  if ( v->hash == ota_hash_md5 ) wc_Md5Final(&v->ctx.md5, (byte*)digest);
+  else acn_sha256_final(&v->ctx.sha256, digest);
+  if ( v->size && v->received != v->size ) {
+    DBG("ota: image %u != %u", (unsigned int)v->received, (unsigned int)v->size);
+    return -1;
+  }
+  if ( memcmp(digest, v->expected, v->digest_size) ) {
+    DBG("ota: checksum failed");
+    return -2;
+  }
+  if ( ota_verify_signature(digest, v->digest_size) < 0 ) {
+    DBG("ota: signature failed");
+    return -3;
+  }
+  return 0;
+}
+
+int __attribute__((weak)) ota_verify_signature(const char *digest, int size) {
+  SSP_PARAMETER_NOT_USED(digest);
+  SSP_PARAMETER_NOT_USED(size);
+  return 0;
+}
@@ -0,0 +1,559 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "arrow/reactor.h"
+
+#if defined(ARROW_REACTOR)
+#include <http/client_mqtt.h>
+#include <debug.h>
+#include <time/timer_wheel.h>
+
+extern int keepalive(MQTTClient *c);
+extern int cycle_r(MQTTClient *c, TimerInterval *timer);
+
+typedef struct _reactor_io_ {
+  int sock;
+  uint32_t events;
+  arrow_reactor_io_f cb;
+  void *arg;
+} reactor_io_t;
+
+typedef struct _reactor_timer_ {
+  timer_node_t node;
+  uint8_t used;
+  int period;
+  arrow_reactor_timer_f cb;
+  void *arg;
+} reactor_timer_t;
+
+typedef struct _reactor_mqtt_ {
+  MQTTClient *c;
+  int timer;
+  arrow_reactor_mqtt_f cb;
+  void *arg;
+  // the network of the blocking client
+  int (*read)(Network *, unsigned char *, int, int);
+  int (*write)(Network *, unsigned char *, int, int);
+  int (*writev)(Network *, socket_iovec_t *, int, int);
+  // the received bytes in[in_pos, in_len), the packet is dispatched whole
+  uint8_t in[ARROW_REACTOR_MQTT_BUF];
+  int in_pos;
+  int in_len;
+  // the bytes to send when the socket is writable
+  uint8_t out[ARROW_REACTOR_MQTT_BUF];
+  int out_len;
+  // the TLS write of the not ready socket is repeated with the same length
+  int out_try;
+  uint8_t want_out;
+  uint8_t dispatch;
+} reactor_mqtt_t;
+
+typedef struct _reactor_http_ {
+  http_client_t *cli;
+  http_response_t *res;
+  int timer;
+  arrow_reactor_http_f cb;
+  void *arg;
+} reactor_http_t;
+
+static int _ps = -1;
+static int _stop = 0;
+static int _running = 0;
+static reactor_io_t _io[ARROW_REACTOR_SOCKETS];
+static reactor_timer_t _timers[ARROW_REACTOR_TIMERS];
+static timer_wheel_t _wheel;
+static reactor_mqtt_t _mqtt[ARROW_REACTOR_MQTT];
+static reactor_http_t _http[ARROW_REACTOR_SOCKETS];
+
+int arrow_reactor_init(void) {
+  int i;
+  if ( _ps >= 0 ) return 0;
+  _ps = sock_poll_create(ARROW_REACTOR_SOCKETS);
+  if ( _ps < 0 ) return -1;
+  for ( i = 0; i < ARROW_REACTOR_SOCKETS; i++ ) {
+    _io[i].sock = -1;
+    _http[i].cli = NULL;
+  }
+  for ( i = 0; i < ARROW_REACTOR_MQTT; i++ ) _mqtt[i].c = NULL;
+  memset(_timers, 0x0, sizeof(_timers));
+  timer_wheel_init(&_wheel, time_mono_ms());
+  _stop = 0;
+  return 0;
+}
+
+void arrow_reactor_done(void) {
+  sock_poll_close(_ps);
+  _ps = -1;
+}
+
+static reactor_io_t *io_find(int sock) {
+  int i;
+  for ( i = 0; i < ARROW_REACTOR_SOCKETS; i++ ) {
+    if ( _io[i].sock == sock ) return _io + i;
+  }
+  return NULL;
+}
+
+int arrow_reactor_add(int sock, uint32_t events, arrow_reactor_io_f cb, void *arg) {
+  if ( sock < 0 || !cb || io_find(sock) ) return -1;
+  reactor_io_t *io = io_find(-1);
+  if ( !io ) {
+    DBG("reactor: no free socket slot");
+    return -1;
+  }
+  if ( sock_poll_add(_ps, sock, events) < 0 ) return -1;
+  io->sock = sock;
+  io->events = events;
+  io->cb = cb;
+  io->arg = arg;
+  return 0;
+}
+
+int arrow_reactor_mod(int sock, uint32_t events) {
+  reactor_io_t *io = io_find(sock);
+  if ( sock < 0 || !io ) return -1;
+  if ( sock_poll_mod(_ps, sock, events) < 0 ) return -1;
+  io->events = events;
+  return 0;
+}
+
+int arrow_reactor_del(int sock) {
+  reactor_io_t *io = io_find(sock);
+  if ( sock < 0 || !io ) return -1;
+  io->sock = -1;
+  return sock_poll_del(_ps, sock);
+}
+
+int arrow_reactor_timer_add(int period_ms, arrow_reactor_timer_f cb, void *arg) {
+  int i;
+  if ( !cb ) return -1;
+  for ( i = 0; i < ARROW_REACTOR_TIMERS; i++ ) {
+    if ( !_timers[i].used ) {
+      reactor_timer_t *t = _timers + i;
+      t->used = 1;
+      t->period = period_ms > 0 ? period_ms : 1;
+      t->cb = cb;
+      t->arg = arg;
+      timer_wheel_add(&_wheel, &t->node, time_mono_ms() + (uint32_t)t->period);
+      return i;
+    }
+  }
+  DBG("reactor: no free timer");
+  return -1;
+}
+
+void arrow_reactor_timer_del(int timer) {
+  if ( timer < 0 || timer >= ARROW_REACTOR_TIMERS ) return;
+  timer_wheel_del(&_wheel, &_timers[timer].node);
+  _timers[timer].used = 0;
+}
+
+// MQTT channel
+
+static reactor_mqtt_t *mqtt_find(MQTTClient *c) {
+  int i;
+  for ( i = 0; i < ARROW_REACTOR_MQTT; i++ ) {
+    if ( _mqtt[i].c == c ) return _mqtt + i;
+  }
+  return NULL;
+}
+
+static reactor_mqtt_t *mqtt_net(Network *n) {
+  int i;
+  for ( i = 0; i < ARROW_REACTOR_MQTT; i++ ) {
+    if ( _mqtt[i].c && _mqtt[i].c->ipstack == n ) return _mqtt + i;
+  }
+  return NULL;
+}
+
+static int mqtt_block(reactor_mqtt_t *m, int on) {
+  return socket_nonblock(m->c->ipstack->my_socket, !on);
+}
+
+static int mqtt_want_out(reactor_mqtt_t *m, int on) {
+  if ( m->want_out == on ) return 0;
+  m->want_out = (uint8_t)on;
+  return arrow_reactor_mod(m->c->ipstack->my_socket,
+                           SOCK_POLL_IN | ( on ? SOCK_POLL_OUT : 0 ));
+}
+
+// send the queued bytes: 0 if all are sent, 1 if the socket isn't ready
+static int mqtt_flush(reactor_mqtt_t *m) {
+  while ( m->out_len ) {
+    int len = m->out_try ? m->out_try : m->out_len;
+    int rc = NetworkTryWrite(m->c->ipstack, m->out, len);
+    if ( rc < 0 ) return -1;
+    if ( !rc ) {
+      m->out_try = len;
+      return 1;
+    }
+    m->out_try = 0;
+    m->out_len -= rc;
+    memmove(m->out, m->out + rc, (size_t)m->out_len);
+  }
+  return 0;
+}
+
+static int mqtt_drain(reactor_mqtt_t *m) {
+  int rc = mqtt_flush(m);
+  if ( rc < 0 ) return -1;
+  return mqtt_want_out(m, rc);
+}
+
+// the client writes (the publish, the ack, the ping) are queued
+// if the socket isn't ready and sent by the loop
+static int mqtt_write(Network *n, unsigned char *buf, int len, int timeout_ms) {
+  reactor_mqtt_t *m = mqtt_net(n);
+  int sent = 0;
+  if ( !m ) return -1;
+  if ( !m->out_len ) {
+    sent = NetworkTryWrite(n, buf, len);
+    if ( sent < 0 ) return -1;
+    if ( sent == len ) return len;
+  }
+  if ( len - sent > ARROW_REACTOR_MQTT_BUF - m->out_len ) {
+    // no room: wait for the socket as the client out of the loop does
+    int rc = -1;
+    if ( mqtt_block(m, 1) < 0 ) return -1;
+    if ( !mqtt_flush(m) ) rc = m->write(n, buf + sent, len - sent, timeout_ms);
+    mqtt_block(m, 0);
+    if ( rc < 0 || mqtt_want_out(m, 0) < 0 ) return -1;
+    return sent + rc;
+  }
+  if ( !m->out_len && !sent ) m->out_try = len;
+  memcpy(m->out + m->out_len, buf + sent, (size_t)(len - sent));
+  m->out_len += len - sent;
+  return mqtt_want_out(m, 1) < 0 ? -1 : len;
+}
+
+// the loop dispatches the packet read already, the blocking call out of
+// the loop (the QoS1 publish, the subscribe) waits for the socket
+static int mqtt_read(Network *n, unsigned char *buf, int len, int timeout_ms) {
+  reactor_mqtt_t *m = mqtt_net(n);
+  int got;
+  int rc = -1;
+  if ( !m ) return -1;
+  got = m->in_len - m->in_pos;
+  if ( got > len ) got = len;
+  memcpy(buf, m->in + m->in_pos, (size_t)got);
+  m->in_pos += got;
+  if ( got == len ) return len;
+  if ( m->dispatch ) return -1;
+  if ( mqtt_block(m, 1) < 0 ) return -1;
+  if ( !mqtt_flush(m) ) rc = m->read(n, buf + got, len - got, timeout_ms);
+  mqtt_block(m, 0);
+  if ( mqtt_want_out(m, m->out_len > 0) < 0 ) return -1;
+  return rc == len - got ? len : -1;
+}
+
+// read what the socket has: -1 on error, 1 if the buffer is full
+static int mqtt_fill(reactor_mqtt_t *m) {
+  if ( m->in_pos ) {
+    m->in_len -= m->in_pos;
+    memmove(m->in, m->in + m->in_pos, (size_t)m->in_len);
+    m->in_pos = 0;
+  }
+  while ( m->in_len < ARROW_REACTOR_MQTT_BUF ) {
+    int rc = NetworkTryRead(m->c->ipstack, m->in + m->in_len,
+                            ARROW_REACTOR_MQTT_BUF - m->in_len);
+    if ( rc < 0 ) return -1;
+    if ( !rc ) return 0;
+    m->in_len += rc;
+  }
+  return 1;
+}
+
+// the length of the whole packet in the buffer, 0 if it isn't whole yet
+static int mqtt_packet_len(reactor_mqtt_t *m) {
+  const uint8_t *p = m->in + m->in_pos;
+  int got = m->in_len - m->in_pos;
+  int rem_len = 0;
+  int multiplier = 1;
+  int i;
+  for ( i = 1; i < got && i <= 4; i++ ) {
+    rem_len += ( p[i] & 127 ) * multiplier;
+    multiplier *= 128;
+    if ( !( p[i] & 128 ) ) {
+      int len = 1 + i + rem_len;
+      if ( len > ARROW_REACTOR_MQTT_BUF ) return -1;
+      return len <= got ? len : 0;
+    }
+  }
+  return i > 4 ? -1 : 0;
+}
+
+static int mqtt_dispatch(reactor_mqtt_t *m) {
+  int len;
+  while ( m->c && ( len = mqtt_packet_len(m) ) > 0 ) {
+    TimerInterval timer;
+    int end = m->in_pos + len;
+    int rc;
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, m->c->command_timeout_ms);
+    m->dispatch = 1;
+    rc = cycle_r(m->c, &timer);
+    m->dispatch = 0;
+    m->in_pos = end;
+    if ( rc < 0 ) return -1;
+    if ( m->cb ) m->cb(m->c, rc, m->arg);
+  }
+  return m->c ? len : 0;
+}
+
+static void mqtt_fail(reactor_mqtt_t *m) {
+  MQTTClient *c = m->c;
+  arrow_reactor_mqtt_f cb = m->cb;
+  void *arg = m->arg;
+  // the broken socket doesn't get the rest
+  m->out_len = 0;
+  arrow_reactor_del_mqtt(c);
+  DBG("reactor: mqtt channel %d fail", c->ipstack->my_socket);
+  if ( cb ) cb(c, -1, arg);
+}
+
+static int mqtt_io(int sock, uint32_t events, void *arg) {
+  reactor_mqtt_t *m = (reactor_mqtt_t *)arg;
+  int full = 0;
+  SSP_PARAMETER_NOT_USED(sock);
+  if ( ( events & SOCK_POLL_OUT ) && mqtt_drain(m) < 0 ) {
+    mqtt_fail(m);
+    return 0;
+  }
+  if ( !( events & ( SOCK_POLL_IN | SOCK_POLL_ERR ) ) ) return 0;
+  do {
+    // the TLS records are read till WANT_READ, nothing stays in wolfSSL
+    full = mqtt_fill(m);
+    if ( full < 0 || mqtt_dispatch(m) < 0 ) {
+      if ( m->c ) mqtt_fail(m);
+      return 0;
+    }
+  } while ( full > 0 && m->c );
+  return 0;
+}
+
+static int mqtt_tick(void *arg) {
+  reactor_mqtt_t *m = (reactor_mqtt_t *)arg;
+  if ( keepalive(m->c) != MQTT_SUCCESS ) {
+    mqtt_fail(m);
+    return -1;
+  }
+  return 0;
+}
+
+int arrow_reactor_add_mqtt(MQTTClient *c, arrow_reactor_mqtt_f cb, void *arg) {
+  if ( !c || !c->isconnected || mqtt_find(c) ) return -1;
+  reactor_mqtt_t *m = mqtt_find(NULL);
+  Network *n = c->ipstack;
+  if ( !m ) return -1;
+  if ( socket_nonblock(n->my_socket, 1) < 0 ) return -1;
+  m->timer = -1;
+  if ( c->keepAliveInterval ) {
+    m->timer = arrow_reactor_timer_add(ARROW_REACTOR_KEEPALIVE_TICK, mqtt_tick, m);
+    if ( m->timer < 0 ) goto add_mqtt_error;
+  }
+  if ( arrow_reactor_add(n->my_socket, SOCK_POLL_IN, mqtt_io, m) < 0 ) {
+    arrow_reactor_timer_del(m->timer);
+    goto add_mqtt_error;
+  }
+  m->in_pos = m->in_len = 0;
+  m->out_len = m->out_try = 0;
+  m->want_out = 0;
+  m->dispatch = 0;
+  m->read = n->mqttread;
+  m->write = n->mqttwrite;
+  m->writev = n->mqttwritev;
+  n->mqttread = mqtt_read;
+  n->mqttwrite = mqtt_write;
+  // the publish is gathered into the client buffer or queued
+  n->mqttwritev = NULL;
+  m->c = c;
+  m->cb = cb;
+  m->arg = arg;
+  return 0;
+add_mqtt_error:
+  socket_nonblock(n->my_socket, 0);
+  return -1;
+}
+
+int arrow_reactor_del_mqtt(MQTTClient *c) {
+  reactor_mqtt_t *m = mqtt_find(c);
+  if ( !c || !m ) return -1;
+  Network *n = c->ipstack;
+  arrow_reactor_timer_del(m->timer);
+  arrow_reactor_del(n->my_socket);
+  // the client goes on blocking, the queued bytes are sent first
+  socket_nonblock(n->my_socket, 0);
+  if ( mqtt_flush(m) ) DBG("reactor: mqtt channel %d lost %d bytes", n->my_socket, m->out_len);
+  n->mqttread = m->read;
+  n->mqttwrite = m->write;
+  n->mqttwritev = m->writev;
+  m->c = NULL;
+  return 0;
+}
+
+int arrow_reactor_has_mqtt(MQTTClient *c) {
+  return c && mqtt_find(c) ? 1 : 0;
+}
+
+// REST call
+
+static void http_finish(reactor_http_t *h, int status) {
+  http_client_t *cli = h->cli;
+  arrow_reactor_http_f cb = h->cb;
+  void *arg = h->arg;
+  arrow_reactor_timer_del(h->timer);
+  if ( cli->protocol == api_via_http ) arrow_reactor_del(cli->sock);
+  h->cli = NULL;
+  if ( cb ) cb(status, cli, h->res, arg);
+}
+
+static int http_io(int sock, uint32_t events, void *arg) {
+  reactor_http_t *h = (reactor_http_t *)arg;
+  int ret = -1;
+  SSP_PARAMETER_NOT_USED(sock);
+  if ( events & SOCK_POLL_IN ) {
+    ret = default_http_client_receive(h->cli, h->res);
+  }
+  http_finish(h, ret < 0 ? -1 : 0);
+  return 0;
+}
+
+static int http_expired(void *arg) {
+  reactor_http_t *h = (reactor_http_t *)arg;
+  DBG("reactor: http timeout");
+  h->timer = -1;
+  http_finish(h, -1);
+  return -1;
+}
+
+#if defined(HTTP_VIA_MQTT)
+static void http_mqtt_done(int status, http_response_t *res, void *arg) {
+  SSP_PARAMETER_NOT_USED(res);
+  http_finish((reactor_http_t *)arg, status);
+}
+#endif
+
+int arrow_reactor_http(http_client_t *cli,
+                       http_response_t *res,
+                       arrow_reactor_http_f cb,
+                       void *arg) {
+  int i;
+  reactor_http_t *h = NULL;
+  if ( !cli || !res ) return -1;
+  for ( i = 0; i < ARROW_REACTOR_SOCKETS; i++ ) {
+    if ( !_http[i].cli ) {
+      h = _http + i;
+      break;
+    }
+  }
+  if ( !h ) return -1;
+  h->res = res;
+  h->cb = cb;
+  h->arg = arg;
+  h->timer = -1;
+#if defined(HTTP_VIA_MQTT)
+  if ( cli->protocol == api_via_mqtt ) {
+    if ( http_mqtt_client_send(cli, res, http_mqtt_done, h) < 0 ) return -1;
+    h->cli = cli;
+    return 0;
+  }
+#endif
+  if ( default_http_client_send(cli, res) < 0 ) return -1;
+  if ( arrow_reactor_add(cli->sock, SOCK_POLL_IN, http_io, h) < 0 ) return -1;
+  h->timer = arrow_reactor_timer_add((int)cli->timeout, http_expired, h);
+  if ( h->timer < 0 ) {
+    arrow_reactor_del(cli->sock);
+    return -1;
+  }
+  h->cli = cli;
+  return 0;
+}
+
+// loop
+
+static int reactor_has_work(void) {
+  int i;
+  for ( i = 0; i < ARROW_REACTOR_SOCKETS; i++ ) {
+    if ( _io[i].sock >= 0 || _http[i].cli ) return 1;
+  }
+  return _wheel.count > 0;
+}
+
+static int timers_run(void) {
+  int served = 0;
+  uint32_t now = time_mono_ms();
+  timer_node_t *n;
+  while ( ( n = timer_wheel_expired(&_wheel, now) ) ) {
+    reactor_timer_t *t = (reactor_timer_t *)n;
+    arrow_reactor_timer_f cb = t->cb;
+    void *arg = t->arg;
+    served++;
+    int ret = cb(arg);
+    // the callback may delete this one or add another timer here
+    if ( !t->used || timer_wheel_pending(n) || t->cb != cb || t->arg != arg ) continue;
+    if ( ret < 0 ) {
+      t->used = 0;
+    } else {
+      timer_wheel_add(&_wheel, n, time_mono_ms() + (uint32_t)t->period);
+    }
+  }
+  return served;
+}
+
+int arrow_reactor_run_once(int timeout_ms) {
+  sock_poll_event_t ev[ARROW_REACTOR_SOCKETS];
+  int i;
+  if ( _ps < 0 ) return -1;
+  int n = sock_poll_wait(_ps, ev, ARROW_REACTOR_SOCKETS,
+                         timer_wheel_next_ms(&_wheel, time_mono_ms(), timeout_ms));
+  if ( n < 0 ) return -1;
+  _running++;
+  for ( i = 0; i < n; i++ ) {
+    int ret;
+    do {
+      reactor_io_t *io = io_find(ev[i].sock);
+      if ( !io ) break;
+      ret = io->cb(io->sock, ev[i].events, io->arg);
+      if ( ret < 0 ) arrow_reactor_del(ev[i].sock);
+    } while ( ret > 0 );
+  }
+#if defined(HTTP_VIA_MQTT)
+  if ( http_mqtt_client_pending() ) http_mqtt_client_dispatch();
+#endif
+  n += timers_run();
+  _running--;
+  return n;
+}
+
+int arrow_reactor_run_for(int timeout_ms) {
+  uint32_t end = time_mono_ms() + (uint32_t)( timeout_ms > 0 ? timeout_ms : 0 );
+  int served = 0;
+  // not from a callback of the loop
+  if ( _ps < 0 || _running ) return -1;
+  for (;;) {
+    int left = (int)( end - time_mono_ms() );
+    int n = arrow_reactor_run_once(left > 0 ? left : 0);
+    if ( n < 0 ) return -1;
+    served += n;
+    if ( left <= 0 ) break;
+  }
+  return served;
+}
+
+int arrow_reactor_run(void) {
+  _stop = 0;
+  while ( !_stop && reactor_has_work() ) {
+    if ( arrow_reactor_run_once(ARROW_REACTOR_KEEPALIVE_TICK) < 0 ) return -1;
+  }
+  return 0;
+}
+
+void arrow_reactor_stop(void) {
+  _stop = 1;
+}
+#endif
@@ -13,6 +13,9 @@
 #include <arrow/api/device/device.h>
 #include <arrow/telemetry_api.h>
 #include <arrow/storage.h>
+#include <arrow/supervisor.h>
+#include <arrow/reactor.h>
+#include <time/monotonic.h>
 #include <json/property_json.h>
 
 #define GATEWAY_CONNECT "Gateway connection [%s]"
@@ -26,6 +29,7 @@ static arrow_gateway_t _gateway;
 static arrow_gateway_config_t _gateway_config;
 static arrow_device_t _device;
 static int _init_done = 0;
+static conn_supervisor_t _api_supervisor;
 
 enum MQTT_INIT_FLAGS {
   MQTT_INIT_TELEMETRY_ROUTINE = 0x01,
@@ -33,6 +37,35 @@ enum MQTT_INIT_FLAGS {
 };
 static int _init_mqtt = 0;
 
+static conn_supervisor_t *api_supervisor(void) {
+  if ( !_api_supervisor.rnd ) conn_supervisor_init(&_api_supervisor, 0, time_mono_ms());
+  return &_api_supervisor;
+}
+
+// the wait serves the event loop if there is one (ARROW_REACTOR),
+// so the other channels aren't blocked by the backoff
+static void routine_wait(uint32_t ms) {
+#if defined(ARROW_REACTOR)
+  if ( arrow_reactor_run_for((int)ms) >= 0 ) return;
+#endif
+  msleep(ms);
+}
+
+// the API request failed, wait the backoff of the supervisor
+static void api_retry_wait(void) {
+  routine_wait(conn_supervisor_failed(api_supervisor(), time_mono_ms()));
+}
+
+static void api_retry_done(void) {
+  conn_supervisor_connected(api_supervisor(), time_mono_ms());
+}
+
+// the MQTT channel counts its connection attempts itself
+static void mqtt_retry_wait(conn_supervisor_t *sv) {
+  if ( sv ) routine_wait(conn_supervisor_wait_ms(sv, time_mono_ms()));
+  else routine_wait(ARROW_RETRY_DELAY);
+}
+
 arrow_device_t *current_device(void) {
   return &_device;
 }
@@ -115,8 +148,9 @@ arrow_routine_error_t arrow_gateway_initialize_routine(void) {
   while ( arrow_connect_gateway(&_gateway) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(GATEWAY_CONNECT, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    api_retry_wait();
   }
+  api_retry_done();
   DBG(GATEWAY_CONNECT, "ok");
   http_session_close_set(current_client(), true);
   wdt_feed();
@@ -124,8 +158,9 @@ arrow_routine_error_t arrow_gateway_initialize_routine(void) {
   while ( arrow_gateway_config(&_gateway, &_gateway_config) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(GATEWAY_CONFIG, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    api_retry_wait();
   }
+  api_retry_done();
   DBG(GATEWAY_CONFIG, "ok");
   _init_done = 1;
   return ROUTINE_SUCCESS;
@@ -139,8 +174,9 @@ arrow_routine_error_t arrow_initialize_routine(void) {
   while ( arrow_connect_gateway(&_gateway) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(GATEWAY_CONNECT, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    api_retry_wait();
   }
+  api_retry_done();
   DBG(GATEWAY_CONNECT, "ok");
 
   wdt_feed();
@@ -148,8 +184,9 @@ arrow_routine_error_t arrow_initialize_routine(void) {
   while ( arrow_gateway_config(&_gateway, &_gateway_config) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(GATEWAY_CONFIG, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    api_retry_wait();
   }
+  api_retry_done();
   DBG(GATEWAY_CONFIG, "ok");
 
   // device registaration
@@ -161,8 +198,9 @@ arrow_routine_error_t arrow_initialize_routine(void) {
   while ( arrow_connect_device(&_gateway, &_device) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(DEVICE_CONNECT, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    api_retry_wait();
   }
+  api_retry_done();
   DBG(DEVICE_CONNECT, "ok");
   _init_done = 1;
   return ROUTINE_SUCCESS;
@@ -190,8 +228,9 @@ arrow_routine_error_t arrow_send_telemetry_routine(void *data) {
   while ( arrow_send_telemetry(&_device, data) < 0) {
     RETRY_UP(retry, {return ROUTINE_ERROR;});
     DBG(DEVICE_TELEMETRY, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    api_retry_wait();
   }
+  api_retry_done();
   DBG(DEVICE_TELEMETRY, "ok");
   return ROUTINE_SUCCESS;
 }
@@ -206,7 +245,7 @@ arrow_routine_error_t arrow_mqtt_connect_telemetry_routine(void) {
   while ( mqtt_telemetry_connect(&_gateway, &_device, &_gateway_config) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_MQTT_CONNECT_FAILED;});
     DBG(DEVICE_MQTT_CONNECT, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    mqtt_retry_wait(mqtt_telemetry_supervisor());
   }
   _init_mqtt |= MQTT_INIT_TELEMETRY_ROUTINE;
   DBG(DEVICE_MQTT_CONNECT, "ok");
@@ -240,7 +279,7 @@ arrow_routine_error_t arrow_mqtt_connect_event_routine(void) {
   while(mqtt_subscribe_connect(&_gateway, &_device, &_gateway_config) < 0 ) {
     RETRY_UP(retry, {return ROUTINE_MQTT_SUBSCRIBE_FAILED;});
     DBG(DEVICE_MQTT_CONNECT, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    mqtt_retry_wait(mqtt_subscribe_supervisor());
   }
   _init_mqtt |= MQTT_INIT_COMMAND_ROUTINE;
   return ROUTINE_SUCCESS;
@@ -250,7 +289,7 @@ arrow_routine_error_t arrow_mqtt_subscribe_event_routine(void) {
   while( mqtt_subscribe() < 0 ) {
     RETRY_UP(retry, {return ROUTINE_MQTT_SUBSCRIBE_FAILED;});
     DBG(DEVICE_MQTT_CONNECT, "fail");
-    msleep(ARROW_RETRY_DELAY);
+    routine_wait(ARROW_RETRY_DELAY);
     _init_mqtt &= ~MQTT_INIT_COMMAND_ROUTINE;
   }
   _init_mqtt |= MQTT_INIT_COMMAND_ROUTINE;
@@ -380,7 +419,8 @@ arrow_routine_error_t arrow_mqtt_telemetry_routine(get_data_cb data_cb, void *da
   }
   wdt_feed();
   while (1) {
-    msleep(TELEMETRY_DELAY);
+    routine_wait(TELEMETRY_DELAY);
+    mqtt_publish_poll();
     int get_data_result = data_cb(data);
     if ( get_data_result < 0 ) {
       DBG(DEVICE_MQTT_TELEMETRY, "Fail to get telemetry data");
@@ -434,7 +474,7 @@ arrow_routine_error_t arrow_mqtt_event_receive_routine() {
   }
 #if defined(NO_EVENTS)
   int ret = MQTT_SUCCESS;
-  msleep(TELEMETRY_DELAY);
+  routine_wait(TELEMETRY_DELAY);
 #else
   int ret = mqtt_yield(TELEMETRY_DELAY);
 #endif
@@ -0,0 +1,124 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include <arrow/sas_token.h>
+#include <arrow/utf8.h>
+#include <debug.h>
+#include "wolfssl/wolfcrypt/coding.h"
+
+#define SAS_PREFIX      "SharedAccessSignature sr="
+#define SAS_SIG         "&sig="
+#define SAS_SE          "&se="
+#define SAS_KEY_LEN     96
+// Base64 of the SHA256 digest
+#define SAS_SIG_B64_LEN 44
+#define SAS_SE_LEN      20
+
+#define SAS_CONST_LEN(x) ( (int)sizeof(x) - 1 )
+
+static int u_to_str(char *s, unsigned long v) {
+    char tmp[SAS_SE_LEN];
+    int n = 0;
+    int i;
+    do {
+        tmp[n++] = (char)( '0' + v % 10 );
+        v /= 10;
+    } while ( v );
+    for ( i = 0; i < n; i++ ) s[i] = tmp[n - 1 - i];
+    s[n] = 0x0;
+    return n;
+}
+
+int sas_token_init(sas_token_t *t, const char *resource, const char *key, uint32_t ttl) {
+    char decoded[SAS_KEY_LEN];
+    word32 decoded_len = sizeof(decoded);
+    int rlen;
+    memset(t, 0x0, sizeof(sas_token_t));
+    if ( !resource || !key ) return -1;
+    rlen = (int)strlen(resource);
+    // the signature may be urlencoded in full
+    if ( rlen >= SAS_RESOURCE_LEN ||
+         SAS_CONST_LEN(SAS_PREFIX) + rlen + SAS_CONST_LEN(SAS_SIG) + 3 * SAS_SIG_B64_LEN +
+         SAS_CONST_LEN(SAS_SE) + SAS_SE_LEN >= SAS_TOKEN_LEN ) {
+        DBG("SAS: the resource is too long %d", rlen);
+        return -1;
+    }
+    if ( Base64_Decode((const byte*)key, (word32)strlen(key),
+                       (byte*)decoded, &decoded_len) ) {
+        DBG("SAS: wrong key");
+        return -1;
+    }
+    acn_hmac256_init(&t->key, decoded, (int)decoded_len);
+    memset(decoded, 0x0, sizeof(decoded));
+    memcpy(t->resource, resource, (size_t)rlen + 1);
+    t->ttl = ttl ? ttl : SAS_TOKEN_TTL;
+    t->margin = SAS_TOKEN_MARGIN < t->ttl ? SAS_TOKEN_MARGIN : t->ttl / 4;
+    return 0;
+}
+
+static int sas_token_build(sas_token_t *t, time_t now) {
+    acn_hmac_ctx ctx = t->key;
+    char se[SAS_SE_LEN];
+    char hmacdig[SHA256_DIGEST_SIZE];
+    char sig[SAS_SIG_B64_LEN + 4];
+    word32 sig_len = sizeof(sig);
+    int rlen = (int)strlen(t->resource);
+    time_t expiry = now + (time_t)t->ttl;
+    int se_len = u_to_str(se, (unsigned long)expiry);
+    char *p = t->token;
+
+    acn_hmac256_update(&ctx, t->resource, rlen);
+    acn_hmac256_update(&ctx, "\n", 1);
+    acn_hmac256_update(&ctx, se, se_len);
+    acn_hmac256_final(&ctx, hmacdig);
+    if ( Base64_Encode_NoNl((const byte*)hmacdig, SHA256_DIGEST_SIZE,
+                            (byte*)sig, &sig_len) ) return -1;
+
+    memcpy(p, SAS_PREFIX, SAS_CONST_LEN(SAS_PREFIX));
+    p += SAS_CONST_LEN(SAS_PREFIX);
+    memcpy(p, t->resource, (size_t)rlen);
+    p += rlen;
+    memcpy(p, SAS_SIG, SAS_CONST_LEN(SAS_SIG));
+    p += SAS_CONST_LEN(SAS_SIG);
+    urlencode(p, sig, (int)sig_len);
+    p += strlen(p);
+    memcpy(p, SAS_SE, SAS_CONST_LEN(SAS_SE));
+    p += SAS_CONST_LEN(SAS_SE);
+    memcpy(p, se, (size_t)se_len + 1);
+    p += se_len;
+
+    t->len = (int)( p - t->token );
+    t->expiry = expiry;
+    return 0;
+}
+
+int sas_token_refresh(sas_token_t *t, time_t now) {
+    if ( !t->ttl ) return -1;
+    if ( t->len && now + (time_t)t->margin < t->expiry ) return 0;
+    if ( sas_token_build(t, now) < 0 ) {
+        t->len = 0;
+        return -1;
+    }
+    return 1;
+}
+
+const char *sas_token_get(sas_token_t *t, time_t now) {
+    if ( sas_token_refresh(t, now) < 0 ) return NULL;
+    return t->token;
+}
+
+int sas_token_timer(void *arg) {
+    sas_token_t *t = (sas_token_t *)arg;
+    // the failed one is tried again by the next tick or the connection
+    sas_token_refresh(t, time(NULL));
+    return 0;
+}
+
+void sas_token_free(sas_token_t *t) {
+    memset(t, 0x0, sizeof(sas_token_t));
+}
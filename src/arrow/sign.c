@@ -81,13 +81,14 @@ void sign(char *signature,
           const char *canQueryString,
           const char *payload,
           const char *apiVersion) {
-    sha256_init();
-    sha256_chunk(P_VALUE(*meth), property_size(meth));
-    sha256_chunk("\n", 1);
-    sha256_chunk(uri, strlen(uri));
-    sha256_chunk("\n", 1);
+    acn_sha256_ctx sh;
+    acn_sha256_init(&sh);
+    acn_sha256_update(&sh, P_VALUE(*meth), property_size(meth));
+    acn_sha256_update(&sh, "\n", 1);
+    acn_sha256_update(&sh, uri, strlen(uri));
+    acn_sha256_update(&sh, "\n", 1);
     if (canQueryString) {
-        sha256_chunk(canQueryString, strlen(canQueryString));
+        acn_sha256_update(&sh, canQueryString, strlen(canQueryString));
     }
 
     CREATE_CHUNK(hex_hash_payload, 66);
@@ -100,10 +101,10 @@ void sign(char *signature,
       strcpy(hex_hash_payload, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"); // pre calculated null string hash
     }
 
-    sha256_chunk(hex_hash_payload, 64);
+    acn_sha256_update(&sh, hex_hash_payload, 64);
 //    DBG_SIGN("<caninical request>%s<end>", canonicalRequest);
 
-    sha256_fin(hash_payload);
+    acn_sha256_final(&sh, hash_payload);
     hex_encode(hex_hash_payload, hash_payload, 32);
     hex_hash_payload[64] = '\0';
     DBG_SIGN("hashed canonical request: %s", hex_hash_payload);
@@ -124,16 +125,17 @@ void sign(char *signature,
     hmac256(tmp, apiVersion, (int)strlen(apiVersion), signKey, 64);
     hex_encode(signKey, tmp, 32);
     DBG_SIGN("step 3: %s", signKey);
-    hmac256_init(signKey, 64);
-    hmac256_chunk(hex_hash_payload, 64);
-    hmac256_chunk("\n", 1);
-    hmac256_chunk(get_api_key(), strlen(get_api_key()));
-    hmac256_chunk("\n", 1);
-    hmac256_chunk(timestamp, strlen(timestamp));
-    hmac256_chunk("\n", 1);
-    hmac256_chunk(apiVersion, strlen(apiVersion));
+    acn_hmac_ctx hmac;
+    acn_hmac256_init(&hmac, signKey, 64);
+    acn_hmac256_update(&hmac, hex_hash_payload, 64);
+    acn_hmac256_update(&hmac, "\n", 1);
+    acn_hmac256_update(&hmac, get_api_key(), strlen(get_api_key()));
+    acn_hmac256_update(&hmac, "\n", 1);
+    acn_hmac256_update(&hmac, timestamp, strlen(timestamp));
+    acn_hmac256_update(&hmac, "\n", 1);
+    acn_hmac256_update(&hmac, apiVersion, strlen(apiVersion));
 //    DBG_SIGN("<string to sign>%s<end>", canonicalRequest);
-    hmac256_fin(tmp);
+    acn_hmac256_final(&hmac, tmp);
     hex_encode(signature, tmp, 32);
     FREE_CHUNK(hex_hash_payload);
     FREE_CHUNK(tmp);
@@ -151,10 +153,19 @@ static void get_canonical_string(char *buffer, http_request_t *req){
     }
 }
 
+// the header values are copied if the sign is called from several threads
+#if defined(HTTP_THREAD)
+# define SIGN_BUF
+# define p_sign(x)  p_stack(x)
+#else
+# define SIGN_BUF   static
+# define p_sign(x)  p_const(x)
+#endif
+
 void sign_request(http_request_t *req) {
     timestamp_t timest;
-    static char ts[25];
-    static char signature[70];
+    SIGN_BUF char ts[25];
+    SIGN_BUF char signature[70];
     char *canonicalQuery = NULL;
     if ( req->query ) {
       canonicalQuery = (char*)malloc(SIGN_BUFFER_LEN);
@@ -169,7 +180,7 @@ void sign_request(http_request_t *req) {
     }
     http_request_add_header(req,
                             p_const("x-arrow-date"),
-                            p_const(ts));
+                            p_sign(ts));
     http_request_add_header(req,
                             p_const("x-arrow-version"),
                             p_const("1"));
@@ -182,7 +193,7 @@ void sign_request(http_request_t *req) {
 
     http_request_add_header(req,
                             p_const("x-arrow-signature"),
-                            p_const(signature));
+                            p_sign(signature));
     http_request_set_content_type(req, p_const("application/json"));
     http_request_add_header(req,
                             p_const("Accept"),
@@ -190,9 +201,11 @@ void sign_request(http_request_t *req) {
     http_request_add_header(req,
                             p_const("Connection"),
                             p_const("Keep-Alive"));
+#if !defined(HTTP_NO_INFLATE)
     http_request_add_header(req,
                             p_const("Accept-Encoding"),
                             p_const("gzip, deflate"));
+#endif
     http_request_add_header(req,
                             p_const("User-Agent"),
                             p_const("Eos"));
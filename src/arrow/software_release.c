@@ -11,7 +11,7 @@
 #include <debug.h>
 #include <sys/watchdog.h>
 #include <sys/reboot.h>
-#include <ssl/md5sum.h>
+#include <arrow/ota_verify.h>
 #include <arrow/utf8.h>
 #include <time/time.h>
 #include <data/chunk.h>
@@ -197,7 +197,9 @@ int ev_DeviceSoftwareRelease(void *_ev, JsonNode *_parameters) {
   tmp = json_find_member(_parameters, p_const("toSoftwareVersion"));
   if ( !tmp || tmp->tag != JSON_STRING ) goto software_release_done;
   char *_to = tmp->string_;
-  tmp = json_find_member(_parameters, p_const("md5checksum"));
+  // the SHA-256 one if the platform sends it
+  tmp = json_find_member(_parameters, p_const("sha256checksum"));
+  if ( !tmp || tmp->tag != JSON_STRING ) tmp = json_find_member(_parameters, p_const("md5checksum"));
   if ( !tmp || tmp->tag != JSON_STRING ) goto software_release_done;
   char *_checksum = tmp->string_;
   wdt_feed();
@@ -265,6 +267,7 @@ int arrow_software_release_set_cb(__release_cb cb) {
 typedef struct _token_hid_ {
   const char *token;
   const char *hid;
+  ota_verify_t *verify;
 } token_hid_t;
 
 
@@ -280,20 +283,29 @@ int arrow_software_release_dowload_set_cb(
 }
 
 // this is a special payload handler for the OTA
+// the image is checked by the pieces on the way to the __payload
 int arrow_software_release_payload_handler(void *r,
                                            property_t payload) {
   http_response_t *res = (http_response_t *)r;
+  ota_verify_t *v = (ota_verify_t *)res->_p_meth._p_arg;
   int flag = FW_FIRST;
-  if ( __payload ) {
+  if ( __payload && v ) {
       wdt_feed();
       if ( ! res->processed_payload_chunk ) {
-          md5_chunk_init();
+          if ( res->m_httpResponseCode != 200 ) return -1;
+          // the decoded image is longer than the Content-Length
+          uint32_t size = res->is_chunked || res->content_coding ? 0 : res->recvContentLength;
+          if ( ota_verify_begin(v, size) < 0 ) goto payload_size_fail;
       } else
           flag |= FW_NEXT;
-      md5_chunk(payload.value, property_size(&payload));
+      if ( ota_verify_update(v, payload.value, property_size(&payload)) < 0 )
+          goto payload_size_fail;
       return __payload(payload.value, property_size(&payload), flag);
   }
   return -1;
+payload_size_fail:
+  if ( __download ) __download(FW_SIZE);
+  return -1;
 }
 
 static void _software_releases_download_init(http_request_t *request, void *arg) {
@@ -304,27 +316,25 @@ static void _software_releases_download_init(http_request_t *request, void *arg)
   uri[n] = 0x0;
   http_request_init(request, GET, uri);
   request->_response_payload_meth._p_add_handler = arrow_software_release_payload_handler;
+  request->_response_payload_meth._p_arg = th->verify;
   FREE_CHUNK(uri);
   wdt_feed();
 }
 
 static int _software_releases_download_proc(http_response_t *response, void *arg) {
-    SSP_PARAMETER_NOT_USED(response);
-    SSP_PARAMETER_NOT_USED(arg);
-    char *checksum = (char *)arg;
+    ota_verify_t *v = (ota_verify_t *)arg;
     wdt_feed();
     if ( response->m_httpResponseCode != 200 ) return -1;
     if ( __download ) {
-        char hash[18];
-        char hash_hex[34];
-        int size = md5_chunk_hash(hash);
-        hex_encode(hash_hex, hash, size);
-        hash_hex[2*size] = 0x0;
-        DBG("fw hash cmp {%s, %s}", checksum, hash_hex);
-        if ( strncmp(hash_hex, checksum, 2*size) == 0 ) {
+        switch ( ota_verify_final(v) ) {
+        case 0:
             return __download(FW_SUCCESS);
-        } else {
-            DBG("fw md5 checksum failed...");
+        case -1:
+            return __download(FW_SIZE);
+        case -3:
+            return __download(FW_SIGNATURE);
+        default:
+            DBG("fw checksum failed...");
             return __download(FW_MD5SUM);
         }
     }
@@ -332,8 +342,10 @@ static int _software_releases_download_proc(http_response_t *response, void *arg
 }
 
 int arrow_software_release_download(const char *token, const char *tr_hid, const char *checksum) {
-  token_hid_t th = { token, tr_hid };
-  STD_ROUTINE(_software_releases_download_init, &th, _software_releases_download_proc, (void*)checksum, "File download fail");
+  ota_verify_t v;
+  token_hid_t th = { token, tr_hid, &v };
+  if ( ota_verify_init(&v, checksum, ARROW_OTA_MAX_SIZE) < 0 ) return -1;
+  STD_ROUTINE(_software_releases_download_init, &th, _software_releases_download_proc, &v, "File download fail");
 }
 
 // schedules
@@ -2,12 +2,14 @@
 #include <time/time.h>
 #include <http/client.h>
 #include <json/json.h>
+#include <json/property_json.h>
 #include <sys/mem.h>
 #include <http/routine.h>
 #include <arrow/events.h>
 #include <debug.h>
 #include <data/chunk.h>
 #include <arrow/api/json/parse.h>
+#include <time/monotonic.h>
 #include <stdarg.h>
 
 typedef struct _state_list_ {
@@ -19,6 +21,14 @@ typedef struct _state_list_ {
         double _number;
     } value;
     timestamp_t ts;
+    // the hash table chain
+    struct _state_list_ *hnext;
+    uint32_t hash;
+    // the version is bumped by every change, the dirty state is
+    // clean again when the posted version is the current one
+    uint16_t version;
+    uint16_t posted;
+    uint8_t dirty;
     arrow_linked_list_head_node;
 } arrow_state_list_t;
 
@@ -34,25 +44,80 @@ static_object_pool_type(arrow_state_list_t, ARROW_MAX_DEVICE_STATES)
 
 #define is_valid_tag(t) (( t & JSON_BOOL ) || ( t & JSON_STRING ) || ( t & JSON_NUMBER ))
 
-static arrow_state_list_t *__state_list = NULL;
+#define STATE_HASH_MASK ( ARROW_STATE_HASH_SIZE - 1 )
+#if ( ARROW_STATE_HASH_SIZE & STATE_HASH_MASK )
+# error "ARROW_STATE_HASH_SIZE must be a power of 2"
+#endif
+
+static arrow_linked_list_head_t __state_list = ARROW_LINKED_LIST_HEAD_INIT;
+static arrow_state_list_t *__state_hash[ARROW_STATE_HASH_SIZE] = {0};
 static property_t _device_hid = {0};
 static timestamp_t _last_modify = {0};
+// the dirty states and the time of the first one
+static int _dirty_count = 0;
+static uint32_t _dirty_since = 0;
 
 typedef void(*_state_add_f_)(arrow_state_list_t *st, void *d);
-typedef JsonNode*(*_state_json_f_)(arrow_state_list_t *st);
+typedef void(*_state_emit_f_)(SB *out, arrow_state_list_t *st);
 typedef int(*_state_parse_f_)(arrow_state_list_t *st, const char *);
 typedef void(*_state_free_f_)(arrow_state_list_t *st);
+typedef int(*_state_eq_f_)(arrow_state_list_t *st, void *d);
 
 typedef struct _state_handle_ {
     _state_add_f_   add;
-    _state_json_f_  json;
+    _state_emit_f_  emit;
     _state_parse_f_ parse;
     _state_free_f_  free;
+    _state_eq_f_    eq;
 } state_handle_t;
 
-static int stateeq( arrow_state_list_t *sl, property_t name ) {
-    if ( property_cmp(&sl->name, &name) == 0 ) return 0;
-    return -1;
+// FNV-1a
+static uint32_t state_hash(property_t *name) {
+    const char *s = P_VALUE(*name);
+    size_t len = property_size(name);
+    uint32_t h = 2166136261UL;
+    while ( len-- ) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+static arrow_state_list_t *state_find(property_t name) {
+    if ( IS_EMPTY(name) ) return NULL;
+    uint32_t h = state_hash(&name);
+    arrow_state_list_t *st = __state_hash[h & STATE_HASH_MASK];
+    while ( st ) {
+        if ( st->hash == h && property_cmp(&st->name, &name) == 0 ) return st;
+        st = st->hnext;
+    }
+    return NULL;
+}
+
+static void state_hash_add(arrow_state_list_t *st) {
+    st->hash = state_hash(&st->name);
+    st->hnext = __state_hash[st->hash & STATE_HASH_MASK];
+    __state_hash[st->hash & STATE_HASH_MASK] = st;
+}
+
+static void state_set_dirty(arrow_state_list_t *st) {
+    st->version++;
+    if ( st->dirty ) return;
+    st->dirty = 1;
+    if ( !_dirty_count++ ) _dirty_since = time_mono_ms();
+}
+
+// the posted states are clean unless they were changed after the serialization
+static void state_set_posted(void) {
+    arrow_state_list_t *tmp = NULL;
+    arrow_linked_list_head_for_each( tmp, &__state_list , arrow_state_list_t ) {
+        if ( tmp->dirty && tmp->posted == tmp->version ) {
+            tmp->dirty = 0;
+            _dirty_count--;
+        }
+    }
+    // the rest wait for the next window
+    if ( _dirty_count ) _dirty_since = time_mono_ms();
 }
 
 // id d is NULL add a default value
@@ -62,9 +127,12 @@ static void state_add_bool(arrow_state_list_t *st, void *d) {
     st->value._bool = data;
 }
 
-static JsonNode *state_value_bool_json(arrow_state_list_t *st) {
-    JsonNode *j = json_mkbool(st->value._bool);
-    return j;
+static void state_value_bool_emit(SB *out, arrow_state_list_t *st) {
+    sb_puts(out, st->value._bool ? "true" : "false");
+}
+
+static int state_value_bool_eq(arrow_state_list_t *st, void *d) {
+    return st->value._bool == *((bool*)d);
 }
 
 static int state_value_bool_parse(arrow_state_list_t *st, const char *s) {
@@ -81,9 +149,12 @@ static void state_add_number(arrow_state_list_t *st, void *d) {
     st->value._number = data;
 }
 
-static JsonNode *state_value_number_json(arrow_state_list_t *st) {
-    JsonNode *j = json_mknumber(st->value._number);
-    return j;
+static void state_value_number_emit(SB *out, arrow_state_list_t *st) {
+    json_emit_number(out, st->value._number);
+}
+
+static int state_value_number_eq(arrow_state_list_t *st, void *d) {
+    return st->value._number == *((double*)d);
 }
 
 static int state_value_number_parse(arrow_state_list_t *st, const char *s) {
@@ -96,13 +167,20 @@ static void state_value_string_add(arrow_state_list_t *st, void *d) {
         st->value._property = p_null();
     } else {
         property_t *p = (property_t *)d;
+        property_free(&st->value._property);
         property_move(&st->value._property, p);
     }
 }
 
-static JsonNode *state_value_string_json(arrow_state_list_t *st) {
-    JsonNode *j = json_mkstring(P_VALUE(st->value._property));
-    return j;
+static void state_value_string_emit(SB *out, arrow_state_list_t *st) {
+    json_emit_string(out, IS_EMPTY(st->value._property) ? "" : P_VALUE(st->value._property));
+}
+
+static int state_value_string_eq(arrow_state_list_t *st, void *d) {
+    property_t *p = (property_t *)d;
+    if ( IS_EMPTY(st->value._property) || IS_EMPTY(*p) )
+        return IS_EMPTY(st->value._property) && IS_EMPTY(*p);
+    return property_cmp(p, &st->value._property) == 0;
 }
 
 static int state_value_string_parse(arrow_state_list_t *st, const char *s) {
@@ -119,15 +197,20 @@ static void state_value_string_free(arrow_state_list_t *st) {
 
 state_handle_t state_adder[] = {
     {NULL, NULL},
-    {state_add_bool, state_value_bool_json, state_value_bool_parse, NULL},
-    {state_value_string_add, state_value_string_json, state_value_string_parse, state_value_string_free},
-    {state_add_number, state_value_number_json, state_value_number_parse, NULL}
+    {state_add_bool, state_value_bool_emit, state_value_bool_parse, NULL, state_value_bool_eq},
+    {state_value_string_add, state_value_string_emit, state_value_string_parse, state_value_string_free, state_value_string_eq},
+    {state_add_number, state_value_number_emit, state_value_number_parse, NULL, state_value_number_eq}
 };
 
 void arrow_device_state_list_init(arrow_state_list_t *st) {
     property_init(&st->name);
     st->value._property = p_null();
     memset(&st->ts, 0x0, sizeof(timestamp_t));
+    st->hnext = NULL;
+    st->hash = 0;
+    st->version = 0;
+    st->posted = 0;
+    st->dirty = 0;
     arrow_linked_list_init(st);
 }
 
@@ -143,11 +226,12 @@ int arrow_device_state_handler(JsonNode *_main) __attribute__((weak));
 void arrow_device_state_add(property_t name,
                             JsonTag tag,
                             void *value) {
-    arrow_state_list_t *dev_state = NULL;
-    linked_list_find_node( dev_state, __state_list, arrow_state_list_t, stateeq, name );
+    arrow_state_list_t *dev_state = state_find(name);
     if ( dev_state ) {
         if ( is_valid_tag(tag) && state_adder[tag].add ) {
+            int changed = !state_adder[tag].eq(dev_state, value);
             state_adder[tag].add(dev_state, value);
+            if ( changed ) state_set_dirty(dev_state);
             timestamp(&dev_state->ts);
             _last_modify = dev_state->ts;
         }
@@ -172,7 +256,8 @@ void arrow_device_state_init(int n, ...) {
       if ( is_valid_tag(tmp.typetag) && state_adder[tmp.typetag].add ) {
           state_adder[tmp.typetag].add(state, NULL);
       }
-      arrow_linked_list_add_node_last(__state_list, arrow_state_list_t, state);
+      arrow_linked_list_head_add_node_last(&__state_list, state);
+      state_hash_add(state);
     }
     va_end(args);
 }
@@ -195,20 +280,22 @@ void arrow_device_state_set_bool(property_t name,
 
 void arrow_device_state_free(void) {
     arrow_state_list_t *tmp = NULL;
-    arrow_linked_list_for_each_safe( tmp, __state_list , arrow_state_list_t ) {
+    arrow_linked_list_head_for_each_safe( tmp, &__state_list , arrow_state_list_t ) {
         arrow_device_state_list_free(tmp);
         FREE(tmp);
     }
-    __state_list = NULL;
+    arrow_linked_list_head_init(&__state_list);
+    memset(__state_hash, 0x0, sizeof(__state_hash));
+    _dirty_count = 0;
 }
 
 int arrow_state_mqtt_is_running(void) {
-  if ( !__state_list ) return -1;
+  if ( !arrow_linked_list_head_size(&__state_list) ) return -1;
   return 0;
 }
 
 int arrow_state_mqtt_stop(void) {
-  if (__state_list) arrow_device_state_free();
+  if ( arrow_linked_list_head_size(&__state_list) ) arrow_device_state_free();
   property_free(&_device_hid);
   return 0;
 }
@@ -267,8 +354,43 @@ typedef enum {
 typedef struct _post_dev_ {
   arrow_device_t *device;
   int post;
+  int delta;
 } post_dev_t;
 
+// {"states":{"name":value,...},"timestamp":"..."} straight into the buffer,
+// the delta has the dirty states only
+static property_t state_payload(int delta) {
+  SB sb;
+  int first = 1;
+  if ( sb_init(&sb) < 0 ) return p_null();
+  sb_puts(&sb, "{\"states\":{");
+  arrow_state_list_t *tmp = NULL;
+  arrow_linked_list_head_for_each( tmp, &__state_list , arrow_state_list_t ) {
+      if ( delta && !tmp->dirty ) continue;
+      if ( is_valid_tag(tmp->tag) && state_adder[tmp->tag].emit ) {
+          if ( !first ) sb_putc(&sb, ',');
+          first = 0;
+          json_emit_string(&sb, P_VALUE(tmp->name));
+          sb_putc(&sb, ':');
+          state_adder[tmp->tag].emit(&sb, tmp);
+          tmp->posted = tmp->version;
+      }
+  }
+  sb_putc(&sb, '}');
+  if ( !timestamp_is_empty(&_last_modify) ) {
+      char ts[30];
+      timestamp_string(&_last_modify, ts);
+      sb_puts(&sb, ",\"timestamp\":");
+      json_emit_string(&sb, ts);
+  }
+  sb_putc(&sb, '}');
+  if ( !sb_is_valid(&sb) ) {
+      sb_free(&sb);
+      return p_null();
+  }
+  return p_json(sb_finish(&sb));
+}
+
 static void _state_post_init(http_request_t *request, void *arg) {
   post_dev_t *pd = (post_dev_t *)arg;
   CREATE_CHUNK(uri, sizeof(ARROW_API_DEVICE_ENDPOINT) + P_SIZE(pd->device->hid) + 20);
@@ -289,44 +411,38 @@ static void _state_post_init(http_request_t *request, void *arg) {
   }
   FREE_CHUNK(uri);
   http_request_init(request, POST, uri);
-  JsonNode *_main = NULL;
-  JsonNode *_states = NULL;
-  _main = json_mkobject();
-  _states = json_mkobject();
-
-  arrow_state_list_t *tmp = NULL;
-  arrow_linked_list_for_each( tmp, __state_list , arrow_state_list_t ) {
-      JsonNode *value = NULL;
-      if ( is_valid_tag(tmp->tag) && state_adder[tmp->tag].json ) {
-          value = state_adder[tmp->tag].json(tmp);
-          json_append_member(_states, tmp->name, value);
-      }
-  }
-  json_append_member(_main, p_const("states"), _states);
+  http_request_set_payload(request, state_payload(pd->delta));
+}
 
-  if ( !timestamp_is_empty(&_last_modify) ) {
-      char ts[30];
-      timestamp_string(&_last_modify, ts);
-      json_append_member(_main, p_const("timestamp"), json_mkstring(ts));
+static int _arrow_post_state(arrow_device_t *device, _st_post_api post_type, int delta) {
+  post_dev_t pd = {device, post_type, delta};
+  int ret = __http_routine(_state_post_init, &pd, NULL, NULL);
+  if ( ret < 0 ) {
+      DBG("Error: State post failed...");
+      return ret;
   }
+  state_set_posted();
+  return ret;
+}
 
-  http_request_set_payload(request, json_encode_property(_main));
-  json_delete(_main);
+int arrow_post_state_request(arrow_device_t *device) {
+  return _arrow_post_state(device, st_request, 0);
 }
 
-static int _arrow_post_state(arrow_device_t *device, _st_post_api post_type) {
-  post_dev_t pd = {device, post_type};
-  STD_ROUTINE(_state_post_init, &pd,
-              NULL, NULL,
-              "State post failed...");
+int arrow_post_state_update(arrow_device_t *device) {
+  return _arrow_post_state(device, st_update, 0);
 }
 
-int arrow_post_state_request(arrow_device_t *device) {
-  return _arrow_post_state(device, st_request);
+int arrow_post_state_delta(arrow_device_t *device) {
+  if ( !_dirty_count ) return 0;
+  return _arrow_post_state(device, st_update, 1);
 }
 
-int arrow_post_state_update(arrow_device_t *device) {
-  return _arrow_post_state(device, st_update);
+int arrow_device_state_sync(arrow_device_t *device) {
+  if ( !_dirty_count ) return 0;
+  int32_t left = ARROW_STATE_COALESCE_MS - time_mono_diff(time_mono_ms(), _dirty_since);
+  if ( left > 0 ) return left;
+  return arrow_post_state_delta(device);
 }
 
 
@@ -346,8 +462,7 @@ typedef struct _put_dev_ {
 int arrow_device_state_handler(JsonNode *_main) {
   JsonNode *tmp = NULL;
   json_foreach(tmp, _main) {
-      arrow_state_list_t *dev_state = NULL;
-      linked_list_find_node( dev_state, __state_list, arrow_state_list_t, stateeq, tmp->key );
+      arrow_state_list_t *dev_state = state_find(tmp->key);
       if ( !dev_state ) {
           DBG("No such state on device %s", P_VALUE(tmp->key));
           continue;
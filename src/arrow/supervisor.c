@@ -0,0 +1,116 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "arrow/supervisor.h"
+#include <sys/mem.h>
+#include <sys/rand.h>
+#include <time/monotonic.h>
+#include <debug.h>
+
+// xorshift32, every supervisor has its own sequence
+static uint32_t next_rand(conn_supervisor_t *s) {
+  uint32_t x = s->rnd;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  s->rnd = x;
+  return x;
+}
+
+static uint32_t backoff_cap(uint32_t failures) {
+  uint32_t cap = ARROW_RETRY_DELAY;
+  while ( --failures && cap < ARROW_RETRY_MAX_DELAY ) cap <<= 1;
+  return cap < ARROW_RETRY_MAX_DELAY ? cap : ARROW_RETRY_MAX_DELAY;
+}
+
+void conn_supervisor_init(conn_supervisor_t *s, uint16_t keepalive, uint32_t now) {
+  memset(s, 0x0, sizeof(conn_supervisor_t));
+  s->state = conn_state_retry;
+  s->keepalive = keepalive;
+  s->next_at = now;
+  s->down_since = now;
+  // the murmur3 finalizer, the close seeds give the different sequences
+  uint32_t x = (uint32_t)rand() ^ now ^ (uint32_t)(uintptr_t)s;
+  x ^= x >> 16;
+  x *= 0x85ebca6b;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35;
+  x ^= x >> 16;
+  s->rnd = x ? x : 0x9e3779b9;
+}
+
+int conn_supervisor_wait_ms(conn_supervisor_t *s, uint32_t now) {
+  if ( s->state == conn_state_up ) return 0;
+  int left = time_mono_diff(s->next_at, now);
+  return left > 0 ? left : 0;
+}
+
+int conn_supervisor_failed(conn_supervisor_t *s, uint32_t now) {
+  uint32_t delay;
+  s->metrics.attempts++;
+  s->attempts++;
+  s->failures++;
+  if ( s->state == conn_state_open || s->failures >= ARROW_BREAKER_FAILURES ) {
+    // the probe failed or too many failures: wait [open/2, open]
+    if ( s->state != conn_state_open ) DBG("connection breaker open after %u failures", (unsigned int)s->failures);
+    s->state = conn_state_open;
+    s->metrics.trips++;
+    delay = ARROW_BREAKER_OPEN / 2 + next_rand(s) % ( ARROW_BREAKER_OPEN / 2 + 1 );
+  } else {
+    s->state = conn_state_retry;
+    delay = next_rand(s) % ( backoff_cap(s->failures) + 1 );
+  }
+  s->next_at = now + delay;
+  return (int)delay;
+}
+
+void conn_supervisor_connected(conn_supervisor_t *s, uint32_t now) {
+  s->metrics.attempts++;
+  s->attempts++;
+  if ( s->was_up ) {
+    uint32_t latency = now - s->down_since;
+    s->metrics.reconnects++;
+    s->metrics.last_latency = latency;
+    if ( latency > s->metrics.max_latency ) s->metrics.max_latency = latency;
+    s->metrics.last_attempts = s->attempts;
+  }
+  s->state = conn_state_up;
+  s->was_up = 1;
+  s->failures = 0;
+  s->attempts = 0;
+  s->up_since = now;
+  s->traffic_at = now;
+}
+
+void conn_supervisor_traffic(conn_supervisor_t *s, uint32_t at) {
+  if ( s->state != conn_state_up ) return;
+  if ( time_mono_diff(at, s->traffic_at) > 0 ) s->traffic_at = at;
+}
+
+void conn_supervisor_lost(conn_supervisor_t *s, uint32_t now) {
+  if ( s->state != conn_state_up ) return;
+  uint32_t session = now - s->up_since;
+  uint32_t idle = now - s->traffic_at;
+  if ( s->keepalive ) {
+    // a long session proves the keepalive; the ping unanswered after the
+    // idle keepalive interval may be the NAT or the firewall dropping the
+    // idle link, the loss in the traffic (the broker restart) says nothing
+    if ( session >= MQTT_KEEPALIVE_STABLE ) {
+      s->keepalive *= 2;
+      if ( s->keepalive > MQTT_KEEPALIVE_MAX ) s->keepalive = MQTT_KEEPALIVE_MAX;
+    } else if ( idle >= (uint32_t)s->keepalive * 1000 &&
+                idle <= (uint32_t)s->keepalive * 2000 ) {
+      s->keepalive /= 2;
+      if ( s->keepalive < MQTT_KEEPALIVE_MIN ) s->keepalive = MQTT_KEEPALIVE_MIN;
+    }
+  }
+  s->state = conn_state_retry;
+  s->down_since = now;
+  // the first attempt is jittered too
+  s->next_at = now + next_rand(s) % ( ARROW_RETRY_DELAY + 1 );
+}
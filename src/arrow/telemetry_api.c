@@ -13,6 +13,7 @@ int telemetry_response_data_list_init(telemetry_response_data_list_t *data, int
   data->totalPages = tpage;
   data->totalSize = tsize;
   data->data = NULL;
+  data->_last = NULL;
   return 0;
 }
 
@@ -24,6 +25,8 @@ int telemetry_response_data_list_free(telemetry_response_data_list_t *data) {
         if ( tmp->type ) free(tmp->type);
         free(tmp);
     }
+    data->data = NULL;
+    data->_last = NULL;
     return 0;
 }
 
@@ -40,7 +43,10 @@ int add_telemetry_data_info(telemetry_response_data_list_t *data,
     info->type = strdup(type);
     info->timestamp = timestamp;
     info->floatValue = flval;
-    arrow_linked_list_add_node_last(data->data, telemetry_data_info_t, info);
+    if ( !data->data ) data->_last = NULL;
+    if ( data->_last ) data->_last->node.next = &info->node;
+    else arrow_linked_list_add_node_last(data->data, telemetry_data_info_t, info);
+    data->_last = info;
     return 0;
 }
 
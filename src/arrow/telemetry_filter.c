@@ -0,0 +1,197 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "arrow/telemetry_filter.h"
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <debug.h>
+
+static telemetry_filter_t *__filters = NULL;
+
+int telemetry_filter_init(telemetry_filter_t *f,
+                          telemetry_filter_rule_t *rules,
+                          int count,
+                          uint32_t max_silence,
+                          int changed_only) {
+  if ( !f || count < 0 || ( count && !rules ) ) return -1;
+  memset(f, 0x0, sizeof(telemetry_filter_t));
+  f->rules = rules;
+  f->count = count;
+  f->max_silence = max_silence;
+  f->changed_only = changed_only ? 1 : 0;
+  f->value = NULL;
+  arrow_linked_list_init(f);
+  telemetry_filter_reset(f);
+  return 0;
+}
+
+void telemetry_filter_reset(telemetry_filter_t *f) {
+  int i;
+  for ( i = 0; i < f->count; i++ ) {
+    f->rules[i].last = 0.0;
+    f->rules[i].valid = 0;
+    f->rules[i].update = 0;
+    f->rules[i].unchanged = 0;
+  }
+  f->started = 0;
+  f->pending = 0;
+  f->last_sent = 0;
+}
+
+static telemetry_filter_rule_t *find_rule(telemetry_filter_t *f, const char *key) {
+  int i;
+  if ( !key ) return NULL;
+  for ( i = 0; i < f->count; i++ ) {
+    if ( strcmp(f->rules[i].key, key) == 0 ) return f->rules + i;
+  }
+  return NULL;
+}
+
+static double hash_string(const char *s) {
+  uint32_t h = 2166136261UL;
+  while ( *s ) {
+    h ^= (uint8_t)*s++;
+    h *= 16777619UL;
+  }
+  return (double)h;
+}
+
+static int json_value(void *data, const char *key, double *val) {
+  JsonNode *node = json_find_member((JsonNode *)data, p_const(key));
+  if ( !node ) return -1;
+  switch(node->tag) {
+  case JSON_NUMBER:
+    *val = node->number_;
+    return telemetry_value_number;
+  case JSON_BOOL:
+    *val = node->bool_ ? 1.0 : 0.0;
+    return telemetry_value_exact;
+  case JSON_STRING:
+    *val = hash_string(node->string_);
+    return telemetry_value_exact;
+  default:
+    return -1;
+  }
+}
+
+static int rule_changed(telemetry_filter_rule_t *rule, int kind, double val) {
+  if ( !rule->valid ) return 1;
+  if ( kind != telemetry_value_number ) return val != rule->last;
+  double diff = val - rule->last;
+  double band = rule->rel_deadband * rule->last;
+  if ( diff < 0 ) diff = -diff;
+  if ( band < 0 ) band = -band;
+  if ( band < rule->abs_deadband ) band = rule->abs_deadband;
+  if ( band == 0.0 ) return diff != 0.0;
+  return diff > band;
+}
+
+static int filter_check(telemetry_filter_t *f, telemetry_filter_value_t value,
+                        void *data, uint32_t now) {
+  int changed = 0;
+  int full = 0;
+  int i;
+  f->pending = 0;
+  if ( !f->started ) full = 1;
+  else if ( f->max_silence && now - f->last_sent >= f->max_silence ) full = 1;
+  for ( i = 0; i < f->count; i++ ) {
+    telemetry_filter_rule_t *rule = f->rules + i;
+    double val;
+    int kind = value(data, rule->key, &val);
+    rule->update = 0;
+    rule->unchanged = 0;
+    if ( kind < 0 ) continue;
+    if ( full || rule_changed(rule, kind, val) ) {
+      // the sample goes out, its values become the reference on the commit
+      rule->next = val;
+      rule->update = 1;
+      if ( !full ) changed = 1;
+    } else {
+      rule->unchanged = 1;
+    }
+  }
+  if ( !changed && !full ) return 1;
+  f->pending = 1;
+  f->next_sent = now;
+  return 0;
+}
+
+int telemetry_filter_check(telemetry_filter_t *f, JsonNode *sample, uint32_t now) {
+  if ( !f || !sample || sample->tag != JSON_OBJECT ) return 0;
+  if ( filter_check(f, json_value, sample, now) ) return 1;
+  telemetry_filter_strip(f, sample);
+  return 0;
+}
+
+int telemetry_filter_check_data(telemetry_filter_t *f, void *data, uint32_t now) {
+  if ( !f || !f->value ) return 0;
+  return filter_check(f, f->value, data, now);
+}
+
+void telemetry_filter_strip(telemetry_filter_t *f, JsonNode *sample) {
+  int i;
+  if ( !f || !f->pending || !f->changed_only ) return;
+  for ( i = 0; i < f->count; i++ ) {
+    if ( !f->rules[i].unchanged ) continue;
+    JsonNode *node = json_find_member(sample, p_const(f->rules[i].key));
+    if ( node ) json_delete(node);
+  }
+}
+
+void telemetry_filter_commit(telemetry_filter_t *f) {
+  int i;
+  if ( !f || !f->pending ) return;
+  for ( i = 0; i < f->count; i++ ) {
+    if ( !f->rules[i].update ) continue;
+    f->rules[i].last = f->rules[i].next;
+    f->rules[i].valid = 1;
+    f->rules[i].update = 0;
+  }
+  f->started = 1;
+  f->pending = 0;
+  f->last_sent = f->next_sent;
+}
+
+int telemetry_filter_apply(telemetry_filter_t *f, JsonNode *sample, uint32_t now) {
+  int ret = telemetry_filter_check(f, sample, now);
+  if ( ret == 0 ) telemetry_filter_commit(f);
+  return ret;
+}
+
+static int filtereq( telemetry_filter_t *f, const char *hid ) {
+  if ( P_VALUE(f->hid) && strcmp(P_VALUE(f->hid), hid) == 0 ) return 0;
+  return -1;
+}
+
+int telemetry_filter_register(arrow_device_t *device, telemetry_filter_t *f) {
+  if ( !device || !f || !P_VALUE(device->hid) ) return -1;
+  if ( telemetry_filter_find(device) ) return -1;
+  property_copy(&f->hid, device->hid);
+  arrow_linked_list_init(f);
+  arrow_linked_list_add_node_last(__filters, telemetry_filter_t, f);
+  return 0;
+}
+
+int telemetry_filter_unregister(arrow_device_t *device) {
+  telemetry_filter_t *f = telemetry_filter_find(device);
+  if ( !f ) return -1;
+  arrow_linked_list_del_node(__filters, telemetry_filter_t, f);
+  property_free(&f->hid);
+  return 0;
+}
+
+telemetry_filter_t *telemetry_filter_find(arrow_device_t *device) {
+  telemetry_filter_t *f = NULL;
+  if ( !__filters || !device || !P_VALUE(device->hid) ) return NULL;
+  linked_list_find_node ( f, __filters, telemetry_filter_t, filtereq, P_VALUE(device->hid) );
+  return f;
+}
+
+uint32_t __attribute_weak__ telemetry_filter_now(void) {
+  return time_mono_ms();
+}
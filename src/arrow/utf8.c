@@ -8,6 +8,9 @@
 
 #include "arrow/utf8.h"
 #include <sys/mem.h>
+#if defined(__SSSE3__)
+# include <tmmintrin.h>
+#endif
 
 static int utf8_validate_cz(const char *s) {
   unsigned char c = (unsigned char) *s;
@@ -112,40 +115,114 @@ void fix_urldecode(char *query) {
     }
 }
 
+static const char hex_digits[] = "0123456789abcdef";
+
+// 1 for the unreserved characters (a-z A-Z 0-9 - _) copied as they are
+static const uint8_t url_plain[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,
+  0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
 void urlencode(char *dst, char *src, int len) {
-  char *hex = "0123456789abcdef";
-  char *src_p = src;
-  char *dst_p = dst;
-  if (!len) len = (int)strlen(src);
-
-  while( src_p && len-- ){
-    if( ('a' <= *src_p && *src_p <= 'z')
-        || ('A' <= *src_p && *src_p <= 'Z')
-        || ('0' <= *src_p && *src_p <= '9')
-        || ( *src_p == '-' )
-        || ( *src_p == '_' )
-        ){
-      *dst_p++ = *src_p++;
+  const unsigned char *s = (const unsigned char *)src;
+  const unsigned char *end;
+  if ( !src ) {
+    *dst = '\0';
+    return;
+  }
+  if ( !len ) len = (int)strlen(src);
+  end = s + len;
+  while ( s < end ) {
+    // the plain runs by 8 bytes
+    while ( end - s >= 8 &&
+            url_plain[s[0]] & url_plain[s[1]] & url_plain[s[2]] & url_plain[s[3]] &
+            url_plain[s[4]] & url_plain[s[5]] & url_plain[s[6]] & url_plain[s[7]] ) {
+      memcpy(dst, s, 8);
+      dst += 8;
+      s += 8;
+    }
+    if ( s == end ) break;
+    if ( url_plain[*s] ) {
+      *dst++ = (char)*s;
     } else {
-      *dst_p++ = ('%');
-      *dst_p++ = (hex[*src_p >> 4]);
-      *dst_p++ = (hex[*src_p & 15]);
-      src_p++;
+      dst[0] = '%';
+      dst[1] = hex_digits[*s >> 4];
+      dst[2] = hex_digits[*s & 0x0f];
+      dst += 3;
     }
+    s++;
   }
-  *dst_p = '\0';
+  *dst = '\0';
 }
 
 void hex_encode(char *dst, const char *src, int size) {
-  int i;
-  for (i=0; i<size; i++)
-    sprintf(dst+i*2, "%02x", (unsigned char)(src[i]));
+  const unsigned char *s = (const unsigned char *)src;
+  int i = 0;
+#if defined(__SSSE3__)
+  // 16 bytes at once: the nibbles are the indexes into the digits
+  const __m128i digits = _mm_loadu_si128((const __m128i *)hex_digits);
+  const __m128i low = _mm_set1_epi8(0x0f);
+  for ( ; i + 16 <= size; i += 16 ) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    __m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), low));
+    __m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, low));
+    _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+#endif
+  for ( ; i < size; i++ ) {
+    dst[i * 2] = hex_digits[s[i] >> 4];
+    dst[i * 2 + 1] = hex_digits[s[i] & 0x0f];
+  }
+  dst[size * 2] = '\0';
 }
 
+// -1 for the non hex characters
+static const int8_t hex_values[256] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
 void hex_decode(char *dst, const char *src, int size) {
-    int i = 0;
-    for (i=0; i<size; i++) {
-        char d[3] = { *(src+i*2), *(src+i*2 + 1), '\0' };
-        dst[i] = (uint8_t)strtol(d, NULL, 16);
+  const unsigned char *s = (const unsigned char *)src;
+  int i;
+  for ( i = 0; i < size; i++ ) {
+    int hi = hex_values[s[i * 2]];
+    int lo = hex_values[s[i * 2 + 1]];
+    if ( ( hi | lo ) < 0 ) {
+      // not a hex pair: as strtol parses it
+      char d[3] = { (char)s[i * 2], (char)s[i * 2 + 1], '\0' };
+      dst[i] = (uint8_t)strtol(d, NULL, 16);
+    } else {
+      dst[i] = (char)( ( hi << 4 ) | lo );
     }
+  }
 }
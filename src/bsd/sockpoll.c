@@ -0,0 +1,117 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "bsd/sockpoll.h"
+#include <sys/mem.h>
+#include <debug.h>
+
+#if defined(__linux__) && !defined(NO_EPOLL)
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define SOCK_POLL_BATCH 16
+
+static uint32_t to_epoll(uint32_t events) {
+    uint32_t e = 0;
+    if ( events & SOCK_POLL_IN ) e |= EPOLLIN;
+    if ( events & SOCK_POLL_OUT ) e |= EPOLLOUT;
+    return e;
+}
+
+static uint32_t from_epoll(uint32_t e) {
+    uint32_t events = 0;
+    if ( e & EPOLLIN ) events |= SOCK_POLL_IN;
+    if ( e & EPOLLOUT ) events |= SOCK_POLL_OUT;
+    if ( e & (EPOLLERR | EPOLLHUP) ) events |= SOCK_POLL_ERR;
+    return events;
+}
+
+static int sock_poll_ctl(int ps, int op, int sock, uint32_t events) {
+    struct epoll_event ev;
+    memset(&ev, 0x0, sizeof(ev));
+    ev.events = to_epoll(events);
+    ev.data.fd = sock;
+    return epoll_ctl(ps, op, sock, &ev) < 0 ? -1 : 0;
+}
+
+int __attribute_weak__ sock_poll_create(int size) {
+    SSP_PARAMETER_NOT_USED(size);
+    int ps = epoll_create1(EPOLL_CLOEXEC);
+    if ( ps < 0 ) DBG("epoll create fail %d", errno);
+    return ps;
+}
+
+int __attribute_weak__ sock_poll_add(int ps, int sock, uint32_t events) {
+    return sock_poll_ctl(ps, EPOLL_CTL_ADD, sock, events);
+}
+
+int __attribute_weak__ sock_poll_mod(int ps, int sock, uint32_t events) {
+    return sock_poll_ctl(ps, EPOLL_CTL_MOD, sock, events);
+}
+
+int __attribute_weak__ sock_poll_del(int ps, int sock) {
+    return sock_poll_ctl(ps, EPOLL_CTL_DEL, sock, 0);
+}
+
+int __attribute_weak__ sock_poll_wait(int ps, sock_poll_event_t *ev, int max, int timeout_ms) {
+    struct epoll_event e[SOCK_POLL_BATCH];
+    int i;
+    if ( max > SOCK_POLL_BATCH ) max = SOCK_POLL_BATCH;
+    int n = epoll_wait(ps, e, max, timeout_ms);
+    if ( n < 0 ) return errno == EINTR ? 0 : -1;
+    for ( i = 0; i < n; i++ ) {
+        ev[i].sock = e[i].data.fd;
+        ev[i].events = from_epoll(e[i].events);
+    }
+    return n;
+}
+
+void __attribute_weak__ sock_poll_close(int ps) {
+    if ( ps >= 0 ) close(ps);
+}
+
+#else
+
+int __attribute_weak__ sock_poll_create(int size) {
+    SSP_PARAMETER_NOT_USED(size);
+    return -1;
+}
+
+int __attribute_weak__ sock_poll_add(int ps, int sock, uint32_t events) {
+    SSP_PARAMETER_NOT_USED(ps);
+    SSP_PARAMETER_NOT_USED(sock);
+    SSP_PARAMETER_NOT_USED(events);
+    return -1;
+}
+
+int __attribute_weak__ sock_poll_mod(int ps, int sock, uint32_t events) {
+    SSP_PARAMETER_NOT_USED(ps);
+    SSP_PARAMETER_NOT_USED(sock);
+    SSP_PARAMETER_NOT_USED(events);
+    return -1;
+}
+
+int __attribute_weak__ sock_poll_del(int ps, int sock) {
+    SSP_PARAMETER_NOT_USED(ps);
+    SSP_PARAMETER_NOT_USED(sock);
+    return -1;
+}
+
+int __attribute_weak__ sock_poll_wait(int ps, sock_poll_event_t *ev, int max, int timeout_ms) {
+    SSP_PARAMETER_NOT_USED(ps);
+    SSP_PARAMETER_NOT_USED(ev);
+    SSP_PARAMETER_NOT_USED(max);
+    SSP_PARAMETER_NOT_USED(timeout_ms);
+    return -1;
+}
+
+void __attribute_weak__ sock_poll_close(int ps) {
+    SSP_PARAMETER_NOT_USED(ps);
+}
+#endif
@@ -38,3 +38,37 @@ doubly_linked_list_t *doubly_linked_list_del(
     el->prev = NULL;
     return el;
 }
+
+void doubly_linked_list_head_init(doubly_linked_list_head_t *head) {
+    head->first = NULL;
+    head->last = NULL;
+    head->count = 0;
+}
+
+void doubly_linked_list_head_add(doubly_linked_list_head_t *head, doubly_linked_list_t *el) {
+    el->next = NULL;
+    el->prev = head->last;
+    if ( head->last ) head->last->next = el;
+    else head->first = el;
+    head->last = el;
+    head->count++;
+}
+
+void doubly_linked_list_head_add_first(doubly_linked_list_head_t *head, doubly_linked_list_t *el) {
+    el->prev = NULL;
+    el->next = head->first;
+    if ( head->first ) head->first->prev = el;
+    else head->last = el;
+    head->first = el;
+    head->count++;
+}
+
+void doubly_linked_list_head_del(doubly_linked_list_head_t *head, doubly_linked_list_t *el) {
+    if ( el->prev ) el->prev->next = el->next;
+    else head->first = el->next;
+    if ( el->next ) el->next->prev = el->prev;
+    else head->last = el->prev;
+    el->next = NULL;
+    el->prev = NULL;
+    head->count--;
+}
@@ -36,3 +36,12 @@ int find_by_validate_key(find_by_t *fb) {
     if ( fb && fb->key < FindBy_count ) return 0;
     return -1;
 }
+
+void find_by_free(find_by_t **params) {
+    find_by_t *tmp = NULL;
+    arrow_linked_list_for_each_safe(tmp, *params, find_by_t) {
+        property_free(&tmp->value);
+        free(tmp);
+    }
+    *params = NULL;
+}
@@ -51,3 +51,62 @@ arrow_linked_list_t *arrow_linked_list_del_last(arrow_linked_list_t *root) {
     } 
     return 0;
 }
+
+void arrow_linked_list_head_init(arrow_linked_list_head_t *head) {
+    head->first = 0;
+    head->last = 0;
+    head->count = 0;
+}
+
+void arrow_linked_list_head_set(arrow_linked_list_head_t *head, arrow_linked_list_t *root) {
+    arrow_linked_list_head_init(head);
+    head->first = root;
+    while ( root ) {
+        head->last = root;
+        head->count++;
+        root = root->next;
+    }
+}
+
+void arrow_linked_list_head_add(arrow_linked_list_head_t *head, arrow_linked_list_t *el) {
+    el->next = 0;
+    if ( head->last ) head->last->next = el;
+    else head->first = el;
+    head->last = el;
+    head->count++;
+}
+
+void arrow_linked_list_head_add_first(arrow_linked_list_head_t *head, arrow_linked_list_t *el) {
+    el->next = head->first;
+    head->first = el;
+    if ( !head->last ) head->last = el;
+    head->count++;
+}
+
+arrow_linked_list_t *arrow_linked_list_head_del_first(arrow_linked_list_head_t *head) {
+    arrow_linked_list_t *first = head->first;
+    if ( !first ) return 0;
+    head->first = first->next;
+    if ( !head->first ) head->last = 0;
+    first->next = 0;
+    head->count--;
+    return first;
+}
+
+int arrow_linked_list_head_del(arrow_linked_list_head_t *head, arrow_linked_list_t *el) {
+    arrow_linked_list_t *last = head->first;
+    arrow_linked_list_t *prev = 0;
+    while ( last ) {
+        if ( last == el ) {
+            if ( prev ) prev->next = el->next;
+            else head->first = el->next;
+            if ( head->last == el ) head->last = prev;
+            el->next = 0;
+            head->count--;
+            return 0;
+        }
+        prev = last;
+        last = last->next;
+    }
+    return -1;
+}
@@ -9,41 +9,41 @@
 #include "data/property.h"
 #include <debug.h>
 
-static property_dispetcher_t *prop_disp = NULL;
+// the handlers by the type bits of the flags
+static property_handler_t *prop_types[PROPERTY_TYPES_MAX] = {0};
 
 void property_type_add(property_dispetcher_t *disp) {
-    arrow_linked_list_add_node_last(prop_disp, property_dispetcher_t, disp);
+    if ( disp->index >= PROPERTY_TYPES_MAX ) {
+        DBG("property type %d > %d", disp->index, PROPERTY_TYPES_MAX - 1);
+        return;
+    }
+    prop_types[disp->index] = &disp->handler;
 }
 
 void property_type_del(uint8_t index) {
-    // FIXME impl
+    if ( index < PROPERTY_TYPES_MAX ) prop_types[index] = NULL;
 }
 
 void property_types_init() {
   property_type_add(property_type_get_const());
   property_type_add(property_type_get_dynamic());
   property_type_add(property_type_get_stack());
+  property_type_add(property_type_get_intern());
+  property_intern_init();
 }
 
 void property_types_deinit() {
-  while( prop_disp ) {
-      arrow_linked_list_del_node_last(prop_disp, property_dispetcher_t);
-  }
+  memset(prop_types, 0x0, sizeof(prop_types));
+  property_intern_deinit();
 }
 
 void property_init(property_t *dst) {
     memset(dst, 0x0, sizeof(property_t));
 }
 
-static int proptypeeq( property_dispetcher_t *d, uint8_t flag ) {
-    if ( d->index == (0x3f & flag) ) return 0;
-    return -1;
-}
-
 property_handler_t *get_property_type(property_t *src) {
-    property_dispetcher_t *tmp = NULL;
-    linked_list_find_node(tmp, prop_disp, property_dispetcher_t, proptypeeq, src->flags);
-    if ( tmp ) return &tmp->handler;
+    uint8_t index = src->flags & PROPERTY_BASE_MASK;
+    if ( index < PROPERTY_TYPES_MAX ) return prop_types[index];
     return NULL;
 }
 
@@ -85,7 +85,7 @@ void dynmc_concat(property_t *dst, property_t *src) {
     int size_dst = 0;
     int size_src = 0;
     if ( ! (dst->flags & is_owner) ) return;
-    if ( dst->flags & is_raw ) {
+    if ( ( dst->flags & is_raw ) || dst->size ) {
         size_dst += dst->size;
     } else {
         size_dst += strlen(dst->value);
@@ -102,7 +102,8 @@ void dynmc_concat(property_t *dst, property_t *src) {
         return;
     }
     memcpy(dst->value + size_dst, src->value, size_src);
-    dst->value[size_dst + size_src +1] = '\0';
+    dst->value[size_dst + size_src] = '\0';
+    if ( dst->size ) dst->size = size_dst + size_src;
 }
 
 static property_dispetcher_t dynamic_property_type = {
@@ -0,0 +1,156 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "data/property_intern.h"
+#include <debug.h>
+#include <stddef.h>
+
+#if defined(STATIC_DYNAMIC_PROPERTY)
+#include <data/static_buf.h>
+CREATE_BUFFER(internbuf, PROPERTY_INTERN_STATIC_BUFFER_SIZE, 0x10)
+# define INTERN_ALLOC(size)  static_buf_alloc(internbuf, (size))
+# define INTERN_FREE(p)      static_buf_free(internbuf, (p))
+#else
+# define INTERN_ALLOC(size)  malloc(size)
+# define INTERN_FREE(p)      free(p)
+#endif
+
+#if defined(ARROW_THREAD) || defined(HTTP_THREAD)
+#include <sys/mutex.h>
+static arrow_mutex *_intern_mutex = NULL;
+# define INTERN_LOCK    if ( _intern_mutex ) arrow_mutex_lock(_intern_mutex)
+# define INTERN_UNLOCK  if ( _intern_mutex ) arrow_mutex_unlock(_intern_mutex)
+#else
+# define INTERN_LOCK
+# define INTERN_UNLOCK
+#endif
+
+#define INTERN_MASK ( PROPERTY_INTERN_BUCKETS - 1 )
+#if ( PROPERTY_INTERN_BUCKETS & INTERN_MASK )
+# error "PROPERTY_INTERN_BUCKETS must be a power of 2"
+#endif
+
+typedef struct _intern_str_ {
+    struct _intern_str_ *next;
+    uint32_t hash;
+    uint32_t refs;
+    uint16_t len;
+    char str[];
+} intern_str_t;
+
+#define intern_entry(s) ( (intern_str_t *)( (s) - offsetof(intern_str_t, str) ) )
+
+static intern_str_t *_intern[PROPERTY_INTERN_BUCKETS] = {0};
+static int _intern_count = 0;
+
+// FNV-1a
+static uint32_t intern_hash(const char *s, int len) {
+    uint32_t h = 2166136261UL;
+    while ( len-- ) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+int property_intern_init(void) {
+#if defined(ARROW_THREAD) || defined(HTTP_THREAD)
+    if ( !_intern_mutex && arrow_mutex_init(&_intern_mutex) < 0 ) return -1;
+#endif
+    return 0;
+}
+
+void property_intern_deinit(void) {
+#if defined(ARROW_THREAD) || defined(HTTP_THREAD)
+    if ( _intern_mutex ) arrow_mutex_deinit(_intern_mutex);
+    _intern_mutex = NULL;
+#endif
+}
+
+property_t property_intern(const char *str, int len) {
+    if ( !str || len > PROPERTY_INTERN_MAX_LEN ) return p_null();
+    uint32_t h = intern_hash(str, len);
+    INTERN_LOCK;
+    intern_str_t *e = _intern[h & INTERN_MASK];
+    while ( e ) {
+        if ( e->hash == h && e->len == len && memcmp(e->str, str, len) == 0 ) break;
+        e = e->next;
+    }
+    if ( e ) {
+        e->refs++;
+    } else {
+        e = (intern_str_t *)INTERN_ALLOC(sizeof(intern_str_t) + len + 1);
+        if ( !e ) {
+            INTERN_UNLOCK;
+            DBG("Out of Memory: intern");
+            return p_null();
+        }
+        e->hash = h;
+        e->refs = 1;
+        e->len = (uint16_t)len;
+        memcpy(e->str, str, len);
+        e->str[len] = 0x0;
+        e->next = _intern[h & INTERN_MASK];
+        _intern[h & INTERN_MASK] = e;
+        _intern_count++;
+    }
+    INTERN_UNLOCK;
+    return property(e->str, PROPERTY_INTERN_TAG | is_owner, len);
+}
+
+int property_intern_count(void) {
+    return _intern_count;
+}
+
+static void intern_copy(property_t *dst, property_t *src) {
+    INTERN_LOCK;
+    intern_entry(src->value)->refs++;
+    INTERN_UNLOCK;
+    dst->value = src->value;
+    dst->size = src->size;
+    dst->flags = is_owner | PROPERTY_INTERN_TAG;
+}
+
+static void intern_weak(property_t *dst, property_t *src) {
+    dst->value = src->value;
+    dst->size = src->size;
+    dst->flags = PROPERTY_INTERN_TAG;
+}
+
+static void intern_move(property_t *dst, property_t *src) {
+    dst->value = src->value;
+    dst->size = src->size;
+    dst->flags = PROPERTY_INTERN_TAG;
+    if ( src->flags & is_owner ) {
+        dst->flags |= is_owner;
+        src->flags &= ~is_owner;
+    }
+}
+
+static void intern_destroy(property_t *dst) {
+    intern_str_t *e = intern_entry(dst->value);
+    INTERN_LOCK;
+    if ( --e->refs ) {
+        INTERN_UNLOCK;
+        return;
+    }
+    intern_str_t **p = &_intern[e->hash & INTERN_MASK];
+    while ( *p != e ) p = &(*p)->next;
+    *p = e->next;
+    _intern_count--;
+    INTERN_UNLOCK;
+    INTERN_FREE(e);
+}
+
+static property_dispetcher_t intern_property_type = {
+    PROPERTY_INTERN_TAG,   { intern_copy, intern_weak, intern_move, intern_destroy }, {NULL}
+};
+
+property_dispetcher_t *property_type_get_intern() {
+    return &intern_property_type;
+}
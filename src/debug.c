@@ -6,6 +6,274 @@ char dbg_buffer[DBG_LINE_SIZE] __attribute__((weak));
 
 #if defined(__USE_STD__)
 #include <stdarg.h>
+#if defined(DEBUG) && defined(DBG_RING)
+#include <stdio.h>
+
+#if ( DBG_RING_SIZE & ( DBG_RING_SIZE - 1 ) )
+# error "DBG_RING_SIZE must be a power of 2"
+#endif
+#define DBG_RING_MASK ( DBG_RING_SIZE - 1 )
+
+// the argument classes of the conversions
+enum {
+  dbg_arg_stop = -1,
+  dbg_arg_none = 0,
+  dbg_arg_int,
+  dbg_arg_long,
+  dbg_arg_llong,
+  dbg_arg_size,
+  dbg_arg_double,
+  dbg_arg_ldouble,
+  dbg_arg_ptr,
+  dbg_arg_str,
+  dbg_arg_count
+};
+
+#define DBG_STAR_WIDTH  0x01
+#define DBG_STAR_PREC   0x02
+
+typedef struct _dbg_rec_ {
+  uint32_t seq;
+  uint16_t len;
+  uint16_t cut;
+  const char *fmt;
+  uint8_t args[DBG_RING_ARGS];
+} dbg_rec_t;
+
+// the bounded MPMC queue (D. Vyukov) with the one consumer:
+// a record is free for the line n if its seq is n, ready if it's n+1.
+// The seq is stored less the record index, so the zeroed ring is ready to write.
+static dbg_rec_t dbg_ring[DBG_RING_SIZE];
+static uint32_t dbg_head = 0;
+static uint32_t dbg_tail = 0;
+static uint32_t dbg_lost = 0;
+static uint8_t dbg_flushing = 0;
+
+#define REC_SEQ(i)         ( __atomic_load_n(&dbg_ring[i].seq, __ATOMIC_ACQUIRE) + (i) )
+#define REC_SEQ_SET(i, s)  __atomic_store_n(&dbg_ring[i].seq, (s) - (i), __ATOMIC_RELEASE)
+
+// parse the conversion after the '%'
+static const char *dbg_spec(const char *p, int *cls, int *stars, int *prec) {
+  int l = 0;
+  int size = 0;
+  *stars = 0;
+  *prec = -1;
+  while ( *p && strchr("-+ #0", *p) ) p++;
+  if ( *p == '*' ) {
+    *stars |= DBG_STAR_WIDTH;
+    p++;
+  } else while ( *p >= '0' && *p <= '9' ) p++;
+  if ( *p == '.' ) {
+    p++;
+    if ( *p == '*' ) {
+      *stars |= DBG_STAR_PREC;
+      p++;
+    } else {
+      *prec = 0;
+      while ( *p >= '0' && *p <= '9' ) *prec = *prec * 10 + *p++ - '0';
+    }
+  }
+  for ( ;; p++ ) {
+    if ( *p == 'h' ) continue;
+    else if ( *p == 'l' ) l++;
+    else if ( *p == 'j' || *p == 'L' ) l = 2;
+    else if ( *p == 'z' || *p == 't' ) size = 1;
+    else break;
+  }
+  switch ( *p ) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+      *cls = size ? dbg_arg_size : l > 1 ? dbg_arg_llong : l ? dbg_arg_long : dbg_arg_int;
+    break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+      *cls = l > 1 ? dbg_arg_ldouble : dbg_arg_double;
+    break;
+    case 's': *cls = dbg_arg_str; break;
+    case 'p': *cls = dbg_arg_ptr; break;
+    case 'n': *cls = dbg_arg_count; break;
+    case '%': *cls = dbg_arg_none; break;
+    default:
+      *cls = dbg_arg_stop;
+      return p;
+  }
+  return p + 1;
+}
+
+#define DBG_PUT(type, v) do { \
+  type _v = (type)(v); \
+  if ( a + sizeof(type) > end ) goto pack_cut; \
+  memcpy(a, &_v, sizeof(type)); \
+  a += sizeof(type); \
+} while (0)
+
+#define DBG_GET(type, v) do { \
+  if ( a + sizeof(type) > end ) goto format_cut; \
+  memcpy(&(v), a, sizeof(type)); \
+  a += sizeof(type); \
+} while (0)
+
+// copy the arguments by the format
+static void dbg_pack(dbg_rec_t *r, const char *fmt, va_list args) {
+  uint8_t *a = r->args;
+  uint8_t *end = r->args + DBG_RING_ARGS;
+  const char *p = fmt;
+  int cls, stars, prec;
+  r->fmt = fmt;
+  r->cut = 0;
+  while ( ( p = strchr(p, '%') ) ) {
+    p = dbg_spec(p + 1, &cls, &stars, &prec);
+    if ( stars & DBG_STAR_WIDTH ) DBG_PUT(int, va_arg(args, int));
+    if ( stars & DBG_STAR_PREC ) {
+      prec = va_arg(args, int);
+      DBG_PUT(int, prec);
+    }
+    switch ( cls ) {
+      case dbg_arg_stop: goto pack_end;
+      case dbg_arg_none: break;
+      case dbg_arg_int: DBG_PUT(int, va_arg(args, int)); break;
+      case dbg_arg_long: DBG_PUT(long, va_arg(args, long)); break;
+      case dbg_arg_llong: DBG_PUT(long long, va_arg(args, long long)); break;
+      case dbg_arg_size: DBG_PUT(size_t, va_arg(args, size_t)); break;
+      case dbg_arg_double: DBG_PUT(double, va_arg(args, double)); break;
+      case dbg_arg_ldouble: DBG_PUT(long double, va_arg(args, long double)); break;
+      case dbg_arg_ptr: DBG_PUT(void *, va_arg(args, void *)); break;
+      case dbg_arg_count: (void)va_arg(args, void *); break;
+      case dbg_arg_str: {
+        // the string may be gone before the flush
+        const char *s = va_arg(args, const char *);
+        size_t n = 0;
+        size_t room;
+        if ( !s ) s = "(null)";
+        if ( a >= end ) goto pack_cut;
+        room = (size_t)( end - a - 1 );
+        if ( prec >= 0 && (size_t)prec < room ) room = (size_t)prec;
+        while ( n < room && s[n] ) n++;
+        memcpy(a, s, n);
+        a[n] = 0x0;
+        a += n + 1;
+        if ( n == room && s[n] && ( prec < 0 || n < (size_t)prec ) ) goto pack_cut;
+      } break;
+    }
+  }
+  goto pack_end;
+pack_cut:
+  r->cut = 1;
+pack_end:
+  r->len = (uint16_t)( a - r->args );
+}
+
+// the line by the pieces: every conversion has its own snprintf
+static void dbg_format(char *out, int size, dbg_rec_t *r) {
+  const uint8_t *a = r->args;
+  const uint8_t *end = r->args + r->len;
+  const char *p = r->fmt;
+  char spec[32];
+  int n = 0;
+  int cls, stars, prec;
+  while ( *p && n < size - 1 ) {
+    const char *q = strchr(p, '%');
+    const char *e;
+    int k = 0;
+    int star[2] = {0, 0};
+    int stars_used = 0;
+    if ( !q ) q = p + strlen(p);
+    while ( p < q && n < size - 1 ) out[n++] = *p++;
+    if ( !*q || n >= size - 1 ) break;
+    e = dbg_spec(q + 1, &cls, &stars, &prec);
+    if ( cls == dbg_arg_stop ) {
+      p = q;
+      while ( *p && n < size - 1 ) out[n++] = *p++;
+      break;
+    }
+    if ( cls == dbg_arg_none ) {
+      out[n++] = '%';
+      p = e;
+      continue;
+    }
+    if ( stars & DBG_STAR_WIDTH ) DBG_GET(int, star[0]);
+    if ( stars & DBG_STAR_PREC ) DBG_GET(int, star[1]);
+    // the '*' are replaced by the values
+    while ( q < e && k < (int)sizeof(spec) - 12 ) {
+      if ( *q == '*' ) {
+        int v = ( stars & DBG_STAR_WIDTH ) && !stars_used ? star[0] : star[1];
+        stars_used++;
+        k += sprintf(spec + k, "%d", v);
+        q++;
+      } else spec[k++] = *q++;
+    }
+    spec[k] = 0x0;
+    p = e;
+    k = 0;
+    switch ( cls ) {
+      case dbg_arg_int: { int v; DBG_GET(int, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_long: { long v; DBG_GET(long, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_llong: { long long v; DBG_GET(long long, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_size: { size_t v; DBG_GET(size_t, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_double: { double v; DBG_GET(double, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_ldouble: { long double v; DBG_GET(long double, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_ptr: { void *v; DBG_GET(void *, v); k = snprintf(out + n, size - n, spec, v); } break;
+      case dbg_arg_str: {
+        if ( a >= end ) goto format_cut;
+        k = snprintf(out + n, size - n, spec, (const char *)a);
+        a += strlen((const char *)a) + 1;
+      } break;
+      default: break;
+    }
+    if ( k > 0 ) n += k;
+    if ( n > size - 1 ) n = size - 1;
+  }
+  if ( r->cut ) goto format_cut;
+  out[n] = 0x0;
+  return;
+format_cut:
+  // the arguments didn't fit into the record
+  if ( n > size - 4 ) n = size - 4;
+  strcpy(out + n, "...");
+}
+
+__attribute__((weak)) void dbg_line(const char *fmt, ...) {
+  va_list args;
+  uint32_t pos = __atomic_load_n(&dbg_head, __ATOMIC_RELAXED);
+  for ( ;; ) {
+    int32_t dif = (int32_t)( REC_SEQ(pos & DBG_RING_MASK) - pos );
+    if ( !dif ) {
+      if ( __atomic_compare_exchange_n(&dbg_head, &pos, pos + 1, 1,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED) ) break;
+    } else if ( dif < 0 ) {
+      // the ring is full, don't wait for the flush
+      __atomic_fetch_add(&dbg_lost, 1, __ATOMIC_RELAXED);
+      return;
+    } else {
+      pos = __atomic_load_n(&dbg_head, __ATOMIC_RELAXED);
+    }
+  }
+  va_start(args, fmt);
+  dbg_pack(dbg_ring + ( pos & DBG_RING_MASK ), fmt, args);
+  va_end(args);
+  REC_SEQ_SET(pos & DBG_RING_MASK, pos + 1);
+}
+
+int dbg_flush(void) {
+  char line[DBG_LINE_SIZE];
+  int count = 0;
+  if ( __atomic_exchange_n(&dbg_flushing, 1, __ATOMIC_ACQUIRE) ) return 0;
+  for ( ;; ) {
+    uint32_t i = dbg_tail & DBG_RING_MASK;
+    if ( REC_SEQ(i) != dbg_tail + 1 ) break;
+    dbg_format(line, DBG_LINE_SIZE - 2, dbg_ring + i);
+    REC_SEQ_SET(i, dbg_tail + DBG_RING_SIZE);
+    dbg_tail++;
+    strcat(line, "\r\n");
+    printf("%s", line);
+    count++;
+  }
+  __atomic_store_n(&dbg_flushing, 0, __ATOMIC_RELEASE);
+  return count;
+}
+
+unsigned int dbg_dropped(void) {
+  return __atomic_load_n(&dbg_lost, __ATOMIC_RELAXED);
+}
+#else
 __attribute__((weak)) void dbg_line(const char *fmt, ...) {
   va_list args;
   va_start(args, fmt);
@@ -15,6 +283,7 @@ __attribute__((weak)) void dbg_line(const char *fmt, ...) {
   printf(dbg_buffer);
   va_end(args);
 }
+#endif
 #else
 __attribute__((weak)) void dbg_line(const char *fmt, ...) {
   (void)(fmt);
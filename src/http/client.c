@@ -9,9 +9,8 @@
 #define MODULE_NAME "HTTP_Client"
 
 #include "http/client.h"
-
-#define USE_STATIC
-#include <data/chunk.h>
+#include <http/pool.h>
+#include <http/inflate.h>
 
 #include <debug.h>
 #include <bsd/socket.h>
@@ -20,10 +19,20 @@
 
 #include <ssl/ssl.h>
 
-#define CHUNK_SIZE (RINGBUFFER_SIZE/2)
+#define CHUNK_SIZE HTTP_CHUNK_SIZE
 
-uint8_t tmpbuffer[CHUNK_SIZE];
-#define MAX_TMP_BUF_SIZE (sizeof(tmpbuffer)-1)
+#if defined(HTTP_THREAD)
+// the clients run in parallel, each one has its scratch space
+# define cli_tmpbuffer(cli)   ( (cli)->tmpbuffer )
+# define cli_linebuffer(cli)  ( (cli)->linebuffer )
+#else
+// one client runs at a time, they share the scratch space
+static uint8_t tmpbuffer[HTTP_CHUNK_SIZE];
+static uint8_t linebuffer[RINGBUFFER_SIZE];
+# define cli_tmpbuffer(cli)   tmpbuffer
+# define cli_linebuffer(cli)  linebuffer
+#endif
+#define MAX_TMP_BUF_SIZE (sizeof(cli_tmpbuffer(cli))-1)
 
 int http_session_is_open(http_client_t *cli) {
     if ( cli->sock < 0 ) return 0;
@@ -57,35 +66,35 @@ void http_session_set_protocol(http_client_t *cli, int prot) {
 #define client_send_direct(cli, buf, size)  simple_write((cli), (uint8_t*)(buf), (size))
 
 static int client_recv(void *c, uint16_t len) {
-    CREATE_CHUNK(tmp, MAX_TMP_BUF_SIZE);
     http_client_t *cli = (http_client_t *)c;
+    uint8_t *tmp = cli_tmpbuffer(cli);
     if ( len > ringbuf_capacity(cli->queue) )
         len = ringbuf_capacity(cli->queue);
+    if ( len > MAX_TMP_BUF_SIZE )
+        len = MAX_TMP_BUF_SIZE;
     int ret = -1;
     if ( cli->flags._cipher ) {
-        ret = ssl_recv(cli->sock, tmp, (int)len);
+        ret = ssl_recv(cli->sock, (char*)tmp, (int)len);
     } else {
         ret = recv(cli->sock, tmp, len, 0);
     }
     if ( ret > 0 ) {
-        if ( ringbuf_push(cli->queue, (uint8_t*)tmp, ret) < 0 ) {
-            FREE_CHUNK(tmp);
+        if ( ringbuf_push(cli->queue, tmp, ret) < 0 ) {
             return -1;
         }
     }
     HTTP_DBG("%d|%s|", ret, tmp);
-    FREE_CHUNK(tmp);
     return ret;
 }
 
 static int simple_write(void *c, uint8_t *buf, uint16_t len) {
-    CREATE_CHUNK(tmp, MAX_TMP_BUF_SIZE);
     http_client_t *cli = (http_client_t *)c;
     if ( !buf ) {
         if ( !len ) len = ringbuf_size(cli->queue);
-        if ( ringbuf_pop(cli->queue, (uint8_t*)tmp, len) < 0 )
+        if ( len > sizeof(cli_linebuffer(cli)) ) return -1;
+        if ( ringbuf_pop(cli->queue, cli_linebuffer(cli), len) < 0 )
             return -1;
-        buf = (uint8_t*)tmp;
+        buf = cli_linebuffer(cli);
     } else {
         if ( !len ) len = strlen((char*)buf);
     }
@@ -96,7 +105,6 @@ static int simple_write(void *c, uint8_t *buf, uint16_t len) {
     } else {
         ret = send(cli->sock, buf, len, 0);
     }
-    FREE_CHUNK(tmp);
     return ret;
 }
 
@@ -119,12 +127,17 @@ int __attribute_weak__ http_client_init(http_client_t *cli) {
     cli->sock = -1;
     cli->flags._close = true;
     cli->flags._cipher = 0;
+    cli->flags._reused = 0;
+    cli->flags._peer_close = 0;
+    cli->flags._drained = 0;
+    cli->pool_slot = -1;
     cli->timeout = DEFAULT_API_TIMEOUT;
     cli->protocol = api_via_http;
     return 0;
 }
 
 int __attribute_weak__ http_client_free(http_client_t *cli) {
+    http_pool_drop(cli);
     ringbuf_free(cli->queue);
 #if !defined(STATIC_HTTP_CLIENT)
     free(cli->queue);
@@ -134,13 +147,17 @@ int __attribute_weak__ http_client_free(http_client_t *cli) {
     return 0;
 }
 
-int default_http_client_open(http_client_t *cli, http_request_t *req);
 int __attribute_weak__ http_client_open(http_client_t *cli, http_request_t *req) {
+#if defined(HTTP_CONN_POOL)
+    return http_pool_client_open(cli, req);
+#else
     return default_http_client_open(cli, req);
+#endif
 }
 
 int default_http_client_open(http_client_t *cli, http_request_t *req) {
     cli->response_code = 0;
+    cli->flags._drained = 0;
     cli->request = req;
     if ( cli->protocol != api_via_http ) return -1;
     if ( !cli->queue ) {
@@ -204,9 +221,12 @@ int default_http_client_open(http_client_t *cli, http_request_t *req) {
     return 0;
 }
 
-int default_http_client_close(http_client_t *cli);
 int __attribute_weak__ http_client_close(http_client_t *cli) {
+#if defined(HTTP_CONN_POOL)
+    return http_pool_client_close(cli);
+#else
     return default_http_client_close(cli);
+#endif
 }
 
 int default_http_client_close(http_client_t *cli) {
@@ -225,13 +245,13 @@ int default_http_client_close(http_client_t *cli) {
 
 static int send_start(http_client_t *cli, http_request_t *req, ring_buffer_t *buf) {
     ringbuf_clear(buf);
-    int ret = snprintf((char*)tmpbuffer, MAX_TMP_BUF_SIZE,
+    int ret = snprintf((char*)cli_tmpbuffer(cli), MAX_TMP_BUF_SIZE,
                        "%s %s",
                        P_VALUE(req->meth), P_VALUE(req->uri));
     if ( ret < 0 ) return ret;
-    if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 ) return -1;
+    if ( ringbuf_push(cli->queue, cli_tmpbuffer(cli), ret) < 0 ) return -1;
     if ( req->query ) {
-        char *queryString = (char*)tmpbuffer;
+        char *queryString = (char*)cli_tmpbuffer(cli);
         strcpy(queryString, "?");
         property_map_t *query = NULL;
         arrow_linked_list_for_each(query, req->query, property_map_t) {
@@ -252,9 +272,9 @@ static int send_start(http_client_t *cli, http_request_t *req, ring_buffer_t *bu
     if ( (ret = client_send(cli)) < 0 ) {
         return ret;
     }
-    ret = snprintf((char*)tmpbuffer, MAX_TMP_BUF_SIZE, "Host: %s:%d\r\n", P_VALUE(req->host), req->port);
+    ret = snprintf((char*)cli_tmpbuffer(cli), MAX_TMP_BUF_SIZE, "Host: %s:%d\r\n", P_VALUE(req->host), req->port);
     if ( ret < 0 ) return ret;
-    if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0) return -1;
+    if ( ringbuf_push(cli->queue, cli_tmpbuffer(cli), ret) < 0) return -1;
     if ( (ret = client_send(cli)) < 0 ) {
         return ret;
     }
@@ -268,31 +288,31 @@ static int send_header(http_client_t *cli, http_request_t *req, ring_buffer_t *b
         if ( req->is_chunked ) {
             ret = client_send_direct(cli, "Transfer-Encoding: chunked\r\n", 0);
         } else {
-            ret = snprintf((char*)tmpbuffer,
+            ret = snprintf((char*)cli_tmpbuffer(cli),
                            ringbuf_capacity(cli->queue),
                            "Content-Length: %lu\r\n", (long unsigned int)property_size(&req->payload));
             if ( ret < 0 ) return ret;
-            if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 )
+            if ( ringbuf_push(cli->queue, cli_tmpbuffer(cli), ret) < 0 )
                 return -1;
             ret = client_send(cli);
         }
         ringbuf_clear(buf);
         if ( ret < 0 ) return ret;
-        ret = snprintf((char*)tmpbuffer,
+        ret = snprintf((char*)cli_tmpbuffer(cli),
                        ringbuf_capacity(cli->queue),
                        "Content-Type: %s\r\n", P_VALUE(req->content_type.value));
-        if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 ) return -1;
+        if ( ringbuf_push(cli->queue, cli_tmpbuffer(cli), ret) < 0 ) return -1;
         if ( ret < 0 ) return ret;
         if ( (ret = client_send(cli)) < 0 ) return ret;
     }
     property_map_t *head = NULL;
     arrow_linked_list_for_each(head, req->header, property_map_t) {
         ringbuf_clear(buf);
-        ret = snprintf((char*)tmpbuffer,
+        ret = snprintf((char*)cli_tmpbuffer(cli),
                            ringbuf_capacity(cli->queue),
                            "%s: %s\r\n", P_VALUE(head->key), P_VALUE(head->value));
     	if ( ret < 0 ) return ret;
-        if ( ringbuf_push(cli->queue, tmpbuffer, ret) < 0 ) return -1;
+        if ( ringbuf_push(cli->queue, cli_tmpbuffer(cli), ret) < 0 ) return -1;
         if ( (ret = client_send(cli)) < 0 ) return ret;
     }
     return client_send_direct(cli, "\r\n", 2);
@@ -330,8 +350,8 @@ static uint8_t *wait_line(http_client_t *cli, uint8_t *buf, size_t maxsize) {
       // pop from buffer by one symbol
       if ( ringbuf_pop(cli->queue, buf + size, 1) == 0 ) {
           size ++;
-          buf[size] = 0x0;
           if ( (size_t)size == maxsize ) return NULL;
+          buf[size] = 0x0;
       } else {
           // empty buffer
           if( ringbuf_capacity(cli->queue) > LINE_CHUNK ) {
@@ -346,14 +366,12 @@ static uint8_t *wait_line(http_client_t *cli, uint8_t *buf, size_t maxsize) {
 }
 
 static int receive_response(http_client_t *cli, http_response_t *res) {
-    ringbuf_clear(cli->queue);
-    CREATE_CHUNK(tmp, RINGBUFFER_SIZE);
+    char *tmp = (char *)cli_linebuffer(cli);
     uint8_t *crlf = NULL;
     do {
-        crlf = wait_line(cli, (uint8_t*)tmp, RINGBUFFER_SIZE);
+        crlf = wait_line(cli, (uint8_t*)tmp, sizeof(cli_linebuffer(cli)));
         if ( !crlf ) {
             DBG("couldn't wait end of a line");
-            FREE_CHUNK(tmp);
             return -1;
         }
         if( (crlf - (uint8_t *)tmp) < 10 ) {
@@ -369,41 +387,32 @@ static int receive_response(http_client_t *cli, http_response_t *res) {
     p = copy_till_to_int(p + 9, " OK", (int*)&res->m_httpResponseCode);
     if( !p ) {
         DBG("Not a correct HTTP answer : %s", tmp);
-        FREE_CHUNK(tmp);
         return -1;
     }
 
     DBG("Response code %d", res->m_httpResponseCode);
     cli->response_code = res->m_httpResponseCode;
-    FREE_CHUNK(tmp);
     return 0;
 }
 
 static int receive_headers(http_client_t *cli, http_response_t *res) {
     uint8_t *crlf = NULL;
-    CREATE_CHUNK(tmp, RINGBUFFER_SIZE);
-    CREATE_CHUNK(key, CHUNK_SIZE>>2);
-    CREATE_CHUNK(value, CHUNK_SIZE);
-    int ret = 0;
-    while( ( crlf = wait_line(cli, (uint8_t*)tmp, RINGBUFFER_SIZE) ) ) {
+    char *tmp = (char *)cli_linebuffer(cli);
+    while( ( crlf = wait_line(cli, (uint8_t*)tmp, sizeof(cli_linebuffer(cli))) ) ) {
         if ( crlf == (uint8_t*)tmp ) {
             HTTP_DBG("Headers read done");
-            ret = 0;
-            break;
+            return 0;
         }
-
-        char *p = copy_till(tmp, ": ", key);
-        if ( !p ) {
+        // split the line in place: "key: value\r\n"
+        *crlf = 0x0;
+        char *key = tmp;
+        char *value = strstr(tmp, ": ");
+        if ( !value ) {
             DBG("Could not parse key");
-            ret = -1;
-            goto recv_header_end;
-        }
-        p = copy_till(p, "\r\n", value);
-        if ( !p ) {
-            DBG("Could not parse value");
-            ret = -1;
-            goto recv_header_end;
+            return -1;
         }
+        *value = 0x0;
+        value += 2;
 
             HTTP_DBG("Read header : %s: %s", key, value);
             if( !strcmp(key, "Content-Length") ) {
@@ -411,7 +420,15 @@ static int receive_headers(http_client_t *cli, http_response_t *res) {
             } else if( !strcmp(key, "Transfer-Encoding") ) {
                 if( !strcmp(value, "Chunked") || !strcmp(value, "chunked") )
                     res->is_chunked = 1;
+            } else if( !strcmp(key, "Connection") ) {
+                if( !strcmp(value, "close") || !strcmp(value, "Close") )
+                    cli->flags._peer_close = 1;
+            }
+#if !defined(HTTP_NO_INFLATE)
+            else if( !strcmp(key, "Content-Encoding") ) {
+                res->content_coding = http_content_coding(value);
             }
+#endif
 #if defined(HTTP_PARSE_HEADER)
             else if( !strcmp(key, "Content-Type") ) {
                 http_response_set_content_type(res, p_stack(value));
@@ -422,36 +439,51 @@ static int receive_headers(http_client_t *cli, http_response_t *res) {
             }
 #endif
     }
-recv_header_end:
-    FREE_CHUNK(tmp);
-    FREE_CHUNK(key);
-    FREE_CHUNK(value);
-    return ret;
+    return 0;
 }
 
 static int get_chunked_payload_size(http_client_t *cli, http_response_t *res) {
     // find the \r\n in the payload
     // next string shoud start at HEX chunk size
     SSP_PARAMETER_NOT_USED(res);
-    CREATE_CHUNK(tmp, RINGBUFFER_SIZE);
+    char *tmp = (char *)cli_linebuffer(cli);
     int chunk_len = 0;
-    uint8_t *crlf = wait_line(cli, (uint8_t*)tmp, RINGBUFFER_SIZE);
+    uint8_t *crlf = wait_line(cli, (uint8_t*)tmp, sizeof(cli_linebuffer(cli)));
     if ( !crlf ) return -1; // no \r\n - wrong string
-    char *p = copy_till_hex_to_int((char*)tmp, "\r\n", &chunk_len);
+    char *p = copy_till_hex_to_int(tmp, "\r\n", &chunk_len);
     if ( !p ) {
         // couldn't read a chunk size - fail
         chunk_len = 0;
-        FREE_CHUNK(tmp);
         return -1;
     }
     HTTP_DBG("detect chunk %d", chunk_len);
-    FREE_CHUNK(tmp);
     return chunk_len;
 }
 
+#if !defined(HTTP_NO_INFLATE)
+static int inflate_payload(void *arg, uint8_t *buf, size_t len) {
+    return http_response_add_payload((http_response_t *)arg, p_stack_raw(buf, len));
+}
+#endif
+
 static int receive_payload(http_client_t *cli, http_response_t *res) {
     int chunk_len = 0;
     int no_data_error = 0;
+    int done = 0;
+    int ret = 0;
+#if !defined(HTTP_NO_INFLATE)
+    // the decoder sits between the queue and the payload handler
+    http_inflate_t *z = NULL;
+    int z_ret = 0;
+    if ( res->content_coding ) {
+        z = alloc_type(http_inflate_t);
+        if ( !z || http_inflate_init(z, res->content_coding, inflate_payload, res) < 0 ) {
+            DBG("Payload decoder init fail");
+            if ( z ) free(z);
+            return -1;
+        }
+    }
+#endif
     do {
         if ( res->is_chunked ) {
             chunk_len = get_chunked_payload_size(cli, res);
@@ -459,54 +491,99 @@ static int receive_payload(http_client_t *cli, http_response_t *res) {
             chunk_len = res->recvContentLength;
             DBG("Con-Len %lu", res->recvContentLength);
         }
-        if ( !chunk_len || chunk_len < 0 ) break;
+        if ( chunk_len < 0 ) break;
+        if ( !chunk_len ) {
+            // the last chunk, the empty line after it may be in the queue
+            // (the status line reading skips it otherwise)
+            if ( res->is_chunked && ringbuf_size(cli->queue) == 2 ) {
+                uint8_t crlf[2];
+                ringbuf_pop(cli->queue, crlf, 2);
+                if ( crlf[0] != '\r' || crlf[1] != '\n' ) break;
+            }
+            done = 1;
+            break;
+        }
         while ( chunk_len ) {
             uint32_t need_to_read = ARROW_MIN(chunk_len, CHUNK_SIZE);
             HTTP_DBG("need to read %d", need_to_read);
             while ( (int)ringbuf_size(cli->queue) < (int)need_to_read ) {
                 HTTP_DBG("get chunk add %d", need_to_read-ringbuf_size(cli->queue));
-                int ret = client_recv(cli, need_to_read-ringbuf_size(cli->queue));
-                if ( ret < 0 ) {
-                    // ret < 0 - error
+                int r = client_recv(cli, need_to_read-ringbuf_size(cli->queue));
+                if ( r < 0 ) {
+                    // r < 0 - error
                     DBG("No data");
-                    if ( no_data_error ++ > 2) return -1;
+                    if ( no_data_error ++ > 2) {
+                        ret = -1;
+                        goto payload_end;
+                    }
                 }
             }
             HTTP_DBG("add payload{%d:s}", need_to_read);//, buf);
-            if ( ringbuf_pop(cli->queue, tmpbuffer, need_to_read) < 0 ) return -1;
+            if ( ringbuf_pop(cli->queue, cli_tmpbuffer(cli), need_to_read) < 0 ) {
+                ret = -1;
+                goto payload_end;
+            }
+#if !defined(HTTP_NO_INFLATE)
+            if ( z ) {
+                z_ret = http_inflate_part(z, cli_tmpbuffer(cli), need_to_read);
+                if ( z_ret < 0 ) {
+                    ringbuf_clear(cli->queue);
+                    DBG("Payload decoding is failed");
+                    ret = -1;
+                    goto payload_end;
+                }
+            } else
+#endif
             if ( http_response_add_payload(res,
-                                           p_stack_raw(tmpbuffer, need_to_read) ) < 0 ) {
+                                           p_stack_raw(cli_tmpbuffer(cli), need_to_read) ) < 0 ) {
                 ringbuf_clear(cli->queue);
                 DBG("Payload is failed");
-                return -1;
+                ret = -1;
+                goto payload_end;
             }
             chunk_len -= need_to_read;
             HTTP_DBG("%d %d", chunk_len, need_to_read);
         }
-        if ( !res->is_chunked ) break;
-        else {
-          uint8_t *crlf = wait_line(cli, tmpbuffer, CHUNK_SIZE);
+        if ( !res->is_chunked ) {
+            done = 1;
+            break;
+        } else {
+          uint8_t *crlf = wait_line(cli, cli_linebuffer(cli), sizeof(cli_linebuffer(cli)));
           if ( !crlf ) {
               DBG("No new line");
           }
         }
     } while(1);
 
+#if !defined(HTTP_NO_INFLATE)
+    if ( z && z_ret != 1 ) {
+        DBG("Payload is truncated");
+        ret = -1;
+    }
+#endif
     HTTP_DBG("body{%s}", P_VALUE(res->payload));
-    return 0;
+payload_end:
+#if !defined(HTTP_NO_INFLATE)
+    if ( z ) {
+        http_inflate_fin(z);
+        free(z);
+    }
+#endif
+    // the unread bytes of the answer must not go to the next request
+    cli->flags._drained = ( !ret && done && !ringbuf_size(cli->queue) );
+    return ret;
 }
 
-int default_http_client_do(http_client_t *cli, http_response_t *res);
 int __attribute_weak__ http_client_do(http_client_t *cli, http_response_t *res) {
+#if defined(HTTP_CONN_POOL)
+    return http_pool_client_do(cli, res);
+#else
     return default_http_client_do(cli, res);
+#endif
 }
 
-int default_http_client_do(http_client_t *cli, http_response_t *res) {
-    int ret;
-    http_request_t *req = cli->request;
-    if ( !req ) return -1;
-    http_response_init(res, &req->_response_payload_meth);
-
+static int send_request(http_client_t *cli, http_request_t *req) {
+    cli->flags._drained = 0;
     if ( send_start(cli, req, cli->queue) < 0 ) {
         DBG("send start fail");
         return -1;
@@ -523,10 +600,13 @@ int default_http_client_do(http_client_t *cli, http_response_t *res) {
             return -1;
         }
     }
+    return 0;
+}
 
+static int receive_answer(http_client_t *cli, http_response_t *res) {
+    int ret;
     HTTP_DBG("Receiving response");
-
-    ringbuf_clear(cli->queue);
+    cli->flags._drained = 0;
 
     ret = receive_response(cli, res);
     if ( ret < 0 ) {
@@ -539,6 +619,7 @@ int default_http_client_do(http_client_t *cli, http_response_t *res) {
     memset(&res->content_type, 0x0, sizeof(property_map_t));
     memset(&res->payload, 0x0, sizeof(http_payload_t));
     res->is_chunked = 0;
+    res->content_coding = 0;
     res->processed_payload_chunk = 0;
 
     //Now let's get a headers
@@ -555,3 +636,63 @@ int default_http_client_do(http_client_t *cli, http_response_t *res) {
     }
     return 0;
 }
+
+int default_http_client_send(http_client_t *cli, http_response_t *res) {
+    http_request_t *req = cli->request;
+    if ( !req ) return -1;
+    http_response_init(res, &req->_response_payload_meth);
+    cli->flags._peer_close = 0;
+    return send_request(cli, req);
+}
+
+int default_http_client_receive(http_client_t *cli, http_response_t *res) {
+    ringbuf_clear(cli->queue);
+    return receive_answer(cli, res);
+}
+
+int default_http_client_do(http_client_t *cli, http_response_t *res) {
+    if ( default_http_client_send(cli, res) < 0 ) return -1;
+    return default_http_client_receive(cli, res);
+}
+
+static int is_idempotent(http_request_t *req) {
+    return !strcmp(P_VALUE(req->meth), "GET") ||
+           !strcmp(P_VALUE(req->meth), "HEAD");
+}
+
+int http_client_do_pipeline(http_client_t *cli,
+                            http_request_t *req,
+                            http_response_t *res,
+                            int count) {
+    int i;
+    http_request_t *opened = cli->request;
+    if ( !opened || count <= 0 ) return -1;
+    for ( i = 0; i < count; i++ ) {
+        if ( !is_idempotent(req + i) ||
+             req[i].port != opened->port ||
+             req[i].is_cipher != opened->is_cipher ||
+             property_cmp(&req[i].host, &opened->host) ) {
+            DBG("pipeline: request %d is not allowed", i);
+            return -1;
+        }
+    }
+    cli->flags._peer_close = 0;
+    for ( i = 0; i < count; i++ ) {
+        if ( send_request(cli, req + i) < 0 ) return -1;
+    }
+    // the answers follow each other in the queue, don't clear it between them
+    ringbuf_clear(cli->queue);
+    for ( i = 0; i < count; i++ ) {
+        // the request is packed, the handlers are copied out of it
+        _payload_meth_t meth = req[i]._response_payload_meth;
+        http_response_init(res + i, &meth);
+        cli->request = req + i;
+        if ( receive_answer(cli, res + i) < 0 ) break;
+        if ( cli->flags._peer_close ) {
+            i++;
+            break;
+        }
+    }
+    cli->request = opened;
+    return i ? i : -1;
+}
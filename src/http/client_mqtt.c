@@ -46,17 +46,38 @@ int http_mqtt_client_close(http_client_t *cli) {
     return 0;
 }
 
-int http_mqtt_client_do(http_client_t *cli, http_response_t *res) {
-    int ret = 0;
-    http_request_t *req = cli->request;
-    if ( !req ) return -1;
-    http_response_init(res, &req->_response_payload_meth);
+// the requests in flight, the answers are matched by the requestId
+enum {
+    mqtt_req_free = 0,
+    mqtt_req_wait,
+    mqtt_req_done
+};
+
+typedef struct _http_mqtt_pending_ {
+    char id[HTTP_MQTT_REQ_ID_LEN];
+    uint8_t state;
+    int status;
+    http_response_t *res;
+    http_mqtt_done_f cb;
+    void *arg;
+    TimerInterval timer;
+} http_mqtt_pending_t;
 
+static http_mqtt_pending_t __pending[HTTP_MQTT_MAX_PENDING];
+static int __in_flight = 0;
+static uint16_t __req_seq = 0;
+
+int __attribute_weak__ http_mqtt_publish(JsonNode *msg) {
+    return mqtt_api_publish(msg);
+}
+
+int __attribute_weak__ http_mqtt_yield(int timeout_ms) {
+    return mqtt_yield(timeout_ms);
+}
+
+static JsonNode *api_request_message(http_request_t *req, const char *reqhid) {
     JsonNode *_node = json_mkobject();
     property_map_t *tmp = NULL;
-    char reqhid[50];
-    strcpy(reqhid, "GS-");
-    get_time(reqhid+3);
     json_append_member(_node,
                        p_const("requestId"),
                        json_mkstring(reqhid));
@@ -107,8 +128,6 @@ int http_mqtt_client_do(http_client_t *cli, http_response_t *res) {
                            json_mkstring(P_VALUE(tmp->value)));
     }
     char sig[65] = {0};
-    // FIXME bad function externing
-    arrow_device_t *current_device(void);
     json_append_member(_node, p_const("parameters"), _parameters);
     arrow_event_sign(sig,
                   p_stack(reqhid),
@@ -121,39 +140,153 @@ int http_mqtt_client_do(http_client_t *cli, http_response_t *res) {
     json_append_member(_node,
                        p_const("signatureVersion"),
                        json_mkstring("1"));
+    return _node;
+}
 
-    arrow_mqtt_api_wait(1);
-    ret = mqtt_api_publish(_node);
+static http_mqtt_pending_t *pending_find(const char *id) {
+    int i;
+    if ( !id ) return NULL;
+    for ( i = 0; i < HTTP_MQTT_MAX_PENDING; i++ ) {
+        if ( __pending[i].state == mqtt_req_wait &&
+             strcmp(__pending[i].id, id) == 0 ) return __pending + i;
+    }
+    return NULL;
+}
+
+static void pending_complete(http_mqtt_pending_t *p, int status) {
+    __in_flight--;
+    if ( !__in_flight ) {
+        // the late answers aren't expected anymore
+        arrow_mqtt_api_wait(0);
+    }
+    if ( p->cb ) {
+        p->state = mqtt_req_free;
+        p->cb(status, p->res, p->arg);
+    } else {
+        p->status = status;
+        p->state = mqtt_req_done;
+    }
+}
 
+static void pending_dispatch(void) {
+    while ( arrow_mqtt_api_has_events() > 0 ) {
+        http_mqtt_pending_t *p = pending_find(arrow_mqtt_api_event_id());
+        if ( !p ) {
+            DBG("mqtt api: unknown answer %s", arrow_mqtt_api_event_id());
+            arrow_mqtt_api_event_proc(NULL);
+            continue;
+        }
+        int ret = arrow_mqtt_api_event_proc(p->res);
+        pending_complete(p, ret < 0 ? -1 : 0);
+    }
+}
+
+static void pending_expire(void) {
+    int i;
+    for ( i = 0; i < HTTP_MQTT_MAX_PENDING; i++ ) {
+        if ( __pending[i].state == mqtt_req_wait &&
+             TimerIsExpired(&__pending[i].timer) ) {
+            DBG("mqtt api: %s timeout", __pending[i].id);
+            pending_complete(__pending + i, -1);
+        }
+    }
+}
+
+// the time to the nearest deadline
+static int pending_left_ms(int timeout_ms) {
+    int i;
+    for ( i = 0; i < HTTP_MQTT_MAX_PENDING; i++ ) {
+        if ( __pending[i].state == mqtt_req_wait ) {
+            int left = TimerLeftMS(&__pending[i].timer);
+            if ( left < timeout_ms ) timeout_ms = left;
+        }
+    }
+    return timeout_ms > 0 ? timeout_ms : 0;
+}
+
+int http_mqtt_client_send(http_client_t *cli, http_response_t *res,
+                          http_mqtt_done_f cb, void *arg) {
+    int i;
+    int ret = -1;
+    http_request_t *req = cli->request;
+    if ( !req ) return -1;
+    http_mqtt_pending_t *p = NULL;
+    for ( i = 0; i < HTTP_MQTT_MAX_PENDING; i++ ) {
+        if ( __pending[i].state == mqtt_req_free ) {
+            p = __pending + i;
+            break;
+        }
+    }
+    if ( !p ) {
+        DBG("mqtt api: too many requests");
+        return -1;
+    }
+    http_response_init(res, &req->_response_payload_meth);
+    // the time has ms resolution, the sequence number keeps the id unique
+    strcpy(p->id, "GS-");
+    get_time(p->id + 3);
+    snprintf(p->id + strlen(p->id), HTTP_MQTT_REQ_ID_LEN - strlen(p->id),
+             "-%u", (unsigned int)__req_seq++);
+
+    JsonNode *_node = api_request_message(req, p->id);
+    if ( !__in_flight ) arrow_mqtt_api_wait(HTTP_MQTT_MAX_PENDING);
+    ret = http_mqtt_publish(_node);
+    json_delete(_node);
     DBG("publish %d", ret);
     if ( ret < 0 ) {
-        ret = -1;
-        goto http_mqtt_error;
+        if ( !__in_flight ) arrow_mqtt_api_wait(0);
+        return -1;
     }
+    p->res = res;
+    p->cb = cb;
+    p->arg = arg;
+    p->status = 0;
+    TimerInit(&p->timer);
+    TimerCountdownMS(&p->timer, (unsigned int) 2*cli->timeout);
+    p->state = mqtt_req_wait;
+    __in_flight++;
+    return (int)( p - __pending );
+}
 
-    TimerInterval timer;
-    TimerInit(&timer);
-    TimerCountdownMS(&timer, (unsigned int) 2*cli->timeout);
-    while ( !arrow_mqtt_api_has_events() && !TimerIsExpired(&timer) ) {
-        ret = mqtt_yield(TimerLeftMS(&timer));
+int http_mqtt_client_dispatch(void) {
+    pending_dispatch();
+    pending_expire();
+    return __in_flight;
+}
+
+int http_mqtt_client_poll(int timeout_ms) {
+    if ( !__in_flight ) return 0;
+    if ( arrow_mqtt_api_has_events() <= 0 ) {
+        int ret = http_mqtt_yield(pending_left_ms(timeout_ms));
         DBG("yield %d", ret);
     }
+    return http_mqtt_client_dispatch();
+}
 
-    if ( arrow_mqtt_api_has_events() <= 0 ) {
-        ret = -1;
-        goto http_mqtt_error;
+int http_mqtt_client_wait(int handle) {
+    if ( handle < 0 || handle >= HTTP_MQTT_MAX_PENDING ) return -1;
+    http_mqtt_pending_t *p = __pending + handle;
+    if ( p->cb ) return -1;
+    while ( p->state == mqtt_req_wait ) {
+        http_mqtt_client_poll(TimerLeftMS(&p->timer));
     }
+    if ( p->state != mqtt_req_done ) return -1;
+    p->state = mqtt_req_free;
+    return p->status;
+}
 
-    while ( (ret = arrow_mqtt_api_event_proc(res)) > 0)
-        ;
-http_mqtt_error:
-    if ( _node ) json_delete(_node);
-    arrow_mqtt_api_wait(0);
-    if ( ret < 0 ) {
+int http_mqtt_client_pending(void) {
+    return __in_flight;
+}
+
+int http_mqtt_client_do(http_client_t *cli, http_response_t *res) {
+    int ret = http_mqtt_client_send(cli, res, NULL, NULL);
+    if ( ret >= 0 ) ret = http_mqtt_client_wait(ret);
+    if ( ret < 0 && !__in_flight ) {
         // try to fix connection
         mqtt_connection_error();
     }
-DBG("%s %d", __PRETTY_FUNCTION__, ret);
+    DBG("%s %d", __PRETTY_FUNCTION__, ret);
     return ret;
 }
 
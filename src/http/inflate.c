@@ -0,0 +1,550 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "http/inflate.h"
+#include <sys/mem.h>
+#include <debug.h>
+
+#if ( HTTP_INFLATE_WINDOW & ( HTTP_INFLATE_WINDOW - 1 ) ) || HTTP_INFLATE_WINDOW > 32768
+# error "HTTP_INFLATE_WINDOW should be a power of two up to 32768"
+#endif
+#define WINDOW_MASK (HTTP_INFLATE_WINDOW - 1)
+
+#define INFLATE_MORE  -2
+#define INFLATE_ERROR -1
+
+enum inflate_states {
+    inf_head = 0,
+    inf_gzip_fixed,
+    inf_gzip_extra_len,
+    inf_gzip_extra,
+    inf_gzip_name,
+    inf_gzip_comment,
+    inf_gzip_hcrc,
+    inf_block,
+    inf_stored_len,
+    inf_stored,
+    inf_table,
+    inf_table_lens,
+    inf_table_codes,
+    inf_codes,
+    inf_dist,
+    inf_copy,
+    inf_check,
+    inf_done,
+    inf_bad
+};
+
+// the gzip header flags
+#define GZ_FHCRC    0x02
+#define GZ_FEXTRA   0x04
+#define GZ_FNAME    0x08
+#define GZ_FCOMMENT 0x10
+
+static const uint16_t len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577 };
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8_t clen_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+static const uint32_t crc_table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c };
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *buf, size_t len) {
+    crc = ~crc;
+    while ( len-- ) {
+        crc ^= *buf++;
+        crc = ( crc >> 4 ) ^ crc_table[crc & 0x0f];
+        crc = ( crc >> 4 ) ^ crc_table[crc & 0x0f];
+    }
+    return ~crc;
+}
+
+static uint32_t adler32_update(uint32_t adler, const uint8_t *buf, size_t len) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while ( len ) {
+        // 5552 is the biggest n keeping b in 32 bits
+        size_t n = len < 5552 ? len : 5552;
+        len -= n;
+        while ( n-- ) {
+            a += *buf++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return ( b << 16 ) | a;
+}
+
+int http_content_coding(const char *value) {
+    if ( !value ) return http_coding_identity;
+    if ( !strcmp(value, "gzip") || !strcmp(value, "x-gzip") )
+        return http_coding_gzip;
+    if ( !strcmp(value, "deflate") )
+        return http_coding_deflate;
+    return http_coding_identity;
+}
+
+#define NEED(n) if ( z->bitcnt < (n) ) return INFLATE_MORE
+#define PEEK(n) ( (uint32_t)( z->bitbuf & ( ( (uint64_t)1 << (n) ) - 1 ) ) )
+#define DROP(n) do { z->bitbuf >>= (n); z->bitcnt -= (n); } while(0)
+
+static uint32_t bits_at(http_inflate_t *z, int off, int n) {
+    return (uint32_t)( ( z->bitbuf >> off ) & ( ( (uint64_t)1 << n ) - 1 ) );
+}
+
+// canonical Huffman code by the number of codes of each length
+static int huff_build(uint16_t *count, uint16_t *symbol,
+                      const uint8_t *length, int n) {
+    uint16_t offs[16];
+    int left = 1;
+    int i;
+    for ( i = 0; i < 16; i++ ) count[i] = 0;
+    for ( i = 0; i < n; i++ ) count[length[i]]++;
+    if ( count[0] == n ) return 0;
+    for ( i = 1; i < 16; i++ ) {
+        left <<= 1;
+        left -= count[i];
+        if ( left < 0 ) return -1;  // over-subscribed
+    }
+    offs[1] = 0;
+    for ( i = 1; i < 15; i++ ) offs[i + 1] = offs[i] + count[i];
+    for ( i = 0; i < n; i++ ) {
+        if ( length[i] ) symbol[offs[length[i]]++] = i;
+    }
+    return left;
+}
+
+// decode the next symbol without taking the bits, *nbits is the code length
+static int huff_peek(http_inflate_t *z, const uint16_t *count,
+                     const uint16_t *symbol, int *nbits) {
+    uint64_t bits = z->bitbuf;
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    int len;
+    for ( len = 1; len < 16; len++ ) {
+        if ( len > z->bitcnt ) return INFLATE_MORE;
+        code |= (int)( bits & 1 );
+        bits >>= 1;
+        int cnt = count[len];
+        if ( code - cnt < first ) {
+            *nbits = len;
+            return symbol[index + ( code - first )];
+        }
+        index += cnt;
+        first += cnt;
+        first <<= 1;
+        code <<= 1;
+    }
+    return INFLATE_ERROR;
+}
+
+static int fixed_tables(http_inflate_t *z) {
+    int i;
+    for ( i = 0; i < 144; i++ ) z->lengths[i] = 8;
+    for ( ; i < 256; i++ ) z->lengths[i] = 9;
+    for ( ; i < 280; i++ ) z->lengths[i] = 7;
+    for ( ; i < 288; i++ ) z->lengths[i] = 8;
+    huff_build(z->lencnt, z->lensym, z->lengths, 288);
+    for ( i = 0; i < 30; i++ ) z->lengths[i] = 5;
+    huff_build(z->distcnt, z->distsym, z->lengths, 30);
+    return 0;
+}
+
+static int flush_window(http_inflate_t *z) {
+    uint32_t size = z->total - z->flushed;
+    if ( !size ) return 0;
+    uint8_t *start = z->window + ( z->flushed & WINDOW_MASK );
+    if ( z->format == http_coding_gzip ) z->check = crc32_update(z->check, start, size);
+    else if ( z->format == http_coding_deflate ) z->check = adler32_update(z->check, start, size);
+    z->flushed = z->total;
+    if ( z->out && z->out(z->arg, start, size) < 0 ) return -1;
+    return 0;
+}
+
+static int put_byte(http_inflate_t *z, uint8_t b) {
+    z->window[z->total & WINDOW_MASK] = b;
+    z->total++;
+    // the window wraps, give the decoded part away before the overwrite
+    if ( !( z->total & WINDOW_MASK ) ) return flush_window(z);
+    return 0;
+}
+
+static int read_head(http_inflate_t *z) {
+    if ( z->format == http_coding_raw ) {
+        z->state = inf_block;
+        return 0;
+    }
+    if ( z->format == http_coding_deflate ) {
+        NEED(16);
+        uint32_t cmf = PEEK(8);
+        uint32_t flg = bits_at(z, 8, 8);
+        if ( ( cmf & 0x0f ) != 8 || ( ( cmf << 8 ) | flg ) % 31 ) {
+            // no zlib header, the raw deflate stream
+            z->format = http_coding_raw;
+            z->state = inf_block;
+            return 0;
+        }
+        if ( ( 1u << ( ( cmf >> 4 ) + 8 ) ) > HTTP_INFLATE_WINDOW ) {
+            DBG("inflate: window %d is too large", 1 << ( ( cmf >> 4 ) + 8 ));
+            return INFLATE_ERROR;
+        }
+        if ( flg & 0x20 ) return INFLATE_ERROR;  // preset dictionary
+        DROP(16);
+        z->check = 1;
+        z->state = inf_block;
+        return 0;
+    }
+    // gzip: ID1 ID2 CM FLG, then MTIME(4) XFL OS are skipped
+    NEED(32);
+    if ( PEEK(8) != 0x1f || bits_at(z, 8, 8) != 0x8b || bits_at(z, 16, 8) != 8 ) {
+        DBG("inflate: not a gzip stream");
+        return INFLATE_ERROR;
+    }
+    z->flags = (uint8_t)bits_at(z, 24, 8);
+    DROP(32);
+    z->count = 6;
+    z->check = 0;
+    z->state = inf_gzip_fixed;
+    return 0;
+}
+
+static int read_gzip_options(http_inflate_t *z) {
+    switch ( z->state ) {
+    case inf_gzip_fixed:
+        while ( z->count ) {
+            NEED(8);
+            DROP(8);
+            z->count--;
+        }
+        z->state = inf_gzip_extra_len;
+        return 0;
+    case inf_gzip_extra_len:
+        if ( z->flags & GZ_FEXTRA ) {
+            NEED(16);
+            z->count = (int)PEEK(16);
+            DROP(16);
+        } else {
+            z->count = 0;
+        }
+        z->state = inf_gzip_extra;
+        return 0;
+    case inf_gzip_extra:
+        while ( z->count ) {
+            NEED(8);
+            DROP(8);
+            z->count--;
+        }
+        z->state = inf_gzip_name;
+        return 0;
+    case inf_gzip_name:
+    case inf_gzip_comment: {
+        uint8_t flag = z->state == inf_gzip_name ? GZ_FNAME : GZ_FCOMMENT;
+        if ( z->flags & flag ) {
+            for ( ;; ) {
+                NEED(8);
+                uint32_t c = PEEK(8);
+                DROP(8);
+                if ( !c ) break;
+            }
+        }
+        z->state++;
+        return 0;
+    }
+    case inf_gzip_hcrc:
+        if ( z->flags & GZ_FHCRC ) {
+            NEED(16);
+            DROP(16);
+        }
+        z->state = inf_block;
+        return 0;
+    }
+    return INFLATE_ERROR;
+}
+
+static int read_block(http_inflate_t *z) {
+    NEED(3);
+    z->last = PEEK(1);
+    uint32_t type = bits_at(z, 1, 2);
+    DROP(3);
+    switch ( type ) {
+    case 0:
+        DROP(z->bitcnt & 7);
+        z->state = inf_stored_len;
+        break;
+    case 1:
+        fixed_tables(z);
+        z->state = inf_codes;
+        break;
+    case 2:
+        z->state = inf_table;
+        break;
+    default:
+        DBG("inflate: wrong block type");
+        return INFLATE_ERROR;
+    }
+    return 0;
+}
+
+static int read_stored(http_inflate_t *z) {
+    if ( z->state == inf_stored_len ) {
+        NEED(32);
+        uint32_t len = PEEK(16);
+        if ( ( len ^ 0xffff ) != bits_at(z, 16, 16) ) {
+            DBG("inflate: stored length mismatch");
+            return INFLATE_ERROR;
+        }
+        DROP(32);
+        z->count = (int)len;
+        z->state = inf_stored;
+    }
+    while ( z->count ) {
+        NEED(8);
+        if ( put_byte(z, (uint8_t)PEEK(8)) < 0 ) return INFLATE_ERROR;
+        DROP(8);
+        z->count--;
+    }
+    z->state = z->last ? inf_check : inf_block;
+    return 0;
+}
+
+static int read_table(http_inflate_t *z) {
+    int i;
+    switch ( z->state ) {
+    case inf_table:
+        NEED(14);
+        z->nlen = (int)PEEK(5) + 257;
+        z->ndist = (int)bits_at(z, 5, 5) + 1;
+        z->ncode = (int)bits_at(z, 10, 4) + 4;
+        DROP(14);
+        if ( z->nlen > 286 || z->ndist > 30 ) return INFLATE_ERROR;
+        z->step = 0;
+        z->state = inf_table_lens;
+        // fall through
+    case inf_table_lens:
+        while ( z->step < z->ncode ) {
+            NEED(3);
+            z->lengths[clen_order[z->step++]] = (uint8_t)PEEK(3);
+            DROP(3);
+        }
+        for ( i = z->ncode; i < 19; i++ ) z->lengths[clen_order[i]] = 0;
+        // the code lengths code is in the length/literal tables for a while
+        if ( huff_build(z->lencnt, z->lensym, z->lengths, 19) != 0 ) return INFLATE_ERROR;
+        z->step = 0;
+        z->state = inf_table_codes;
+        // fall through
+    case inf_table_codes:
+        while ( z->step < z->nlen + z->ndist ) {
+            int nbits = 0;
+            int sym = huff_peek(z, z->lencnt, z->lensym, &nbits);
+            if ( sym < 0 ) return sym;
+            if ( sym < 16 ) {
+                DROP(nbits);
+                z->lengths[z->step++] = (uint8_t)sym;
+                continue;
+            }
+            int extra = sym == 16 ? 2 : ( sym == 17 ? 3 : 7 );
+            NEED(nbits + extra);
+            int rep = (int)bits_at(z, nbits, extra) + ( sym == 16 ? 3 : ( sym == 17 ? 3 : 11 ) );
+            uint8_t len = 0;
+            if ( sym == 16 ) {
+                if ( !z->step ) return INFLATE_ERROR;
+                len = z->lengths[z->step - 1];
+            }
+            if ( z->step + rep > z->nlen + z->ndist ) return INFLATE_ERROR;
+            DROP(nbits + extra);
+            while ( rep-- ) z->lengths[z->step++] = len;
+        }
+        if ( !z->lengths[256] ) return INFLATE_ERROR;  // no end of block
+        i = huff_build(z->lencnt, z->lensym, z->lengths, z->nlen);
+        if ( i < 0 || ( i > 0 && z->nlen - z->lencnt[0] != 1 ) ) return INFLATE_ERROR;
+        i = huff_build(z->distcnt, z->distsym, z->lengths + z->nlen, z->ndist);
+        if ( i < 0 || ( i > 0 && z->ndist - z->distcnt[0] != 1 ) ) return INFLATE_ERROR;
+        z->state = inf_codes;
+        return 0;
+    }
+    return INFLATE_ERROR;
+}
+
+static int read_codes(http_inflate_t *z) {
+    for ( ;; ) {
+        int nbits = 0;
+        int sym;
+        switch ( z->state ) {
+        case inf_codes:
+            sym = huff_peek(z, z->lencnt, z->lensym, &nbits);
+            if ( sym < 0 ) return sym;
+            if ( sym < 256 ) {
+                DROP(nbits);
+                if ( put_byte(z, (uint8_t)sym) < 0 ) return INFLATE_ERROR;
+                break;
+            }
+            if ( sym == 256 ) {
+                DROP(nbits);
+                z->state = z->last ? inf_check : inf_block;
+                return 0;
+            }
+            sym -= 257;
+            if ( sym >= 29 ) return INFLATE_ERROR;
+            NEED(nbits + len_extra[sym]);
+            z->copy_len = len_base[sym] + (int)bits_at(z, nbits, len_extra[sym]);
+            DROP(nbits + len_extra[sym]);
+            z->state = inf_dist;
+            // fall through
+        case inf_dist:
+            sym = huff_peek(z, z->distcnt, z->distsym, &nbits);
+            if ( sym < 0 ) return sym;
+            if ( sym >= 30 ) return INFLATE_ERROR;
+            NEED(nbits + dist_extra[sym]);
+            z->copy_dist = dist_base[sym] + (int)bits_at(z, nbits, dist_extra[sym]);
+            DROP(nbits + dist_extra[sym]);
+            if ( (uint32_t)z->copy_dist > HTTP_INFLATE_WINDOW ||
+                 (uint32_t)z->copy_dist > z->total ) {
+                DBG("inflate: distance %d is too far", z->copy_dist);
+                return INFLATE_ERROR;
+            }
+            z->state = inf_copy;
+            // fall through
+        case inf_copy:
+            while ( z->copy_len ) {
+                uint8_t b = z->window[( z->total - z->copy_dist ) & WINDOW_MASK];
+                if ( put_byte(z, b) < 0 ) return INFLATE_ERROR;
+                z->copy_len--;
+            }
+            z->state = inf_codes;
+            break;
+        default:
+            return INFLATE_ERROR;
+        }
+    }
+}
+
+static int read_check(http_inflate_t *z) {
+    uint32_t check = 0;
+    if ( flush_window(z) < 0 ) return INFLATE_ERROR;
+    DROP(z->bitcnt & 7);
+    if ( z->format == http_coding_gzip ) {
+        // CRC32 and ISIZE, little endian
+        NEED(64);
+        check = PEEK(32);
+        uint32_t isize = bits_at(z, 32, 32);
+        if ( check != z->check || isize != z->total ) {
+            DBG("inflate: gzip check fail");
+            return INFLATE_ERROR;
+        }
+        DROP(32);
+        DROP(32);
+    } else if ( z->format == http_coding_deflate ) {
+        // Adler32, big endian
+        NEED(32);
+        int i;
+        for ( i = 0; i < 4; i++ ) check = ( check << 8 ) | bits_at(z, i * 8, 8);
+        if ( check != z->check ) {
+            DBG("inflate: adler32 check fail");
+            return INFLATE_ERROR;
+        }
+        DROP(32);
+    }
+    z->state = inf_done;
+    return 0;
+}
+
+int http_inflate_init(http_inflate_t *z, int format, http_inflate_out_f out, void *arg) {
+    memset(z, 0x0, sizeof(http_inflate_t));
+    if ( format == http_coding_identity ) return -1;
+    z->window = (uint8_t *)malloc(HTTP_INFLATE_WINDOW);
+    if ( !z->window ) {
+        DBG("inflate: window alloc fail");
+        return -1;
+    }
+    z->format = (uint8_t)format;
+    z->state = inf_head;
+    z->out = out;
+    z->arg = arg;
+    return 0;
+}
+
+int http_inflate_part(http_inflate_t *z, const uint8_t *in, size_t len) {
+    int ret = 0;
+    if ( !z->window || z->state == inf_bad ) return -1;
+    while ( z->state != inf_done ) {
+        while ( z->bitcnt <= 56 && len ) {
+            z->bitbuf |= (uint64_t)*in++ << z->bitcnt;
+            z->bitcnt += 8;
+            len--;
+        }
+        switch ( z->state ) {
+        case inf_head:
+            ret = read_head(z);
+            break;
+        case inf_gzip_fixed:
+        case inf_gzip_extra_len:
+        case inf_gzip_extra:
+        case inf_gzip_name:
+        case inf_gzip_comment:
+        case inf_gzip_hcrc:
+            ret = read_gzip_options(z);
+            break;
+        case inf_block:
+            ret = read_block(z);
+            break;
+        case inf_stored_len:
+        case inf_stored:
+            ret = read_stored(z);
+            break;
+        case inf_table:
+        case inf_table_lens:
+        case inf_table_codes:
+            ret = read_table(z);
+            break;
+        case inf_codes:
+        case inf_dist:
+        case inf_copy:
+            ret = read_codes(z);
+            break;
+        case inf_check:
+            ret = read_check(z);
+            break;
+        default:
+            ret = INFLATE_ERROR;
+        }
+        if ( ret == INFLATE_MORE && z->bitcnt <= 56 ) {
+            // the bits are kept, wait for the next piece
+            if ( !len ) {
+                if ( flush_window(z) < 0 ) break;
+                return 0;
+            }
+            continue;
+        }
+        if ( ret < 0 ) break;
+    }
+    if ( z->state == inf_done ) return 1;
+    DBG("inflate: broken stream");
+    z->state = inf_bad;
+    return -1;
+}
+
+void http_inflate_fin(http_inflate_t *z) {
+    if ( z->window ) free(z->window);
+    z->window = NULL;
+}
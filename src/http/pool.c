@@ -0,0 +1,261 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "http/pool.h"
+#include <debug.h>
+#include <bsd/socket.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <ssl/ssl.h>
+#if defined(__USE_STD__)
+# include <errno.h>
+#endif
+
+#if defined(HTTP_THREAD)
+#include <sys/mutex.h>
+static arrow_mutex *_pool_mutex = NULL;
+#define HTTP_POOL_LOCK      arrow_mutex_lock(_pool_mutex)
+#define HTTP_POOL_UNLOCK    arrow_mutex_unlock(_pool_mutex)
+#else
+#define HTTP_POOL_LOCK
+#define HTTP_POOL_UNLOCK
+#endif
+
+enum {
+  pool_free = 0,
+  pool_busy,
+  pool_idle
+};
+
+typedef struct _http_pool_conn_ {
+  char host[HTTP_POOL_HOST_LEN];
+  uint16_t port;
+  uint8_t cipher;
+  uint8_t state;
+  int sock;
+  uint32_t idle_since;
+} http_pool_conn_t;
+
+static http_pool_conn_t __pool[HTTP_POOL_SIZE];
+
+static int conn_is_key(http_pool_conn_t *conn, http_request_t *req) {
+  size_t len = property_size(&req->host);
+  if ( conn->port != req->port ) return 0;
+  if ( conn->cipher != ( req->is_cipher ? 1 : 0 ) ) return 0;
+  if ( strlen(conn->host) != len ) return 0;
+  return strncmp(conn->host, P_VALUE(req->host), len) == 0;
+}
+
+static void conn_close(http_pool_conn_t *conn) {
+  if ( conn->state == pool_idle ) {
+    HTTP_DBG("pool: close %d", conn->sock);
+    if ( conn->cipher ) ssl_close(conn->sock);
+    soc_close(conn->sock);
+  }
+  conn->sock = -1;
+  conn->state = pool_free;
+}
+
+static void pool_evict(void) {
+  uint32_t now = http_pool_now();
+  int i;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( __pool[i].state == pool_idle &&
+         now - __pool[i].idle_since >= HTTP_POOL_IDLE_TIMEOUT ) {
+      conn_close(__pool + i);
+    }
+  }
+}
+
+static http_pool_conn_t *pool_slot(void) {
+  http_pool_conn_t *oldest = NULL;
+  int i;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( __pool[i].state == pool_free ) return __pool + i;
+    if ( __pool[i].state == pool_idle &&
+         ( !oldest || (int32_t)( __pool[i].idle_since - oldest->idle_since ) < 0 ) ) {
+      oldest = __pool + i;
+    }
+  }
+  if ( oldest ) conn_close(oldest);
+  return oldest;
+}
+
+static void pool_drop(http_client_t *cli) {
+  if ( cli->pool_slot < 0 || cli->pool_slot >= HTTP_POOL_SIZE ) return;
+  conn_close(__pool + cli->pool_slot);
+  cli->pool_slot = -1;
+}
+
+static int pool_acquire(http_client_t *cli, http_request_t *req) {
+  int i;
+  pool_drop(cli);
+  pool_evict();
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    http_pool_conn_t *conn = __pool + i;
+    if ( conn->state != pool_idle || !conn_is_key(conn, req) ) continue;
+    if ( !http_pool_sock_alive(conn->sock) ) {
+      DBG("pool: the peer closed %d", conn->sock);
+      conn_close(conn);
+      continue;
+    }
+    conn->state = pool_busy;
+    cli->sock = conn->sock;
+    cli->flags._cipher = conn->cipher;
+    cli->flags._reused = 1;
+    cli->pool_slot = i;
+    HTTP_DBG("pool: reuse %d", cli->sock);
+    return 1;
+  }
+  if ( property_size(&req->host) >= HTTP_POOL_HOST_LEN ) return 0;
+  http_pool_conn_t *conn = pool_slot();
+  if ( !conn ) return 0;
+  memcpy(conn->host, P_VALUE(req->host), property_size(&req->host));
+  conn->host[property_size(&req->host)] = 0x0;
+  conn->port = req->port;
+  conn->cipher = req->is_cipher ? 1 : 0;
+  conn->state = pool_busy;
+  conn->sock = -1;
+  cli->pool_slot = conn - __pool;
+  return 0;
+}
+
+int http_pool_init(void) {
+#if defined(HTTP_THREAD)
+  if ( !_pool_mutex && arrow_mutex_init(&_pool_mutex) < 0 ) return -1;
+#endif
+  return 0;
+}
+
+void http_pool_deinit(void) {
+  http_pool_clear();
+#if defined(HTTP_THREAD)
+  if ( _pool_mutex ) arrow_mutex_deinit(_pool_mutex);
+  _pool_mutex = NULL;
+#endif
+}
+
+int http_pool_acquire(http_client_t *cli, http_request_t *req) {
+  if ( cli->sock >= 0 ) return 0;
+  HTTP_POOL_LOCK;
+  int ret = pool_acquire(cli, req);
+  HTTP_POOL_UNLOCK;
+  return ret;
+}
+
+int http_pool_release(http_client_t *cli) {
+  int ret = 0;
+  if ( cli->pool_slot < 0 || cli->pool_slot >= HTTP_POOL_SIZE ) return -1;
+  HTTP_POOL_LOCK;
+  http_pool_conn_t *conn = __pool + cli->pool_slot;
+  if ( cli->sock < 0 ||
+       cli->flags._peer_close ||
+       !cli->flags._drained ||
+       conn->cipher != cli->flags._cipher ) {
+    pool_drop(cli);
+    ret = -1;
+  } else {
+    conn->sock = cli->sock;
+    conn->state = pool_idle;
+    conn->idle_since = http_pool_now();
+    cli->sock = -1;
+    cli->pool_slot = -1;
+  }
+  HTTP_POOL_UNLOCK;
+  return ret;
+}
+
+void http_pool_drop(http_client_t *cli) {
+  if ( cli->pool_slot < 0 ) return;
+  HTTP_POOL_LOCK;
+  pool_drop(cli);
+  HTTP_POOL_UNLOCK;
+}
+
+void http_pool_evict(void) {
+  HTTP_POOL_LOCK;
+  pool_evict();
+  HTTP_POOL_UNLOCK;
+}
+
+void http_pool_clear(void) {
+  int i;
+  HTTP_POOL_LOCK;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( __pool[i].state == pool_idle ) conn_close(__pool + i);
+  }
+  HTTP_POOL_UNLOCK;
+}
+
+int http_pool_idle_count(void) {
+  int i;
+  int count = 0;
+  HTTP_POOL_LOCK;
+  for ( i = 0; i < HTTP_POOL_SIZE; i++ ) {
+    if ( __pool[i].state == pool_idle ) count++;
+  }
+  HTTP_POOL_UNLOCK;
+  return count;
+}
+
+int http_pool_client_open(http_client_t *cli, http_request_t *req) {
+  if ( cli->protocol == api_via_http ) {
+    http_pool_acquire(cli, req);
+  }
+  return default_http_client_open(cli, req);
+}
+
+int http_pool_client_do(http_client_t *cli, http_response_t *res) {
+  http_request_t *req = cli->request;
+  int ret = default_http_client_do(cli, res);
+  if ( ret < 0 && cli->flags._reused && !cli->response_code && req ) {
+    // the server dropped the idle connection before the answer
+    uint8_t _close = cli->flags._close;
+    DBG("pool: stale connection, reconnect");
+    http_response_free(res);
+    cli->flags._close = true;
+    default_http_client_close(cli);
+    cli->flags._close = _close;
+    cli->flags._reused = 0;
+    ret = default_http_client_open(cli, req);
+    if ( ret >= 0 ) ret = default_http_client_do(cli, res);
+  }
+  cli->flags._reused = 0;
+  return ret;
+}
+
+int http_pool_client_close(http_client_t *cli) {
+  if ( cli->protocol == api_via_http &&
+       cli->flags._close &&
+       http_pool_release(cli) == 0 ) {
+    cli->request = NULL;
+    cli->flags._cipher = 0;
+    return 0;
+  }
+  return default_http_client_close(cli);
+}
+
+int __attribute_weak__ http_pool_sock_alive(int sock) {
+  uint8_t tmp;
+  int ret = recv(sock, &tmp, 1, MSG_PEEK | MSG_DONTWAIT);
+  // 0 - the orderly shutdown, > 0 - unexpected data
+  if ( ret >= 0 ) return 0;
+  // no data yet is the only good answer, the rest are the socket errors
+#if defined(EAGAIN) && defined(EWOULDBLOCK)
+  return errno == EAGAIN || errno == EWOULDBLOCK;
+#elif defined(EAGAIN)
+  return errno == EAGAIN;
+#else
+  // no errno here, the port overrides this check
+  return 1;
+#endif
+}
+
+uint32_t __attribute_weak__ http_pool_now(void) {
+  return time_mono_ms();
+}
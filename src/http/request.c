@@ -109,6 +109,7 @@ void http_request_init(http_request_t *req, int meth, const char *url) {
   property_map_init(&req->content_type);
   req->_response_payload_meth._p_set_handler = default_set_payload_handler;
   req->_response_payload_meth._p_add_handler = default_add_payload_handler;
+  req->_response_payload_meth._p_arg = NULL;
 }
 
 void http_request_close(http_request_t *req) {
@@ -38,6 +38,7 @@ void http_response_init(http_response_t *res, _payload_meth_t *handler) {
   memset(res, 0x00, sizeof(http_response_t));
   res->_p_meth._p_set_handler = handler->_p_set_handler;
   res->_p_meth._p_add_handler = handler->_p_add_handler;
+  res->_p_meth._p_arg = handler->_p_arg;
 }
 
 void http_response_free(http_response_t *res) {
@@ -50,6 +51,15 @@ void http_response_free(http_response_t *res) {
 }
 
 void http_response_add_header(http_response_t *req, property_t key, property_t value) {
+#if !defined(PROPERTY_NO_INTERN)
+    // the same few names in every response: the map holds the shared copy
+    property_t name = property_intern(P_VALUE(key), (int)property_size(&key));
+    if ( !IS_EMPTY(name) ) {
+        property_map_add(&req->header, name, value);
+        property_free(&name);
+        return;
+    }
+#endif
     property_map_add(&req->header, key, value);
 }
 
@@ -8,18 +8,100 @@
 
 #include "http/routine.h"
 #include <http/client.h>
+#include <http/pool.h>
 #include <arrow/sign.h>
 #include <debug.h>
 #include <http/client_mqtt.h>
 
-static http_client_t _cli;
+// HTTP_THREAD: the API calls take a free client from this set,
+// so up to HTTP_CLIENTS requests are processed in parallel.
+// The first one is the current_client(): while it's set up for a session
+// (opened socket or the not http protocol) every call goes through it,
+// so the session flows stay single-threaded.
+static http_client_t _cli[HTTP_CLIENTS];
+
+#if defined(HTTP_THREAD)
+#include <sys/mutex.h>
+#include <ssl/ssl.h>
+#include <time/time.h>
+static uint8_t _cli_busy[HTTP_CLIENTS];
+static arrow_mutex *_cli_mutex = NULL;
+#define HTTP_CLIENTS_LOCK     arrow_mutex_lock(_cli_mutex)
+#define HTTP_CLIENTS_UNLOCK   arrow_mutex_unlock(_cli_mutex)
+#define HTTP_CLIENT_WAIT      10
+#endif
+
+#if defined(HTTP_THREAD) && defined(USE_STATIC)
+// the hash contexts are on the stack, but the sign chunks are static
+static arrow_mutex *_sign_mutex = NULL;
+#define HTTP_SIGN_LOCK        arrow_mutex_lock(_sign_mutex)
+#define HTTP_SIGN_UNLOCK      arrow_mutex_unlock(_sign_mutex)
+#else
+#define HTTP_SIGN_LOCK
+#define HTTP_SIGN_UNLOCK
+#endif
 
 http_client_t *current_client(void) {
-  return &_cli;
+  return _cli;
+}
+
+#if defined(HTTP_THREAD)
+static int client_is_reserved(http_client_t *cli) {
+  return !cli->flags._close || cli->protocol != api_via_http;
+}
+
+static http_client_t *http_client_take(void) {
+  int wait = 0;
+  do {
+    http_client_t *cli = NULL;
+    int i;
+    HTTP_CLIENTS_LOCK;
+    if ( client_is_reserved(_cli) ) {
+      if ( !_cli_busy[0] ) cli = _cli;
+    } else {
+      for ( i = 0; i < HTTP_CLIENTS; i++ ) {
+        if ( !_cli_busy[i] ) {
+          cli = _cli + i;
+          break;
+        }
+      }
+    }
+    if ( cli ) _cli_busy[cli - _cli] = 1;
+    HTTP_CLIENTS_UNLOCK;
+    if ( cli ) return cli;
+    msleep(HTTP_CLIENT_WAIT);
+    wait += HTTP_CLIENT_WAIT;
+  } while ( wait < DEFAULT_API_TIMEOUT );
+  DBG("HTTP: no free client");
+  return NULL;
+}
+
+static void http_client_give(http_client_t *cli) {
+  HTTP_CLIENTS_LOCK;
+  _cli_busy[cli - _cli] = 0;
+  HTTP_CLIENTS_UNLOCK;
 }
+#else
+# define http_client_take()     (_cli)
+# define http_client_give(cli)
+#endif
 
 int __http_init(void) {
-    return http_client_init(&_cli);
+    int i;
+#if defined(HTTP_THREAD)
+    if ( !_cli_mutex && arrow_mutex_init(&_cli_mutex) < 0 ) return -1;
+# if defined(USE_STATIC)
+    if ( !_sign_mutex && arrow_mutex_init(&_sign_mutex) < 0 ) return -1;
+# endif
+    if ( ssl_init() < 0 ) return -1;
+    memset(_cli_busy, 0x0, sizeof(_cli_busy));
+#endif
+    if ( http_pool_init() < 0 ) return -1;
+    for ( i = 0; i < HTTP_CLIENTS; i++ ) {
+        int ret = http_client_init(_cli + i);
+        if ( ret < 0 ) return ret;
+    }
+    return 0;
 }
 
 typedef struct protocol_handler_ {
@@ -46,19 +128,24 @@ int __http_routine(response_init_f req_init, void *arg_init,
   int ret = 0;
   http_request_t request;
   http_response_t response;
-  if ( _cli.protocol > client_protocol_size ) {
-      DBG("Unknown client protocol %lu", _cli.protocol);
+  http_client_t *cli = http_client_take();
+  if ( !cli ) return -1;
+  if ( cli->protocol > client_protocol_size ) {
+      DBG("Unknown client protocol %lu", cli->protocol);
+      http_client_give(cli);
       return -2;
   }
   req_init(&request, arg_init);
+  HTTP_SIGN_LOCK;
   sign_request(&request);
+  HTTP_SIGN_UNLOCK;
 
-  protocol_handler_t *ph = &client_protocols[_cli.protocol];
-  if ( (ret = ph->client_open(&_cli, &request)) >= 0 ) {
-      ret = ph->client_do(&_cli, &response);
+  protocol_handler_t *ph = &client_protocols[cli->protocol];
+  if ( (ret = ph->client_open(cli, &request)) >= 0 ) {
+      ret = ph->client_do(cli, &response);
   }
   http_request_close(&request);
-  ph->client_close(&_cli);
+  ph->client_close(cli);
   if ( ret < 0 ) goto http_error;
   if ( resp_proc ) {
     ret = resp_proc(&response, arg_proc);
@@ -70,13 +157,29 @@ int __http_routine(response_init_f req_init, void *arg_init,
   }
 http_error:
   http_response_free(&response);
-  if ( http_session_is_open(&_cli) && ret < 0 ) {
-      http_session_close_set(&_cli, true);
-      ph->client_close(&_cli);
+  if ( http_session_is_open(cli) && ret < 0 ) {
+      http_session_close_set(cli, true);
+      ph->client_close(cli);
   }
+  http_client_give(cli);
   return ret;
 }
 
 int __http_done(void) {
-    return http_client_free(&_cli);
+    int i;
+    int ret = 0;
+    http_pool_deinit();
+    for ( i = 0; i < HTTP_CLIENTS; i++ ) {
+        if ( http_client_free(_cli + i) < 0 ) ret = -1;
+    }
+#if defined(HTTP_THREAD)
+    ssl_deinit();
+# if defined(USE_STATIC)
+    arrow_mutex_deinit(_sign_mutex);
+    _sign_mutex = NULL;
+# endif
+    arrow_mutex_deinit(_cli_mutex);
+    _cli_mutex = NULL;
+#endif
+    return ret;
 }
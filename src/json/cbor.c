@@ -0,0 +1,427 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "json/cbor.h"
+#include <json/property_json.h>
+#include <math.h>
+#include <debug.h>
+
+enum cbor_major_type {
+    cbor_uint   = 0,
+    cbor_nint   = 1,
+    cbor_bytes  = 2,
+    cbor_text   = 3,
+    cbor_array  = 4,
+    cbor_map    = 5,
+    cbor_tag    = 6,
+    cbor_simple = 7
+};
+
+#define CBOR_FALSE   0xf4
+#define CBOR_TRUE    0xf5
+#define CBOR_NULL    0xf6
+#define CBOR_FLOAT32 0xfa
+#define CBOR_FLOAT64 0xfb
+
+#define CBOR_INT_LIMIT 9223372036854775807.0
+
+static int cbor_put_be(uint8_t *out, uint64_t val, int size) {
+    int i;
+    for ( i = size - 1; i >= 0; i-- ) {
+        out[i] = (uint8_t)(val & 0xff);
+        val >>= 8;
+    }
+    return size;
+}
+
+static int cbor_head(uint8_t *out, uint8_t major, uint64_t val) {
+    major <<= 5;
+    if ( val < 24 ) {
+        out[0] = major | (uint8_t)val;
+        return 1;
+    } else if ( val <= 0xff ) {
+        out[0] = major | 24;
+        return 1 + cbor_put_be(out + 1, val, 1);
+    } else if ( val <= 0xffff ) {
+        out[0] = major | 25;
+        return 1 + cbor_put_be(out + 1, val, 2);
+    } else if ( val <= 0xffffffffUL ) {
+        out[0] = major | 26;
+        return 1 + cbor_put_be(out + 1, val, 4);
+    }
+    out[0] = major | 27;
+    return 1 + cbor_put_be(out + 1, val, 8);
+}
+
+static int cbor_number(uint8_t *out, double num) {
+    double intg;
+    double fraction = modf(num, &intg);
+    if ( fraction == 0.0 && num < CBOR_INT_LIMIT && num > -CBOR_INT_LIMIT ) {
+        int64_t i = (int64_t)num;
+        if ( i >= 0 ) return cbor_head(out, cbor_uint, (uint64_t)i);
+        return cbor_head(out, cbor_nint, (uint64_t)(-1 - i));
+    }
+    float f = (float)num;
+    if ( (double)f == num || num != num ) {
+        union { float f; uint32_t u; } u32;
+        u32.f = f;
+        out[0] = CBOR_FLOAT32;
+        return 1 + cbor_put_be(out + 1, u32.u, 4);
+    }
+    union { double d; uint64_t u; } u64;
+    u64.d = num;
+    out[0] = CBOR_FLOAT64;
+    return 1 + cbor_put_be(out + 1, u64.u, 8);
+}
+
+static uint64_t cbor_children(JsonNode *node) {
+    uint64_t count = 0;
+    JsonNode *tmp = NULL;
+    json_foreach(tmp, node) {
+        count++;
+    }
+    return count;
+}
+
+static int cbor_is_member(cbor_encode_machine_t *cem) {
+    return cem->ptr != cem->root &&
+            cem->ptr->parent &&
+            cem->ptr->parent->tag == JSON_OBJECT;
+}
+
+static size_t cbor_node_size(JsonNode *o, int member) {
+    uint8_t head[9];
+    size_t ret = 0;
+    if ( member ) {
+        size_t key_len = property_size(&o->key);
+        ret += cbor_head(head, cbor_text, key_len) + key_len;
+    }
+    switch(o->tag) {
+    case JSON_NULL:
+    case JSON_BOOL:
+        ret += 1;
+        break;
+    case JSON_STRING: {
+        size_t str_len = strlen(o->string_);
+        ret += cbor_head(head, cbor_text, str_len) + str_len;
+    } break;
+    case JSON_NUMBER:
+        ret += cbor_number(head, o->number_);
+        break;
+    case JSON_ARRAY:
+    case JSON_OBJECT: {
+        JsonNode *tmp = NULL;
+        ret += cbor_head(head,
+                         o->tag == JSON_ARRAY ? cbor_array : cbor_map,
+                         cbor_children(o));
+        json_foreach(tmp, o) {
+            ret += cbor_node_size(tmp, o->tag == JSON_OBJECT);
+        }
+    } break;
+    }
+    return ret;
+}
+
+size_t cbor_size(JsonNode *node) {
+    if ( !node ) return 0;
+    return cbor_node_size(node, 0);
+}
+
+static void cem_set_head(cbor_encode_machine_t *cem, int len) {
+    cem->head_len = (uint8_t)len;
+    cem->seg = cem->head;
+    cem->seg_len = cem->head_len;
+}
+
+static void cem_set_data(cbor_encode_machine_t *cem, const char *data, size_t len) {
+    cem->seg = (const uint8_t *)data;
+    cem->seg_len = len;
+}
+
+// prepare the next piece of the output: a header or a string body
+static int cem_next_segment(cbor_encode_machine_t *cem) {
+    cem->start = 0;
+    cem->seg_len = 0;
+    while ( cem->state != cem_encode_state_done ) {
+        switch(cem->state) {
+        case cem_encode_state_key: {
+            if ( cbor_is_member(cem) ) {
+                cem_set_head(cem, cbor_head(cem->head,
+                                            cbor_text,
+                                            property_size(&cem->ptr->key)));
+                cem->state = cem_encode_state_key_data;
+                return 0;
+            }
+            cem->state = cem_encode_state_value;
+        } break;
+        case cem_encode_state_key_data: {
+            cem_set_data(cem,
+                         P_VALUE(cem->ptr->key),
+                         property_size(&cem->ptr->key));
+            cem->state = cem_encode_state_value;
+            return 0;
+        }
+        case cem_encode_state_value: {
+            JsonNode *node = cem->ptr;
+            cem->state = cem_encode_state_next;
+            switch(node->tag) {
+            case JSON_NULL:
+                cem->head[0] = CBOR_NULL;
+                cem_set_head(cem, 1);
+                break;
+            case JSON_BOOL:
+                cem->head[0] = node->bool_ ? CBOR_TRUE : CBOR_FALSE;
+                cem_set_head(cem, 1);
+                break;
+            case JSON_STRING:
+                cem_set_head(cem, cbor_head(cem->head,
+                                            cbor_text,
+                                            strlen(node->string_)));
+                cem->state = cem_encode_state_value_data;
+                break;
+            case JSON_NUMBER:
+                cem_set_head(cem, cbor_number(cem->head, node->number_));
+                break;
+            case JSON_ARRAY:
+            case JSON_OBJECT:
+                cem_set_head(cem, cbor_head(cem->head,
+                                            node->tag == JSON_ARRAY ? cbor_array : cbor_map,
+                                            cbor_children(node)));
+                break;
+            default:
+                return -1;
+            }
+            return 0;
+        }
+        case cem_encode_state_value_data: {
+            cem_set_data(cem, cem->ptr->string_, strlen(cem->ptr->string_));
+            cem->state = cem_encode_state_next;
+            return 0;
+        }
+        case cem_encode_state_next: {
+            JsonNode *child = json_first_child(cem->ptr);
+            if ( child ) {
+                cem->ptr = child;
+            } else {
+                while ( cem->ptr != cem->root && !json_next(cem->ptr) ) {
+                    cem->ptr = cem->ptr->parent;
+                }
+                if ( cem->ptr == cem->root ) {
+                    cem->state = cem_encode_state_done;
+                    break;
+                }
+                cem->ptr = json_next(cem->ptr);
+            }
+            cem->state = cem_encode_state_key;
+        } break;
+        default:
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int cbor_encode_init(cbor_encode_machine_t *cem, JsonNode *node) {
+    memset(cem, 0x0, sizeof(cbor_encode_machine_t));
+    if ( !node ) return -1;
+    cem->root = node;
+    cem->ptr = node;
+    cem->state = cem_encode_state_key;
+    return 0;
+}
+
+int cbor_encode_part(cbor_encode_machine_t *cem, char *s, int len) {
+    int total = 0;
+    while ( len > 0 ) {
+        if ( cem->start < cem->seg_len ) {
+            size_t chunk = cem->seg_len - cem->start;
+            if ( chunk > (size_t)len ) chunk = (size_t)len;
+            memcpy(s, cem->seg + cem->start, chunk);
+            cem->start += chunk;
+            s += chunk;
+            len -= (int)chunk;
+            total += (int)chunk;
+            continue;
+        }
+        if ( cem->state == cem_encode_state_done ) break;
+        if ( cem_next_segment(cem) < 0 ) return -1;
+    }
+    return total;
+}
+
+int cbor_encode_fin(cbor_encode_machine_t *cem) {
+    cem->root = NULL;
+    cem->ptr = NULL;
+    cem->seg = NULL;
+    cem->seg_len = 0;
+    cem->state = cem_encode_state_done;
+    return 0;
+}
+
+int cbor_encode(JsonNode *node, uint8_t *buf, size_t len) {
+    cbor_encode_machine_t cem;
+    size_t size = cbor_size(node);
+    if ( !size || size > len ) return -1;
+    if ( cbor_encode_init(&cem, node) < 0 ) return -1;
+    int ret = cbor_encode_part(&cem, (char *)buf, (int)size);
+    cbor_encode_fin(&cem);
+    if ( ret != (int)size ) return -1;
+    return ret;
+}
+
+// decoder
+
+typedef struct _cbor_reader_ {
+    const uint8_t *p;
+    const uint8_t *end;
+} cbor_reader_t;
+
+static int cbor_read_be(cbor_reader_t *r, int size, uint64_t *val) {
+    int i;
+    if ( r->end - r->p < size ) return -1;
+    *val = 0;
+    for ( i = 0; i < size; i++ ) {
+        *val = (*val << 8) | *r->p++;
+    }
+    return 0;
+}
+
+static int cbor_read_head(cbor_reader_t *r, uint8_t *major, uint8_t *info, uint64_t *val) {
+    if ( r->p >= r->end ) return -1;
+    uint8_t ib = *r->p++;
+    *major = ib >> 5;
+    *info = ib & 0x1f;
+    if ( *info < 24 ) {
+        *val = *info;
+        return 0;
+    }
+    switch ( *info ) {
+    case 24: return cbor_read_be(r, 1, val);
+    case 25: return cbor_read_be(r, 2, val);
+    case 26: return cbor_read_be(r, 4, val);
+    case 27: return cbor_read_be(r, 8, val);
+    default:
+        // indefinite length items are not supported
+        return -1;
+    }
+}
+
+static char *cbor_read_text(cbor_reader_t *r, uint64_t len) {
+    SB sb;
+    if ( (uint64_t)(r->end - r->p) < len ) return NULL;
+    if ( sb_init(&sb) < 0 ) return NULL;
+    if ( sb_put(&sb, (const char *)r->p, (int)len) < 0 ) {
+        sb_free(&sb);
+        return NULL;
+    }
+    r->p += len;
+    return sb_finish(&sb);
+}
+
+static double cbor_half(uint16_t h) {
+    int exp = (h >> 10) & 0x1f;
+    int mant = h & 0x3ff;
+    double val;
+    if ( exp == 0 ) val = ldexp(mant, -24);
+    else if ( exp != 31 ) val = ldexp(mant + 1024, exp - 25);
+    else val = mant == 0 ? INFINITY : NAN;
+    return (h & 0x8000) ? -val : val;
+}
+
+static JsonNode *cbor_decode_item(cbor_reader_t *r, int depth) {
+    uint8_t major, info;
+    uint64_t val;
+    JsonNode *node = NULL;
+    if ( depth > CBOR_MAX_DEPTH ) return NULL;
+    if ( cbor_read_head(r, &major, &info, &val) < 0 ) return NULL;
+    switch ( major ) {
+    case cbor_uint:
+        return json_mknumber((double)val);
+    case cbor_nint:
+        return json_mknumber(-1.0 - (double)val);
+    case cbor_bytes:
+    case cbor_text: {
+        char *str = cbor_read_text(r, val);
+        if ( !str ) return NULL;
+        node = json_mkstring(str);
+        free(str);
+        return node;
+    }
+    case cbor_array: {
+        uint64_t i;
+        node = json_mkarray();
+        if ( !node ) return NULL;
+        for ( i = 0; i < val; i++ ) {
+            JsonNode *el = cbor_decode_item(r, depth + 1);
+            if ( !el ) goto decode_error;
+            json_append_element(node, el);
+        }
+        return node;
+    }
+    case cbor_map: {
+        uint64_t i;
+        node = json_mkobject();
+        if ( !node ) return NULL;
+        for ( i = 0; i < val; i++ ) {
+            uint8_t kmajor, kinfo;
+            uint64_t klen;
+            if ( cbor_read_head(r, &kmajor, &kinfo, &klen) < 0 ||
+                 kmajor != cbor_text ) goto decode_error;
+            char *str = cbor_read_text(r, klen);
+            if ( !str ) goto decode_error;
+            property_t key = p_json(str);
+            JsonNode *el = cbor_decode_item(r, depth + 1);
+            if ( !el ) {
+                property_free(&key);
+                goto decode_error;
+            }
+            json_append_member(node, key, el);
+        }
+        return node;
+    }
+    case cbor_tag:
+        // skip the semantic tag, keep the item itself
+        return cbor_decode_item(r, depth + 1);
+    case cbor_simple:
+        switch ( info ) {
+        case 20: return json_mkbool(false);
+        case 21: return json_mkbool(true);
+        case 22:
+        case 23: return json_mknull();
+        case 25: return json_mknumber(cbor_half((uint16_t)val));
+        case 26: {
+            union { float f; uint32_t u; } u32;
+            u32.u = (uint32_t)val;
+            return json_mknumber(u32.f);
+        }
+        case 27: {
+            union { double d; uint64_t u; } u64;
+            u64.u = val;
+            return json_mknumber(u64.d);
+        }
+        default:
+            return NULL;
+        }
+    default:
+        return NULL;
+    }
+decode_error:
+    json_delete(node);
+    return NULL;
+}
+
+JsonNode *cbor_decode(const uint8_t *buf, size_t len) {
+    cbor_reader_t r = { buf, buf + len };
+    JsonNode *root = cbor_decode_item(&r, 0);
+    if ( root && r.p != r.end ) {
+        DBG("CBOR: %d trailing bytes", (int)(r.end - r.p));
+        json_delete(root);
+        return NULL;
+    }
+    return root;
+}
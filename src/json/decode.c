@@ -108,9 +108,21 @@ static int jpm_number_body(json_parse_machine_t *jpm, char byte) {
     return 0;
 }
 
+// the nested machine closed before the first value: {} or []
+static int jpm_empty_end(json_parse_machine_t *jpm) {
+    if ( !jpm->p || json_first_child(jpm->p->root) ) return -1;
+    jpm->complete = 1;
+    jpm->process_byte = NULL;
+    return 0;
+}
+
 static int jpm_value_init(json_parse_machine_t *jpm, char byte) {
     if ( is_space(byte) ) return 0;
     switch( byte ) {
+    case ']': {
+        if ( !jpm->p || !is_array_context(jpm) ) return -1;
+        return jpm_empty_end(jpm);
+    } break;
     case '{' : {
         json_parse_machine_t *nvalue = alloc_type(json_parse_machine_t);
         json_parse_machine_init(nvalue);
@@ -211,6 +223,8 @@ static int jpm_key_init(json_parse_machine_t *jpm, char byte) {
             return -1;
         jpm->process_byte = (_json_parse_fn) jpm_key_body;
     } break;
+    case '}':
+        return jpm_empty_end(jpm);
     default:
         return -1;
     }
@@ -233,8 +247,9 @@ static int jpm_key_body(json_parse_machine_t *jpm, char byte) {
     switch ( byte ) {
     case '"': {
         if ( sb_size(&jpm->buffer) <= 0 ) return -1;
+        int len = (int)( jpm->buffer.cur - jpm->buffer.start );
         char *str = sb_finish(&jpm->buffer);
-        property_t key = p_json(str);
+        property_t key = json_key_property(str, len);
         property_move(&jpm->key, &key);
         property_free(&key);
         sb_clear(&jpm->buffer);
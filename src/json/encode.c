@@ -8,7 +8,6 @@
 
 #include "json/json.h"
 
-extern void emit_number(SB *out, double num);
 int encoded_strlen(const char *str);
 
 #define is_escape(c) ( (c) == '\"' )
@@ -29,7 +28,7 @@ size_t json_size(JsonNode *o) {
     case JSON_NUMBER: {
         SB t;
         sb_init(&t);
-        emit_number(&t, tmp->number_);
+        json_emit_number(&t, tmp->number_);
         ret += t.cur - t.start;
         sb_free(&t);
     } break;
@@ -124,7 +123,7 @@ int jem_encode_bool(json_encode_machine_t *jem, char *s, int len) {
 int jem_encode_number(json_encode_machine_t *jem, char *s, int len) {
     if ( !sb_size(&jem->buffer) ) {
         sb_init(&jem->buffer);
-        emit_number(&jem->buffer, jem->ptr->number_);
+        json_emit_number(&jem->buffer, jem->ptr->number_);
     }
     int buf_size = (jem->buffer.cur - jem->buffer.start) - jem->start;
     if ( buf_size < len ) {
@@ -58,6 +58,17 @@ property_t  json_strdup_property(const char *str) {
     return p_json(tmp);
 }
 
+property_t  json_key_property(char *key, int len) {
+#if !defined(PROPERTY_NO_INTERN)
+    property_t p = property_intern(key, len);
+    if ( !IS_EMPTY(p) ) {
+        json_delete_string(key);
+        return p;
+    }
+#endif
+    return p_json(key);
+}
+
 /*
  * Unicode helper functions
  *
@@ -281,8 +292,6 @@ static void skip_space      (const char **sp);
 
 static void emit_value              (SB *out, const JsonNode *node);
 static void emit_value_indented     (SB *out, const JsonNode *node, const char *space, int indent_level);
-static void emit_string             (SB *out, const char *str);
-void emit_number             (SB *out, double num);
 static void emit_array              (SB *out, const JsonNode *array);
 static void emit_array_indented     (SB *out, const JsonNode *array, const char *space, int indent_level);
 static void emit_object             (SB *out, const JsonNode *object);
@@ -334,7 +343,7 @@ char *json_encode_string(const char *str)
 	SB sb;
     if ( sb_init(&sb) < 0 ) return NULL;
 	
-	emit_string(&sb, str);
+	json_emit_string(&sb, str);
 	
 	return sb_finish(&sb);
 }
@@ -704,11 +713,39 @@ failure:
 	return false;
 }
 
+// the short ASCII key without escapes is interned straight from the text
+static bool parse_plain_key(const char **sp, property_t *out)
+{
+#if !defined(PROPERTY_NO_INTERN)
+	const char *s = *sp;
+	const char *start;
+	
+	if (*s++ != '"')
+		return false;
+	start = s;
+	while (*s != '"') {
+		unsigned char c = (unsigned char) *s++;
+		if (c < 0x20 || c >= 0x80 || c == '\\' || s - start > PROPERTY_INTERN_MAX_LEN)
+			return false;
+	}
+	*out = property_intern(start, (int)(s - start));
+	if (IS_EMPTY(*out))
+		return false;
+	*sp = s + 1;
+	return true;
+#else
+	(void)sp;
+	(void)out;
+	return false;
+#endif
+}
+
 static bool parse_object(const char **sp, JsonNode **out)
 {
 	const char *s = *sp;
 	JsonNode *ret = out ? json_mkobject() : NULL;
 	char *key;
+	property_t pkey = p_null();
 	JsonNode *value;
 	
 	if (*s++ != '{')
@@ -721,8 +758,12 @@ static bool parse_object(const char **sp, JsonNode **out)
 	}
 	
 	for (;;) {
-		if (!parse_string(&s, out ? &key : NULL))
-			goto failure;
+		if (!out || !parse_plain_key(&s, &pkey)) {
+			if (!parse_string(&s, out ? &key : NULL))
+				goto failure;
+			if (out)
+				pkey = json_key_property(key, strlen(key));
+		}
 		skip_space(&s);
 		
 		if (*s++ != ':')
@@ -734,7 +775,7 @@ static bool parse_object(const char **sp, JsonNode **out)
 		skip_space(&s);
 		
 		if (out)
-            append_member(ret, p_json(key), value);
+            append_member(ret, pkey, value);
 		
 		if (*s == '}') {
 			s++;
@@ -754,7 +795,7 @@ success:
 
 failure_free_key:
     if (out) {
-        json_delete_string(key);
+        property_free(&pkey);
     }
 failure:
 	json_delete(ret);
@@ -953,10 +994,10 @@ static void emit_value(SB *out, const JsonNode *node)
 			sb_puts(out, node->bool_ ? "true" : "false");
 			break;
 		case JSON_STRING:
-			emit_string(out, node->string_);
+			json_emit_string(out, node->string_);
 			break;
 		case JSON_NUMBER:
-			emit_number(out, node->number_);
+			json_emit_number(out, node->number_);
 			break;
 		case JSON_ARRAY:
 			emit_array(out, node);
@@ -980,10 +1021,10 @@ void emit_value_indented(SB *out, const JsonNode *node, const char *space, int i
 			sb_puts(out, node->bool_ ? "true" : "false");
 			break;
 		case JSON_STRING:
-			emit_string(out, node->string_);
+			json_emit_string(out, node->string_);
 			break;
 		case JSON_NUMBER:
-			emit_number(out, node->number_);
+			json_emit_number(out, node->number_);
 			break;
 		case JSON_ARRAY:
 			emit_array_indented(out, node, space, indent_level);
@@ -1039,7 +1080,7 @@ static void emit_object(SB *out, const JsonNode *object)
 	
 	sb_putc(out, '{');
 	json_foreach(member, object) {
-        emit_string(out, P_VALUE(member->key));
+        json_emit_string(out, P_VALUE(member->key));
 		sb_putc(out, ':');
 		emit_value(out, member);
 		if (member->next != NULL)
@@ -1062,7 +1103,7 @@ static void emit_object_indented(SB *out, const JsonNode *object, const char *sp
 	while (member != NULL) {
 		for (i = 0; i < indent_level + 1; i++)
 			sb_puts(out, space);
-        emit_string(out, P_VALUE(member->key));
+        json_emit_string(out, P_VALUE(member->key));
 		sb_puts(out, ": ");
 		emit_value_indented(out, member, space, indent_level + 1);
 		
@@ -1074,7 +1115,7 @@ static void emit_object_indented(SB *out, const JsonNode *object, const char *sp
 	sb_putc(out, '}');
 }
 
-void emit_string(SB *out, const char *str)
+void json_emit_string(SB *out, const char *str)
 {
 	bool escape_unicode = false;
 	const char *s = str;
@@ -1193,7 +1234,7 @@ void emit_string(SB *out, const char *str)
 	out->cur = b;
 }
 
-void emit_number(SB *out, double num)
+void json_emit_number(SB *out, double num)
 {
 	/*
 	 * This isn't exactly how JavaScript renders numbers,
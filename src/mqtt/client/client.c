@@ -202,6 +202,9 @@ int cycle_r(MQTTClient* c, TimerInterval* timer) {
 
     len = decodePacket(c, &rem_len, TimerLeftMS(timer));
     if ( len <= 0 || rem_len > MQTT_CLIENT_MAX_MSG_LEN ) goto exit;
+    // the keepalive counts the received packets as in the cycle()
+    TimerCountdown(&c->last_received, c->keepAliveInterval);
+    if ( pack_type == PINGRESP ) c->ping_outstanding = 0;
 
     if ( !__cycle_collection[pack_type] ) {
         while ( rem_len ) {
@@ -235,7 +238,6 @@ int MQTTPublish_part(MQTTClient* c,
     TimerInterval timer;
     MQTTString topic = MQTTString_initializer;
     topic.cstring = (char *)topicName;
-    extern int MQTTSerialize_publishLength(int qos, MQTTString topicName, int payloadlen);
 
 #if defined(MQTT_TASK)
       MutexLock(&c->mutex);
@@ -252,44 +254,28 @@ int MQTTPublish_part(MQTTClient* c,
     int payloadlen = drive->init();
     if ( payloadlen <= 0 )
         goto exit;
-    int rem_len = MQTTSerialize_publishLength(message->qos, topic, payloadlen);
-
-    unsigned char *ptr = c->buf;
-
-    // send header
-    MQTTHeader header;
-    header.bits.type = PUBLISH;
-    header.bits.dup = message->dup;
-    header.bits.qos = message->qos;
-    header.bits.retain = message->retained;
-    writeChar(&ptr, header.byte);
-
-    ptr += MQTTPacket_encode(ptr, rem_len);
-
-    writeMQTTString(&ptr, topic);
-
-    if (message->qos > 0)
-        writeInt(&ptr, message->id);
-
-    int len = ptr - c->buf;
-
-    if ((rc = sendPacket(c, len, &timer)) != MQTT_SUCCESS) // send the subscribe packet
-        goto exit; // there was a problem
+    int len = MQTTSerialize_publishHeader(c->buf, c->buf_size, message->dup, message->qos,
+                                          message->retained, message->id, topic, payloadlen);
+    if ( len <= 0 )
+        goto exit;
 
-    ptr = c->buf;
-    // send packet body
+    // the first part of the body is encoded right after the header,
+    // every write is the full buffer
     int total = payloadlen;
-    len = c->buf_size;
     while( total && !TimerIsExpired(&timer) ) {
-        int chunk = total < len ? total : len;
-        chunk = drive->part((char*)ptr, chunk);
-        if ( chunk <= 0 ) {
-            rc = FAILURE;
-            goto exit;
+        int chunk = (int)c->buf_size - len;
+        if ( chunk > total ) chunk = total;
+        if ( chunk > 0 ) {
+            chunk = drive->part((char*)c->buf + len, chunk);
+            if ( chunk <= 0 ) {
+                rc = FAILURE;
+                goto exit;
+            }
         }
-        if ((rc = sendPacket(c, chunk, &timer)) != MQTT_SUCCESS) // send the subscribe packet
+        if ((rc = sendPacket(c, len + chunk, &timer)) != MQTT_SUCCESS) // send the publish packet
             goto exit;
         total -= chunk;
+        len = 0;
     }
     if ( !total ) {
         drive->fin();
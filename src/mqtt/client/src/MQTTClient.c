@@ -40,7 +40,7 @@ int sendPacket(MQTTClient *c, int length, TimerInterval *timer) {
       sent = 0;
 
   while (sent < length && !TimerIsExpired(timer)) {
-    rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer));
+    rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length - sent, TimerLeftMS(timer));
     if (rc <= 0) { // there was an error writing the data
         rc = FAILURE;
         break;
@@ -57,6 +57,46 @@ int sendPacket(MQTTClient *c, int length, TimerInterval *timer) {
 }
 
 
+int sendPacketv(MQTTClient *c, socket_iovec_t *iov, int cnt, TimerInterval *timer) {
+  int rc = FAILURE;
+
+  for (;;) {
+    while (cnt && !iov->len) {
+      iov++;
+      cnt--;
+    }
+    if (!cnt || TimerIsExpired(timer)) {
+      break;
+    }
+    if (c->ipstack->mqttwritev) {
+      rc = c->ipstack->mqttwritev(c->ipstack, iov, cnt, TimerLeftMS(timer));
+    } else {
+      rc = c->ipstack->mqttwrite(c->ipstack, (unsigned char *)iov->base, (int)iov->len, TimerLeftMS(timer));
+    }
+    if (rc <= 0) { // there was an error writing the data
+      break;
+    }
+    // skip the sent part
+    while (cnt && rc >= (int)iov->len) {
+      rc -= (int)iov->len;
+      iov++;
+      cnt--;
+    }
+    if (cnt) {
+      iov->base = (const unsigned char *)iov->base + rc;
+      iov->len -= rc;
+    }
+  }
+  if (!cnt) {
+    TimerCountdown(&c->last_sent, c->keepAliveInterval);
+    rc = MQTT_SUCCESS;
+  } else {
+    rc = FAILURE;
+  }
+  return rc;
+}
+
+
 void MQTTClientInit(MQTTClient *c, Network *network, unsigned int command_timeout_ms,
                     unsigned char *sendbuf, size_t sendbuf_size, unsigned char *readbuf, size_t readbuf_size) {
   int i;
@@ -608,6 +648,7 @@ int MQTTPublish(MQTTClient *c, const char *topicName, MQTTMessage *message) {
   TimerInterval timer;
   MQTTString topic = MQTTString_initializer;
   topic.cstring = (char *)topicName;
+  socket_iovec_t iov[2];
   int len = 0;
 
 #if defined(MQTT_TASK)
@@ -624,12 +665,24 @@ int MQTTPublish(MQTTClient *c, const char *topicName, MQTTMessage *message) {
     message->id = getNextPacketId(c);
   }
 
-  len = MQTTSerialize_publish(c->buf, c->buf_size, 0, message->qos, message->retained, message->id,
-                              topic, (unsigned char *)message->payload, message->payloadlen);
+  // the payload is sent from the message, the buf keeps the header only
+  len = MQTTSerialize_publishHeader(c->buf, c->buf_size, 0, message->qos, message->retained, message->id,
+                                    topic, (int)message->payloadlen);
   if (len <= 0) {
     goto exit;
   }
-  if ((rc = sendPacket(c, len, &timer)) != MQTT_SUCCESS) { // send the subscribe packet
+  if (!c->ipstack->mqttwritev && len + message->payloadlen <= c->buf_size) {
+    // no gather write (TLS): the small packet is the one write
+    memcpy(c->buf + len, message->payload, message->payloadlen);
+    rc = sendPacket(c, len + (int)message->payloadlen, &timer);
+  } else {
+    iov[0].base = c->buf;
+    iov[0].len = len;
+    iov[1].base = message->payload;
+    iov[1].len = message->payloadlen;
+    rc = sendPacketv(c, iov, 2, &timer);
+  }
+  if (rc != MQTT_SUCCESS) { // send the publish packet
     goto exit;  // there was a problem
   }
 
@@ -18,43 +18,31 @@
 
 void TimerInit(Timer* timer)
 {
-	timer->end_time = (struct timeval){0, 0};
+	timer->end_ms = time_mono_ms();
 }
 
 char TimerIsExpired(Timer* timer)
 {
-	struct timeval now, res;
-	gettimeofday(&now, NULL);
-	timersub(&timer->end_time, &now, &res);		
-	return res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+	return time_mono_diff(timer->end_ms, time_mono_ms()) <= 0;
 }
 
 
 void TimerCountdownMS(Timer* timer, unsigned int timeout)
 {
-	struct timeval now;
-	gettimeofday(&now, NULL);
-	struct timeval interval = {timeout / 1000, (timeout % 1000) * 1000};
-	timeradd(&now, &interval, &timer->end_time);
+	timer->end_ms = time_mono_ms() + timeout;
 }
 
 
 void TimerCountdown(Timer* timer, unsigned int timeout)
 {
-	struct timeval now;
-	gettimeofday(&now, NULL);
-	struct timeval interval = {timeout, 0};
-	timeradd(&now, &interval, &timer->end_time);
+	timer->end_ms = time_mono_ms() + timeout * 1000;
 }
 
 
 int TimerLeftMS(Timer* timer)
 {
-	struct timeval now, res;
-	gettimeofday(&now, NULL);
-	timersub(&timer->end_time, &now, &res);
-	//printf("left %d ms\n", (res.tv_sec < 0) ? 0 : res.tv_sec * 1000 + res.tv_usec / 1000);
-	return (res.tv_sec < 0) ? 0 : res.tv_sec * 1000 + res.tv_usec / 1000;
+	int left = time_mono_diff(timer->end_ms, time_mono_ms());
+	return left < 0 ? 0 : left;
 }
 
 
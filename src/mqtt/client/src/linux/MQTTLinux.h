@@ -45,10 +45,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <stdint.h>
+#include <time/monotonic.h>
 
+// the time_mono_ms tick as the TimerInterval of the SDK port
 typedef struct Timer
 {
-	struct timeval end_time;
+	uint32_t end_ms;
 } Timer;
 
 void TimerInit(Timer*);
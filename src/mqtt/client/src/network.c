@@ -68,11 +68,50 @@ static int _write(Network* n, unsigned char* buffer, int len, int timeout_ms) {
     return rc;
 }
 
+#if !defined(MQTT_CIPHER)
+static int _writev(Network* n, socket_iovec_t *iov, int cnt, int timeout_ms) {
+    struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    setsockopt(n->my_socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(struct timeval));
+    return (int)socket_sendv(n->my_socket, iov, cnt);
+}
+#endif
+
+int NetworkTryRead(Network* n, unsigned char* buffer, int len) {
+#if defined(MQTT_CIPHER)
+    int rc = ssl_recv(n->my_socket, (char*)buffer, len);
+    if ( rc > 0 ) return rc;
+    return ssl_would_block(n->my_socket, rc) ? 0 : -1;
+#else
+    int rc = recv(n->my_socket, (char*)buffer, len, 0);
+    if ( rc > 0 ) return rc;
+    // zero is the peer close
+    return ( rc < 0 && socket_would_block(n->my_socket) ) ? 0 : -1;
+#endif
+}
+
+int NetworkTryWrite(Network* n, unsigned char* buffer, int len) {
+#if defined(MQTT_CIPHER)
+    int rc = ssl_send(n->my_socket, (char*)buffer, len);
+    if ( rc > 0 ) return rc;
+    return ssl_would_block(n->my_socket, rc) ? 0 : -1;
+#else
+    int rc = send(n->my_socket, (char*)buffer, len, 0);
+    if ( rc > 0 ) return rc;
+    return ( rc < 0 && socket_would_block(n->my_socket) ) ? 0 : -1;
+#endif
+}
 
 void NetworkInit(Network* n) {
     n->my_socket = -1;
     n->mqttread = _read;
     n->mqttwrite = _write;
+#if defined(MQTT_CIPHER)
+    // every ssl_send is the TLS record: the client gathers the packet
+    // into its buffer instead
+    n->mqttwritev = NULL;
+#else
+    n->mqttwritev = _writev;
+#endif
 }
 
 void NetworkDisconnect(Network* n) {
@@ -27,16 +27,20 @@
 
 #include <sys/mem.h>
 #include <time/time.h>
+#include <time/monotonic.h>
 #include <bsd/socket.h>
 
 typedef struct Network {
     int my_socket;
     int (*mqttread) (struct Network*, unsigned char*, int, int);
     int (*mqttwrite) (struct Network*, unsigned char*, int, int);
+    // optional, the vectors are written one by one by the mqttwrite if NULL
+    int (*mqttwritev) (struct Network*, socket_iovec_t*, int, int);
 } Network;
 
+// the time_mono_ms tick, the NTP doesn't move it
 typedef struct TimerInterval {
-    struct timeval end_time;
+    uint32_t end_ms;
 } TimerInterval;
 
 #if defined(MQTT_TASK)
@@ -60,5 +64,9 @@ int TimerLeftMS(TimerInterval*);
 DLLExport void NetworkInit(Network*);
 DLLExport int NetworkConnect(Network*, char*, int);
 DLLExport void NetworkDisconnect(Network*);
+// the non-blocking socket of the event loop: the bytes read/written,
+// 0 if the socket isn't ready (call again with the same data) or -1
+DLLExport int NetworkTryRead(Network*, unsigned char*, int);
+DLLExport int NetworkTryWrite(Network*, unsigned char*, int);
 
 #endif /* ACN_SDK_C_MQTT_NETWORK_H_ */
@@ -1,37 +1,26 @@
 #include "network.h"
-#include <time/time.h>
+#include <time/monotonic.h>
 
 void TimerInit(TimerInterval* timer) {
-    timer->end_time = (struct timeval){0, 0};
+    timer->end_ms = time_mono_ms();
 }
 
 char TimerIsExpired(TimerInterval* timer) {
-    struct timeval now, res;
-    gettimeofday(&now, NULL);
-    timersub(&timer->end_time, &now, &res);
-    return (int)res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+    return time_mono_diff(timer->end_ms, time_mono_ms()) <= 0;
 }
 
 
 void TimerCountdownMS(TimerInterval* timer, unsigned int timeout) {
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    struct timeval interval = {(time_t)(timeout / 1000), (suseconds_t)(timeout % 1000) * 1000};
-    timeradd(&now, &interval, &timer->end_time);
+    timer->end_ms = time_mono_ms() + timeout;
 }
 
 
 void TimerCountdown(TimerInterval* timer, unsigned int timeout) {
-    struct timeval now;
-    gettimeofday(&now, NULL);
-    struct timeval interval = {(time_t)timeout, 0};
-    timeradd(&now, &interval, &timer->end_time);
+    timer->end_ms = time_mono_ms() + timeout * 1000;
 }
 
 
 int TimerLeftMS(TimerInterval* timer) {
-    struct timeval now, res;
-    gettimeofday(&now, NULL);
-    timersub(&timer->end_time, &now, &res);
-    return ((int)res.tv_sec < 0) ? 0 : res.tv_sec * 1000 + res.tv_usec / 1000;
+    int left = time_mono_diff(timer->end_ms, time_mono_ms());
+    return left < 0 ? 0 : left;
 }
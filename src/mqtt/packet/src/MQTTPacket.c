@@ -17,6 +17,7 @@
 
 #include "StackTrace.h"
 #include "MQTTPacket.h"
+#include <bsd/byteorder.h>
 #if defined(__USE_STD__)
 #include <string.h>
 #endif
@@ -125,8 +126,7 @@ int MQTTPacket_decodeBuf(unsigned char* buf, int* value)
  */
 int readInt(unsigned char** pptr)
 {
-	unsigned char* ptr = *pptr;
-	int len = 256*(*ptr) + (*(ptr+1));
+	int len = be16_get(*pptr);
 	*pptr += 2;
 	return len;
 }
@@ -164,10 +164,8 @@ void writeChar(unsigned char** pptr, char c)
  */
 void writeInt(unsigned char** pptr, int anInt)
 {
-	**pptr = (unsigned char)(anInt / 256);
-	(*pptr)++;
-	**pptr = (unsigned char)(anInt % 256);
-	(*pptr)++;
+	be16_put(*pptr, anInt);
+	*pptr += 2;
 }
 
 
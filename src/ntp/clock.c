@@ -0,0 +1,119 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "ntp/clock.h"
+#include <time/monotonic.h>
+#include <sys/mem.h>
+#include <debug.h>
+
+// the drift is averaged over the last measures
+#define NTP_DRIFT_GAIN     4
+
+static ntp_clock_t *_source = NULL;
+
+static int64_t clock_elapsed_us(const ntp_clock_t *c, uint32_t mono_ms) {
+  int64_t el = (int64_t)time_mono_diff(mono_ms, c->base_ms) * 1000;
+  return el + el * c->freq_ppb / 1000000000;
+}
+
+// the part of the slew applied since the base tick
+static int64_t clock_slewed_us(const ntp_clock_t *c, uint32_t mono_ms) {
+  int32_t el = time_mono_diff(mono_ms, c->base_ms);
+  int64_t max;
+  if ( el <= 0 ) return 0;
+  max = (int64_t)el * NTP_SYNC_SLEW_PPM / 1000;
+  if ( c->slew_us > max ) return max;
+  if ( c->slew_us < -max ) return -max;
+  return c->slew_us;
+}
+
+void ntp_clock_init(ntp_clock_t *c, int64_t now_us, uint32_t mono_ms) {
+  memset(c, 0x0, sizeof(ntp_clock_t));
+  c->base_us = now_us;
+  c->base_ms = mono_ms;
+}
+
+int64_t ntp_clock_now(const ntp_clock_t *c, uint32_t mono_ms) {
+  return c->base_us + clock_elapsed_us(c, mono_ms) + clock_slewed_us(c, mono_ms);
+}
+
+int64_t ntp_clock_target(const ntp_clock_t *c, uint32_t mono_ms) {
+  return c->base_us + clock_elapsed_us(c, mono_ms) + c->slew_us;
+}
+
+void ntp_clock_rebase(ntp_clock_t *c, uint32_t mono_ms) {
+  int64_t slewed = clock_slewed_us(c, mono_ms);
+  c->base_us += clock_elapsed_us(c, mono_ms) + slewed;
+  c->slew_us -= slewed;
+  c->base_ms = mono_ms;
+}
+
+// the server time against the ticks, the step is too far for the drift
+static void clock_drift(ntp_clock_t *c, int64_t server_us, uint32_t tick) {
+  int32_t el;
+  int64_t ppb;
+  if ( !c->last_us ) goto anchor;
+  el = time_mono_diff(tick, c->last_ms);
+  if ( el < NTP_SYNC_DRIFT_MIN_MS ) return;
+  ppb = ( server_us - c->last_us - (int64_t)el * 1000 ) * 1000000 / el;
+  if ( ppb > NTP_SYNC_MAX_PPM * 1000 || ppb < -NTP_SYNC_MAX_PPM * 1000 ) {
+    DBG("NTP: drift out of range %d ppb", (int)ppb);
+    goto anchor;
+  }
+  if ( !c->drift ) c->freq_ppb = (int32_t)ppb;
+  else c->freq_ppb += (int32_t)( ( ppb - c->freq_ppb ) / NTP_DRIFT_GAIN );
+  c->drift = 1;
+anchor:
+  c->last_us = server_us;
+  c->last_ms = tick;
+}
+
+int ntp_clock_adjust(ntp_clock_t *c, int64_t offset_us,
+                     uint32_t sample_ms, uint32_t mono_ms) {
+  ntp_clock_rebase(c, mono_ms);
+  clock_drift(c, ntp_clock_target(c, sample_ms) + offset_us, sample_ms);
+  if ( !c->synced ||
+       offset_us >= NTP_SYNC_STEP_MS * 1000 ||
+       offset_us <= -NTP_SYNC_STEP_MS * 1000 ) {
+    c->base_us += c->slew_us + offset_us;
+    c->slew_us = 0;
+    c->synced = 1;
+    return 1;
+  }
+  c->slew_us += offset_us;
+  return 0;
+}
+
+void ntp_clock_set_source(ntp_clock_t *c) {
+  _source = c;
+}
+
+int ntp_clock_gettimeofday(struct timeval *tv) {
+  int64_t us;
+  if ( !_source || !_source->synced ) return gettimeofday(tv, NULL);
+  us = ntp_clock_now(_source, time_mono_ms());
+  tv->tv_sec = (time_t)( us / 1000000 );
+  tv->tv_usec = (suseconds_t)( us % 1000000 );
+  return 0;
+}
+
+void ntp_clock_timestamp(timestamp_t *ts) {
+  struct timeval tv;
+  struct tm tm;
+  time_t sec;
+  ntp_clock_gettimeofday(&tv);
+  sec = tv.tv_sec;
+  gmtime_r(&sec, &tm);
+  ts->year = 1900 + tm.tm_year;
+  ts->mon = 1 + tm.tm_mon;
+  ts->day = tm.tm_mday;
+  ts->hour = tm.tm_hour;
+  ts->min = tm.tm_min;
+  ts->sec = tm.tm_sec;
+  ts->msec = tv.tv_usec / 1000;
+}
@@ -0,0 +1,320 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "ntp/sync.h"
+#include <ntp/ntp.h>
+#include <arrow/reactor.h>
+#include <bsd/byteorder.h>
+#include <time/monotonic.h>
+#include <sys/mem.h>
+#include <debug.h>
+
+// the seconds from 1900 to 1970
+#define NTP_UNIX_DELTA     2208988800LL
+#define NTP_MODE_CLIENT    3
+#define NTP_MODE_SERVER    4
+#define NTP_VERSION        4
+#define NTP_LEAP_UNSYNC    3
+#define NTP_STRATUM_MAX    15
+#define NTP_OFF_ORG        24
+#define NTP_OFF_RX         32
+#define NTP_OFF_TX         40
+// the dispersion growth of an old sample (RFC 5905)
+#define NTP_PHI_PPM        15
+
+static void ntp_ts_put(uint8_t *p, int64_t us) {
+  uint64_t sec = (uint64_t)( us / 1000000 + NTP_UNIX_DELTA );
+  uint64_t frac = ( (uint64_t)( us % 1000000 ) << 32 ) / 1000000;
+  be32_put(p, (uint32_t)sec);
+  be32_put(p + 4, (uint32_t)frac);
+}
+
+// the era 0 ends in 2036, the seconds without the high bit are the era 1
+static int64_t ntp_ts_get(const uint8_t *p) {
+  uint64_t sec = be32_get(p);
+  uint64_t frac = be32_get(p + 4);
+  if ( !( sec & 0x80000000UL ) ) sec += 0x100000000ULL;
+  return ( (int64_t)sec - NTP_UNIX_DELTA ) * 1000000 +
+      (int64_t)( ( frac * 1000000 ) >> 32 );
+}
+
+// client
+
+void ntp_sync_init(ntp_sync_t *s) {
+  struct timeval tv;
+  memset(s, 0x0, sizeof(ntp_sync_t));
+  s->sock = -1;
+  s->timer = -1;
+  s->poll_ms = NTP_SYNC_POLL_MS;
+  s->timeout_ms = NTP_SYNC_TIMEOUT_MS;
+  gettimeofday(&tv, NULL);
+  ntp_clock_init(&s->clock, (int64_t)tv.tv_sec * 1000000 + tv.tv_usec, time_mono_ms());
+  s->next_ms = s->clock.base_ms;
+}
+
+int ntp_sync_add_server(ntp_sync_t *s, const char *host, uint16_t port) {
+  ntp_server_t *sv;
+  if ( !host || s->servers >= NTP_SYNC_SERVERS ) return -1;
+  sv = s->server + s->servers++;
+  sv->host = host;
+  sv->port = port ? port : NTP_DEFAULT_PORT;
+  return 0;
+}
+
+int ntp_sync_open(ntp_sync_t *s) {
+  if ( s->sock >= 0 ) return s->sock;
+  s->sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if ( s->sock < 0 ) {
+    DBG("NTP: socket fail %d", s->sock);
+    s->sock = -1;
+  }
+  return s->sock;
+}
+
+// the blocking DNS is once per server
+static int server_resolve(ntp_server_t *sv) {
+  struct hostent *h;
+  if ( sv->resolved ) return 0;
+  h = gethostbyname(sv->host);
+  if ( !h || !h->h_addr_list || !h->h_addr_list[0] ) {
+    DBG("NTP: no such host %s", sv->host);
+    return -1;
+  }
+  memset(&sv->addr, 0x0, sizeof(sv->addr));
+  sv->addr.sin_family = AF_INET;
+  memcpy(&sv->addr.sin_addr.s_addr, h->h_addr_list[0], sizeof(sv->addr.sin_addr.s_addr));
+  sv->addr.sin_port = htons(sv->port);
+  sv->resolved = 1;
+  return 0;
+}
+
+int ntp_sync_poll(ntp_sync_t *s) {
+  uint8_t pkt[NTP_PACKET_LEN];
+  uint32_t now = time_mono_ms();
+  int sent = 0;
+  int i;
+  if ( ntp_sync_open(s) < 0 ) return -1;
+  for ( i = 0; i < s->servers; i++ ) {
+    ntp_server_t *sv = s->server + i;
+    sv->reach <<= 1;
+    sv->pending = 0;
+    if ( server_resolve(sv) < 0 ) continue;
+    memset(pkt, 0x0, sizeof(pkt));
+    pkt[0] = ( NTP_VERSION << 3 ) | NTP_MODE_CLIENT;
+    sv->t1_us = ntp_clock_target(&s->clock, now);
+    ntp_ts_put(pkt + NTP_OFF_TX, sv->t1_us);
+    memcpy(sv->org, pkt + NTP_OFF_TX, sizeof(sv->org));
+    if ( sendto(s->sock, (char*)pkt, sizeof(pkt), 0,
+                (struct sockaddr*)&sv->addr, sizeof(sv->addr)) != (ssize_t)sizeof(pkt) ) {
+      DBG("NTP: send to %s fail", sv->host);
+      continue;
+    }
+    sv->pending = 1;
+    sent++;
+  }
+  s->polling = sent ? 1 : 0;
+  s->next_ms = now + ( sent ? s->timeout_ms : NTP_SYNC_RETRY_MS );
+  return sent ? 0 : -1;
+}
+
+static ntp_server_t *server_find(ntp_sync_t *s, struct sockaddr_in *from) {
+  int i;
+  for ( i = 0; i < s->servers; i++ ) {
+    ntp_server_t *sv = s->server + i;
+    if ( sv->pending &&
+         sv->addr.sin_addr.s_addr == from->sin_addr.s_addr &&
+         sv->addr.sin_port == from->sin_port ) return sv;
+  }
+  return NULL;
+}
+
+static void server_answer(ntp_sync_t *s, ntp_server_t *sv,
+                          const uint8_t *pkt, uint32_t now) {
+  int li = pkt[0] >> 6;
+  int mode = pkt[0] & 0x7;
+  int stratum = pkt[1];
+  int64_t t2, t3, t4;
+  ntp_sample_t *sm;
+  if ( mode != NTP_MODE_SERVER || li == NTP_LEAP_UNSYNC ||
+       !stratum || stratum > NTP_STRATUM_MAX ) {
+    // the kiss of death is stratum 0
+    DBG("NTP: %s answer is rejected, stratum %d", sv->host, stratum);
+    return;
+  }
+  t2 = ntp_ts_get(pkt + NTP_OFF_RX);
+  t3 = ntp_ts_get(pkt + NTP_OFF_TX);
+  t4 = ntp_clock_target(&s->clock, now);
+  sm = sv->sample + sv->next;
+  sm->offset_us = ( ( t2 - sv->t1_us ) + ( t3 - t4 ) ) / 2;
+  sm->delay_us = (int32_t)( ( t4 - sv->t1_us ) - ( t3 - t2 ) );
+  if ( sm->delay_us < 0 ) sm->delay_us = 0;
+  sm->tick = now;
+  sm->seq = ++s->seq;
+  sv->next = (uint8_t)( ( sv->next + 1 ) % NTP_SYNC_SAMPLES );
+  if ( sv->count < NTP_SYNC_SAMPLES ) sv->count++;
+  sv->reach |= 1;
+}
+
+// the least distance sample: the half of the delay and the age dispersion
+static ntp_sample_t *server_best(ntp_server_t *sv, uint32_t now, int64_t *dist) {
+  ntp_sample_t *best = NULL;
+  int i;
+  for ( i = 0; i < sv->count; i++ ) {
+    ntp_sample_t *sm = sv->sample + i;
+    int64_t d = sm->delay_us / 2 +
+        (int64_t)time_mono_diff(now, sm->tick) * NTP_PHI_PPM / 1000;
+    if ( !best || d < *dist ) {
+      best = sm;
+      *dist = d;
+    }
+  }
+  return best;
+}
+
+static void sync_select(ntp_sync_t *s, uint32_t now) {
+  ntp_sample_t *best = NULL;
+  int64_t best_dist = 0;
+  int64_t offset;
+  int i, j;
+  for ( i = 0; i < s->servers; i++ ) {
+    ntp_server_t *sv = s->server + i;
+    ntp_sample_t *sm;
+    int64_t dist;
+    if ( !sv->reach ) continue;
+    sm = server_best(sv, now, &dist);
+    if ( sm && ( !best || dist < best_dist ) ) {
+      best = sm;
+      best_dist = dist;
+    }
+  }
+  // the older sample than the used one is skipped
+  if ( !best || ( s->used && (int32_t)( best->seq - s->used_seq ) <= 0 ) ) return;
+  offset = best->offset_us;
+  if ( ntp_clock_adjust(&s->clock, offset, best->tick, now) ) {
+    DBG("NTP: step %d ms", (int)( offset / 1000 ));
+  }
+  s->used = 1;
+  s->used_seq = best->seq;
+  // the samples are against the clock target, it is moved
+  for ( i = 0; i < s->servers; i++ ) {
+    for ( j = 0; j < s->server[i].count; j++ ) s->server[i].sample[j].offset_us -= offset;
+  }
+}
+
+static void sync_done(ntp_sync_t *s, uint32_t now) {
+  int answered = 0;
+  int i;
+  for ( i = 0; i < s->servers; i++ ) {
+    ntp_server_t *sv = s->server + i;
+    if ( sv->pending ) {
+      DBG("NTP: %s timeout", sv->host);
+      sv->pending = 0;
+    }
+    if ( sv->reach & 1 ) answered++;
+  }
+  s->polling = 0;
+  if ( answered ) sync_select(s, now);
+  s->next_ms = now + ( answered ? s->poll_ms : NTP_SYNC_RETRY_MS );
+}
+
+int ntp_sync_input(ntp_sync_t *s) {
+  uint8_t pkt[NTP_PACKET_LEN];
+  struct sockaddr_in from;
+  socklen_t fromlen;
+  int n = 0;
+  int i;
+  if ( s->sock < 0 ) return -1;
+  // the rest is read by the next call, the socket is still ready
+  while ( n < 2 * NTP_SYNC_SERVERS ) {
+    ntp_server_t *sv;
+    ssize_t r;
+    fromlen = sizeof(from);
+    r = recvfrom(s->sock, (char*)pkt, sizeof(pkt), MSG_DONTWAIT,
+                 (struct sockaddr*)&from, &fromlen);
+    if ( r <= 0 ) break;
+    n++;
+    sv = server_find(s, &from);
+    // the late or the forged answer doesn't return the last request time
+    if ( !sv || r < NTP_PACKET_LEN ||
+         memcmp(pkt + NTP_OFF_ORG, sv->org, sizeof(sv->org)) ) {
+      DBG("NTP: unexpected answer %d", (int)r);
+      continue;
+    }
+    sv->pending = 0;
+    server_answer(s, sv, pkt, time_mono_ms());
+  }
+  if ( s->polling ) {
+    for ( i = 0; i < s->servers; i++ ) {
+      if ( s->server[i].pending ) break;
+    }
+    if ( i == s->servers ) sync_done(s, time_mono_ms());
+  }
+  return n;
+}
+
+int ntp_sync_step(ntp_sync_t *s, uint32_t mono_ms) {
+  int32_t left;
+  ntp_clock_rebase(&s->clock, mono_ms);
+  if ( time_mono_diff(mono_ms, s->next_ms) >= 0 ) {
+    if ( s->polling ) sync_done(s, mono_ms);
+    else ntp_sync_poll(s);
+  }
+  left = time_mono_diff(s->next_ms, mono_ms);
+  return left > 0 ? left : 0;
+}
+
+void ntp_sync_close(ntp_sync_t *s) {
+  if ( s->sock >= 0 ) soc_close(s->sock);
+  s->sock = -1;
+  s->polling = 0;
+}
+
+int ntp_sync_is_synced(ntp_sync_t *s) {
+  return s->clock.synced;
+}
+
+#if defined(ARROW_REACTOR)
+// reactor
+
+static int sync_io(int sock, uint32_t events, void *arg) {
+  SSP_PARAMETER_NOT_USED(sock);
+  SSP_PARAMETER_NOT_USED(events);
+  ntp_sync_input((ntp_sync_t *)arg);
+  return 0;
+}
+
+static int sync_tick(void *arg) {
+  ntp_sync_step((ntp_sync_t *)arg, time_mono_ms());
+  return 0;
+}
+
+int ntp_sync_attach(ntp_sync_t *s) {
+  if ( ntp_sync_open(s) < 0 ) return -1;
+  if ( arrow_reactor_add(s->sock, SOCK_POLL_IN, sync_io, s) < 0 ) return -1;
+  s->timer = arrow_reactor_timer_add(NTP_SYNC_TICK_MS, sync_tick, s);
+  if ( s->timer < 0 ) {
+    arrow_reactor_del(s->sock);
+    return -1;
+  }
+  // the first poll doesn't wait for the tick
+  ntp_sync_step(s, time_mono_ms());
+  return 0;
+}
+
+void ntp_sync_detach(ntp_sync_t *s) {
+  if ( s->timer >= 0 ) arrow_reactor_timer_del(s->timer);
+  s->timer = -1;
+  if ( s->sock >= 0 ) arrow_reactor_del(s->sock);
+}
+#endif
+
+// time source
+
+void ntp_sync_set_source(ntp_sync_t *s) {
+  ntp_clock_set_source(s ? &s->clock : NULL);
+}
@@ -8,47 +8,223 @@
 
 #include "ssl/crypt.h"
 
-#include "wolfssl/wolfcrypt/sha256.h"
-#include "wolfssl/wolfcrypt/hmac.h"
-
 #include <sys/mem.h>
 
+#if defined(CRYPT_SHA_NI)
+#include <cpuid.h>
+#include <immintrin.h>
+
+static const word32 sha_k[64] __attribute__((aligned(16))) = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+__attribute__((target("sha,sse4.1")))
+static void sha_ni_blocks(word32 *state, const byte *data, word32 blocks) {
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i msg[4];
+  __m128i st0, st1, tmp, w, abef, cdgh;
+  int g;
+  // the state words as the instructions want them: ABEF and CDGH
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0xb1);
+  st1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(state + 4)), 0x1b);
+  st0 = _mm_alignr_epi8(tmp, st1, 8);
+  st1 = _mm_blend_epi16(st1, tmp, 0xf0);
+  while ( blocks-- ) {
+    abef = st0;
+    cdgh = st1;
+    for ( g = 0; g < 16; g++ ) {
+      if ( g < 4 ) {
+        msg[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + g * 16)), mask);
+      } else {
+        // W[g] = msg2(msg1(W[g-4], W[g-3]) + W[g-2..g-1] shifted, W[g-1])
+        tmp = _mm_alignr_epi8(msg[(g - 1) & 3], msg[(g - 2) & 3], 4);
+        w = _mm_add_epi32(_mm_sha256msg1_epu32(msg[g & 3], msg[(g - 3) & 3]), tmp);
+        msg[g & 3] = _mm_sha256msg2_epu32(w, msg[(g - 1) & 3]);
+      }
+      w = _mm_add_epi32(msg[g & 3], _mm_load_si128((const __m128i *)(sha_k + g * 4)));
+      st1 = _mm_sha256rnds2_epu32(st1, st0, w);
+      st0 = _mm_sha256rnds2_epu32(st0, st1, _mm_shuffle_epi32(w, 0x0e));
+    }
+    st0 = _mm_add_epi32(st0, abef);
+    st1 = _mm_add_epi32(st1, cdgh);
+    data += SHA256_BLOCK_SIZE;
+  }
+  tmp = _mm_shuffle_epi32(st0, 0x1b);
+  st1 = _mm_shuffle_epi32(st1, 0xb1);
+  _mm_storeu_si128((__m128i *)state, _mm_blend_epi16(tmp, st1, 0xf0));
+  _mm_storeu_si128((__m128i *)(state + 4), _mm_alignr_epi8(st1, tmp, 8));
+}
+
+// -1 - not checked yet
+static int sha_ni = -1;
+
+static int sha_ni_supported(void) {
+  if ( sha_ni < 0 ) {
+    unsigned int a, b, c, d;
+    int ok = __get_cpuid(1, &a, &b, &c, &d) && ( c & bit_SSE4_1 ) && ( c & bit_SSSE3 );
+    ok = ok && __get_cpuid_count(7, 0, &a, &b, &c, &d) && ( b & ( 1u << 29 ) );
+    sha_ni = ok;
+  }
+  return sha_ni;
+}
+
+// the buffer keeps the bytes as they are, the lengths are wolfCrypt's
+static void sha_ni_update(Sha256 *sh, const byte *buf, word32 size) {
+  byte *tail = (byte *)sh->buffer;
+  word32 lo = sh->loLen;
+  sh->loLen += size;
+  if ( sh->loLen < lo ) sh->hiLen++;
+  if ( sh->buffLen ) {
+    word32 n = SHA256_BLOCK_SIZE - sh->buffLen;
+    if ( n > size ) n = size;
+    memcpy(tail + sh->buffLen, buf, n);
+    sh->buffLen += n;
+    buf += n;
+    size -= n;
+    if ( sh->buffLen < SHA256_BLOCK_SIZE ) return;
+    sha_ni_blocks(sh->digest, tail, 1);
+    sh->buffLen = 0;
+  }
+  if ( size >= SHA256_BLOCK_SIZE ) {
+    sha_ni_blocks(sh->digest, buf, size / SHA256_BLOCK_SIZE);
+    buf += size & ~( SHA256_BLOCK_SIZE - 1 );
+    size &= SHA256_BLOCK_SIZE - 1;
+  }
+  memcpy(tail, buf, size);
+  sh->buffLen = size;
+}
+
+static void sha_ni_final(Sha256 *sh, byte *shasum) {
+  byte *tail = (byte *)sh->buffer;
+  word32 hi = ( sh->hiLen << 3 ) | ( sh->loLen >> 29 );
+  word32 lo = sh->loLen << 3;
+  int i;
+  tail[sh->buffLen++] = 0x80;
+  if ( sh->buffLen > SHA256_PAD_SIZE ) {
+    memset(tail + sh->buffLen, 0x0, SHA256_BLOCK_SIZE - sh->buffLen);
+    sha_ni_blocks(sh->digest, tail, 1);
+    sh->buffLen = 0;
+  }
+  memset(tail + sh->buffLen, 0x0, SHA256_PAD_SIZE - sh->buffLen);
+  for ( i = 0; i < 4; i++ ) {
+    tail[SHA256_PAD_SIZE + i] = (byte)( hi >> ( 24 - i * 8 ) );
+    tail[SHA256_PAD_SIZE + 4 + i] = (byte)( lo >> ( 24 - i * 8 ) );
+  }
+  sha_ni_blocks(sh->digest, tail, 1);
+  for ( i = 0; i < SHA256_DIGEST_SIZE; i++ ) {
+    shasum[i] = (byte)( sh->digest[i / 4] >> ( 24 - ( i % 4 ) * 8 ) );
+  }
+  wc_InitSha256(sh);
+}
+#else
+# define sha_ni_supported() 0
+# define sha_ni_update(sh, buf, size)
+# define sha_ni_final(sh, shasum)
+#endif
+
+// the keys don't stay on the stack, the compiler can't drop these stores
+static void crypt_wipe(void *p, size_t len) {
+  volatile byte *v = (volatile byte *)p;
+  while ( len-- ) *v++ = 0;
+}
+
+int acn_sha256_accel(void) {
+  return sha_ni_supported();
+}
+
+void acn_sha256_init(acn_sha256_ctx *ctx) {
+  wc_InitSha256(&ctx->sh);
+}
+
+void acn_sha256_update(acn_sha256_ctx *ctx, const char *buf, int size) {
+  if ( sha_ni_supported() ) sha_ni_update(&ctx->sh, (const byte*)buf, (word32)size);
+  else wc_Sha256Update(&ctx->sh, (const byte*)buf, (word32)size);
+}
+
+void acn_sha256_final(acn_sha256_ctx *ctx, char *shasum) {
+  if ( sha_ni_supported() ) sha_ni_final(&ctx->sh, (byte*)shasum);
+  else wc_Sha256Final(&ctx->sh, (byte*)shasum);
+}
+
+void acn_hmac256_init(acn_hmac_ctx *ctx, const char *key, int key_size) {
+  byte pad[SHA256_BLOCK_SIZE];
+  byte hkey[SHA256_DIGEST_SIZE];
+  int i;
+  if ( key_size > SHA256_BLOCK_SIZE ) {
+    acn_sha256_init(&ctx->inner);
+    acn_sha256_update(&ctx->inner, key, key_size);
+    acn_sha256_final(&ctx->inner, (char*)hkey);
+    key = (const char*)hkey;
+    key_size = SHA256_DIGEST_SIZE;
+  }
+  memset(pad, 0x0, sizeof(pad));
+  memcpy(pad, key, (size_t)key_size);
+  for ( i = 0; i < SHA256_BLOCK_SIZE; i++ ) pad[i] ^= 0x36;
+  acn_sha256_init(&ctx->inner);
+  acn_sha256_update(&ctx->inner, (const char*)pad, SHA256_BLOCK_SIZE);
+  // 0x36 ^ 0x5c: the ipad to the opad
+  for ( i = 0; i < SHA256_BLOCK_SIZE; i++ ) pad[i] ^= 0x6a;
+  acn_sha256_init(&ctx->outer);
+  acn_sha256_update(&ctx->outer, (const char*)pad, SHA256_BLOCK_SIZE);
+  crypt_wipe(pad, sizeof(pad));
+  crypt_wipe(hkey, sizeof(hkey));
+}
+
+void acn_hmac256_update(acn_hmac_ctx *ctx, const char *buf, int buf_size) {
+  acn_sha256_update(&ctx->inner, buf, buf_size);
+}
+
+void acn_hmac256_final(acn_hmac_ctx *ctx, char *hmacdig) {
+  char dig[SHA256_DIGEST_SIZE];
+  acn_sha256_final(&ctx->inner, dig);
+  acn_sha256_update(&ctx->outer, dig, SHA256_DIGEST_SIZE);
+  acn_sha256_final(&ctx->outer, hmacdig);
+  crypt_wipe(dig, sizeof(dig));
+}
+
 void __attribute__((weak)) sha256(char *shasum, char *buf, int size) {
-  Sha256 sh;
-  wc_InitSha256(&sh);
-  wc_Sha256Update(&sh, (byte*)buf, (word32)size);
-  wc_Sha256Final(&sh, (byte*)shasum);
+  acn_sha256_ctx ctx;
+  acn_sha256_init(&ctx);
+  acn_sha256_update(&ctx, buf, size);
+  acn_sha256_final(&ctx, shasum);
+}
+
+void __attribute__((weak)) hmac256(char *hmacdig, const char *key, int key_size, const char *buf, int buf_size) {
+  acn_hmac_ctx ctx;
+  acn_hmac256_init(&ctx, key, key_size);
+  acn_hmac256_update(&ctx, buf, buf_size);
+  acn_hmac256_final(&ctx, hmacdig);
 }
 
-static Sha256 static_sh;
+static acn_sha256_ctx static_sh;
 void sha256_init() {
-    wc_InitSha256(&static_sh);
+  acn_sha256_init(&static_sh);
 }
 
 void sha256_chunk(const char *buf, int size) {
-    wc_Sha256Update(&static_sh, (byte*)buf, (word32)size);
+  acn_sha256_update(&static_sh, buf, size);
 }
 
 void sha256_fin(char *shasum) {
-    wc_Sha256Final(&static_sh, (byte*)shasum);
-}
-
-void __attribute__((weak)) hmac256(char *hmacdig, const char *key, int key_size, const char *buf, int buf_size) {
-  Hmac hmac;
-  wc_HmacSetKey(&hmac, SHA256, (const byte*)key, (word32)key_size);
-  wc_HmacUpdate(&hmac, (const byte*)buf, (word32)buf_size);
-  wc_HmacFinal(&hmac, (byte*)hmacdig);
+  acn_sha256_final(&static_sh, shasum);
 }
 
-static Hmac static_hmac;
+static acn_hmac_ctx static_hmac;
 void hmac256_init(const char *key, int key_size) {
-    wc_HmacSetKey(&static_hmac, SHA256, (const byte*)key, (word32)key_size);
+  acn_hmac256_init(&static_hmac, key, key_size);
 }
 
 void hmac256_chunk(const char *buf, int buf_size) {
-    wc_HmacUpdate(&static_hmac, (const byte*)buf, (word32)buf_size);
+  acn_hmac256_update(&static_hmac, buf, buf_size);
 }
 
 void hmac256_fin(char *hmacdig) {
-    wc_HmacFinal(&static_hmac, (byte*)hmacdig);
+  acn_hmac256_final(&static_hmac, hmacdig);
 }
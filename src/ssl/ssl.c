@@ -27,6 +27,31 @@ typedef struct socket_ssl {
 
 static socket_ssl_t *__sock = NULL;
 
+#if defined(HTTP_THREAD)
+#include <sys/mutex.h>
+static arrow_mutex *_ssl_mutex = NULL;
+#define SSL_LIST_LOCK      arrow_mutex_lock(_ssl_mutex)
+#define SSL_LIST_UNLOCK    arrow_mutex_unlock(_ssl_mutex)
+#else
+#define SSL_LIST_LOCK
+#define SSL_LIST_UNLOCK
+#endif
+
+int __attribute__((weak)) ssl_init(void) {
+#if defined(HTTP_THREAD)
+    if ( !_ssl_mutex && arrow_mutex_init(&_ssl_mutex) < 0 ) return -1;
+#endif
+    return 0;
+}
+
+void __attribute__((weak)) ssl_deinit(void) {
+#if defined(HTTP_THREAD)
+    if ( _ssl_mutex ) arrow_mutex_deinit(_ssl_mutex);
+    _ssl_mutex = NULL;
+#endif
+}
+
+
 #ifdef DEBUG_WOLFSSL
 static void cli_wolfSSL_Logging_cb(const int logLevel,
                                   const char *const logMessage) {
@@ -39,6 +64,14 @@ static int sockeq(socket_ssl_t *s, int data) {
     return -1;
 }
 
+static socket_ssl_t *ssl_find(int sock) {
+    socket_ssl_t *s = NULL;
+    SSL_LIST_LOCK;
+    linked_list_find_node(s, __sock, socket_ssl_t, sockeq, sock);
+    SSL_LIST_UNLOCK;
+    return s;
+}
+
 static int recv_ssl(WOLFSSL *wsl, char* buf, int sz, void* vp) {
     SSP_PARAMETER_NOT_USED(wsl);
     socket_ssl_t *s = (socket_ssl_t *)vp;
@@ -46,7 +79,8 @@ static int recv_ssl(WOLFSSL *wsl, char* buf, int sz, void* vp) {
 //    struct timeval interval = { 5000/1000, (0 % 1000) * 1000 };
 //    setsockopt(s->socket, SOL_SOCKET, SO_RCVTIMEO, (char *)&interval, sizeof(struct timeval));
     int got = recv(s->socket, buf, (uint32_t)sz, 0);
-    if (got <= 0)  return -2;  // IO_ERR_WANT_READ;
+    if (got == 0) return WOLFSSL_CBIO_ERR_CONN_CLOSE;
+    if (got < 0)  return WOLFSSL_CBIO_ERR_WANT_READ;
     return (int)got;
 }
 
@@ -56,13 +90,15 @@ static int send_ssl(WOLFSSL *wsl, char* buf, int sz, void* vp) {
     if ( sz < 0 ) return sz;
     int sent = send(s->socket, buf, (uint32_t)sz, 0);
 //    DBG("send ssl %d [%d]", sent, sz);
-    if (sent <= 0) return -2;  // IO_ERR_WANT_WRITE
+    if (sent <= 0) return WOLFSSL_CBIO_ERR_WANT_WRITE;
     return (int)sent;
 }
 
 
 int __attribute__((weak)) ssl_connect(int sock) {
+    SSL_LIST_LOCK;
     if ( !__sock ) wolfSSL_Init();
+    SSL_LIST_UNLOCK;
     socket_ssl_t *s = alloc_type(socket_ssl_t);
     arrow_linked_list_init(s);
 	s->socket = sock;
@@ -91,7 +127,9 @@ int __attribute__((weak)) ssl_connect(int sock) {
     if (err != SSL_SUCCESS) {
         goto ssl_connect_error_ssl;
     } else {
+        SSL_LIST_LOCK;
         arrow_linked_list_add_node_last(__sock, socket_ssl_t, s);
+        SSL_LIST_UNLOCK;
         DBG("SSL connect done");
         return 0;
     }
@@ -108,8 +146,7 @@ ssl_connect_error_sock:
 
 int __attribute__((weak)) ssl_recv(int sock, char *data, int len) {
 //    DBG("ssl r[%d]", len);
-    socket_ssl_t *s = NULL;
-    linked_list_find_node(s, __sock, socket_ssl_t, sockeq, sock);
+    socket_ssl_t *s = ssl_find(sock);
 	if ( !s ) {
             DBG("No socket %d", sock);
             return -1;
@@ -119,23 +156,37 @@ int __attribute__((weak)) ssl_recv(int sock, char *data, int len) {
 
 int __attribute__((weak)) ssl_send(int sock, char* data, int length) {
 //    DBG("ssl w[%d]", length);
-    socket_ssl_t *s = NULL;
-    linked_list_find_node(s, __sock, socket_ssl_t, sockeq, sock);
+    socket_ssl_t *s = ssl_find(sock);
 	if ( !s ) return -1;
 	return wolfSSL_write(s->ssl, data, (int)length);
 }
 
+int __attribute__((weak)) ssl_pending(int sock) {
+    socket_ssl_t *s = ssl_find(sock);
+    if ( !s ) return 0;
+    return wolfSSL_pending(s->ssl);
+}
+
+int __attribute__((weak)) ssl_would_block(int sock, int ret) {
+    if ( ret > 0 ) return 0;
+    socket_ssl_t *s = ssl_find(sock);
+    if ( !s ) return 0;
+    int err = wolfSSL_get_error(s->ssl, ret);
+    return err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE;
+}
+
 int __attribute__((weak)) ssl_close(int sock) {
-    socket_ssl_t *s = NULL;
-    linked_list_find_node(s, __sock, socket_ssl_t, sockeq, sock);
+    socket_ssl_t *s = ssl_find(sock);
     DBG("close ssl %d", sock);
     if ( s ) {
         wolfSSL_shutdown(s->ssl);
         wolfSSL_free(s->ssl);
         wolfSSL_CTX_free(s->ctx);
+        SSL_LIST_LOCK;
         arrow_linked_list_del_node(__sock, socket_ssl_t, s);
-        free(s);
         if ( !__sock ) wolfSSL_Cleanup();
+        SSL_LIST_UNLOCK;
+        free(s);
     }
     return 0;
 }
@@ -2,7 +2,7 @@
 #include <sys/mem.h>
 #include <debug.h>
 
-#if defined(ARROW_THREAD)
+#if defined(ARROW_THREAD) || defined(HTTP_THREAD)
 int __attribute__((weak)) arrow_mutex_init(arrow_mutex **mutex) {
     SSP_PARAMETER_NOT_USED(mutex);
     DBG("No mutex implementation!");
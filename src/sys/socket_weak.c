@@ -1,6 +1,64 @@
 #include "http/client.h"
+#include <bsd/socket.h>
 
 int __attribute_weak__ socket_connect_done(int sock) {
     SSP_PARAMETER_NOT_USED(sock);
     return 0;
 }
+
+#if defined(__linux__) && !defined(NO_WRITEV)
+#include <sys/uio.h>
+
+#define SOCKET_IOV_MAX 8
+
+ssize_t __attribute_weak__ socket_sendv(int sock, const socket_iovec_t *iov, int iovcnt) {
+    struct iovec v[SOCKET_IOV_MAX];
+    int i;
+    if ( iovcnt > SOCKET_IOV_MAX ) iovcnt = SOCKET_IOV_MAX;
+    for ( i = 0; i < iovcnt; i++ ) {
+        v[i].iov_base = (void *)iov[i].base;
+        v[i].iov_len = iov[i].len;
+    }
+    return writev(sock, v, iovcnt);
+}
+#else
+ssize_t __attribute_weak__ socket_sendv(int sock, const socket_iovec_t *iov, int iovcnt) {
+    ssize_t sent = 0;
+    int i;
+    for ( i = 0; i < iovcnt; i++ ) {
+        ssize_t rc = send(sock, iov[i].base, iov[i].len, 0);
+        if ( rc <= 0 ) return sent ? sent : -1;
+        sent += rc;
+        if ( (size_t)rc < iov[i].len ) break;
+    }
+    return sent;
+}
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <errno.h>
+
+int __attribute_weak__ socket_nonblock(int sock, int on) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if ( flags < 0 ) return -1;
+    flags = on ? ( flags | O_NONBLOCK ) : ( flags & ~O_NONBLOCK );
+    return fcntl(sock, F_SETFL, flags) < 0 ? -1 : 0;
+}
+
+int __attribute_weak__ socket_would_block(int sock) {
+    SSP_PARAMETER_NOT_USED(sock);
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+#else
+int __attribute_weak__ socket_nonblock(int sock, int on) {
+    SSP_PARAMETER_NOT_USED(sock);
+    SSP_PARAMETER_NOT_USED(on);
+    return -1;
+}
+
+int __attribute_weak__ socket_would_block(int sock) {
+    SSP_PARAMETER_NOT_USED(sock);
+    return 0;
+}
+#endif
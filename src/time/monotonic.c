@@ -0,0 +1,29 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "time/monotonic.h"
+#include <time/time.h>
+#include <sys/mem.h>
+
+#if defined(CLOCK_MONOTONIC_COARSE) && !defined(TIME_MONO_PRECISE)
+# define TIME_MONO_CLOCK CLOCK_MONOTONIC_COARSE
+#elif defined(CLOCK_MONOTONIC)
+# define TIME_MONO_CLOCK CLOCK_MONOTONIC
+#endif
+
+uint32_t __attribute_weak__ time_mono_ms(void) {
+#if defined(TIME_MONO_CLOCK)
+  struct timespec ts;
+  clock_gettime(TIME_MONO_CLOCK, &ts);
+  return (uint32_t)ts.tv_sec * 1000 + (uint32_t)( ts.tv_nsec / 1000000 );
+#else
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (uint32_t)( now.tv_sec * 1000 + now.tv_usec / 1000 );
+#endif
+}
@@ -8,6 +8,9 @@
 
 #include "time/time.h"
 #include <sys/mem.h>
+#if defined(NTP_CLOCK_TIMESTAMP)
+#include <ntp/clock.h>
+#endif
 
 time_t build_time(void) {
   static const char *built = __DATE__ " " __TIME__;
@@ -42,14 +45,59 @@ int timestamp_is_empty(timestamp_t *t) {
     return 1;
 }
 
+#if defined(NTP_CLOCK_TIMESTAMP)
+// the platform one takes over, this one is the NTP client clock
+// if it is set by the ntp_sync_set_source
+void __attribute_weak__ timestamp(timestamp_t *ts) {
+  ntp_clock_timestamp(ts);
+}
+#endif
+
+static const char _digits2[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+#define put2(p, v) do { \
+    memcpy((p), _digits2 + 2 * (v), 2); \
+    (p) += 2; \
+  } while (0)
+
+// "2018-05-21T13:40:32.173Z", the s is 25 bytes at least
 void timestamp_string(timestamp_t *ts, char *s) {
-    snprintf(s, 25,
-             "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
-             ts->year,
-             ts->mon,
-             ts->day,
-             ts->hour,
-             ts->min,
-             ts->sec,
-             ts->msec);
+    uint32_t year = ts->year;
+    uint32_t msec = ts->msec;
+    // the other fields are two digits by the bit width
+    if ( year > 9999 || msec > 999 ) {
+        // it doesn't fit the layout and it is cut
+        snprintf(s, 25,
+                 "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+                 ts->year,
+                 ts->mon,
+                 ts->day,
+                 ts->hour,
+                 ts->min,
+                 ts->sec,
+                 ts->msec);
+        return;
+    }
+    put2(s, year / 100);
+    put2(s, year % 100);
+    *s++ = '-';
+    put2(s, ts->mon);
+    *s++ = '-';
+    put2(s, ts->day);
+    *s++ = 'T';
+    put2(s, ts->hour);
+    *s++ = ':';
+    put2(s, ts->min);
+    *s++ = ':';
+    put2(s, ts->sec);
+    *s++ = '.';
+    *s++ = (char)( '0' + msec / 100 );
+    put2(s, msec % 100);
+    *s++ = 'Z';
+    *s = 0x0;
 }
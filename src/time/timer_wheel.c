@@ -0,0 +1,90 @@
+/* Copyright (c) 2018 Arrow Electronics, Inc.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Apache License 2.0
+ * which accompanies this distribution, and is available at
+ * http://apache.org/licenses/LICENSE-2.0
+ * Contributors: Arrow Electronics, Inc.
+ */
+
+#include "time/timer_wheel.h"
+#include <sys/mem.h>
+
+#if TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1)
+# error "TIMER_WHEEL_SLOTS should be the power of 2"
+#endif
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define to_tick(ms) ( (uint32_t)(ms) >> TIMER_WHEEL_TICK_SHIFT )
+
+void timer_wheel_init(timer_wheel_t *w, uint32_t now) {
+  memset(w, 0x0, sizeof(timer_wheel_t));
+  w->tick = to_tick(now);
+}
+
+void timer_wheel_add(timer_wheel_t *w, timer_node_t *n, uint32_t due) {
+  uint32_t tick = to_tick(due);
+  // the past one is taken on the next expire step
+  if ( time_mono_diff(tick, w->tick) < 0 ) tick = w->tick;
+  timer_node_t **head = w->slot + ( tick & SLOT_MASK );
+  n->due = due;
+  n->next = *head;
+  if ( *head ) (*head)->pprev = &n->next;
+  n->pprev = head;
+  *head = n;
+  w->count++;
+}
+
+void timer_wheel_del(timer_wheel_t *w, timer_node_t *n) {
+  if ( !timer_wheel_pending(n) ) return;
+  *n->pprev = n->next;
+  if ( n->next ) n->next->pprev = n->pprev;
+  n->next = NULL;
+  n->pprev = NULL;
+  w->count--;
+}
+
+timer_node_t *timer_wheel_expired(timer_wheel_t *w, uint32_t now) {
+  uint32_t now_tick = to_tick(now);
+  if ( !w->count ) {
+    if ( time_mono_diff(now_tick, w->tick) > 0 ) w->tick = now_tick;
+    return NULL;
+  }
+  // a long sleep: every slot is looked at once
+  if ( time_mono_diff(now_tick, w->tick) >= TIMER_WHEEL_SLOTS )
+    w->tick = now_tick - TIMER_WHEEL_SLOTS + 1;
+  for (;;) {
+    timer_node_t *n = w->slot[w->tick & SLOT_MASK];
+    for ( ; n; n = n->next ) {
+      if ( time_mono_diff(n->due, now) <= 0 ) {
+        timer_wheel_del(w, n);
+        return n;
+      }
+    }
+    // the current slot may keep the timers due later in this tick
+    if ( time_mono_diff(w->tick, now_tick) >= 0 ) return NULL;
+    w->tick++;
+  }
+}
+
+int timer_wheel_next_ms(timer_wheel_t *w, uint32_t now, int max_ms) {
+  uint32_t tick = w->tick;
+  int i;
+  if ( !w->count ) return max_ms;
+  for ( i = 0; i < TIMER_WHEEL_SLOTS; i++, tick++ ) {
+    timer_node_t *n = w->slot[tick & SLOT_MASK];
+    int found = 0;
+    int left = max_ms;
+    for ( ; n; n = n->next ) {
+      // the later rounds are skipped
+      if ( time_mono_diff(to_tick(n->due), w->tick) >= TIMER_WHEEL_SLOTS ) continue;
+      int d = time_mono_diff(n->due, now);
+      if ( d < 0 ) d = 0;
+      if ( !found || d < left ) left = d;
+      found = 1;
+    }
+    if ( found ) return left < max_ms ? left : max_ms;
+  }
+  // nothing in this round, look again after it
+  i = TIMER_WHEEL_SLOTS << TIMER_WHEEL_TICK_SHIFT;
+  return i < max_ms ? i : max_ms;
+}
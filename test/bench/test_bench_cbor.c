@@ -0,0 +1,95 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include "bench_clock.h"
+
+// The telemetry sample in JSON against CBOR, chunked as the MQTT buffer.
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+static JsonNode *telemetry_sample(int i) {
+    JsonNode *_node = json_mkobject();
+    json_append_member(_node, p_const(TELEMETRY_DEVICE_HID),
+                       json_mkstring("e000000f63b1a317222772437dc586cb59d680fe"));
+    json_append_member(_node, p_const(TELEMETRY_TEMPERATURE), json_mknumber(23.5 + i % 10));
+    json_append_member(_node, p_const(TELEMETRY_HUMIDITY), json_mknumber(41.37));
+    json_append_member(_node, p_const(TELEMETRY_BAROMETER), json_mknumber(1013.0 + i % 3));
+    json_append_member(_node, p_const("i|counter"), json_mknumber(i));
+    json_append_member(_node, p_const("b|alarm"), json_mkbool(i % 2));
+    json_append_member(_node, p_const(TELEMETRY_ACCELEROMETER_XYZ),
+                       json_mkstring("0.012|-0.031|0.981"));
+    return _node;
+}
+
+#define BENCH_SAMPLES 20000
+#define BENCH_CHUNK   MQTT_BUF_LEN
+
+void test_cbor_bench_telemetry(void) {
+    static char chunk[BENCH_CHUNK];
+    JsonNode *_node = telemetry_sample(1);
+    size_t json_bytes = 0;
+    size_t cbor_bytes = 0;
+    int i;
+
+    double start = bench_now_ns();
+    for ( i = 0; i < BENCH_SAMPLES; i++ ) {
+        json_encode_machine_t jem;
+        int total = json_size(_node);
+        json_encode_init(&jem, _node);
+        while ( total > 0 ) {
+            int r = json_encode_part(&jem, chunk, ARROW_MIN(total, BENCH_CHUNK));
+            if ( r <= 0 ) break;
+            total -= r;
+            json_bytes += r;
+        }
+        json_encode_fin(&jem);
+    }
+    double json_ns = ( bench_now_ns() - start ) / BENCH_SAMPLES;
+
+    start = bench_now_ns();
+    for ( i = 0; i < BENCH_SAMPLES; i++ ) {
+        cbor_encode_machine_t cem;
+        int total = cbor_size(_node);
+        cbor_encode_init(&cem, _node);
+        while ( total > 0 ) {
+            int r = cbor_encode_part(&cem, chunk, ARROW_MIN(total, BENCH_CHUNK));
+            if ( r <= 0 ) break;
+            total -= r;
+            cbor_bytes += r;
+        }
+        cbor_encode_fin(&cem);
+    }
+    double cbor_ns = ( bench_now_ns() - start ) / BENCH_SAMPLES;
+
+    printf("telemetry json: %d bytes/sample %.0f ns/sample\r\n",
+           (int)(json_bytes / BENCH_SAMPLES), json_ns);
+    printf("telemetry cbor: %d bytes/sample %.0f ns/sample\r\n",
+           (int)(cbor_bytes / BENCH_SAMPLES), cbor_ns);
+    TEST_ASSERT(cbor_bytes < json_bytes);
+    json_delete(_node);
+}
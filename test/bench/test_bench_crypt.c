@@ -0,0 +1,192 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(CRYPT_SHA_NI)
+#include <cpuid.h>
+#endif
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <data/linkedlist.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <ssl/crypt.h>
+#include "wolfssl/wolfcrypt/aes.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <ntp/clock.h>
+#include "mock_storage.h"
+
+#include "acnsdkc_time.h"
+#include "bench_clock.h"
+
+// The signatures by several threads with their own hash contexts against
+// the ones serialized under a lock, and the hash/cipher throughput.
+
+#define SIGN_THREADS   8
+#define SIGN_CASES     16
+#define SIGN_ROUNDS    200
+#define BENCH_MS       300
+#define BENCH_RECORD   16384
+
+typedef struct {
+    char uri[64];
+    char query[64];
+    char payload[128];
+    char ts[32];
+    char ref[70];
+    char gw_ref[70];
+} sign_case_t;
+
+static sign_case_t cases[SIGN_CASES];
+
+static void sign_case(sign_case_t *c, char *signature) {
+    const char *m = ( c - cases ) % 2 ? "POST" : "GET";
+    property_t meth = p_const(m);
+    sign(signature, c->ts, &meth, c->uri,
+         c->query[0] ? c->query : NULL,
+         c->payload[0] ? c->payload : NULL, "1");
+}
+
+static void gw_sign_case(sign_case_t *c, char *signature) {
+    gateway_payload_sign(signature, c->ts, c->uri, ( c - cases ) % 2, c->payload, "1");
+}
+
+void setUp(void) {
+    int i;
+    property_types_init();
+    set_api_key("abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789");
+    set_secret_key("secret0123456789secret0123456789abcdefgh");
+    for ( i = 0; i < SIGN_CASES; i++ ) {
+        sign_case_t *c = cases + i;
+        snprintf(c->uri, sizeof(c->uri), "/api/v1/kronos/devices/%08x", i * 2654435761u);
+        if ( i % 3 ) snprintf(c->query, sizeof(c->query), "_page=%d\r\n_size=%d\r\n", i, i * 10);
+        else c->query[0] = 0x0;
+        if ( i % 4 ) snprintf(c->payload, sizeof(c->payload), "{\"name\":\"device%d\",\"uid\":\"%x\"}", i, i * 7919);
+        else c->payload[0] = 0x0;
+        snprintf(c->ts, sizeof(c->ts), "2018-03-%02dT10:%02d:00.000Z", i % 28 + 1, i);
+    }
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+typedef struct {
+    int id;
+    int errors;
+    pthread_mutex_t *lock;
+} sign_arg_t;
+
+static void *sign_thread(void *arg) {
+    sign_arg_t *a = (sign_arg_t *)arg;
+    char signature[70];
+    int i;
+    for ( i = 0; i < SIGN_ROUNDS * SIGN_CASES; i++ ) {
+        sign_case_t *c = cases + ( i + a->id ) % SIGN_CASES;
+        if ( a->lock ) pthread_mutex_lock(a->lock);
+        sign_case(c, signature);
+        if ( strcmp(signature, c->ref) ) a->errors++;
+        gw_sign_case(c, signature);
+        if ( strcmp(signature, c->gw_ref) ) a->errors++;
+        if ( a->lock ) pthread_mutex_unlock(a->lock);
+    }
+    return NULL;
+}
+
+static double sign_run(pthread_mutex_t *lock, int *errors) {
+    pthread_t th[SIGN_THREADS];
+    sign_arg_t args[SIGN_THREADS];
+    int i;
+    double start = bench_now_ms();
+    for ( i = 0; i < SIGN_THREADS; i++ ) {
+        args[i].id = i;
+        args[i].errors = 0;
+        args[i].lock = lock;
+        pthread_create(th + i, NULL, sign_thread, args + i);
+    }
+    for ( i = 0; i < SIGN_THREADS; i++ ) {
+        pthread_join(th[i], NULL);
+        *errors += args[i].errors;
+    }
+    return bench_now_ms() - start;
+}
+
+void test_sign_threads_bench(void) {
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    int i;
+    int errors = 0;
+    // the single-threaded reference
+    for ( i = 0; i < SIGN_CASES; i++ ) {
+        sign_case(cases + i, cases[i].ref);
+        gw_sign_case(cases + i, cases[i].gw_ref);
+        TEST_ASSERT_EQUAL_INT(64, strlen(cases[i].ref));
+    }
+    // the different requests give the different signatures
+    TEST_ASSERT(strcmp(cases[0].ref, cases[1].ref));
+    double concurrent_ms = sign_run(NULL, &errors);
+    TEST_ASSERT_EQUAL_INT(0, errors);
+    // the previous way: every sign under the one lock
+    double serial_ms = sign_run(&lock, &errors);
+    TEST_ASSERT_EQUAL_INT(0, errors);
+    int signs = SIGN_THREADS * SIGN_ROUNDS * SIGN_CASES * 2;
+    printf("%d threads: %.0f signs/s with own contexts, %.0f signs/s serialized\n",
+           SIGN_THREADS, signs * 1000.0 / concurrent_ms, signs * 1000.0 / serial_ms);
+}
+
+// the library built with WOLF_ACCEL=yes takes the accelerated paths
+void test_crypt_bench(void) {
+    static unsigned char rec[BENCH_RECORD];
+    static unsigned char enc[BENCH_RECORD];
+    const unsigned char key[16] = "0123456789abcdef";
+    const unsigned char iv[16] = "fedcba9876543210";
+    char signature[70];
+    char dig[32];
+    int n = 0;
+    double start, ms;
+    Aes aes;
+
+    start = bench_now_ms();
+    do {
+        sign_case(cases + n % SIGN_CASES, signature);
+        n++;
+    } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    printf("sign: %.0f signatures/s\n", n * 1000.0 / ms);
+
+    memset(rec, 0x5a, sizeof(rec));
+    n = 0;
+    start = bench_now_ms();
+    do {
+        sha256(dig, (char*)rec, sizeof(rec));
+        n++;
+    } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    printf("sha256: %.1f MB/s\n", n * (double)BENCH_RECORD / 1000.0 / ms);
+
+    TEST_ASSERT_EQUAL_INT(0, wc_AesSetKey(&aes, key, sizeof(key), iv, AES_ENCRYPTION));
+    n = 0;
+    start = bench_now_ms();
+    do {
+        TEST_ASSERT_EQUAL_INT(0, wc_AesCbcEncrypt(&aes, enc, rec, sizeof(rec)));
+        n++;
+    } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    printf("aes-128-cbc: %.1f MB/s of %d byte TLS records\n",
+           n * (double)BENCH_RECORD / 1000.0 / ms, BENCH_RECORD);
+}
@@ -0,0 +1,221 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <config.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <arrow/mqtt.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include "mock_watchdog.h"
+#include <time/time.h>
+#include "acnsdkc_time.h"
+
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+// The ring logger is built in here, the library's DBG calls come to it.
+#define DBG_RING
+#include "../../src/debug.c"
+#include "bench_clock.h"
+
+// The log calls printed in place against the ring, and the MQTT yield
+// latency with either.
+
+#define BENCH_MS       300
+#define YIELDS         20000
+
+static int saved_stdout = -1;
+
+// the previous dbg_line: format and print by the caller
+__attribute__((optimize("Os")))
+static void old_dbg_line(const char *fmt, ...) {
+    static char buffer[DBG_LINE_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    *buffer = 0x0;
+    vsnprintf(buffer, DBG_LINE_SIZE-2, fmt, args);
+    strcat(buffer, "\r\n");
+    printf("%s", buffer);
+    // the console isn't buffered
+    fflush(stdout);
+    va_end(args);
+}
+
+static void stdout_to(const char *path) {
+    fflush(stdout);
+    saved_stdout = dup(1);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    dup2(fd, 1);
+    close(fd);
+}
+
+static void stdout_back(void) {
+    fflush(stdout);
+    dup2(saved_stdout, 1);
+    close(saved_stdout);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// the fake broker answers PINGRESP on every read
+static const unsigned char pingresp[2] = { PINGRESP << 4, 0 };
+static int ping_pos = 0;
+
+static int fake_read(Network *n, unsigned char *buf, int len, int timeout) {
+    (void)n; (void)timeout;
+    int i;
+    for ( i = 0; i < len; i++ ) {
+        buf[i] = pingresp[ping_pos];
+        ping_pos = ( ping_pos + 1 ) % (int)sizeof(pingresp);
+    }
+    return len;
+}
+
+static int fake_write(Network *n, unsigned char *buf, int len, int timeout) {
+    (void)n; (void)buf; (void)timeout;
+    return len;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// the yield with the log line printed in place or put into the ring;
+// the ring is flushed out of the yield as by the log thread on the other core
+static void yield_latency(MQTTClient *c, int inline_flush, double *mean, double *p99) {
+    static double lat[YIELDS];
+    int i;
+    double sum = 0;
+    for ( i = 0; i < YIELDS; i++ ) {
+        double start = bench_now_us();
+        TEST_ASSERT_EQUAL_INT(PINGRESP, MQTTYield(c, 100));
+        if ( inline_flush ) {
+            dbg_flush();
+            fflush(stdout);
+        }
+        lat[i] = bench_now_us() - start;
+        sum += lat[i];
+        if ( !inline_flush && i % ( DBG_RING_SIZE / 2 ) == 0 ) {
+            dbg_flush();
+            fflush(stdout);
+        }
+    }
+    qsort(lat, YIELDS, sizeof(double), cmp_double);
+    *mean = sum / YIELDS;
+    *p99 = lat[YIELDS * 99 / 100];
+}
+
+void test_dbg_ring_bench(void) {
+    static unsigned char buf[MQTT_BUF_LEN];
+    static unsigned char readbuf[MQTT_RECVBUF_LEN];
+    Network net;
+    MQTTClient client;
+    double start, ms, old_rate, ring_rate;
+    double sync_mean, sync_p99, ring_mean, ring_p99;
+    int n;
+
+    stdout_to("/dev/null");
+    n = 0;
+    start = bench_now_us();
+    do { old_dbg_line("mqtt recv type %d", n++); } while ( (ms = ( bench_now_us() - start ) / 1000) < BENCH_MS );
+    old_rate = n * 1000.0 / ms;
+
+    // the caller's part and the flush by the ring sizes, nothing is dropped
+    double call_us = 0, flush_us = 0;
+    unsigned int lost = dbg_dropped();
+    n = 0;
+    do {
+        int i;
+        start = bench_now_us();
+        for ( i = 0; i < DBG_RING_SIZE; i++ ) dbg_line("mqtt recv type %d", n++);
+        call_us += bench_now_us() - start;
+        start = bench_now_us();
+        dbg_flush();
+        fflush(stdout);
+        flush_us += bench_now_us() - start;
+    } while ( call_us + flush_us < BENCH_MS * 1000 );
+    ring_rate = n * 1e6 / call_us;
+    TEST_ASSERT_EQUAL_INT(lost, dbg_dropped());
+
+    // cycle_r logs every packet
+    net.mqttread = fake_read;
+    net.mqttwrite = fake_write;
+    MQTTClientInit(&client, &net, 1000, buf, sizeof(buf), readbuf, sizeof(readbuf));
+    client.isconnected = 1;
+    yield_latency(&client, 1, &sync_mean, &sync_p99);
+    yield_latency(&client, 0, &ring_mean, &ring_p99);
+    TEST_ASSERT_EQUAL_INT(lost, dbg_dropped());
+    stdout_back();
+
+    printf("log calls: %.0f/s printed in place, %.0f/s into the ring (%.0f/s with the flush)\n",
+           old_rate, ring_rate, n * 1e6 / ( call_us + flush_us ));
+    printf("mqtt_yield: %.2f us mean %.2f us p99 printed in place, "
+           "%.2f us mean %.2f us p99 with the ring\n",
+           sync_mean, sync_p99, ring_mean, ring_p99);
+}
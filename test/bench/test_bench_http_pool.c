@@ -0,0 +1,206 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <http/client.h>
+#include <http/pool.h>
+#include <http/inflate.h>
+#include <sys/mem.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <arrow/utf8.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <bsd/socket.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <data/find_by.h>
+#include <time/monotonic.h>
+
+#include "acnsdkc_ssl.h"
+
+#include "mock_mac.h"
+#include "mock_sockdecl.h"
+#include "socket_weak.h"
+
+#include "fakedns.h"
+#include "bench_clock.h"
+
+// The requests over the new connections against the keep-alive pool,
+// every connect takes the BENCH_HANDSHAKE.
+
+#define TEST_URL      "http://api.arrowconnect.io:80/api/v1/kronos/gateways"
+#define TEST_URL_PORT "http://api.arrowconnect.io:8080/api/v1/kronos/gateways"
+
+// fake server: answers every request line with "HTTP/1.1 200 OK" and the number of the answer
+static int next_sock = 0;
+static int opened = 0;
+static int closed = 0;
+static int peer_closed_sock = -1;
+static int peer_reset_sock = -1;
+static int fail_send = 0;
+static int pending = 0;
+static int served = 0;
+static int connect_delay_us = 0;
+static const char *extra_header = "";
+static int body_len = 2;
+static __payload_handler add_handler = NULL;
+static char answer[1024];
+static int answer_len = 0;
+static int answer_pos = 0;
+static uint32_t fake_now = 0;
+static http_client_t cli;
+
+uint32_t http_pool_now(void) {
+    return fake_now;
+}
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    opened++;
+    return next_sock++;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    if ( connect_delay_us ) usleep(connect_delay_us);
+    return 0;
+}
+
+static void soc_close_cb(int sock, int num) {
+    (void)sock; (void)num;
+    closed++;
+    // the unread rest of the answer goes away with the connection
+    if ( answer_len ) {
+        answer_len = 0;
+        pending--;
+        served++;
+    }
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    if ( fail_send ) {
+        fail_send = 0;
+        return -1;
+    }
+    if ( len > 4 && ( !strncmp(buf, "GET ", 4) || !strncmp(buf, "POST", 4) ) ) pending++;
+    return len;
+}
+
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)num;
+    if ( flags & MSG_PEEK ) {
+        if ( sockfd == peer_closed_sock ) return 0;
+        errno = sockfd == peer_reset_sock ? ECONNRESET : EAGAIN;
+        return -1;
+    }
+    if ( !answer_len ) {
+        if ( !pending ) return -1;
+        answer_len = sprintf(answer,
+                             "HTTP/1.1 200 OK\r\n%sContent-Length: %d\r\n\r\n%02d",
+                             extra_header, body_len, served % 100);
+        memset(answer + answer_len, 'x', body_len - 2);
+        answer_len += body_len - 2;
+        answer_pos = 0;
+    }
+    int size = answer_len - answer_pos;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, answer + answer_pos, size);
+    answer_pos += size;
+    if ( answer_pos == answer_len ) {
+        answer_len = 0;
+        pending--;
+        served++;
+    }
+    return size;
+}
+
+void setUp(void) {
+    property_types_init();
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    soc_close_StubWithCallback(soc_close_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    opened = closed = 0;
+    pending = served = 0;
+    answer_len = 0;
+    peer_closed_sock = -1;
+    peer_reset_sock = -1;
+    fail_send = 0;
+    connect_delay_us = 0;
+    extra_header = "";
+    body_len = 2;
+    add_handler = NULL;
+    fake_now = 1000;
+    http_client_init(&cli);
+}
+
+void tearDown(void) {
+    http_pool_clear();
+    http_client_free(&cli);
+    property_types_deinit();
+}
+
+static int do_get(const char *url, int pool, char *payload) {
+    http_request_t req;
+    http_response_t res;
+    memset(&res, 0x0, sizeof(res));
+    http_request_init(&req, GET, url);
+    if ( add_handler ) req._response_payload_meth._p_add_handler = add_handler;
+    int ret = pool ? http_pool_client_open(&cli, &req) : default_http_client_open(&cli, &req);
+    if ( ret >= 0 ) {
+        ret = pool ? http_pool_client_do(&cli, &res) : default_http_client_do(&cli, &res);
+    }
+    http_request_close(&req);
+    if ( pool ) http_pool_client_close(&cli);
+    else default_http_client_close(&cli);
+    if ( ret >= 0 && payload ) strcpy(payload, P_VALUE(res.payload));
+    http_response_free(&res);
+    return ret;
+}
+
+#define BENCH_REQUESTS  500
+#define BENCH_HANDSHAKE 200
+
+void test_http_pool_bench(void) {
+    int pool;
+    connect_delay_us = BENCH_HANDSHAKE;
+    for ( pool = 0; pool < 2; pool++ ) {
+        int i;
+        opened = 0;
+        double start = bench_now_s();
+        for ( i = 0; i < BENCH_REQUESTS; i++ ) {
+            TEST_ASSERT_EQUAL_INT(0, do_get(TEST_URL, pool, NULL));
+        }
+        double spent = bench_now_s() - start;
+        printf("%s: %d connections %8.0f requests/s\r\n",
+               pool ? "keep-alive pool" : "new connection ",
+               opened, BENCH_REQUESTS / spent);
+    }
+    TEST_ASSERT_EQUAL_INT(1, opened);
+}
@@ -0,0 +1,78 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+// the build which doesn't trust the target macros: the byte order is probed
+// and swapped without the builtins
+#define BYTE_ORDER_PROBE
+#define BYTE_ORDER_NO_BUILTIN
+#include <bsd/byteorder.h>
+#include <bsd/inet.h>
+#include <MQTTPacket.h>
+
+#include "acnsdkc_time.h"
+#include "bench_clock.h"
+
+// htonl as the runtime byte order detection, the library call and the
+// probed inline swap.
+
+#define BENCH_ROUNDS 20000000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// the conversion as it was: the byte order was found on every call
+static int endianness_runtime(void) {
+    union {
+        uint32_t value;
+        uint8_t data[sizeof(uint32_t)];
+    } number;
+    number.data[0] = 0x00;
+    number.data[1] = 0x01;
+    number.data[2] = 0x02;
+    number.data[3] = 0x03;
+    switch ( number.value ) {
+    case (uint32_t)(0x00010203): return 1;
+    default: return 0;
+    }
+}
+
+static uint32_t __attribute__((noinline)) htonl_runtime(uint32_t n) {
+    if ( endianness_runtime() ) return n;
+    return ((n & 0xff) << 24) |
+        ((n & 0xff00) << 8) |
+        ((n & 0xff0000UL) >> 8) |
+        ((n & 0xff000000UL) >> 24);
+}
+
+void test_inet_bench(void) {
+    volatile uint32_t sink = 0;
+    uint32_t acc;
+    uint32_t i;
+    double start, runtime_ns, call_ns, inline_ns;
+
+    acc = 0;
+    start = bench_now_ns();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) acc += htonl_runtime(i);
+    runtime_ns = ( bench_now_ns() - start ) / BENCH_ROUNDS;
+    sink = acc;
+
+    acc = 0;
+    start = bench_now_ns();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) acc += htonl(i);
+    call_ns = ( bench_now_ns() - start ) / BENCH_ROUNDS;
+    TEST_ASSERT_EQUAL_HEX32(sink, acc);
+
+    acc = 0;
+    start = bench_now_ns();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) acc += byteorder_htonl(i);
+    inline_ns = ( bench_now_ns() - start ) / BENCH_ROUNDS;
+    TEST_ASSERT_EQUAL_HEX32(sink, acc);
+
+    printf("htonl: runtime detect %.2f ns, library call %.2f ns, "
+           "probed inline %.2f ns\r\n", runtime_ns, call_ns, inline_ns);
+}
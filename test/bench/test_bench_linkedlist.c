@@ -0,0 +1,83 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <data/linkedlist.h>
+#include <data/dllist.h>
+#include <time.h>
+#include "bench_clock.h"
+
+typedef struct _test_ {
+  int data;
+  int count;
+  int hello;
+  arrow_linked_list_head_node;
+} test_t;
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+#define BENCH_NODES 100000
+
+typedef struct _dl_test_ {
+  int count;
+  doubly_linked_list_head_node;
+} dl_test_t;
+
+// append 100000 nodes to the list of every kind
+void test_list_append_bench(void) {
+    test_t *n = (test_t *)malloc(BENCH_NODES * sizeof(test_t));
+    dl_test_t *dn = (dl_test_t *)malloc(BENCH_NODES * sizeof(dl_test_t));
+    test_t *root = NULL;
+    test_t *tmp = NULL;
+    dl_test_t *droot = NULL;
+    arrow_linked_list_head_t head = ARROW_LINKED_LIST_HEAD_INIT;
+    doubly_linked_list_head_t dhead = DOUBLY_LINKED_LIST_HEAD_INIT;
+    double start, walk_ms, head_ms, dl_ms, dl_head_ms;
+    int i;
+
+    start = bench_now_ms();
+    for ( i = 0; i < BENCH_NODES; i++ ) {
+        n[i].count = i;
+        arrow_linked_list_add_node_last(root, test_t, n + i);
+    }
+    walk_ms = bench_now_ms() - start;
+
+    start = bench_now_ms();
+    for ( i = 0; i < BENCH_NODES; i++ ) {
+        arrow_linked_list_head_add_node_last(&head, n + i);
+    }
+    head_ms = bench_now_ms() - start;
+    i = 0;
+    arrow_linked_list_head_for_each(tmp, &head, test_t) {
+        TEST_ASSERT_EQUAL_INT(i++, tmp->count);
+    }
+    TEST_ASSERT_EQUAL_INT(BENCH_NODES, i);
+    TEST_ASSERT_EQUAL_INT(BENCH_NODES, arrow_linked_list_head_size(&head));
+
+    start = bench_now_ms();
+    for ( i = 0; i < BENCH_NODES; i++ ) {
+        dn[i].count = i;
+        doubly_linked_list_add_node_tail(droot, dl_test_t, dn + i);
+    }
+    dl_ms = bench_now_ms() - start;
+
+    start = bench_now_ms();
+    for ( i = 0; i < BENCH_NODES; i++ ) {
+        doubly_linked_list_head_add_node_last(&dhead, dn + i);
+    }
+    dl_head_ms = bench_now_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BENCH_NODES, doubly_linked_list_head_size(&dhead));
+    TEST_ASSERT_EQUAL_INT(BENCH_NODES - 1, doubly_linked_list_head_last(&dhead, dl_test_t)->count);
+
+    printf("append %d nodes: list %.1f ms, list head %.2f ms, "
+           "doubly linked list %.2f ms, doubly linked list head %.2f ms\n",
+           BENCH_NODES, walk_ms, head_ms, dl_ms, dl_head_ms);
+    free(n);
+    free(dn);
+}
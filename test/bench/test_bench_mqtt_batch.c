@@ -0,0 +1,184 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <json/json.h>
+#include <arrow/mqtt.h>
+#include <arrow/telemetry_filter.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/cbor.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include "mock_watchdog.h"
+#include <time/time.h>
+#include "acnsdkc_time.h"
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+
+#include "mock_mac.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+#include "fakedns.h"
+#include "bench_clock.h"
+
+// The telemetry samples published one by one against the batches of them,
+// every PUBACK comes after the BENCH_RTT_US.
+
+#define TEST_TOPIC "krs.tel.gts.test"
+#define BENCH_SAMPLES 2000
+#define BENCH_RTT_US  100
+
+// fake broker: count the packets and answer PUBACK on every PUBLISH after the rtt
+static unsigned char ack[4];
+static int ack_len = 0;
+static int ack_pos = 0;
+static int sent_packets = 0;
+static int packet_left = 0;
+
+static int fake_write(Network *n, unsigned char *buf, int len, int timeout) {
+    (void)n; (void)timeout;
+    if ( !packet_left ) {
+        // the new packet begins with the fixed header
+        int i = 1;
+        int mult = 1;
+        do {
+            packet_left += ( buf[i] & 0x7f ) * mult;
+            mult *= 128;
+        } while ( buf[i++] & 0x80 );
+        packet_left += i;
+        if ( ( buf[0] >> 4 ) == PUBLISH ) {
+            sent_packets++;
+            ack[0] = PUBACK << 4;
+            ack[1] = 2;
+            ack[2] = 0;
+            ack[3] = 1;
+            ack_len = 4;
+            ack_pos = 0;
+        }
+    }
+    packet_left -= len;
+    return len;
+}
+
+static int fake_read(Network *n, unsigned char *buf, int len, int timeout) {
+    (void)n; (void)timeout;
+    int i;
+    if ( ack_pos == 0 ) usleep(BENCH_RTT_US);
+    for ( i = 0; i < len && ack_pos < ack_len; i++ ) {
+        buf[i] = ack[ack_pos++];
+    }
+    return i;
+}
+
+static Network net;
+static MQTTClient client;
+static unsigned char buf[MQTT_BUF_LEN];
+static unsigned char readbuf[MQTT_RECVBUF_LEN];
+static mqtt_batch_t batch;
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+    net.mqttread = fake_read;
+    net.mqttwrite = fake_write;
+    MQTTClientInit(&client, &net, 1000, buf, sizeof(buf), readbuf, sizeof(readbuf));
+    client.isconnected = 1;
+    // MQTTPublish_part checks the ack in the readbuf
+    readbuf[0] = PUBACK << 4;
+    readbuf[1] = 2;
+    readbuf[2] = 0;
+    readbuf[3] = 1;
+    sent_packets = 0;
+    packet_left = 0;
+}
+
+void tearDown(void) {
+    mqtt_batch_free(&batch);
+    property_types_deinit();
+}
+
+static JsonNode *sample(int i) {
+    JsonNode *_node = json_mkobject();
+    json_append_member(_node, p_const(TELEMETRY_DEVICE_HID), json_mkstring("hid"));
+    json_append_member(_node, p_const("i|counter"), json_mknumber(i));
+    return _node;
+}
+
+void test_mqtt_batch_bench(void) {
+    int sizes[] = { 1, 5, 10, 50 };
+    unsigned int s;
+    for ( s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++ ) {
+        int i;
+        sent_packets = 0;
+        mqtt_batch_init(&batch, sizes[s], 60000);
+        double start = bench_now_s();
+        for ( i = 0; i < BENCH_SAMPLES; i++ ) {
+            if ( mqtt_batch_add(&batch, sample(i)) > 0 ) {
+                TEST_ASSERT_EQUAL_INT(0, mqtt_batch_publish(&client, TEST_TOPIC,
+                                                            &batch, mqtt_payload_json));
+            }
+        }
+        double spent = bench_now_s() - start;
+        printf("batch %2d: %5d publishes %8.0f samples/s\r\n",
+               sizes[s], sent_packets, BENCH_SAMPLES / spent);
+        TEST_ASSERT_EQUAL_INT(BENCH_SAMPLES / sizes[s], sent_packets);
+        mqtt_batch_free(&batch);
+    }
+}
@@ -0,0 +1,226 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <arrow/mqtt.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include "mock_watchdog.h"
+#include <time/time.h>
+#include "acnsdkc_time.h"
+
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+#include "bench_clock.h"
+
+#define TEST_TOPIC "krs.tel.gts.test"
+
+// The publish serialized into the one buffer as large as the packet
+// against the gather write and the payload encoded into the client buffer.
+
+// fake broker: count the write calls and the bytes which went through
+// the client send buffer
+static int writes = 0;
+static long staged = 0;
+
+static Network net;
+static MQTTClient client;
+static unsigned char buf[MQTT_BUF_LEN];
+static unsigned char readbuf[MQTT_RECVBUF_LEN];
+
+static void take(const unsigned char *p, int len) {
+    if ( p >= buf && p < buf + sizeof(buf) ) staged += len;
+}
+
+static int fake_write(Network *n, unsigned char *p, int len, int timeout) {
+    (void)n; (void)timeout;
+    writes++;
+    take(p, len);
+    return len;
+}
+
+static int fake_writev(Network *n, socket_iovec_t *iov, int cnt, int timeout) {
+    int i;
+    int sent = 0;
+    (void)n; (void)timeout;
+    writes++;
+    for ( i = 0; i < cnt; i++ ) {
+        take((const unsigned char *)iov[i].base, (int)iov[i].len);
+        sent += (int)iov[i].len;
+    }
+    return sent;
+}
+
+static int fake_read(Network *n, unsigned char *p, int len, int timeout) {
+    (void)n; (void)p; (void)len; (void)timeout;
+    return 0;
+}
+
+// the encoder writes the payload right into the buffer given
+static const char *drive_src = NULL;
+static int drive_len = 0;
+static int drive_pos = 0;
+
+static int drive_init(void) {
+    drive_pos = 0;
+    return drive_len;
+}
+
+static int drive_part(char *out, int len) {
+    if ( len > drive_len - drive_pos ) len = drive_len - drive_pos;
+    memcpy(out, drive_src + drive_pos, len);
+    drive_pos += len;
+    return len;
+}
+
+static int drive_fin(void) {
+    return 0;
+}
+
+static mqtt_payload_drive_t test_drive = { drive_init, drive_part, drive_fin };
+
+static char payload[65536];
+
+void setUp(void) {
+    int i;
+    net.mqttread = fake_read;
+    net.mqttwrite = fake_write;
+    net.mqttwritev = fake_writev;
+    MQTTClientInit(&client, &net, 1000, buf, sizeof(buf), readbuf, sizeof(readbuf));
+    client.isconnected = 1;
+    for ( i = 0; i < (int)sizeof(payload); i++ ) payload[i] = 'a' + i % 26;
+    writes = 0;
+    staged = 0;
+}
+
+void tearDown(void) {
+}
+
+static int expected_packet(unsigned char *out, int outlen, int len) {
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = TEST_TOPIC;
+    return MQTTSerialize_publish(out, outlen, 0, QOS0, 0, 0, topic,
+                                 (unsigned char *)payload, len);
+}
+
+static int publish(int len) {
+    MQTTMessage msg;
+    memset(&msg, 0x0, sizeof(msg));
+    msg.qos = QOS0;
+    msg.payload = payload;
+    msg.payloadlen = len;
+    return MQTTPublish(&client, TEST_TOPIC, &msg);
+}
+
+static int publish_part(int len) {
+    MQTTMessage msg;
+    memset(&msg, 0x0, sizeof(msg));
+    msg.qos = QOS0;
+    drive_src = payload;
+    drive_len = len;
+    return MQTTPublish_part(&client, TEST_TOPIC, &msg, &test_drive);
+}
+
+#define BENCH_MESSAGES 2000
+
+// the whole packet is serialized into the buffer as large as the packet
+// and written by the one call
+static int publish_copy(unsigned char *out, int outlen, int len) {
+    int plen = expected_packet(out, outlen, len);
+    staged += plen;
+    return fake_write(&net, out, plen, 0) == plen ? 0 : -1;
+}
+
+void test_mqtt_publish_bench(void) {
+    static unsigned char copybuf[66000];
+    int sizes[] = { 100, 4096, 65000 };
+    unsigned int s;
+    for ( s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++ ) {
+        int i;
+        double start;
+
+        writes = 0; staged = 0;
+        start = bench_now_us();
+        for ( i = 0; i < BENCH_MESSAGES; i++ )
+            TEST_ASSERT_EQUAL_INT(0, publish_copy(copybuf, sizeof(copybuf), sizes[s]));
+        printf("%5d B copy:   %5.2f writes/msg %7ld bytes copied/msg %7.2f us/msg\r\n",
+               sizes[s], (double)writes / BENCH_MESSAGES, staged / BENCH_MESSAGES,
+               ( bench_now_us() - start ) / BENCH_MESSAGES);
+
+        writes = 0; staged = 0;
+        start = bench_now_us();
+        for ( i = 0; i < BENCH_MESSAGES; i++ )
+            TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish(sizes[s]));
+        printf("%5d B writev: %5.2f writes/msg %7ld bytes copied/msg %7.2f us/msg\r\n",
+               sizes[s], (double)writes / BENCH_MESSAGES, staged / BENCH_MESSAGES,
+               ( bench_now_us() - start ) / BENCH_MESSAGES);
+        TEST_ASSERT_EQUAL_INT(BENCH_MESSAGES, writes);
+
+        writes = 0; staged = 0;
+        start = bench_now_us();
+        for ( i = 0; i < BENCH_MESSAGES; i++ )
+            TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish_part(sizes[s]));
+        printf("%5d B drive:  %5.2f writes/msg %7ld bytes encoded/msg %6.2f us/msg\r\n",
+               sizes[s], (double)writes / BENCH_MESSAGES, staged / BENCH_MESSAGES,
+               ( bench_now_us() - start ) / BENCH_MESSAGES);
+    }
+}
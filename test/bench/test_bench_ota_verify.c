@@ -0,0 +1,256 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/routine.h>
+#include <arrow/utf8.h>
+#include <arrow/ota_verify.h>
+#include <arrow/software_release.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_intern.h>
+#include <http/client.h>
+#include <ssl/crypt.h>
+#include <ssl/md5sum.h>
+#include <bsd/socket.h>
+#include <json/property_json.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_api.h>
+#include "api_device_device.h"
+#include "api_gateway_gateway.h"
+#include "api_gateway_info.h"
+#include <arrow/api/device/info.h>
+#include <arrow/api/device/event.h>
+#include <arrow/api/log.h>
+#include <arrow/api/json/page.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_update.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+
+#include "acnsdkc_time.h"
+#include "mock_mac.h"
+#include "mock_watchdog.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+#include "fakedns.h"
+#include "bench_clock.h"
+
+// The 8 MB image downloaded with the MD5 and the SHA-256 checksum, and the
+// SHA-256 verifier alone by the client pieces.
+
+#define BENCH_SIZE     ( 8 * 1024 * 1024 )
+
+static char *image = NULL;
+static char head[256];
+static int head_len = 0;
+static int body_len = 0;
+static int served = 0;
+
+static uint32_t payload_bytes = 0;
+static int payload_calls = 0;
+static int payload_first = 0;
+static int complete_result = -1;
+static int complete_calls = 0;
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 0;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)buf; (void)flags; (void)num;
+    return len;
+}
+
+// the header, then the body of the image
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    int size = head_len + body_len - served;
+    if ( size <= 0 ) return -1;
+    if ( size > (int)len ) size = len;
+    if ( served < head_len ) {
+        if ( size > head_len - served ) size = head_len - served;
+        memcpy(buf, head + served, size);
+    } else {
+        memcpy(buf, image + served - head_len, size);
+    }
+    served += size;
+    return size;
+}
+
+static void serve(int code, int content_length, int len) {
+    head_len = sprintf(head, "HTTP/1.1 %d OK\r\n"
+                             "Content-Type: application/octet-stream\r\n"
+                             "Content-Length: %d\r\n\r\n", code, content_length);
+    body_len = len;
+    served = 0;
+}
+
+static int payload_cb(const char *data, int len, int flag) {
+    (void)data;
+    if ( flag == FW_FIRST ) payload_first++;
+    payload_calls++;
+    payload_bytes += (uint32_t)len;
+    return 0;
+}
+
+static int complete_cb(int result) {
+    complete_calls++;
+    complete_result = result;
+    return result == FW_SUCCESS ? 0 : -1;
+}
+
+static void make_image(int size) {
+    uint32_t x = 0x12345678;
+    int i;
+    for ( i = 0; i < size; i++ ) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        image[i] = (char)x;
+    }
+}
+
+static void sha256_hex(char *hex, int size) {
+    char dig[32];
+    sha256(dig, image, size);
+    hex_encode(hex, dig, 32);
+    hex[64] = 0x0;
+}
+
+static void md5_hex(char *hex, int size) {
+    char dig[16];
+    md5sum(dig, image, size);
+    hex_encode(hex, dig, 16);
+    hex[32] = 0x0;
+}
+
+static int download(const char *checksum) {
+    payload_bytes = 0;
+    payload_calls = 0;
+    payload_first = 0;
+    complete_calls = 0;
+    complete_result = -1;
+    return arrow_software_release_download("token", "trans", checksum);
+}
+
+void setUp(void) {
+    arrow_init();
+    image = malloc(BENCH_SIZE);
+    make_image(BENCH_SIZE);
+    arrow_software_release_dowload_set_cb(NULL, payload_cb, complete_cb);
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    soc_close_Ignore();
+    wdt_feed_IgnoreAndReturn(0);
+}
+
+void tearDown(void) {
+    free(image);
+    arrow_deinit();
+}
+
+// the same image through the client with the MD5 and the SHA-256 checksum
+void test_ota_download_bench(void) {
+    char hex[66];
+    double start, md5_ms, sha_ms, hash_ms;
+    ota_verify_t v;
+
+    md5_hex(hex, BENCH_SIZE);
+    serve(200, BENCH_SIZE, BENCH_SIZE);
+    start = bench_now_ms();
+    TEST_ASSERT_EQUAL_INT(0, download(hex));
+    md5_ms = bench_now_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BENCH_SIZE, payload_bytes);
+
+    sha256_hex(hex, BENCH_SIZE);
+    serve(200, BENCH_SIZE, BENCH_SIZE);
+    start = bench_now_ms();
+    TEST_ASSERT_EQUAL_INT(0, download(hex));
+    sha_ms = bench_now_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BENCH_SIZE, payload_bytes);
+
+    // the hashing alone by the client pieces
+    start = bench_now_ms();
+    int pos;
+    ota_verify_init(&v, hex, 0);
+    for ( pos = 0; pos < BENCH_SIZE; pos += HTTP_CHUNK_SIZE ) {
+        ota_verify_update(&v, image + pos, HTTP_CHUNK_SIZE);
+    }
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_final(&v));
+    hash_ms = bench_now_ms() - start;
+
+    printf("OTA %d MB image: MD5 %.1f MB/s, SHA-256 %.1f MB/s (SHA-256 alone %.1f MB/s)\n",
+           BENCH_SIZE >> 20,
+           BENCH_SIZE / 1000.0 / md5_ms,
+           BENCH_SIZE / 1000.0 / sha_ms,
+           BENCH_SIZE / 1000.0 / hash_ms);
+}
@@ -0,0 +1,121 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include "bench_clock.h"
+
+// The property copy and free dispatched by the table against the previous
+// list of the types.
+
+#define BENCH_MS   200
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+#define NAME "HELLO"
+
+// the previous dispatcher: the list of the types
+static property_dispetcher_t *old_disp = NULL;
+
+static int old_proptypeeq( property_dispetcher_t *d, uint8_t flag ) {
+    if ( d->index == (0x3f & flag) ) return 0;
+    return -1;
+}
+
+__attribute__((optimize("Os")))
+static property_handler_t *old_get_property_type(property_t *src) {
+    property_dispetcher_t *tmp = NULL;
+    linked_list_find_node(tmp, old_disp, property_dispetcher_t, old_proptypeeq, src->flags);
+    if ( tmp ) return &tmp->handler;
+    return NULL;
+}
+
+__attribute__((optimize("Os")))
+static void old_property_copy(property_t *dst, property_t src, int weak) {
+    property_init(dst);
+    property_handler_t *handler = old_get_property_type(&src);
+    if ( !handler ) return;
+    if ( weak ) handler->weak(dst, &src);
+    else handler->copy(dst, &src);
+}
+
+__attribute__((optimize("Os")))
+static void old_property_free(property_t *dst) {
+    if ( dst->flags & is_owner ) {
+        property_handler_t *handler = old_get_property_type(dst);
+        if ( handler && handler->destroy ) handler->destroy(dst);
+    }
+    memset(dst, 0x0, sizeof(property_t));
+}
+
+static double copy_rate(property_t src, int weak, int old) {
+    property_t p;
+    double start, ms;
+    int n = 0;
+    start = bench_now_ms();
+    do {
+        int i;
+        for ( i = 0; i < 100; i++ ) {
+            if ( old ) {
+                old_property_copy(&p, src, weak);
+                old_property_free(&p);
+            } else {
+                if ( weak ) property_weak_copy(&p, src);
+                else property_copy(&p, src);
+                property_free(&p);
+            }
+        }
+        n += 100;
+    } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    return n * 1000.0 / ms;
+}
+
+// copy + free pairs by the type, the json type is the last registered one
+void test_property_dispatch_bench( void ) {
+    static char json[] = "{\"a\":1}";
+    struct { const char *name; property_t p; } types[] = {
+        { "const",   p_const(NAME) },
+        { "stack",   p_stack(NAME) },
+        { "dynamic", p_heap(NAME) },
+        { "json",    p_json(json) }
+    };
+    int t, weak;
+    arrow_linked_list_add_node_last(old_disp, property_dispetcher_t, property_type_get_const());
+    arrow_linked_list_add_node_last(old_disp, property_dispetcher_t, property_type_get_dynamic());
+    arrow_linked_list_add_node_last(old_disp, property_dispetcher_t, property_type_get_stack());
+    arrow_linked_list_add_node_last(old_disp, property_dispetcher_t, property_type_get_json());
+    for ( t = 0; t < (int)(sizeof(types) / sizeof(types[0])); t++ ) {
+        for ( weak = 1; weak >= 0; weak-- ) {
+            double old_rate = copy_rate(types[t].p, weak, 1);
+            double new_rate = copy_rate(types[t].p, weak, 0);
+            printf("%-7s %s + free: %.1f M/s list, %.1f M/s table (x%.2f)\n",
+                   types[t].name, weak ? "weak copy" : "copy     ",
+                   old_rate / 1e6, new_rate / 1e6, new_rate / old_rate);
+        }
+    }
+    while ( old_disp ) {
+        arrow_linked_list_del_node_last(old_disp, property_dispetcher_t);
+    }
+}
@@ -0,0 +1,366 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <config.h>
+#include <debug.h>
+#include <http/client.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <sys/mem.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/reactor.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <bsd/socket.h>
+#include <bsd/sockpoll.h>
+#include <mqtt/client/client.h>
+#include <ssl/crypt.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <data/find_by.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include "socket_weak.h"
+#include "mock_storage.h"
+
+#include "acnsdkc_ssl.h"
+#include "acnsdkc_time.h"
+#include "bench_clock.h"
+
+// The event loop over the real sockets (the unix socket pairs) with the
+// MQTT channels and the REST calls in one thread.
+// The peers are the threads: an MQTT broker stand-in per channel sends
+// the PUBLISH packets, the HTTP server answers the request uri.
+
+#define BENCH_CHANNELS   4
+#define BENCH_MESSAGES   5000
+#define BENCH_CALLS      400
+#define BENCH_DEPTH      4
+#define BENCH_TOPIC      "bench/ch"
+#define BENCH_PAYLOAD    32
+
+int socketpair(int domain, int type, int protocol, int sv[2]);
+#define UNIX_DOMAIN      1
+#define UNIX_STREAM      1
+
+// the shared debug buffer isn't for the threads
+void dbg_line(const char *fmt, ...) {
+    (void)fmt;
+}
+
+// the HTTP server: the connect() gives it the other end of a socket pair
+
+static pthread_mutex_t srv_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t srv_cond = PTHREAD_COND_INITIALIZER;
+static int srv_queue[64];
+static int srv_len = 0;
+static int srv_stop = 0;
+
+struct hostent *gethostbyname(const char *name) {
+    static struct hostent s_hostent;
+    static char *s_aliases;
+    static unsigned long s_hostent_addr;
+    static unsigned long *s_phostent_addr[2];
+    s_hostent_addr = 0x0100007f;
+    s_phostent_addr[0] = &s_hostent_addr;
+    s_phostent_addr[1] = NULL;
+    s_hostent.h_name = (char*)name;
+    s_hostent.h_aliases = &s_aliases;
+    s_hostent.h_addrtype = AF_INET;
+    s_hostent.h_length = sizeof(unsigned long);
+    s_hostent.h_addr_list = (char**)&s_phostent_addr;
+    s_hostent.h_addr = s_hostent.h_addr_list[0];
+    return &s_hostent;
+}
+
+// the SDK socket options don't match the host ones
+int setsockopt(int sockfd, int level, int optname,
+               const void *optval, socklen_t optlen) {
+    (void)sockfd; (void)level; (void)optname; (void)optval; (void)optlen;
+    return 0;
+}
+
+int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen) {
+    int sv[2];
+    (void)addr; (void)addrlen;
+    if ( socketpair(UNIX_DOMAIN, UNIX_STREAM, 0, sv) < 0 ) return -1;
+    dup2(sv[0], sockfd);
+    close(sv[0]);
+    pthread_mutex_lock(&srv_mutex);
+    srv_queue[srv_len++] = sv[1];
+    pthread_cond_signal(&srv_cond);
+    pthread_mutex_unlock(&srv_mutex);
+    return 0;
+}
+
+void soc_close(int socket) {
+    close(socket);
+}
+
+static void serve_http(int fd) {
+    char req[512];
+    char answer[256];
+    int len = 0;
+    while ( len < (int)sizeof(req) - 1 ) {
+        int r = read(fd, req + len, sizeof(req) - 1 - len);
+        if ( r <= 0 ) break;
+        len += r;
+        req[len] = 0x0;
+        if ( strstr(req, "\r\n\r\n") ) break;
+    }
+    char uri[128] = {0};
+    sscanf(req, "GET %127s", uri);
+    int size = snprintf(answer, sizeof(answer),
+                        "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s",
+                        (int)strlen(uri), uri);
+    if ( write(fd, answer, size) != size ) return;
+}
+
+static void *http_server(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&srv_mutex);
+    while ( !srv_stop || srv_len ) {
+        if ( !srv_len ) {
+            pthread_cond_wait(&srv_cond, &srv_mutex);
+            continue;
+        }
+        int fd = srv_queue[0];
+        memmove(srv_queue, srv_queue + 1, --srv_len * sizeof(int));
+        pthread_mutex_unlock(&srv_mutex);
+        serve_http(fd);
+        close(fd);
+        pthread_mutex_lock(&srv_mutex);
+    }
+    pthread_mutex_unlock(&srv_mutex);
+    return NULL;
+}
+
+// the MQTT broker stand-in sends BENCH_MESSAGES publishes on its channel
+
+static int publish_packet(unsigned char *p) {
+    int topic = strlen(BENCH_TOPIC);
+    p[0] = 0x30;
+    p[1] = 2 + topic + BENCH_PAYLOAD;
+    p[2] = 0;
+    p[3] = topic;
+    memcpy(p + 4, BENCH_TOPIC, topic);
+    memset(p + 4 + topic, 'x', BENCH_PAYLOAD);
+    return 4 + topic + BENCH_PAYLOAD;
+}
+
+static void *mqtt_broker(void *arg) {
+    int fd = *(int *)arg;
+    unsigned char buf[64 * 64];
+    unsigned char pack[64];
+    int size = publish_packet(pack);
+    int i;
+    int sent = 0;
+    while ( sent < BENCH_MESSAGES ) {
+        int n = 0;
+        for ( i = 0; i < 64 && sent < BENCH_MESSAGES; i++, sent++ ) {
+            memcpy(buf + n, pack, size);
+            n += size;
+        }
+        if ( write(fd, buf, n) != n ) break;
+    }
+    return NULL;
+}
+
+static int received = 0;
+
+static int msg_init(int len) {
+    (void)len;
+    return 0;
+}
+
+static int msg_part(const char *s, int len) {
+    (void)s; (void)len;
+    return 0;
+}
+
+static int msg_done(void) {
+    received++;
+    return 0;
+}
+
+static arrow_mqtt_delivery_callback_t bench_callbacks = {
+    {0},
+    msg_init,
+    msg_part,
+    msg_done,
+    {NULL}
+};
+
+typedef struct {
+    Network net;
+    MQTTClient client;
+    unsigned char buf[128];
+    unsigned char readbuf[128];
+    int peer;
+    int packets;
+    int failed;
+} channel_t;
+
+static void channel_init(channel_t *ch, int keepalive) {
+    int sv[2];
+    memset(ch, 0x0, sizeof(channel_t));
+    TEST_ASSERT_EQUAL_INT(0, socketpair(UNIX_DOMAIN, UNIX_STREAM, 0, sv));
+    NetworkInit(&ch->net);
+    ch->net.my_socket = sv[0];
+    ch->peer = sv[1];
+    MQTTClientInit(&ch->client, &ch->net, 1000,
+                   ch->buf, sizeof(ch->buf),
+                   ch->readbuf, sizeof(ch->readbuf));
+    ch->client.keepAliveInterval = keepalive;
+    ch->client.isconnected = 1;
+}
+
+static void channel_close(channel_t *ch) {
+    arrow_reactor_del_mqtt(&ch->client);
+    close(ch->net.my_socket);
+    close(ch->peer);
+}
+
+static void channel_event(MQTTClient *c, int rc, void *arg) {
+    channel_t *ch = (channel_t *)arg;
+    (void)c;
+    if ( rc < 0 ) ch->failed++;
+    else ch->packets++;
+}
+
+void setUp(void) {
+    static int registered = 0;
+    property_types_init();
+    if ( !registered ) {
+        property_copy(&bench_callbacks.topic, p_const(BENCH_TOPIC));
+        arrow_mqtt_client_delivery_message_reg(&bench_callbacks);
+        registered = 1;
+    }
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_init());
+}
+
+void tearDown(void) {
+    arrow_reactor_done();
+    property_types_deinit();
+}
+
+typedef struct {
+    http_client_t cli;
+    http_request_t req;
+    http_response_t res;
+    char url[128];
+} rest_call_t;
+
+static rest_call_t calls[BENCH_DEPTH];
+static int calls_sent = 0;
+static int calls_done = 0;
+static int calls_failed = 0;
+
+static void rest_done(int status, http_client_t *cli, http_response_t *res, void *arg) {
+    rest_call_t *c = (rest_call_t *)arg;
+    const char *uri = strstr(c->url, "/api/");
+    (void)cli;
+    if ( status < 0 || res->m_httpResponseCode != 200 ||
+         property_size(&res->payload) != strlen(uri) ||
+         strncmp(P_VALUE(res->payload), uri, strlen(uri)) ) calls_failed++;
+    calls_done++;
+    http_request_close(&c->req);
+    default_http_client_close(&c->cli);
+    http_response_free(&c->res);
+    if ( calls_sent < BENCH_CALLS ) {
+        sprintf(c->url, "http://api.arrowconnect.io:80/api/v1/bench/%d", calls_sent++);
+        memset(&c->res, 0x0, sizeof(c->res));
+        http_request_init(&c->req, GET, c->url);
+        if ( default_http_client_open(&c->cli, &c->req) < 0 ||
+             arrow_reactor_http(&c->cli, &c->res, rest_done, c) < 0 ) calls_failed++;
+    }
+}
+
+void test_reactor_bench_one_thread(void) {
+    static channel_t ch[BENCH_CHANNELS];
+    pthread_t brokers[BENCH_CHANNELS];
+    pthread_t server;
+    int i;
+    received = 0;
+    calls_sent = 0;
+    calls_done = 0;
+    calls_failed = 0;
+    srv_stop = 0;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&server, NULL, http_server, NULL));
+    for ( i = 0; i < BENCH_CHANNELS; i++ ) {
+        channel_init(ch + i, 0);
+        TEST_ASSERT_EQUAL_INT(0, arrow_reactor_add_mqtt(&ch[i].client, channel_event, ch + i));
+    }
+    double start = bench_now_ms();
+    for ( i = 0; i < BENCH_CHANNELS; i++ ) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(brokers + i, NULL, mqtt_broker, &ch[i].peer));
+    }
+    for ( i = 0; i < BENCH_DEPTH; i++ ) {
+        http_client_init(&calls[i].cli);
+        sprintf(calls[i].url, "http://api.arrowconnect.io:80/api/v1/bench/%d", calls_sent++);
+        memset(&calls[i].res, 0x0, sizeof(calls[i].res));
+        http_request_init(&calls[i].req, GET, calls[i].url);
+        TEST_ASSERT_EQUAL_INT(0, default_http_client_open(&calls[i].cli, &calls[i].req));
+        TEST_ASSERT_EQUAL_INT(0, arrow_reactor_http(&calls[i].cli, &calls[i].res, rest_done, calls + i));
+    }
+    while ( ( received < BENCH_CHANNELS * BENCH_MESSAGES || calls_done < BENCH_CALLS ) &&
+            bench_now_ms() - start < 20000 ) {
+        if ( arrow_reactor_run_once(1000) <= 0 ) break;
+    }
+    double ms = bench_now_ms() - start;
+
+    for ( i = 0; i < BENCH_CHANNELS; i++ ) {
+        pthread_join(brokers[i], NULL);
+        TEST_ASSERT_EQUAL_INT(0, ch[i].failed);
+        TEST_ASSERT_EQUAL_INT(BENCH_MESSAGES, ch[i].packets);
+        channel_close(ch + i);
+    }
+    pthread_mutex_lock(&srv_mutex);
+    srv_stop = 1;
+    pthread_cond_signal(&srv_cond);
+    pthread_mutex_unlock(&srv_mutex);
+    pthread_join(server, NULL);
+    for ( i = 0; i < BENCH_DEPTH; i++ ) http_client_free(&calls[i].cli);
+
+    printf("reactor, one thread: %d mqtt channels %d msgs + %d rest calls (depth %d) in %.0f ms\r\n",
+           BENCH_CHANNELS, received, calls_done, BENCH_DEPTH, ms);
+    printf("reactor, one thread: %.0f msgs/s, %.0f rest calls/s\r\n",
+           received * 1000.0 / ms, calls_done * 1000.0 / ms);
+    TEST_ASSERT_EQUAL_INT(BENCH_CHANNELS * BENCH_MESSAGES, received);
+    TEST_ASSERT_EQUAL_INT(BENCH_CALLS, calls_done);
+    TEST_ASSERT_EQUAL_INT(0, calls_failed);
+}
@@ -0,0 +1,320 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+// the short window for the test
+#define ARROW_STATE_COALESCE_MS 50
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/routine.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <http/client.h>
+#include <bsd/socket.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_api.h>
+#include "api_device_device.h"
+#include "api_gateway_gateway.h"
+#include "api_gateway_info.h"
+#include <arrow/api/device/info.h>
+#include <arrow/api/device/event.h>
+#include <arrow/api/log.h>
+#include <arrow/api/json/page.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+
+#include "acnsdkc_time.h"
+#include "mock_mac.h"
+#include "mock_watchdog.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+#include "fakedns.h"
+
+// The state table is built in here to compare with the linear lookup
+// and the JsonNode tree of the previous post, 1% of the 1000 states are
+// changed between the posts; the linked module is shadowed by this copy.
+#include "../../src/arrow/state.c"
+#include "bench_clock.h"
+
+#define STATES      1000
+#define CHURN       ( STATES / 100 )
+#define ROUNDS      200
+
+// the posted requests are caught by the fake socket, the answer is 200
+static const char answer[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+static int answered = 0;
+static int no_answer = 0;
+static char *sent = NULL;
+static int sent_len = 0;
+static int posts = 0;
+static long post_bytes = 0;
+
+static arrow_device_t dev;
+static char names[STATES][16];
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 0;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    if ( len > 5 && strncmp(buf, "POST ", 5) == 0 ) {
+        posts++;
+        sent_len = 0;
+        answered = 0;
+    }
+    memcpy(sent + sent_len, buf, len);
+    sent_len += len;
+    sent[sent_len] = 0x0;
+    post_bytes += len;
+    return len;
+}
+
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    int size = (int)sizeof(answer) - 1 - answered;
+    if ( size <= 0 || no_answer ) return -1;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, answer + answered, size);
+    answered += size;
+    return size;
+}
+
+static const char *sent_body(void) {
+    char *body = strstr(sent, "\r\n\r\n");
+    return body ? body + 4 : "";
+}
+
+static int starts(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static void add_states(int n) {
+    int i;
+    for ( i = 0; i < n; i++ ) {
+        sprintf(names[i], "state_%04d", i);
+        arrow_device_state_init(1, state_pr(p_stack(names[i]), i % 3 == 0 ? JSON_BOOL :
+                                                               i % 3 == 1 ? JSON_NUMBER : JSON_STRING));
+    }
+}
+
+static void set_state(int i, int v) {
+    char str[16];
+    switch ( i % 3 ) {
+    case 0: arrow_device_state_set_bool(p_stack(names[i]), v & 1); break;
+    case 1: arrow_device_state_set_number(p_stack(names[i]), v); break;
+    default:
+        sprintf(str, "v%d", v);
+        arrow_device_state_set_string(p_stack(names[i]), p_stack(str));
+    }
+}
+
+// the previous post body: the whole tree for every post
+static property_t old_payload(void) {
+    JsonNode *_main = json_mkobject();
+    JsonNode *_states = json_mkobject();
+    arrow_state_list_t *tmp = NULL;
+    arrow_linked_list_head_for_each( tmp, &__state_list , arrow_state_list_t ) {
+        JsonNode *value = NULL;
+        switch ( tmp->tag ) {
+        case JSON_BOOL: value = json_mkbool(tmp->value._bool); break;
+        case JSON_NUMBER: value = json_mknumber(tmp->value._number); break;
+        // the tree can't take the empty one
+        default: value = json_mkstring(IS_EMPTY(tmp->value._property) ? "" : P_VALUE(tmp->value._property));
+        }
+        // the tree took the dynamic names away, the weak ones are here
+        property_t name;
+        property_weak_copy(&name, tmp->name);
+        json_append_member(_states, name, value);
+    }
+    json_append_member(_main, p_const("states"), _states);
+    if ( !timestamp_is_empty(&_last_modify) ) {
+        char ts[30];
+        timestamp_string(&_last_modify, ts);
+        json_append_member(_main, p_const("timestamp"), json_mkstring(ts));
+    }
+    property_t p = json_encode_property(_main);
+    json_delete(_main);
+    return p;
+}
+
+static int stateeq( arrow_state_list_t *sl, property_t name ) {
+    if ( property_cmp(&sl->name, &name) == 0 ) return 0;
+    return -1;
+}
+
+void setUp(void) {
+    arrow_init();
+    sent = malloc(256 * 1024);
+    sent[0] = 0x0;
+    sent_len = 0;
+    posts = 0;
+    no_answer = 0;
+    arrow_device_init(&dev);
+    property_copy(&dev.hid, p_const("devicehid"));
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    soc_close_Ignore();
+    wdt_feed_IgnoreAndReturn(0);
+}
+
+void tearDown(void) {
+    arrow_device_state_free();
+    arrow_device_free(&dev);
+    free(sent);
+    arrow_deinit();
+}
+
+// 1000 states, 1% of them are changed between the posts
+void test_state_bench(void) {
+    int i, r, n;
+    double start, linear_us, hash_us, old_us, full_us, delta_us;
+    long old_bytes = 0, delta_bytes = 0;
+    add_states(STATES);
+
+    // the lookup of every state
+    arrow_state_list_t *st = NULL;
+    start = bench_now_us();
+    for ( r = 0; r < 20; r++ ) for ( i = 0; i < STATES; i++ ) {
+        linked_list_find_node( st, arrow_linked_list_head_first(&__state_list, arrow_state_list_t),
+                               arrow_state_list_t, stateeq, p_stack(names[i]) );
+        TEST_ASSERT(st);
+    }
+    linear_us = bench_now_us() - start;
+    start = bench_now_us();
+    for ( r = 0; r < 20; r++ ) for ( i = 0; i < STATES; i++ ) {
+        st = state_find(p_stack(names[i]));
+        TEST_ASSERT(st);
+    }
+    hash_us = bench_now_us() - start;
+
+    // the body only: the tree of the 1000, the streamed 1000, the streamed 10
+    property_t body;
+    n = 0;
+    start = bench_now_us();
+    for ( r = 0; r < ROUNDS; r++ ) {
+        for ( i = 0; i < CHURN; i++ ) set_state(( r * 97 + i * 101 ) % STATES, r + i);
+        body = old_payload();
+        old_bytes += property_size(&body);
+        property_free(&body);
+    }
+    old_us = bench_now_us() - start;
+    start = bench_now_us();
+    for ( r = 0; r < ROUNDS; r++ ) {
+        for ( i = 0; i < CHURN; i++ ) set_state(( r * 97 + i * 101 ) % STATES, r + i + 1);
+        body = state_payload(0);
+        property_free(&body);
+    }
+    full_us = bench_now_us() - start;
+    state_set_posted();
+    start = bench_now_us();
+    for ( r = 0; r < ROUNDS; r++ ) {
+        for ( i = 0; i < CHURN; i++ ) set_state(( r * 97 + i * 101 ) % STATES, r + i + 2);
+        body = state_payload(1);
+        delta_bytes += property_size(&body);
+        state_set_posted();
+        property_free(&body);
+    }
+    delta_us = bench_now_us() - start;
+    TEST_ASSERT_EQUAL_INT(0, _dirty_count);
+
+    printf("%d states lookup: %.0f ns linear, %.0f ns hashed (%d buckets)\n",
+           STATES, linear_us * 1000 / ( 20 * STATES ), hash_us * 1000 / ( 20 * STATES ),
+           ARROW_STATE_HASH_SIZE);
+    printf("%d%% churn body: %.1f us %ld bytes the tree, %.1f us streamed, %.1f us %ld bytes the delta\n",
+           100 * CHURN / STATES, old_us / ROUNDS, old_bytes / ROUNDS,
+           full_us / ROUNDS, delta_us / ROUNDS, delta_bytes / ROUNDS);
+
+    // the posts through the client
+    long bytes = post_bytes;
+    start = bench_now_us();
+    for ( r = 0; r < 50; r++ ) {
+        for ( i = 0; i < CHURN; i++ ) set_state(( r * 97 + i * 101 ) % STATES, r + i + 3);
+        TEST_ASSERT_EQUAL_INT(0, arrow_post_state_update(&dev));
+    }
+    old_us = bench_now_us() - start;
+    old_bytes = post_bytes - bytes;
+    bytes = post_bytes;
+    start = bench_now_us();
+    for ( r = 0; r < 50; r++ ) {
+        for ( i = 0; i < CHURN; i++ ) set_state(( r * 97 + i * 101 ) % STATES, r + i + 4);
+        TEST_ASSERT_EQUAL_INT(0, arrow_post_state_delta(&dev));
+    }
+    delta_us = bench_now_us() - start;
+    delta_bytes = post_bytes - bytes;
+    printf("%d%% churn post: %.1f us %ld bytes sent the update, %.1f us %ld bytes the delta\n",
+           100 * CHURN / STATES, old_us / 50, old_bytes / 50, delta_us / 50, delta_bytes / 50);
+}
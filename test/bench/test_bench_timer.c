@@ -0,0 +1,78 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <config.h>
+#include <debug.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <network.h>
+#include "timer.h"
+#include "acnsdkc_ssl.h"
+#include "mock_sockdecl.h"
+#include "socket_weak.h"
+#include "bench_clock.h"
+
+// The MQTT timer checks over gettimeofday against the coarse monotonic clock,
+// and the timer wheel with many timers.
+
+#define BENCH_CHECKS  10000000
+#define BENCH_TIMERS  10000
+
+typedef struct {
+    timer_node_t node;
+    int id;
+} bench_timer_t;
+
+static timer_wheel_t wheel;
+static struct timeval old_end;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// the previous TimerIsExpired
+static char old_is_expired(void) {
+    struct timeval now, res;
+    gettimeofday(&now, NULL);
+    timersub(&old_end, &now, &res);
+    return (int)res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+}
+
+void test_timer_bench_expired(void) {
+    TimerInterval t;
+    int i;
+    int expired = 0;
+    gettimeofday(&old_end, NULL);
+    old_end.tv_sec += 60;
+    double start = bench_now_ms();
+    for ( i = 0; i < BENCH_CHECKS; i++ ) expired += old_is_expired();
+    double old_ms = bench_now_ms() - start;
+    TimerCountdown(&t, 60);
+    start = bench_now_ms();
+    for ( i = 0; i < BENCH_CHECKS; i++ ) expired += TimerIsExpired(&t);
+    double new_ms = bench_now_ms() - start;
+    TEST_ASSERT_EQUAL_INT(0, expired);
+    printf("timer checks: gettimeofday %.0f/s, monotonic coarse %.0f/s\n",
+           BENCH_CHECKS * 1000.0 / old_ms, BENCH_CHECKS * 1000.0 / new_ms);
+}
+
+void test_timer_bench_wheel(void) {
+    static bench_timer_t timers[BENCH_TIMERS];
+    uint32_t now = 1000;
+    int i;
+    int expired = 0;
+    timer_wheel_init(&wheel, now);
+    double start = bench_now_ms();
+    for ( i = 0; i < BENCH_TIMERS; i++ ) {
+        timer_wheel_add(&wheel, &timers[i].node, now + 1 + (uint32_t)(i * 7919) % 30000);
+    }
+    now += 30000;
+    while ( timer_wheel_expired(&wheel, now) ) expired++;
+    double wheel_ms = bench_now_ms() - start;
+    TEST_ASSERT_EQUAL_INT(BENCH_TIMERS, expired);
+    printf("timer wheel: %d timers added and expired in %.2f ms\n", BENCH_TIMERS, wheel_ms);
+}
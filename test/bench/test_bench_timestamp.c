@@ -0,0 +1,126 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <sb.h>
+#include <data/property.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/json.h>
+#include <arrow/utf8.h>
+#include <arrow/api/json/parse.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <ntp/clock.h>
+
+#include "acnsdkc_time.h"
+#include "bench_clock.h"
+
+#define BENCH_ROUNDS 2000000
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// the parser and the formatter as they were
+
+static int timestamp_parse_old(timestamp_t *t, const char *s) {
+    int tmp;
+    char *p = copy_till_to_int(s, "-", &tmp);
+    if ( !p ) return -1;
+    t->year = tmp;
+    p = copy_till_to_int(p, "-", &tmp);
+    if ( !p ) return -1;
+    t->mon = tmp;
+    p = copy_till_to_int(p, "T", &tmp);
+    if ( !p ) return -1;
+    t->day = tmp;
+    p = copy_till_to_int(p, ":", &tmp);
+    if ( !p ) return -1;
+    t->hour = tmp;
+    p = copy_till_to_int(p, ":", &tmp);
+    if ( !p ) return -1;
+    t->min = tmp;
+    p = copy_till_to_int(p, ".", &tmp);
+    if ( !p ) return -1;
+    t->sec = tmp;
+    p = copy_till_to_int(p, "Z", &tmp);
+    if ( !p ) return -1;
+    t->msec = tmp;
+    return 0;
+}
+
+static void timestamp_string_old(timestamp_t *ts, char *s) {
+    snprintf(s, 25,
+             "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+             ts->year,
+             ts->mon,
+             ts->day,
+             ts->hour,
+             ts->min,
+             ts->sec,
+             ts->msec);
+}
+
+static void random_ts(timestamp_t *t) {
+    memset(t, 0x0, sizeof(timestamp_t));
+    t->year = 1970 + rand() % 130;
+    t->mon = 1 + rand() % 12;
+    t->day = 1 + rand() % 28;
+    t->hour = rand() % 24;
+    t->min = rand() % 60;
+    t->sec = rand() % 60;
+    t->msec = rand() % 1000;
+}
+
+void test_timestamp_bench(void) {
+    static char s[64][32];
+    static timestamp_t in[64];
+    timestamp_t t;
+    volatile uint32_t sink = 0;
+    double start, parse_old, parse_new, string_old, string_new;
+    int i;
+    srand(17);
+    for ( i = 0; i < 64; i++ ) {
+        random_ts(in + i);
+        timestamp_string(in + i, s[i]);
+    }
+
+    start = bench_now_s();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) {
+        timestamp_parse_old(&t, s[i & 63]);
+        sink += t.msec;
+    }
+    parse_old = BENCH_ROUNDS / ( bench_now_s() - start );
+
+    start = bench_now_s();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) {
+        timestamp_parse(&t, s[i & 63]);
+        sink += t.msec;
+    }
+    parse_new = BENCH_ROUNDS / ( bench_now_s() - start );
+
+    start = bench_now_s();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) {
+        timestamp_string_old(in + ( i & 63 ), s[i & 63]);
+        sink += (uint32_t)s[i & 63][22];
+    }
+    string_old = BENCH_ROUNDS / ( bench_now_s() - start );
+
+    start = bench_now_s();
+    for ( i = 0; i < BENCH_ROUNDS; i++ ) {
+        timestamp_string(in + ( i & 63 ), s[i & 63]);
+        sink += (uint32_t)s[i & 63][22];
+    }
+    string_new = BENCH_ROUNDS / ( bench_now_s() - start );
+    (void)sink;
+
+    printf("timestamps/sec: parse %.1fM (was %.1fM), string %.1fM (was %.1fM)\r\n",
+           parse_new / 1e6, parse_old / 1e6, string_new / 1e6, string_old / 1e6);
+}
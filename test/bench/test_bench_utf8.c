@@ -0,0 +1,105 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <arrow/utf8.h>
+#include "bench_clock.h"
+
+// The table encoders against the previous sprintf/strtol/branching ones,
+// these are built with -Os as the library is.
+// Build the library with -mssse3 to check the SSSE3 hex_encode.
+
+#define BENCH_MS   300
+
+__attribute__((optimize("Os")))
+static void old_hex_encode(char *dst, const char *src, int size) {
+    int i;
+    for (i=0; i<size; i++)
+        sprintf(dst+i*2, "%02x", (unsigned char)(src[i]));
+}
+
+__attribute__((optimize("Os")))
+static void old_hex_decode(char *dst, const char *src, int size) {
+    int i = 0;
+    for (i=0; i<size; i++) {
+        char d[3] = { *(src+i*2), *(src+i*2 + 1), '\0' };
+        dst[i] = (uint8_t)strtol(d, NULL, 16);
+    }
+}
+
+// the old one indexed the digits by the signed char: ASCII only
+__attribute__((optimize("Os")))
+static void old_urlencode(char *dst, char *src, int len) {
+    char *hex = "0123456789abcdef";
+    char *src_p = src;
+    char *dst_p = dst;
+    if (!len) len = (int)strlen(src);
+    while( src_p && len-- ){
+        if( ('a' <= *src_p && *src_p <= 'z')
+            || ('A' <= *src_p && *src_p <= 'Z')
+            || ('0' <= *src_p && *src_p <= '9')
+            || ( *src_p == '-' )
+            || ( *src_p == '_' )
+            ){
+            *dst_p++ = *src_p++;
+        } else {
+            *dst_p++ = ('%');
+            *dst_p++ = (hex[*src_p >> 4]);
+            *dst_p++ = (hex[*src_p & 15]);
+            src_p++;
+        }
+    }
+    *dst_p = '\0';
+}
+
+void setUp(void) {
+    srand(1);
+}
+
+void tearDown(void) {
+}
+
+void test_utf8_bench(void) {
+    char digest[32];
+    char hex[66];
+    char sas[200];
+    char bin[32];
+    // the SAS signature is the base64 of the HMAC digest
+    char token[] = "bXlzZWNyZXRrZXlpc2hlcmVhbmRpdGlzcXVpdGVsb25n+w/Kq3Zs9PdgTQ==";
+    int i, n;
+    double start, ms, old_rate, new_rate;
+    for ( i = 0; i < 32; i++ ) digest[i] = (char)(i * 37);
+
+    n = 0;
+    start = bench_now_ms();
+    do { old_hex_encode(hex, digest, 32); n++; } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    old_rate = n * 1000.0 / ms;
+    n = 0;
+    start = bench_now_ms();
+    do { hex_encode(hex, digest, 32); n++; } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    new_rate = n * 1000.0 / ms;
+    printf("hex_encode 32 bytes: %.0f/s sprintf, %.0f/s table (x%.1f)\n", old_rate, new_rate, new_rate / old_rate);
+
+    n = 0;
+    start = bench_now_ms();
+    do { old_hex_decode(bin, hex, 32); n++; } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    old_rate = n * 1000.0 / ms;
+    n = 0;
+    start = bench_now_ms();
+    do { hex_decode(bin, hex, 32); n++; } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    new_rate = n * 1000.0 / ms;
+    printf("hex_decode 32 bytes: %.0f/s strtol, %.0f/s table (x%.1f)\n", old_rate, new_rate, new_rate / old_rate);
+    TEST_ASSERT_EQUAL_MEMORY(digest, bin, 32);
+
+    n = 0;
+    start = bench_now_ms();
+    do { old_urlencode(sas, token, 0); n++; } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    old_rate = n * 1000.0 / ms;
+    n = 0;
+    start = bench_now_ms();
+    do { urlencode(sas, token, 0); n++; } while ( (ms = bench_now_ms() - start) < BENCH_MS );
+    new_rate = n * 1000.0 / ms;
+    printf("urlencode SAS signature: %.0f/s branching, %.0f/s table (x%.1f)\n", old_rate, new_rate, new_rate / old_rate);
+}
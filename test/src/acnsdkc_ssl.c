@@ -14,7 +14,23 @@ int ssl_send(int sock, char* data, int length) {
     return send(sock, data, length, 0);
 }
 
+int ssl_pending(int sock) {
+    (void)(sock);
+    return 0;
+}
+
+int ssl_would_block(int sock, int ret) {
+    return ret < 0 && socket_would_block(sock);
+}
+
 int ssl_close(int sock) {
     (void)(sock);
     return 0;
 }
+
+int ssl_init(void) {
+    return 0;
+}
+
+void ssl_deinit(void) {
+}
@@ -0,0 +1,11 @@
+#ifndef TEST_BENCH_CLOCK_H_
+#define TEST_BENCH_CLOCK_H_
+
+// the monotonic host clock of the benchmarks
+double bench_now_s(void);
+
+#define bench_now_ms() ( bench_now_s() * 1e3 )
+#define bench_now_us() ( bench_now_s() * 1e6 )
+#define bench_now_ns() ( bench_now_s() * 1e9 )
+
+#endif
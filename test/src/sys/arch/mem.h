@@ -0,0 +1,12 @@
+#ifndef TEST_SYS_ARCH_MEM_H_
+#define TEST_SYS_ARCH_MEM_H_
+
+// the __NO_STD__ test build (options/nostd.yml): the port gives the memory
+// and the string functions, here they are the host ones
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#endif  // TEST_SYS_ARCH_MEM_H_
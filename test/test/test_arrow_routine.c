@@ -13,6 +13,7 @@
 #include <arrow/device.h>
 #include <arrow/api/device/info.h>
 #include <arrow/api/json/parse.h>
+#include <arrow/api/json/page.h>
 #include <arrow/gateway.h>
 #include <arrow/api/log.h>
 #include <arrow/utf8.h>
@@ -21,17 +22,20 @@
 #include <data/static_alloc.h>
 #include <arrow/sign.h>
 #include <bsd/socket.h>
+#include <bsd/sockpoll.h>
 #include <data/linkedlist.h>
 #include <data/property.h>
 #include <data/property_base.h>
 #include <data/property_const.h>
 #include <data/property_dynamic.h>
 #include <data/property_stack.h>
+#include <data/property_intern.h>
 #include <json/property_json.h>
 #include <data/ringbuffer.h>
 #include <data/propmap.h>
 #include <data/find_by.h>
 #include <json/json.h>
+#include <json/cbor.h>
 #include <sb.h>
 #include <encode.h>
 #include <decode.h>
@@ -40,20 +44,28 @@
 #include <http/client.h>
 #include <http/request.h>
 #include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
 #include <ssl/crypt.h>
 #include <arrow/state.h>
 #include <arrow/routine.h>
 #include <arrow/telemetry_api.h>
+#include <arrow/telemetry_filter.h>
 #include <arrow/mqtt.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
 #include <arrow/events.h>
 #include <arrow/gateway_payload_sign.h>
 #include <arrow/device_command.h>
 #include <arrow/software_release.h>
 #include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
 #include <ssl/md5sum.h>
 #include <http/client_mqtt.h>
 
 #include <time/time.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
 #include "acnsdkc_time.h"
 #include <network.h>
 
@@ -0,0 +1,184 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+static uint8_t out[512];
+
+static JsonNode *telemetry_sample(int i) {
+    JsonNode *_node = json_mkobject();
+    json_append_member(_node, p_const(TELEMETRY_DEVICE_HID),
+                       json_mkstring("e000000f63b1a317222772437dc586cb59d680fe"));
+    json_append_member(_node, p_const(TELEMETRY_TEMPERATURE), json_mknumber(23.5 + i % 10));
+    json_append_member(_node, p_const(TELEMETRY_HUMIDITY), json_mknumber(41.37));
+    json_append_member(_node, p_const(TELEMETRY_BAROMETER), json_mknumber(1013.0 + i % 3));
+    json_append_member(_node, p_const("i|counter"), json_mknumber(i));
+    json_append_member(_node, p_const("b|alarm"), json_mkbool(i % 2));
+    json_append_member(_node, p_const(TELEMETRY_ACCELEROMETER_XYZ),
+                       json_mkstring("0.012|-0.031|0.981"));
+    return _node;
+}
+
+void test_cbor_encode_uint(void) {
+    JsonNode *_node = json_mknumber(0);
+    TEST_ASSERT_EQUAL_INT(1, cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x00, out[0]);
+    json_delete(_node);
+
+    _node = json_mknumber(24);
+    TEST_ASSERT_EQUAL_INT(2, cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x18, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x18, out[1]);
+    json_delete(_node);
+
+    _node = json_mknumber(1000);
+    TEST_ASSERT_EQUAL_INT(3, cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x19, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x03, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xe8, out[2]);
+    json_delete(_node);
+}
+
+void test_cbor_encode_negative(void) {
+    JsonNode *_node = json_mknumber(-1);
+    TEST_ASSERT_EQUAL_INT(1, cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x20, out[0]);
+    json_delete(_node);
+
+    _node = json_mknumber(-1000);
+    TEST_ASSERT_EQUAL_INT(3, cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_HEX8(0x39, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x03, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xe7, out[2]);
+    json_delete(_node);
+}
+
+void test_cbor_encode_float(void) {
+    uint8_t f32[] = { 0xfa, 0x3f, 0xc0, 0x00, 0x00 };
+    uint8_t f64[] = { 0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a };
+    JsonNode *_node = json_mknumber(1.5);
+    TEST_ASSERT_EQUAL_INT(sizeof(f32), cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(f32, out, sizeof(f32));
+    json_delete(_node);
+
+    _node = json_mknumber(1.1);
+    TEST_ASSERT_EQUAL_INT(sizeof(f64), cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(f64, out, sizeof(f64));
+    json_delete(_node);
+}
+
+void test_cbor_encode_object(void) {
+    // {"a":1,"b":[true,null],"c":"xy"}
+    uint8_t exp[] = { 0xa3,
+                      0x61, 'a', 0x01,
+                      0x61, 'b', 0x82, 0xf5, 0xf6,
+                      0x61, 'c', 0x62, 'x', 'y' };
+    JsonNode *_node = json_mkobject();
+    JsonNode *_arr = json_mkarray();
+    json_append_element(_arr, json_mkbool(true));
+    json_append_element(_arr, json_mknull());
+    json_append_member(_node, p_const("a"), json_mknumber(1));
+    json_append_member(_node, p_const("b"), _arr);
+    json_append_member(_node, p_const("c"), json_mkstring("xy"));
+    TEST_ASSERT_EQUAL_INT(sizeof(exp), cbor_size(_node));
+    TEST_ASSERT_EQUAL_INT(sizeof(exp), cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(exp, out, sizeof(exp));
+    json_delete(_node);
+}
+
+void test_cbor_encode_empty_containers(void) {
+    uint8_t exp[] = { 0x82, 0xa0, 0x80 };
+    JsonNode *_node = json_mkarray();
+    json_append_element(_node, json_mkobject());
+    json_append_element(_node, json_mkarray());
+    TEST_ASSERT_EQUAL_INT(sizeof(exp), cbor_encode(_node, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(exp, out, sizeof(exp));
+    json_delete(_node);
+}
+
+void test_cbor_encode_part(void) {
+    uint8_t whole[256];
+    JsonNode *_node = telemetry_sample(7);
+    int size = cbor_encode(_node, whole, sizeof(whole));
+    TEST_ASSERT_EQUAL_INT(cbor_size(_node), size);
+    int chunk;
+    for ( chunk = 1; chunk < 20; chunk++ ) {
+        cbor_encode_machine_t cem;
+        int total = 0;
+        int r = 0;
+        memset(out, 0x0, sizeof(out));
+        cbor_encode_init(&cem, _node);
+        while ( ( r = cbor_encode_part(&cem, (char*)out + total, chunk) ) > 0 ) {
+            total += r;
+        }
+        cbor_encode_fin(&cem);
+        TEST_ASSERT_EQUAL_INT(0, r);
+        TEST_ASSERT_EQUAL_INT(size, total);
+        TEST_ASSERT_EQUAL_MEMORY(whole, out, size);
+    }
+    json_delete(_node);
+}
+
+void test_cbor_decode_roundtrip(void) {
+    JsonNode *_node = telemetry_sample(3);
+    JsonNode *_arr = json_mkarray();
+    json_append_element(_arr, json_mknumber(-70000));
+    json_append_element(_arr, json_mknumber(1.1));
+    json_append_element(_arr, json_mknull());
+    json_append_member(_node, p_const("list"), _arr);
+    int size = cbor_encode(_node, out, sizeof(out));
+    TEST_ASSERT(size > 0);
+    JsonNode *_dec = cbor_decode(out, size);
+    TEST_ASSERT(_dec);
+    char *exp = json_encode(_node);
+    char *res = json_encode(_dec);
+    TEST_ASSERT_EQUAL_STRING(exp, res);
+    free(exp);
+    free(res);
+    json_delete(_dec);
+    json_delete(_node);
+}
+
+void test_cbor_decode_half_float(void) {
+    uint8_t half[] = { 0xf9, 0x3e, 0x00 };
+    JsonNode *_dec = cbor_decode(half, sizeof(half));
+    TEST_ASSERT(_dec);
+    TEST_ASSERT_EQUAL_INT(JSON_NUMBER, _dec->tag);
+    TEST_ASSERT(_dec->number_ == 1.5);
+    json_delete(_dec);
+}
+
+void test_cbor_decode_broken(void) {
+    uint8_t truncated[] = { 0xa2, 0x61, 'a', 0x01, 0x61 };
+    uint8_t bad_key[] = { 0xa1, 0x01, 0x01 };
+    uint8_t trailing[] = { 0x01, 0x02 };
+    TEST_ASSERT(!cbor_decode(truncated, sizeof(truncated)));
+    TEST_ASSERT(!cbor_decode(bad_key, sizeof(bad_key)));
+    TEST_ASSERT(!cbor_decode(trailing, sizeof(trailing)));
+}
@@ -0,0 +1,256 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(CRYPT_SHA_NI)
+#include <cpuid.h>
+#endif
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <data/linkedlist.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <ssl/crypt.h>
+#include "wolfssl/wolfcrypt/aes.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <ntp/clock.h>
+#include "mock_storage.h"
+
+#include "acnsdkc_time.h"
+
+// The hash contexts are owned by the caller: the signatures made by
+// several threads at once are the same as made by one.
+
+#define SIGN_THREADS   8
+#define SIGN_CASES     16
+#define SIGN_ROUNDS    200
+
+typedef struct {
+    char uri[64];
+    char query[64];
+    char payload[128];
+    char ts[32];
+    char ref[70];
+    char gw_ref[70];
+} sign_case_t;
+
+static sign_case_t cases[SIGN_CASES];
+
+static void sign_case(sign_case_t *c, char *signature) {
+    const char *m = ( c - cases ) % 2 ? "POST" : "GET";
+    property_t meth = p_const(m);
+    sign(signature, c->ts, &meth, c->uri,
+         c->query[0] ? c->query : NULL,
+         c->payload[0] ? c->payload : NULL, "1");
+}
+
+static void gw_sign_case(sign_case_t *c, char *signature) {
+    gateway_payload_sign(signature, c->ts, c->uri, ( c - cases ) % 2, c->payload, "1");
+}
+
+void setUp(void) {
+    int i;
+    property_types_init();
+    set_api_key("abcdef0123456789abcdef0123456789abcdef0123456789abcdef0123456789");
+    set_secret_key("secret0123456789secret0123456789abcdefgh");
+    for ( i = 0; i < SIGN_CASES; i++ ) {
+        sign_case_t *c = cases + i;
+        snprintf(c->uri, sizeof(c->uri), "/api/v1/kronos/devices/%08x", i * 2654435761u);
+        if ( i % 3 ) snprintf(c->query, sizeof(c->query), "_page=%d\r\n_size=%d\r\n", i, i * 10);
+        else c->query[0] = 0x0;
+        if ( i % 4 ) snprintf(c->payload, sizeof(c->payload), "{\"name\":\"device%d\",\"uid\":\"%x\"}", i, i * 7919);
+        else c->payload[0] = 0x0;
+        snprintf(c->ts, sizeof(c->ts), "2018-03-%02dT10:%02d:00.000Z", i % 28 + 1, i);
+    }
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+static void hex(char *out, const char *dig) {
+    hex_encode(out, dig, 32);
+    out[64] = 0x0;
+}
+
+void test_crypt_vectors(void) {
+    char dig[32];
+    char out[66];
+    acn_sha256_ctx sh;
+    acn_hmac_ctx hmac;
+    acn_sha256_init(&sh);
+    acn_sha256_update(&sh, "a", 1);
+    acn_sha256_update(&sh, "bc", 2);
+    acn_sha256_final(&sh, dig);
+    hex(out, dig);
+    TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", out);
+    // RFC 4231, test case 2
+    acn_hmac256_init(&hmac, "Jefe", 4);
+    acn_hmac256_update(&hmac, "what do ya want ", 16);
+    acn_hmac256_update(&hmac, "for nothing?", 12);
+    acn_hmac256_final(&hmac, dig);
+    hex(out, dig);
+    TEST_ASSERT_EQUAL_STRING("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", out);
+    // the padding takes one more block
+    const char *msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha256(dig, (char*)msg, strlen(msg));
+    hex(out, dig);
+    TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", out);
+    // RFC 4231, test case 6: the key is hashed first
+    char key[131];
+    memset(key, 0xaa, sizeof(key));
+    msg = "Test Using Larger Than Block-Size Key - Hash Key First";
+    hmac256(dig, key, sizeof(key), msg, strlen(msg));
+    hex(out, dig);
+    TEST_ASSERT_EQUAL_STRING("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54", out);
+}
+
+// the accelerated path against wolfCrypt's C code
+void test_crypt_chunks(void) {
+    static char buf[1000];
+    char a[32], b[32];
+    int len, i;
+    for ( i = 0; i < (int)sizeof(buf); i++ ) buf[i] = (char)(i * 31 + 7);
+    for ( len = 0; len <= (int)sizeof(buf); len += 37 ) {
+        Sha256 ref;
+        acn_sha256_ctx sh;
+        int pos = 0, step = 1;
+        wc_InitSha256(&ref);
+        wc_Sha256Update(&ref, (byte*)buf, len);
+        wc_Sha256Final(&ref, (byte*)a);
+        acn_sha256_init(&sh);
+        while ( pos < len ) {
+            int n = len - pos < step ? len - pos : step;
+            acn_sha256_update(&sh, buf + pos, n);
+            pos += n;
+            step = step * 3 % 97 + 1;
+        }
+        acn_sha256_final(&sh, b);
+        TEST_ASSERT_EQUAL_MEMORY(a, b, 32);
+    }
+}
+
+// with CRYPT_SHA_NI (options/accel.yml) the tests above check the SHA
+// extensions against wolfCrypt if the CPU has them
+void test_crypt_accel(void) {
+#if defined(CRYPT_SHA_NI)
+    unsigned int a, b, c, d;
+    int cpu = __get_cpuid_count(7, 0, &a, &b, &c, &d) && ( b & ( 1u << 29 ) );
+    TEST_ASSERT_EQUAL_INT(cpu, acn_sha256_accel());
+    if ( !cpu ) TEST_IGNORE_MESSAGE("no SHA extensions on this CPU");
+#else
+    TEST_ASSERT_EQUAL_INT(0, acn_sha256_accel());
+#endif
+}
+
+void test_crypt_interleaved(void) {
+    char a[32], b[32], ref[32];
+    acn_sha256_ctx sa, sb;
+    acn_hmac_ctx ha, hb;
+    acn_sha256_init(&sa);
+    acn_sha256_init(&sb);
+    acn_sha256_update(&sa, "hello ", 6);
+    acn_sha256_update(&sb, "another ", 8);
+    acn_sha256_update(&sa, "world", 5);
+    acn_sha256_update(&sb, "message", 7);
+    acn_sha256_final(&sa, a);
+    acn_sha256_final(&sb, b);
+    sha256(ref, "hello world", 11);
+    TEST_ASSERT_EQUAL_MEMORY(ref, a, 32);
+    sha256(ref, "another message", 15);
+    TEST_ASSERT_EQUAL_MEMORY(ref, b, 32);
+
+    acn_hmac256_init(&ha, "key1", 4);
+    acn_hmac256_init(&hb, "key2", 4);
+    acn_hmac256_update(&ha, "hello ", 6);
+    acn_hmac256_update(&hb, "another ", 8);
+    acn_hmac256_update(&ha, "world", 5);
+    acn_hmac256_update(&hb, "message", 7);
+    acn_hmac256_final(&ha, a);
+    acn_hmac256_final(&hb, b);
+    hmac256(ref, "key1", 4, "hello world", 11);
+    TEST_ASSERT_EQUAL_MEMORY(ref, a, 32);
+    hmac256(ref, "key2", 4, "another message", 15);
+    TEST_ASSERT_EQUAL_MEMORY(ref, b, 32);
+
+    // the old API over the shared context
+    sha256_init();
+    sha256_chunk("hello ", 6);
+    sha256_chunk("world", 5);
+    sha256_fin(a);
+    sha256(ref, "hello world", 11);
+    TEST_ASSERT_EQUAL_MEMORY(ref, a, 32);
+    hmac256_init("key1", 4);
+    hmac256_chunk("hello world", 11);
+    hmac256_fin(a);
+    hmac256(ref, "key1", 4, "hello world", 11);
+    TEST_ASSERT_EQUAL_MEMORY(ref, a, 32);
+}
+
+typedef struct {
+    int id;
+    int errors;
+} sign_arg_t;
+
+static void *sign_thread(void *arg) {
+    sign_arg_t *a = (sign_arg_t *)arg;
+    char signature[70];
+    int i;
+    for ( i = 0; i < SIGN_ROUNDS * SIGN_CASES; i++ ) {
+        sign_case_t *c = cases + ( i + a->id ) % SIGN_CASES;
+        sign_case(c, signature);
+        if ( strcmp(signature, c->ref) ) a->errors++;
+        gw_sign_case(c, signature);
+        if ( strcmp(signature, c->gw_ref) ) a->errors++;
+    }
+    return NULL;
+}
+
+static void sign_run(int *errors) {
+    pthread_t th[SIGN_THREADS];
+    sign_arg_t args[SIGN_THREADS];
+    int i;
+    for ( i = 0; i < SIGN_THREADS; i++ ) {
+        args[i].id = i;
+        args[i].errors = 0;
+        pthread_create(th + i, NULL, sign_thread, args + i);
+    }
+    for ( i = 0; i < SIGN_THREADS; i++ ) {
+        pthread_join(th[i], NULL);
+        *errors += args[i].errors;
+    }
+}
+
+void test_sign_threads(void) {
+    int i;
+    int errors = 0;
+    // the single-threaded reference
+    for ( i = 0; i < SIGN_CASES; i++ ) {
+        sign_case(cases + i, cases[i].ref);
+        gw_sign_case(cases + i, cases[i].gw_ref);
+        TEST_ASSERT_EQUAL_INT(64, strlen(cases[i].ref));
+    }
+    // the different requests give the different signatures
+    TEST_ASSERT(strcmp(cases[0].ref, cases[1].ref));
+    sign_run(&errors);
+    TEST_ASSERT_EQUAL_INT(0, errors);
+}
@@ -0,0 +1,228 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <config.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <arrow/mqtt.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include <time/time.h>
+#include "acnsdkc_time.h"
+
+#include "mock_sockdecl.h"
+#include "mock_watchdog.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+// The ring logger is built in here, the library's DBG calls come to it.
+#define DBG_RING
+#include "../../src/debug.c"
+
+#define LOG_THREADS    4
+#define LOG_LINES      20000
+
+static int saved_stdout = -1;
+
+static void stdout_to(const char *path) {
+    fflush(stdout);
+    saved_stdout = dup(1);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    dup2(fd, 1);
+    close(fd);
+}
+
+static void stdout_back(void) {
+    fflush(stdout);
+    dup2(saved_stdout, 1);
+    close(saved_stdout);
+}
+
+// format the last logged line and drop the ring
+static const char *last_line(void) {
+    static char line[DBG_LINE_SIZE];
+    dbg_format(line, sizeof(line), dbg_ring + ( ( dbg_head - 1 ) & DBG_RING_MASK ));
+    stdout_to("/dev/null");
+    dbg_flush();
+    stdout_back();
+    return line;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_dbg_ring_format(void) {
+    char ref[DBG_LINE_SIZE];
+    char str[] = "hello";
+    int i;
+    const char *s = NULL;
+    dbg_line("plain line");
+    TEST_ASSERT_EQUAL_STRING("plain line", last_line());
+    dbg_line("mqtt recv type %d", 13);
+    TEST_ASSERT_EQUAL_STRING("mqtt recv type 13", last_line());
+    dbg_line("%02x %02x %08x %hu %u", 0x0a, 0xff, 0xdeadbeef, (unsigned short)65535, 4000000000u);
+    TEST_ASSERT_EQUAL_STRING("0a ff deadbeef 65535 4000000000", last_line());
+    dbg_line("Con-Len %lu, %zu, %lld", 123456789ul, (size_t)77, -5ll);
+    TEST_ASSERT_EQUAL_STRING("Con-Len 123456789, 77, -5", last_line());
+    dbg_line("[%-8s|%8s] %c %5.2f%%", "ab", str, 'x', 3.14159);
+    TEST_ASSERT_EQUAL_STRING("[ab      |   hello] x  3.14%", last_line());
+    dbg_line("%.*s|%*d|%.3s", 2, str, 4, 7, "abcdef");
+    TEST_ASSERT_EQUAL_STRING("he|   7|abc", last_line());
+    dbg_line("%s", s);
+    snprintf(ref, sizeof(ref), "%s", "(null)");
+    TEST_ASSERT_EQUAL_STRING(ref, last_line());
+    // the pointer as printf gives
+    snprintf(ref, sizeof(ref), "p=%p", (void *)str);
+    dbg_line("p=%p", (void *)str);
+    TEST_ASSERT_EQUAL_STRING(ref, last_line());
+    // the arguments are copied: the buffer may be gone before the flush
+    dbg_line("str %s", str);
+    for ( i = 0; i < (int)sizeof(str) - 1; i++ ) str[i] = 'x';
+    TEST_ASSERT_EQUAL_STRING("str hello", last_line());
+}
+
+void test_dbg_ring_cut(void) {
+    char big[DBG_RING_ARGS * 2];
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = 0x0;
+    dbg_line("%s %d", big, 5);
+    const char *line = last_line();
+    // the string is cut to the record, the number is lost
+    TEST_ASSERT_EQUAL_INT(DBG_RING_ARGS - 1 + 4, strlen(line));
+    TEST_ASSERT_EQUAL_STRING(" ...", line + strlen(line) - 4);
+}
+
+void test_dbg_ring_full(void) {
+    int i;
+    unsigned int lost = dbg_dropped();
+    for ( i = 0; i < DBG_RING_SIZE + 10; i++ ) dbg_line("line %d", i);
+    TEST_ASSERT_EQUAL_INT(lost + 10, dbg_dropped());
+    stdout_to("/dev/null");
+    int n = dbg_flush();
+    stdout_back();
+    TEST_ASSERT_EQUAL_INT(DBG_RING_SIZE, n);
+    TEST_ASSERT_EQUAL_INT(0, dbg_flush());
+}
+
+static volatile int consumer_stop = 0;
+
+static void *consumer(void *arg) {
+    (void)arg;
+    while ( !consumer_stop ) {
+        if ( dbg_flush() ) fflush(stdout);
+        else sched_yield();
+    }
+    dbg_flush();
+    fflush(stdout);
+    return NULL;
+}
+
+static void *producer(void *arg) {
+    int id = (int)(intptr_t)arg;
+    int i;
+    for ( i = 0; i < LOG_LINES; i++ ) {
+        dbg_line("thread %d line %d", id, i);
+        if ( i % ( DBG_RING_SIZE / 2 ) == 0 ) sched_yield();
+    }
+    return NULL;
+}
+
+// every thread's lines are in order, the lost ones are counted
+void test_dbg_ring_threads(void) {
+    pthread_t th[LOG_THREADS];
+    pthread_t cons;
+    int last[LOG_THREADS];
+    int got = 0;
+    int i;
+    char path[] = "/tmp/dbg_ringXXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    unsigned int lost = dbg_dropped();
+    stdout_to(path);
+    consumer_stop = 0;
+    pthread_create(&cons, NULL, consumer, NULL);
+    for ( i = 0; i < LOG_THREADS; i++ ) pthread_create(th + i, NULL, producer, (void *)(intptr_t)i);
+    for ( i = 0; i < LOG_THREADS; i++ ) pthread_join(th[i], NULL);
+    consumer_stop = 1;
+    pthread_join(cons, NULL);
+    stdout_back();
+    lost = dbg_dropped() - lost;
+
+    FILE *f = fopen(path, "r");
+    char line[128];
+    for ( i = 0; i < LOG_THREADS; i++ ) last[i] = -1;
+    while ( fgets(line, sizeof(line), f) ) {
+        int id, n;
+        TEST_ASSERT_EQUAL_INT(2, sscanf(line, "thread %d line %d", &id, &n));
+        TEST_ASSERT(id >= 0 && id < LOG_THREADS);
+        TEST_ASSERT(n > last[id]);
+        last[id] = n;
+        got++;
+    }
+    fclose(f);
+    unlink(path);
+    TEST_ASSERT_EQUAL_INT(LOG_THREADS * LOG_LINES, got + (int)lost);
+    printf("%d threads: %d lines printed, %u dropped by the full ring\n", LOG_THREADS, got, lost);
+}
@@ -191,3 +191,37 @@ void test_check_del_hard(void) {
     }
     TEST_ASSERT_EQUAL_INT( 2, rm_count );
 }
+
+void test_doubly_list_head(void) {
+    test_t n[4];
+    test_t *tmp = NULL;
+    int exp_ord[] = {3, 0, 2};
+    int i;
+    doubly_linked_list_head_t head = DOUBLY_LINKED_LIST_HEAD_INIT;
+    for ( i = 0; i < 4; i++ ) n[i].count = i;
+    for ( i = 0; i < 3; i++ ) doubly_linked_list_head_add_node_last(&head, n + i);
+    doubly_linked_list_head_add_node_first(&head, n + 3);
+    doubly_linked_list_head_del_node(&head, n + 1);
+    TEST_ASSERT_EQUAL_INT(3, doubly_linked_list_head_size(&head));
+    i = 0;
+    dl_head_for_each_node(tmp, &head, test_t) {
+        TEST_ASSERT_EQUAL_INT(exp_ord[i++], tmp->count);
+    }
+    TEST_ASSERT_EQUAL_INT(3, i);
+    TEST_ASSERT( n[2].node.prev == &n[0].node );
+    // the ends
+    doubly_linked_list_head_del_node(&head, n + 2);
+    TEST_ASSERT( doubly_linked_list_head_last(&head, test_t) == n );
+    doubly_linked_list_head_del_node(&head, n + 3);
+    TEST_ASSERT( doubly_linked_list_head_first(&head, test_t) == n );
+    TEST_ASSERT( !n[0].node.prev && !n[0].node.next );
+    i = 0;
+    dl_head_for_each_node_safe(tmp, &head, test_t) {
+        doubly_linked_list_head_del_node(&head, tmp);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_INT(1, i);
+    TEST_ASSERT( !head.first && !head.last );
+    TEST_ASSERT_EQUAL_INT(0, doubly_linked_list_head_size(&head));
+}
+
@@ -15,6 +15,7 @@
 #include <data/property_const.h>
 #include <data/property_dynamic.h>
 #include <data/property_stack.h>
+#include <data/property_intern.h>
 #include <json/property_json.h>
 #include <data/ringbuffer.h>
 #include <data/propmap.h>
@@ -25,7 +26,10 @@
 #include <bsd/socket.h>
 #include <http/request.h>
 #include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
 #include <data/find_by.h>
+#include <time/monotonic.h>
 
 #include "acnsdkc_ssl.h"
 
@@ -0,0 +1,415 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <http/client.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <sys/mem.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <arrow/utf8.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <bsd/socket.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <data/find_by.h>
+#include <time/monotonic.h>
+
+#include "acnsdkc_ssl.h"
+
+#include "mock_mac.h"
+#include "mock_sockdecl.h"
+#include "socket_weak.h"
+
+#include "fakedns.h"
+
+// the device list of 60 items (list_text), gzip with a file name
+static const uint8_t list_gz[1003] = {
+    0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x6c, 0x69,
+    0x73, 0x74, 0x2e, 0x6a, 0x73, 0x6f, 0x6e, 0x00, 0xad, 0xd9, 0x4b, 0x6b,
+    0x65, 0x55, 0x10, 0x05, 0xe0, 0xff, 0x72, 0xc6, 0x89, 0xec, 0x7a, 0xed,
+    0x47, 0xc6, 0x4e, 0x9d, 0x39, 0x52, 0x1c, 0xec, 0x27, 0x06, 0x62, 0xb7,
+    0x24, 0x51, 0xd1, 0xa6, 0xff, 0xbb, 0x37, 0x95, 0x08, 0x42, 0x15, 0xf4,
+    0xa4, 0x42, 0x46, 0x97, 0x5c, 0x16, 0x67, 0x93, 0xf3, 0xad, 0xb3, 0xee,
+    0xfd, 0x72, 0xbd, 0x3c, 0xfe, 0xb3, 0xaf, 0x87, 0x9c, 0xee, 0xae, 0xd5,
+    0x5f, 0xfb, 0xf5, 0xf0, 0xf3, 0x97, 0xeb, 0xd7, 0xc7, 0x75, 0x3d, 0x5c,
+    0xe9, 0xe3, 0xe7, 0xba, 0xbb, 0x3e, 0xf5, 0xdf, 0x6e, 0x7f, 0x73, 0xad,
+    0xfd, 0xe7, 0xe3, 0xdc, 0xf7, 0x6f, 0xaf, 0xbc, 0xfe, 0xfd, 0xfb, 0xdb,
+    0x2b, 0xfd, 0xf9, 0xf9, 0xf3, 0x5f, 0xf7, 0x2f, 0xfb, 0xd3, 0xcb, 0xe7,
+    0xe7, 0xdb, 0xab, 0xfb, 0x53, 0x1f, 0x4f, 0xfb, 0xf6, 0xe6, 0xd3, 0x9f,
+    0x5e, 0xf6, 0xdd, 0xf5, 0xd4, 0x5f, 0x5e, 0x7f, 0xf8, 0xbc, 0x1e, 0xcf,
+    0xe3, 0x5e, 0xdf, 0xf7, 0xd7, 0xb7, 0x77, 0x60, 0x82, 0x7a, 0x9f, 0xe8,
+    0x3e, 0xc1, 0x8f, 0x90, 0x1e, 0xd2, 0xdb, 0xef, 0x77, 0xb7, 0x90, 0x9f,
+    0xae, 0xaf, 0x77, 0xff, 0x05, 0xb7, 0x4d, 0xa5, 0xb4, 0x01, 0x26, 0x18,
+    0xbe, 0x1d, 0xfc, 0xfa, 0xfc, 0xc7, 0x37, 0x72, 0x51, 0x73, 0xc1, 0xc9,
+    0xa5, 0x99, 0xf7, 0xa1, 0x8c, 0x26, 0x17, 0x23, 0x72, 0x49, 0x73, 0xd1,
+    0xc9, 0x5d, 0xbd, 0xe7, 0xbc, 0x80, 0x4c, 0x2e, 0x85, 0x1c, 0x34, 0x6b,
+    0x30, 0x39, 0xc1, 0xa5, 0xae, 0xb5, 0xf3, 0x64, 0x13, 0xcc, 0x11, 0x17,
+    0x2c, 0x9a, 0xcb, 0x4e, 0x2e, 0x14, 0x90, 0x9c, 0x8a, 0x98, 0x5c, 0x89,
+    0xc8, 0xcd, 0x9a, 0x2b, 0x4e, 0xee, 0x10, 0x9e, 0xab, 0x63, 0x36, 0xb9,
+    0x39, 0xe4, 0xa0, 0x8b, 0x06, 0x67, 0x27, 0x58, 0xa8, 0xb2, 0xd0, 0x2a,
+    0x26, 0xb8, 0x44, 0x5c, 0x70, 0xd5, 0xdc, 0xe2, 0xe4, 0x1e, 0x18, 0x63,
+    0xae, 0x5a, 0x4d, 0x6e, 0x8d, 0xc8, 0x6d, 0x9a, 0x5b, 0x9d, 0xdc, 0x7a,
+    0x0e, 0x71, 0xa1, 0x66, 0x72, 0x5b, 0xc4, 0x41, 0x43, 0xd2, 0xe0, 0xe6,
+    0x04, 0xe3, 0xc6, 0x3e, 0xd3, 0xee, 0x96, 0x8e, 0x14, 0x70, 0xc5, 0xa0,
+    0x66, 0x81, 0x67, 0xd6, 0x9c, 0x19, 0xa9, 0xb7, 0x61, 0x83, 0x23, 0xd0,
+    0x02, 0x45, 0x0b, 0x3c, 0xb4, 0x72, 0x6f, 0x6d, 0x30, 0x4f, 0x1b, 0x8c,
+    0x21, 0x67, 0xad, 0x6c, 0x81, 0xc7, 0x56, 0xaa, 0x0b, 0x70, 0x9d, 0x65,
+    0x93, 0x29, 0xe2, 0x92, 0x95, 0x2d, 0xf0, 0xd8, 0xea, 0x25, 0xd5, 0x5e,
+    0xfa, 0xb6, 0xc1, 0x11, 0x6e, 0x81, 0xba, 0x05, 0x9e, 0x5b, 0x2c, 0x9c,
+    0x10, 0xe4, 0xd8, 0x60, 0x09, 0x39, 0x6b, 0x95, 0x0b, 0x3c, 0xb9, 0x3e,
+    0x1a, 0xd1, 0x76, 0x31, 0xe4, 0x88, 0x4b, 0x56, 0xb9, 0xc0, 0x93, 0xab,
+    0x42, 0x3f, 0xc0, 0xd3, 0xe9, 0xe2, 0x08, 0xba, 0x40, 0xe9, 0x02, 0x8f,
+    0x2e, 0x38, 0x3b, 0xd7, 0x5d, 0x6c, 0x19, 0x43, 0x0d, 0x39, 0x6b, 0xc5,
+    0x0b, 0x3c, 0xbc, 0xc6, 0x86, 0x9d, 0x2a, 0xda, 0x3a, 0x86, 0x16, 0x70,
+    0xc9, 0xa8, 0x78, 0x81, 0x87, 0x97, 0x4c, 0x91, 0x0a, 0xcb, 0xd6, 0x31,
+    0x46, 0xe0, 0x85, 0x8a, 0x17, 0x7a, 0x78, 0x9d, 0x5e, 0xe7, 0x19, 0xd5,
+    0xf6, 0x31, 0x42, 0xc4, 0x59, 0xa3, 0xea, 0x85, 0x9e, 0x5e, 0xad, 0x4e,
+    0x2e, 0x42, 0xb6, 0x91, 0x31, 0xe2, 0x99, 0x0b, 0x15, 0x2f, 0xf4, 0xf0,
+    0xa2, 0x7c, 0xc6, 0xde, 0xdb, 0x36, 0x32, 0x46, 0xe0, 0x85, 0x8a, 0x17,
+    0x7a, 0x78, 0x2d, 0x21, 0xca, 0xb5, 0xd9, 0x4a, 0x46, 0x0e, 0x39, 0x6b,
+    0xd5, 0x0b, 0x3d, 0xbd, 0x0a, 0xe5, 0xbe, 0x91, 0x6d, 0x29, 0x63, 0xc4,
+    0x63, 0x17, 0x2a, 0x5e, 0xe8, 0xe1, 0x05, 0xd0, 0x51, 0xc6, 0xb1, 0xa5,
+    0x8c, 0x11, 0x78, 0xa1, 0xe2, 0x85, 0x1e, 0x5e, 0xfd, 0xac, 0xb6, 0xa4,
+    0xdb, 0x52, 0xc6, 0x12, 0x72, 0xd6, 0xaa, 0x17, 0x7a, 0x7a, 0xf1, 0x06,
+    0xe0, 0x23, 0xb6, 0x95, 0x31, 0xe4, 0xc9, 0xeb, 0xfd, 0x56, 0xf6, 0xf0,
+    0xda, 0x93, 0xeb, 0x6c, 0xc9, 0x96, 0x32, 0xb6, 0xb0, 0xf1, 0x84, 0x1e,
+    0x5e, 0xb5, 0xd7, 0xc4, 0x38, 0x6c, 0x29, 0x53, 0xcc, 0x5c, 0xd4, 0x5b,
+    0x99, 0x3c, 0xbd, 0xb0, 0x8e, 0x32, 0x66, 0xb6, 0xad, 0x4c, 0x21, 0x7b,
+    0x51, 0x6f, 0x65, 0xf2, 0xf0, 0xfa, 0x98, 0x8b, 0xb6, 0x94, 0x09, 0xc3,
+    0xf6, 0x13, 0x79, 0x78, 0x65, 0xc1, 0x7c, 0xfb, 0xdf, 0xb6, 0xa5, 0x4c,
+    0x31, 0x8b, 0x51, 0x6f, 0x65, 0xf2, 0xf4, 0x4a, 0x24, 0x1b, 0x5b, 0xb5,
+    0xad, 0x4c, 0x21, 0x93, 0x51, 0x6f, 0x65, 0xf2, 0xf0, 0xea, 0xd0, 0xa4,
+    0x13, 0x39, 0x1b, 0x59, 0xc2, 0x26, 0x14, 0x79, 0x78, 0xd1, 0x99, 0x0b,
+    0xe6, 0xb6, 0xa5, 0x4c, 0x31, 0xa3, 0x51, 0x9f, 0x43, 0xc8, 0xd3, 0x6b,
+    0xed, 0xc4, 0x2d, 0x37, 0xdb, 0xca, 0x14, 0xf2, 0xe8, 0xa5, 0xcf, 0x21,
+    0xe4, 0xe1, 0x55, 0x26, 0x4d, 0x48, 0x6c, 0x4b, 0x99, 0x6a, 0xd8, 0x88,
+    0x22, 0x0f, 0x2f, 0xe8, 0x85, 0x6a, 0x3b, 0xb6, 0x94, 0x29, 0x66, 0x37,
+    0xaa, 0x5e, 0xe4, 0xe9, 0x35, 0x6a, 0x1f, 0x89, 0xba, 0x6d, 0x65, 0x0e,
+    0xd9, 0x8d, 0x8a, 0x17, 0x7b, 0x78, 0x49, 0xde, 0x58, 0x96, 0xd8, 0x52,
+    0x66, 0x08, 0x1b, 0x51, 0xec, 0xe1, 0x75, 0x04, 0x6e, 0x27, 0x9d, 0x6c,
+    0x29, 0x73, 0xcc, 0x6e, 0x54, 0xbd, 0xd8, 0xd3, 0xab, 0x91, 0x40, 0x49,
+    0xc3, 0xb6, 0x32, 0x87, 0xec, 0x46, 0xc5, 0x8b, 0x3d, 0xbc, 0x08, 0x6a,
+    0xdd, 0x3d, 0xdb, 0x52, 0x66, 0x0e, 0x1b, 0x51, 0xec, 0xe1, 0x35, 0xcf,
+    0x4c, 0x99, 0xc1, 0x96, 0x32, 0xc7, 0xec, 0x46, 0xd5, 0x8b, 0x3d, 0xbd,
+    0xf2, 0x3a, 0x65, 0xad, 0x69, 0x5b, 0x99, 0x43, 0x76, 0xa3, 0xe2, 0xc5,
+    0x1e, 0x5e, 0x69, 0xe2, 0x91, 0x52, 0x6c, 0x29, 0x73, 0x09, 0x1b, 0x51,
+    0xec, 0xe1, 0xf5, 0xf1, 0x59, 0xaa, 0x2d, 0x65, 0x0e, 0xd9, 0x8d, 0xef,
+    0x2b, 0x8a, 0x3d, 0xbd, 0xb8, 0xb6, 0xcd, 0x7d, 0xdb, 0x56, 0xe6, 0x90,
+    0xdd, 0xa8, 0x78, 0xb1, 0x87, 0xd7, 0xce, 0x4b, 0x26, 0x37, 0x5b, 0xca,
+    0x92, 0xc2, 0x46, 0x94, 0x78, 0x78, 0x55, 0x49, 0x8b, 0x36, 0xdb, 0x52,
+    0x96, 0x98, 0xdd, 0xa8, 0x7a, 0x89, 0xa7, 0x17, 0x12, 0xf3, 0x28, 0xc7,
+    0xb6, 0xb2, 0x84, 0xec, 0x46, 0xc5, 0x4b, 0x3c, 0xbc, 0x26, 0xdc, 0xda,
+    0x11, 0xba, 0xf3, 0xd1, 0x35, 0x85, 0x8d, 0x28, 0xf1, 0xf0, 0x92, 0x33,
+    0xa8, 0x0f, 0xb1, 0xa5, 0x2c, 0x31, 0xbb, 0x51, 0xf5, 0x12, 0x4f, 0xaf,
+    0xb3, 0xf6, 0x40, 0x49, 0xb6, 0x95, 0x25, 0x64, 0x37, 0x2a, 0x5e, 0xe2,
+    0xe1, 0xd5, 0x26, 0x62, 0xdb, 0xc3, 0x96, 0xb2, 0xe4, 0xb0, 0x11, 0x25,
+    0x1e, 0x5e, 0xd4, 0xa5, 0x43, 0xcd, 0xb6, 0x94, 0x25, 0x64, 0x37, 0xbe,
+    0xaf, 0x28, 0xf1, 0xf4, 0x5a, 0xb5, 0x41, 0x43, 0xb0, 0xad, 0x2c, 0x35,
+    0xec, 0x3b, 0x28, 0xf1, 0xf0, 0x2a, 0xf9, 0xb6, 0x1a, 0xc7, 0xb4, 0xa5,
+    0x2c, 0x2d, 0x6c, 0x44, 0xc9, 0xff, 0xf0, 0xfa, 0xe5, 0xeb, 0xbf, 0xfe,
+    0xd2, 0x6a, 0x1d, 0x7a, 0x1c, 0x00, 0x00,
+};
+
+// the first 1200 bytes of the list, raw deflate with the fixed codes
+static const uint8_t list_fixed[308] = {
+    0xab, 0x56, 0x2a, 0xce, 0xac, 0x4a, 0x55, 0xb2, 0x32, 0x33, 0xd0, 0x51,
+    0x4a, 0x49, 0x2c, 0x49, 0x54, 0xb2, 0x8a, 0xae, 0x56, 0xca, 0xc8, 0x4c,
+    0x51, 0xb2, 0x52, 0x32, 0x80, 0x02, 0x25, 0x1d, 0xa5, 0xbc, 0xc4, 0x5c,
+    0xa0, 0x1a, 0xa5, 0x94, 0xd4, 0xb2, 0xcc, 0xe4, 0x54, 0x5d, 0x90, 0x48,
+    0x49, 0x65, 0x01, 0x48, 0x24, 0xb1, 0xa8, 0x28, 0xbf, 0x5c, 0xb7, 0x38,
+    0x35, 0xaf, 0x38, 0xbf, 0x08, 0x28, 0x9a, 0x9a, 0x97, 0x98, 0x94, 0x93,
+    0x0a, 0xd4, 0x9c, 0x96, 0x98, 0x53, 0x9c, 0xaa, 0xa3, 0x94, 0x93, 0x58,
+    0x5c, 0xe2, 0x9b, 0x9f, 0x92, 0x99, 0x96, 0x99, 0x9a, 0xe2, 0x92, 0x58,
+    0x02, 0xd2, 0x61, 0x64, 0x60, 0x68, 0xa1, 0x6b, 0x60, 0xac, 0x6b, 0x60,
+    0x18, 0x62, 0x68, 0x60, 0x65, 0x00, 0x42, 0x7a, 0x40, 0x4b, 0xa2, 0x94,
+    0x6a, 0x75, 0x60, 0x16, 0x5b, 0xa6, 0x1a, 0x9b, 0x9b, 0x5b, 0x26, 0x19,
+    0x62, 0x58, 0x6c, 0x48, 0xd8, 0xe2, 0x92, 0xa2, 0x52, 0x02, 0xf6, 0x1a,
+    0x81, 0xed, 0x35, 0xc4, 0x62, 0xaf, 0x71, 0xb2, 0x59, 0x6a, 0x9a, 0xb1,
+    0x99, 0x11, 0x86, 0xbd, 0x46, 0xd4, 0xb0, 0xd7, 0x18, 0x6c, 0xaf, 0x11,
+    0x16, 0x7b, 0x53, 0x12, 0x13, 0xcd, 0xcc, 0x52, 0x0c, 0x8d, 0x31, 0xec,
+    0x35, 0xa6, 0x4a, 0x40, 0x9b, 0x80, 0x2d, 0x36, 0xc6, 0x62, 0xb1, 0xb9,
+    0x45, 0x4a, 0x4a, 0xaa, 0x59, 0xb2, 0x09, 0x86, 0xc5, 0x26, 0xd4, 0xf0,
+    0xb0, 0x29, 0xd8, 0x5e, 0x13, 0x2c, 0xf6, 0x1a, 0x9a, 0x1b, 0x9a, 0x9a,
+    0x19, 0x98, 0x9b, 0x62, 0xd8, 0x6b, 0x4a, 0x0d, 0x7b, 0xcd, 0xc0, 0xf6,
+    0x9a, 0x62, 0xb1, 0x37, 0xc9, 0xd4, 0x24, 0x39, 0x25, 0xd1, 0xc8, 0x0c,
+    0xc3, 0x5e, 0x33, 0xaa, 0x04, 0xb4, 0x39, 0xd8, 0x62, 0x33, 0x2c, 0x16,
+    0x9b, 0x1a, 0x5b, 0x98, 0x98, 0x1a, 0xa7, 0x98, 0x63, 0x58, 0x6c, 0x4e,
+    0x0d, 0x0f, 0x5b, 0x80, 0xed, 0x35, 0xc7, 0x62, 0x6f, 0x9a, 0x61, 0x52,
+    0x52, 0x72, 0x8a, 0x85, 0x05, 0x86, 0xbd, 0x16, 0xd4, 0xb0, 0xd7, 0x12,
+    0x6c, 0xaf, 0x05, 0x16, 0x7b, 0x2d, 0xd2, 0xd2, 0x8c, 0x4d, 0xcc, 0x8d,
+    0x2d, 0x31, 0xec, 0xb5, 0xa4, 0x34, 0xa0, 0x01,
+};
+
+// the first 300 bytes of the list, zlib stored blocks
+static const uint8_t list_stored[311] = {
+    0x78, 0x01, 0x01, 0x2c, 0x01, 0xd3, 0xfe, 0x7b, 0x22, 0x73, 0x69, 0x7a,
+    0x65, 0x22, 0x3a, 0x36, 0x30, 0x2c, 0x22, 0x64, 0x61, 0x74, 0x61, 0x22,
+    0x3a, 0x5b, 0x7b, 0x22, 0x68, 0x69, 0x64, 0x22, 0x3a, 0x22, 0x30, 0x30,
+    0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x22, 0x2c, 0x22, 0x6e, 0x61, 0x6d,
+    0x65, 0x22, 0x3a, 0x22, 0x64, 0x65, 0x76, 0x69, 0x63, 0x65, 0x2d, 0x30,
+    0x22, 0x2c, 0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x22, 0x61, 0x72,
+    0x72, 0x6f, 0x77, 0x2d, 0x73, 0x65, 0x6e, 0x73, 0x6f, 0x72, 0x22, 0x2c,
+    0x22, 0x65, 0x6e, 0x61, 0x62, 0x6c, 0x65, 0x64, 0x22, 0x3a, 0x66, 0x61,
+    0x6c, 0x73, 0x65, 0x2c, 0x22, 0x6c, 0x61, 0x73, 0x74, 0x4d, 0x6f, 0x64,
+    0x69, 0x66, 0x69, 0x65, 0x64, 0x44, 0x61, 0x74, 0x65, 0x22, 0x3a, 0x22,
+    0x32, 0x30, 0x31, 0x38, 0x2d, 0x30, 0x33, 0x2d, 0x30, 0x31, 0x54, 0x31,
+    0x30, 0x3a, 0x30, 0x30, 0x3a, 0x30, 0x30, 0x2e, 0x30, 0x30, 0x30, 0x5a,
+    0x22, 0x7d, 0x2c, 0x7b, 0x22, 0x68, 0x69, 0x64, 0x22, 0x3a, 0x22, 0x39,
+    0x65, 0x33, 0x37, 0x37, 0x39, 0x62, 0x31, 0x22, 0x2c, 0x22, 0x6e, 0x61,
+    0x6d, 0x65, 0x22, 0x3a, 0x22, 0x64, 0x65, 0x76, 0x69, 0x63, 0x65, 0x2d,
+    0x31, 0x22, 0x2c, 0x22, 0x74, 0x79, 0x70, 0x65, 0x22, 0x3a, 0x22, 0x61,
+    0x72, 0x72, 0x6f, 0x77, 0x2d, 0x73, 0x65, 0x6e, 0x73, 0x6f, 0x72, 0x22,
+    0x2c, 0x22, 0x65, 0x6e, 0x61, 0x62, 0x6c, 0x65, 0x64, 0x22, 0x3a, 0x74,
+    0x72, 0x75, 0x65, 0x2c, 0x22, 0x6c, 0x61, 0x73, 0x74, 0x4d, 0x6f, 0x64,
+    0x69, 0x66, 0x69, 0x65, 0x64, 0x44, 0x61, 0x74, 0x65, 0x22, 0x3a, 0x22,
+    0x32, 0x30, 0x31, 0x38, 0x2d, 0x30, 0x33, 0x2d, 0x30, 0x32, 0x54, 0x31,
+    0x30, 0x3a, 0x30, 0x31, 0x3a, 0x30, 0x30, 0x2e, 0x30, 0x30, 0x30, 0x5a,
+    0x22, 0x7d, 0x2c, 0x7b, 0x22, 0x68, 0x69, 0x64, 0x22, 0x3a, 0x22, 0x33,
+    0x63, 0x36, 0x65, 0x66, 0x33, 0x36, 0x32, 0x22, 0x2c, 0x22, 0x6e, 0x61,
+    0x6d, 0x65, 0x22, 0x3a, 0x22, 0x64, 0x65, 0x76, 0x69, 0x63, 0x65, 0x2d,
+    0x32, 0x22, 0x2c, 0x22, 0x74, 0x79, 0x70, 0x42, 0x46, 0x58, 0x32,
+};
+
+// "0123456789abcdefghij" x 6000, zlib: longer than the window
+static const uint8_t pattern_zlib[336] = {
+    0x78, 0xda, 0xed, 0xc8, 0x49, 0x01, 0x80, 0x20, 0x00, 0x00, 0xb0, 0x4a,
+    0x88, 0x0a, 0x12, 0x07, 0x05, 0xaf, 0xfe, 0x01, 0xf8, 0x91, 0x62, 0x7b,
+    0x2e, 0x2c, 0x71, 0xdd, 0xf6, 0x94, 0x8f, 0x52, 0xcf, 0xab, 0xf5, 0xfb,
+    0x79, 0xbf, 0x3f, 0x38, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73,
+    0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39,
+    0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c,
+    0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce,
+    0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7,
+    0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73,
+    0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39,
+    0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c,
+    0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce,
+    0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7,
+    0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73,
+    0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39,
+    0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c,
+    0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce,
+    0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7,
+    0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73,
+    0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39,
+    0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c,
+    0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce,
+    0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7,
+    0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73,
+    0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39,
+    0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c,
+    0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce, 0x39, 0xe7, 0x9c, 0x73, 0xce,
+    0x39, 0xe7, 0x9c, 0x73, 0xce, 0xb9, 0x79, 0x03, 0x32, 0x76, 0x06, 0x04,
+};
+
+#define LIST_ITEMS   60
+#define PATTERN_SIZE 120000
+
+static char list_text[8192];
+static uint8_t *decoded = NULL;
+static size_t decoded_len = 0;
+static size_t decoded_max = 0;
+static int out_calls = 0;
+
+static void make_list(void) {
+    int i;
+    char *p = list_text;
+    p += sprintf(p, "{\"size\":%d,\"data\":[", LIST_ITEMS);
+    for ( i = 0; i < LIST_ITEMS; i++ ) {
+        p += sprintf(p, "%s{\"hid\":\"%08x\",\"name\":\"device-%d\",\"type\":\"arrow-sensor\","
+                        "\"enabled\":%s,\"lastModifiedDate\":\"2018-03-%02dT10:%02d:00.000Z\"}",
+                     i ? "," : "", (uint32_t)( i * 2654435761u ), i,
+                     i % 3 ? "true" : "false", i % 28 + 1, i % 60);
+    }
+    strcpy(p, "]}");
+}
+
+static int collect(void *arg, uint8_t *buf, size_t len) {
+    (void)arg;
+    out_calls++;
+    if ( decoded_len + len > decoded_max ) return -1;
+    memcpy(decoded + decoded_len, buf, len);
+    decoded_len += len;
+    return 0;
+}
+
+// push the stream by the pieces of the size step
+static int inflate_by(int format, const uint8_t *in, size_t len, size_t step) {
+    http_inflate_t z;
+    size_t pos = 0;
+    int ret = 0;
+    decoded_len = 0;
+    out_calls = 0;
+    TEST_ASSERT_EQUAL_INT(0, http_inflate_init(&z, format, collect, NULL));
+    while ( pos < len && ret == 0 ) {
+        size_t n = ARROW_MIN(step, len - pos);
+        ret = http_inflate_part(&z, in + pos, n);
+        pos += n;
+    }
+    http_inflate_fin(&z);
+    return ret;
+}
+
+void setUp(void) {
+    property_types_init();
+    make_list();
+    decoded_max = PATTERN_SIZE + 1;
+    decoded = malloc(decoded_max);
+}
+
+void tearDown(void) {
+    free(decoded);
+    property_types_deinit();
+}
+
+void test_http_content_coding(void) {
+    TEST_ASSERT_EQUAL_INT(http_coding_gzip, http_content_coding("gzip"));
+    TEST_ASSERT_EQUAL_INT(http_coding_gzip, http_content_coding("x-gzip"));
+    TEST_ASSERT_EQUAL_INT(http_coding_deflate, http_content_coding("deflate"));
+    TEST_ASSERT_EQUAL_INT(http_coding_identity, http_content_coding("br"));
+    TEST_ASSERT_EQUAL_INT(http_coding_identity, http_content_coding(NULL));
+}
+
+void test_http_inflate_gzip(void) {
+    size_t steps[] = { 1, 2, 3, 7, 64, 512, sizeof(list_gz) };
+    size_t i;
+    for ( i = 0; i < sizeof(steps)/sizeof(steps[0]); i++ ) {
+        TEST_ASSERT_EQUAL_INT(1, inflate_by(http_coding_gzip, list_gz, sizeof(list_gz), steps[i]));
+        TEST_ASSERT_EQUAL_INT(strlen(list_text), decoded_len);
+        TEST_ASSERT_EQUAL_MEMORY(list_text, decoded, decoded_len);
+    }
+}
+
+void test_http_inflate_fixed(void) {
+    TEST_ASSERT_EQUAL_INT(1, inflate_by(http_coding_deflate, list_fixed, sizeof(list_fixed), 5));
+    TEST_ASSERT_EQUAL_INT(1200, decoded_len);
+    TEST_ASSERT_EQUAL_MEMORY(list_text, decoded, decoded_len);
+}
+
+void test_http_inflate_stored(void) {
+    TEST_ASSERT_EQUAL_INT(1, inflate_by(http_coding_deflate, list_stored, sizeof(list_stored), 1));
+    TEST_ASSERT_EQUAL_INT(300, decoded_len);
+    TEST_ASSERT_EQUAL_MEMORY(list_text, decoded, decoded_len);
+}
+
+void test_http_inflate_window(void) {
+    int i;
+    TEST_ASSERT_EQUAL_INT(1, inflate_by(http_coding_deflate, pattern_zlib, sizeof(pattern_zlib), 16));
+    TEST_ASSERT_EQUAL_INT(PATTERN_SIZE, decoded_len);
+    for ( i = 0; i < PATTERN_SIZE; i++ ) {
+        if ( decoded[i] != "0123456789abcdefghij"[i % 20] ) break;
+    }
+    TEST_ASSERT_EQUAL_INT(PATTERN_SIZE, i);
+    // the output comes by the window pieces
+    TEST_ASSERT(out_calls >= PATTERN_SIZE / HTTP_INFLATE_WINDOW);
+}
+
+void test_http_inflate_broken(void) {
+    uint8_t bad[sizeof(list_gz)];
+    memcpy(bad, list_gz, sizeof(bad));
+    // CRC32 of the data
+    bad[sizeof(bad) - 8] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_by(http_coding_gzip, bad, sizeof(bad), 100));
+    memcpy(bad, list_gz, sizeof(bad));
+    bad[0] = 0x00;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_by(http_coding_gzip, bad, sizeof(bad), 100));
+    // truncated stream is waiting for more
+    TEST_ASSERT_EQUAL_INT(0, inflate_by(http_coding_gzip, list_gz, sizeof(list_gz) - 4, 100));
+}
+
+// fake server: a gzip body by the 100 bytes chunks
+static char answer[2048];
+static int answer_len = 0;
+static int answer_pos = 0;
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 0;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)buf; (void)flags; (void)num;
+    return len;
+}
+
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    int size = answer_len - answer_pos;
+    if ( size <= 0 ) return -1;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, answer + answer_pos, size);
+    answer_pos += size;
+    return size;
+}
+
+static void chunked_gzip_answer(void) {
+    size_t pos = 0;
+    answer_pos = 0;
+    answer_len = sprintf(answer, "HTTP/1.1 200 OK\r\n"
+                                 "Content-Type: application/json\r\n"
+                                 "Content-Encoding: gzip\r\n"
+                                 "Transfer-Encoding: chunked\r\n\r\n");
+    while ( pos < sizeof(list_gz) ) {
+        size_t n = ARROW_MIN(100, sizeof(list_gz) - pos);
+        answer_len += sprintf(answer + answer_len, "%x\r\n", (int)n);
+        memcpy(answer + answer_len, list_gz + pos, n);
+        answer_len += n;
+        answer_len += sprintf(answer + answer_len, "\r\n");
+        pos += n;
+    }
+    answer_len += sprintf(answer + answer_len, "0\r\n\r\n");
+}
+
+void test_http_client_gzip_chunked(void) {
+    http_client_t cli;
+    http_request_t req;
+    http_response_t res;
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    soc_close_Ignore();
+    chunked_gzip_answer();
+
+    http_client_init(&cli);
+    http_request_init(&req, GET, "http://api.arrowconnect.io:80/api/v1/kronos/devices");
+    TEST_ASSERT_EQUAL_INT(0, default_http_client_open(&cli, &req));
+    TEST_ASSERT_EQUAL_INT(0, default_http_client_do(&cli, &res));
+    TEST_ASSERT_EQUAL_INT(200, res.m_httpResponseCode);
+    TEST_ASSERT_EQUAL_INT(http_coding_gzip, res.content_coding);
+    TEST_ASSERT_EQUAL_INT(strlen(list_text), property_size(&res.payload));
+    TEST_ASSERT_EQUAL_MEMORY(list_text, P_VALUE(res.payload), strlen(list_text));
+    http_request_close(&req);
+    default_http_client_close(&cli);
+    http_response_free(&res);
+    http_client_free(&cli);
+}
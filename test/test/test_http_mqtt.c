@@ -0,0 +1,310 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <arrow/routine.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include "http_routine.h"
+#include <sys/mem.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/events.h>
+#include <arrow/api/json/parse.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/device_command.h>
+#include <arrow/state.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <ssl/crypt.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <ntp/clock.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_api.h>
+#include "api_device_device.h"
+#include "api_gateway_gateway.h"
+#include "api_gateway_info.h"
+#include <arrow/api/device/info.h>
+#include <arrow/api/device/event.h>
+#include <arrow/api/log.h>
+#include <arrow/api/json/page.h>
+#include <json/cbor.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <bsd/sockpoll.h>
+#include <time/timer_wheel.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <acn.h>
+
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include "acnsdkc_time.h"
+
+#include "mock_sockdecl.h"
+#include "mock_watchdog.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+#include "mock_mac.h"
+#include "bench_clock.h"
+
+// The requests over MQTT in flight.
+// The broker stand-in is the loopback: every published request is answered
+// after the BROKER_RTT_US with its uri in the payload, the answers come in
+// the order of their due time, so the requests with the longer uri
+// may be answered out of order. The client needs the HTTP_VIA_MQTT define:
+//   ceedling options:mqtt test:test_http_mqtt
+
+#if defined(HTTP_VIA_MQTT)
+
+#define BROKER_RTT_US    1000
+#define BROKER_QUEUE     64
+
+typedef struct {
+    char id[HTTP_MQTT_REQ_ID_LEN];
+    char uri[128];
+    double due;
+} broker_msg_t;
+
+static broker_msg_t broker[BROKER_QUEUE];
+static int broker_len = 0;
+static int broker_drop = 0;
+static int broker_delay_us = 0;
+
+// the shared debug buffer is too slow for the broker timing
+void dbg_line(const char *fmt, ...) {
+    (void)fmt;
+}
+
+int http_mqtt_publish(JsonNode *msg) {
+    JsonNode *id = json_find_member(msg, p_const("requestId"));
+    JsonNode *prm = json_find_member(msg, p_const("parameters"));
+    JsonNode *uri = prm ? json_find_member(prm, p_const("uri")) : NULL;
+    if ( !id || !uri || broker_len >= BROKER_QUEUE ) return -1;
+    if ( broker_drop ) {
+        broker_drop--;
+        return 0;
+    }
+    broker_msg_t *m = broker + broker_len++;
+    strcpy(m->id, id->string_);
+    strcpy(m->uri, uri->string_);
+    m->due = bench_now_us() + BROKER_RTT_US + broker_delay_us * (int)strlen(m->uri);
+    return 0;
+}
+
+static int broker_answer(broker_msg_t *m) {
+    char msg[512];
+    int len = snprintf(msg, sizeof(msg),
+                       "{\"requestId\":\"%s\","
+                       "\"eventName\":\"ServerToGateway_ApiResponse\","
+                       "\"encrypted\":false,"
+                       "\"parameters\":{\"status\":\"OK\",\"payload\":\"%s\"}}",
+                       m->id, m->uri);
+    if ( process_http_init(len) < 0 ) return -1;
+    if ( process_http(msg, len) < 0 ) return -1;
+    return process_http_finish();
+}
+
+int http_mqtt_yield(int timeout_ms) {
+    double end = bench_now_us() + timeout_ms * 1000.0;
+    int i;
+    int first = -1;
+    for ( i = 0; i < broker_len; i++ ) {
+        if ( first < 0 || broker[i].due < broker[first].due ) first = i;
+    }
+    if ( first >= 0 && broker[first].due < end ) end = broker[first].due;
+    while ( bench_now_us() < end )
+        ;
+    double now = bench_now_us();
+    int delivered = 0;
+    for ( i = 0; i < broker_len; ) {
+        if ( broker[i].due <= now ) {
+            broker_answer(broker + i);
+            broker[i] = broker[--broker_len];
+            delivered++;
+        } else {
+            i++;
+        }
+    }
+    return delivered;
+}
+
+static http_client_t cli;
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+    memset(&cli, 0x0, sizeof(cli));
+    http_session_set_protocol(&cli, api_via_mqtt);
+    cli.timeout = 1000;
+    broker_len = 0;
+    broker_drop = 0;
+    broker_delay_us = 0;
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+typedef struct {
+    http_request_t req;
+    http_response_t res;
+    char url[128];
+    int done;
+    int status;
+} call_t;
+
+static int call_send(call_t *c, int n, http_mqtt_done_f cb) {
+    sprintf(c->url, "http://api.arrowconnect.io:80/api/v1/kronos/%0*d", n % 40 + 1, n);
+    memset(&c->res, 0x0, sizeof(c->res));
+    c->done = 0;
+    c->status = 1;
+    http_request_init(&c->req, GET, c->url);
+    if ( http_mqtt_client_open(&cli, &c->req) < 0 ) return -1;
+    return http_mqtt_client_send(&cli, &c->res, cb, c);
+}
+
+static int call_check(call_t *c) {
+    const char *uri = strstr(c->url, "/api/");
+    if ( c->res.m_httpResponseCode != 200 ) return -1;
+    if ( property_size(&c->res.payload) != strlen(uri) ) return -1;
+    return strncmp(P_VALUE(c->res.payload), uri, strlen(uri)) ? -1 : 0;
+}
+
+static void call_close(call_t *c) {
+    http_request_close(&c->req);
+    http_response_free(&c->res);
+    http_mqtt_client_close(&cli);
+}
+
+static void call_done(int status, http_response_t *res, void *arg) {
+    call_t *c = (call_t *)arg;
+    (void)res;
+    c->done = 1;
+    c->status = status;
+}
+
+void test_http_mqtt_do(void) {
+    call_t c;
+    sprintf(c.url, "http://api.arrowconnect.io:80/api/v1/kronos/gateways");
+    memset(&c.res, 0x0, sizeof(c.res));
+    http_request_init(&c.req, GET, c.url);
+    TEST_ASSERT_EQUAL_INT(0, http_mqtt_client_open(&cli, &c.req));
+    TEST_ASSERT_EQUAL_INT(0, http_mqtt_client_do(&cli, &c.res));
+    TEST_ASSERT_EQUAL_INT(0, call_check(&c));
+    call_close(&c);
+    TEST_ASSERT_EQUAL_INT(0, http_mqtt_client_pending());
+    TEST_ASSERT_EQUAL_INT(0, arrow_mqtt_api_has_events());
+}
+
+void test_http_mqtt_out_of_order(void) {
+    call_t c[HTTP_MQTT_MAX_PENDING];
+    call_t extra;
+    int h[HTTP_MQTT_MAX_PENDING];
+    int i;
+    // the longer uri is answered later
+    broker_delay_us = 100;
+    for ( i = 0; i < HTTP_MQTT_MAX_PENDING; i++ ) {
+        h[i] = call_send(c + i, HTTP_MQTT_MAX_PENDING * 7 - i * 7, NULL);
+        TEST_ASSERT(h[i] >= 0);
+    }
+    TEST_ASSERT_EQUAL_INT(HTTP_MQTT_MAX_PENDING, http_mqtt_client_pending());
+    // no free slot
+    TEST_ASSERT_EQUAL_INT(-1, call_send(&extra, 0, NULL));
+    call_close(&extra);
+    for ( i = 0; i < HTTP_MQTT_MAX_PENDING; i++ ) {
+        TEST_ASSERT_EQUAL_INT(0, http_mqtt_client_wait(h[i]));
+        TEST_ASSERT_EQUAL_INT(0, call_check(c + i));
+        call_close(c + i);
+    }
+    TEST_ASSERT_EQUAL_INT(0, http_mqtt_client_pending());
+}
+
+void test_http_mqtt_callback(void) {
+    call_t c[4];
+    int i;
+    for ( i = 0; i < 4; i++ ) {
+        TEST_ASSERT(call_send(c + i, i, call_done) >= 0);
+    }
+    while ( http_mqtt_client_poll(100) > 0 )
+        ;
+    for ( i = 0; i < 4; i++ ) {
+        TEST_ASSERT_EQUAL_INT(1, c[i].done);
+        TEST_ASSERT_EQUAL_INT(0, c[i].status);
+        TEST_ASSERT_EQUAL_INT(0, call_check(c + i));
+        call_close(c + i);
+    }
+}
+
+void test_http_mqtt_timeout(void) {
+    call_t c[2];
+    cli.timeout = 25;
+    // the first request is lost by the broker
+    broker_drop = 1;
+    int lost = call_send(c, 1, NULL);
+    TEST_ASSERT(call_send(c + 1, 2, call_done) >= 0);
+    TEST_ASSERT(lost >= 0);
+    double start = bench_now_us();
+    TEST_ASSERT_EQUAL_INT(-1, http_mqtt_client_wait(lost));
+    TEST_ASSERT(bench_now_us() - start >= 2 * cli.timeout * 1000.0 - 1000.0);
+    TEST_ASSERT_EQUAL_INT(1, c[1].done);
+    TEST_ASSERT_EQUAL_INT(0, c[1].status);
+    TEST_ASSERT_EQUAL_INT(0, call_check(c + 1));
+    call_close(c);
+    call_close(c + 1);
+    TEST_ASSERT_EQUAL_INT(0, http_mqtt_client_pending());
+}
+
+#else
+void setUp(void) {}
+void tearDown(void) {}
+
+#define IGNORE_TEST(name) \
+    void name(void) { TEST_IGNORE_MESSAGE("HTTP_VIA_MQTT is not defined"); }
+
+IGNORE_TEST(test_http_mqtt_do)
+IGNORE_TEST(test_http_mqtt_out_of_order)
+IGNORE_TEST(test_http_mqtt_callback)
+IGNORE_TEST(test_http_mqtt_timeout)
+#endif
@@ -13,6 +13,7 @@
 #include <data/property_const.h>
 #include <data/property_dynamic.h>
 #include <data/property_stack.h>
+#include <data/property_intern.h>
 #include <json/property_json.h>
 #include <data/ringbuffer.h>
 #include <data/propmap.h>
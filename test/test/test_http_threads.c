@@ -0,0 +1,308 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <config.h>
+#include <debug.h>
+#include <http/client.h>
+#include "http_routine.h"
+#include <http/pool.h>
+#include <http/inflate.h>
+#include <sys/mem.h>
+#include <sys/mutex.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <bsd/socket.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <ssl/crypt.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <ntp/clock.h>
+
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include "acnsdkc_time.h"
+#include "mock_storage.h"
+
+// Stress test of the parallel HTTP clients.
+// The sockets are the in-memory loopback: every socket has its own fake
+// server answering the request uri in the payload, so an answer mixed up
+// between the clients is caught. Build with -fsanitize=thread to check
+// the data races. The clients share the scratch buffers without the
+// HTTP_THREAD define, so both tests need it:
+//   ceedling options:threads test:test_http_threads
+
+#define STRESS_THREADS   8
+#define STRESS_REQUESTS  50
+#define FAKE_SOCKETS     64
+
+typedef struct {
+    int used;
+    char req[512];
+    int req_len;
+    char answer[256];
+    int answer_len;
+    int answer_pos;
+} fake_conn_t;
+
+static pthread_mutex_t sock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static fake_conn_t conns[FAKE_SOCKETS];
+static int served = 0;
+static int opened = 0;
+
+// the shared debug buffer isn't for the threads
+void dbg_line(const char *fmt, ...) {
+    (void)fmt;
+}
+
+int socket(int protocol_family, int socket_type, int protocol) {
+    (void)protocol_family; (void)socket_type; (void)protocol;
+    int i;
+    int sock = -1;
+    pthread_mutex_lock(&sock_mutex);
+    for ( i = 0; i < FAKE_SOCKETS; i++ ) {
+        if ( !conns[i].used ) {
+            memset(conns + i, 0x0, sizeof(fake_conn_t));
+            conns[i].used = 1;
+            opened++;
+            sock = i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sock_mutex);
+    return sock;
+}
+
+struct hostent *gethostbyname(const char *name) {
+    static __thread struct hostent s_hostent;
+    static __thread char *s_aliases;
+    static __thread unsigned long s_hostent_addr;
+    static __thread unsigned long *s_phostent_addr[2];
+    s_hostent_addr = 0x0100007f;
+    s_phostent_addr[0] = &s_hostent_addr;
+    s_phostent_addr[1] = NULL;
+    s_hostent.h_name = (char*)name;
+    s_hostent.h_aliases = &s_aliases;
+    s_hostent.h_addrtype = AF_INET;
+    s_hostent.h_length = sizeof(unsigned long);
+    s_hostent.h_addr_list = (char**)&s_phostent_addr;
+    s_hostent.h_addr = s_hostent.h_addr_list[0];
+    return &s_hostent;
+}
+
+int setsockopt(int sockfd, int level, int optname,
+               const void *optval, socklen_t optlen) {
+    (void)sockfd; (void)level; (void)optname; (void)optval; (void)optlen;
+    return 0;
+}
+
+int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen) {
+    (void)addr; (void)addrlen;
+    return ( sockfd >= 0 && sockfd < FAKE_SOCKETS ) ? 0 : -1;
+}
+
+void soc_close(int socket) {
+    pthread_mutex_lock(&sock_mutex);
+    conns[socket].used = 0;
+    pthread_mutex_unlock(&sock_mutex);
+}
+
+// the socket belongs to one client, so only the counters are locked
+ssize_t send(int sockfd, const void *buf, size_t len, int flags) {
+    (void)flags;
+    fake_conn_t *c = conns + sockfd;
+    if ( c->req_len + len >= sizeof(c->req) ) return -1;
+    memcpy(c->req + c->req_len, buf, len);
+    c->req_len += len;
+    c->req[c->req_len] = 0x0;
+    char *end = strstr(c->req, "\r\n\r\n");
+    if ( end ) {
+        char uri[128] = {0};
+        sscanf(c->req, "GET %127s", uri);
+        c->answer_len = snprintf(c->answer, sizeof(c->answer),
+                                 "HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s",
+                                 (int)strlen(uri), uri);
+        c->answer_pos = 0;
+        c->req_len = 0;
+    }
+    return len;
+}
+
+ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
+    fake_conn_t *c = conns + sockfd;
+    if ( flags & MSG_PEEK ) return -1;
+    int size = c->answer_len - c->answer_pos;
+    if ( size <= 0 ) return -1;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, c->answer + c->answer_pos, size);
+    c->answer_pos += size;
+    if ( c->answer_pos == c->answer_len ) {
+        c->answer_len = 0;
+        pthread_mutex_lock(&sock_mutex);
+        served++;
+        pthread_mutex_unlock(&sock_mutex);
+    }
+    return size;
+}
+
+#if defined(HTTP_THREAD)
+int arrow_mutex_init(arrow_mutex **mutex) {
+    pthread_mutex_t *m = malloc(sizeof(pthread_mutex_t));
+    if ( !m ) return -1;
+    pthread_mutex_init(m, NULL);
+    *mutex = m;
+    return 0;
+}
+
+int arrow_mutex_deinit(arrow_mutex *mutex) {
+    pthread_mutex_destroy((pthread_mutex_t *)mutex);
+    free(mutex);
+    return 0;
+}
+
+int arrow_mutex_lock(arrow_mutex *mutex) {
+    return pthread_mutex_lock((pthread_mutex_t *)mutex);
+}
+
+int arrow_mutex_unlock(arrow_mutex *mutex) {
+    return pthread_mutex_unlock((pthread_mutex_t *)mutex);
+}
+#endif
+
+void setUp(void) {
+    property_types_init();
+    memset(conns, 0x0, sizeof(conns));
+    served = 0;
+    opened = 0;
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+#if defined(HTTP_THREAD)
+typedef struct {
+    int id;
+    int errors;
+} stress_arg_t;
+
+static int check_answer(http_response_t *res, const char *uri) {
+    if ( res->m_httpResponseCode != 200 ) return -1;
+    if ( property_size(&res->payload) != strlen(uri) ) return -1;
+    return strncmp(P_VALUE(res->payload), uri, strlen(uri)) ? -1 : 0;
+}
+
+static void *client_thread(void *a) {
+    stress_arg_t *arg = (stress_arg_t *)a;
+    http_client_t cli;
+    char url[128];
+    int i;
+    http_client_init(&cli);
+    for ( i = 0; i < STRESS_REQUESTS; i++ ) {
+        http_request_t req;
+        http_response_t res;
+        memset(&res, 0x0, sizeof(res));
+        sprintf(url, "http://api.arrowconnect.io:80/api/v1/stress/%d/%d", arg->id, i);
+        http_request_init(&req, GET, url);
+        int ret = default_http_client_open(&cli, &req);
+        if ( ret >= 0 ) ret = default_http_client_do(&cli, &res);
+        if ( ret < 0 || check_answer(&res, strstr(url, "/api/")) < 0 ) arg->errors++;
+        http_request_close(&req);
+        default_http_client_close(&cli);
+        http_response_free(&res);
+    }
+    http_client_free(&cli);
+    return NULL;
+}
+
+static void run_threads(void *(*routine)(void *), stress_arg_t *args) {
+    pthread_t th[STRESS_THREADS];
+    int i;
+    for ( i = 0; i < STRESS_THREADS; i++ ) {
+        args[i].id = i;
+        args[i].errors = 0;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(th + i, NULL, routine, args + i));
+    }
+    for ( i = 0; i < STRESS_THREADS; i++ ) {
+        pthread_join(th[i], NULL);
+    }
+}
+
+void test_http_threads_clients(void) {
+    stress_arg_t args[STRESS_THREADS];
+    int i;
+    run_threads(client_thread, args);
+    for ( i = 0; i < STRESS_THREADS; i++ ) {
+        TEST_ASSERT_EQUAL_INT(0, args[i].errors);
+    }
+    TEST_ASSERT_EQUAL_INT(STRESS_THREADS * STRESS_REQUESTS, served);
+    TEST_ASSERT_EQUAL_INT(STRESS_THREADS * STRESS_REQUESTS, opened);
+}
+
+typedef struct {
+    char url[128];
+    const char *uri;
+} stress_req_t;
+
+static void stress_init(http_request_t *request, void *arg) {
+    stress_req_t *r = (stress_req_t *)arg;
+    http_request_init(request, GET, r->url);
+}
+
+static int stress_proc(http_response_t *response, void *arg) {
+    stress_req_t *r = (stress_req_t *)arg;
+    return check_answer(response, r->uri);
+}
+
+static void *routine_thread(void *a) {
+    stress_arg_t *arg = (stress_arg_t *)a;
+    int i;
+    for ( i = 0; i < STRESS_REQUESTS; i++ ) {
+        stress_req_t r;
+        sprintf(r.url, "http://api.arrowconnect.io:80/api/v1/stress/%d/%d", arg->id, i);
+        r.uri = strstr(r.url, "/api/");
+        if ( __http_routine(stress_init, &r, stress_proc, &r) < 0 ) arg->errors++;
+    }
+    return NULL;
+}
+
+void test_http_threads_routine(void) {
+    stress_arg_t args[STRESS_THREADS];
+    int i;
+    TEST_ASSERT_EQUAL_INT(0, __http_init());
+    run_threads(routine_thread, args);
+    TEST_ASSERT_EQUAL_INT(0, __http_done());
+    for ( i = 0; i < STRESS_THREADS; i++ ) {
+        TEST_ASSERT_EQUAL_INT(0, args[i].errors);
+    }
+    TEST_ASSERT_EQUAL_INT(STRESS_THREADS * STRESS_REQUESTS, served);
+}
+#else
+void test_http_threads_clients(void) {
+    TEST_IGNORE_MESSAGE("HTTP_THREAD is not defined");
+}
+
+void test_http_threads_routine(void) {
+    TEST_IGNORE_MESSAGE("HTTP_THREAD is not defined");
+}
+#endif
@@ -0,0 +1,86 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+// the build which doesn't trust the target macros: the byte order is probed
+// and swapped without the builtins
+#define BYTE_ORDER_PROBE
+#define BYTE_ORDER_NO_BUILTIN
+#include <bsd/byteorder.h>
+#include <bsd/inet.h>
+#include <MQTTPacket.h>
+
+#include "acnsdkc_time.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static int host_is_be(void) {
+    uint32_t v = 1;
+    return *(uint8_t *)&v == 0;
+}
+
+void test_inet_probe(void) {
+    uint16_t s = 0x1234;
+    uint32_t l = 0x12345678UL;
+    uint8_t *b;
+    TEST_ASSERT_EQUAL_INT(host_is_be(), byteorder_is_be());
+    // the network order is big endian in the memory
+    s = byteorder_htons(s);
+    b = (uint8_t *)&s;
+    TEST_ASSERT_EQUAL_HEX8(0x12, b[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x34, b[1]);
+    l = byteorder_htonl(l);
+    b = (uint8_t *)&l;
+    TEST_ASSERT_EQUAL_HEX8(0x12, b[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x34, b[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x56, b[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x78, b[3]);
+}
+
+// the probed and portable conversion is the same as the library one
+// built by the compile time byte order
+void test_inet_same_as_library(void) {
+    uint32_t i;
+    srand(7);
+    for ( i = 0; i < 100000; i++ ) {
+        uint32_t l = ( (uint32_t)rand() << 16 ) ^ (uint32_t)rand();
+        uint16_t s = (uint16_t)l;
+        TEST_ASSERT_EQUAL_HEX16(htons(s), byteorder_htons(s));
+        TEST_ASSERT_EQUAL_HEX16(ntohs(s), byteorder_ntohs(s));
+        TEST_ASSERT_EQUAL_HEX32(htonl(l), byteorder_htonl(l));
+        TEST_ASSERT_EQUAL_HEX32(ntohl(l), byteorder_ntohl(l));
+        TEST_ASSERT_EQUAL_HEX32(l, ntohl(htonl(l)));
+        TEST_ASSERT_EQUAL_HEX16(s, ntohs(htons(s)));
+    }
+}
+
+void test_inet_be_fields(void) {
+    uint8_t buf[7];
+    unsigned char *p = buf;
+    memset(buf, 0x0, sizeof(buf));
+    be16_put(buf + 1, 0xabcd);
+    be32_put(buf + 3, 0x01020304UL);
+    TEST_ASSERT_EQUAL_HEX8(0x00, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xab, buf[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xcd, buf[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, buf[3]);
+    TEST_ASSERT_EQUAL_HEX8(0x04, buf[6]);
+    // unaligned
+    TEST_ASSERT_EQUAL_HEX16(0xabcd, be16_get(buf + 1));
+    TEST_ASSERT_EQUAL_HEX32(0x01020304UL, be32_get(buf + 3));
+    // the MQTT packet id and string length
+    writeInt(&p, 65535);
+    writeInt(&p, 258);
+    TEST_ASSERT_EQUAL_PTR(buf + 4, p);
+    TEST_ASSERT_EQUAL_HEX8(0xff, buf[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, buf[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x02, buf[3]);
+    p = buf;
+    TEST_ASSERT_EQUAL_INT(65535, readInt(&p));
+    TEST_ASSERT_EQUAL_INT(258, readInt(&p));
+}
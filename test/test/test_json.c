@@ -1,6 +1,7 @@
 #include "unity.h"
 #include <stdlib.h>
 #include <string.h>
+#include <malloc.h>
 #include <config.h>
 #include <debug.h>
 #include <data/static_buf.h>
@@ -11,12 +12,61 @@
 #include <data/property_const.h>
 #include <data/property_dynamic.h>
 #include <data/property_stack.h>
+#include <data/property_intern.h>
 #include <json/property_json.h>
 #include <json/json.h>
 #include <sb.h>
 #include <encode.h>
 #include <decode.h>
 
+// the heap usage counted by the malloc of the test
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void __libc_free(void *p);
+
+static long heap_allocs = 0;
+static long heap_blocks = 0;
+static long heap_bytes = 0;
+
+void *malloc(size_t size) {
+    void *p = __libc_malloc(size);
+    if ( p ) {
+        heap_allocs++;
+        heap_blocks++;
+        heap_bytes += malloc_usable_size(p);
+    }
+    return p;
+}
+
+void *calloc(size_t n, size_t size) {
+    void *p = __libc_calloc(n, size);
+    if ( p ) {
+        heap_allocs++;
+        heap_blocks++;
+        heap_bytes += malloc_usable_size(p);
+    }
+    return p;
+}
+
+void *realloc(void *old, size_t size) {
+    if ( !old ) return malloc(size);
+    long was = malloc_usable_size(old);
+    void *p = __libc_realloc(old, size);
+    if ( p ) {
+        heap_allocs++;
+        heap_bytes += (long)malloc_usable_size(p) - was;
+    }
+    return p;
+}
+
+void free(void *p) {
+    if ( !p ) return;
+    heap_blocks--;
+    heap_bytes -= malloc_usable_size(p);
+    __libc_free(p);
+}
+
 void setUp(void) {
     property_types_init();
     property_type_add(property_type_get_json());
@@ -448,6 +498,37 @@ void test_parse_json_string_part(void) {
     TEST_ASSERT_EQUAL_INT( 0, strcmp(_key->string_, "hello") );
 }
 
+void test_parse_json_empty_part(void) {
+    const char *text = "{\"links\":{},\"tags\":[],\"info\":{\"a\":[{}, []]},\"hid\":\"x\"}";
+    json_parse_machine_t sm;
+    json_decode_init(&sm);
+    TEST_ASSERT_EQUAL_INT(strlen(text), json_decode_part(&sm, text, strlen(text)));
+    JsonNode *_main = json_decode_finish(&sm);
+    TEST_ASSERT(_main);
+    JsonNode *t = json_find_member(_main, p_const("links"));
+    TEST_ASSERT(t && t->tag == JSON_OBJECT && !json_first_child(t));
+    t = json_find_member(_main, p_const("tags"));
+    TEST_ASSERT(t && t->tag == JSON_ARRAY && !json_first_child(t));
+    t = json_find_member(json_find_member(_main, p_const("info")), p_const("a"));
+    TEST_ASSERT(t && json_find_element(t, 1) && !json_find_element(t, 2));
+    t = json_find_member(_main, p_const("hid"));
+    TEST_ASSERT_EQUAL_STRING("x", t->string_);
+    json_delete(_main);
+
+    json_decode_init(&sm);
+    TEST_ASSERT_EQUAL_INT(2, json_decode_part(&sm, "{}", 2));
+    _main = json_decode_finish(&sm);
+    TEST_ASSERT(_main && _main->tag == JSON_OBJECT);
+    json_delete(_main);
+    // the trailing comma is still wrong
+    json_decode_init(&sm);
+    TEST_ASSERT_EQUAL_INT(-1, json_decode_part(&sm, "{\"a\":1,}", 8));
+    json_delete(json_decode_finish(&sm));
+    json_decode_init(&sm);
+    TEST_ASSERT_EQUAL_INT(-1, json_decode_part(&sm, "[1,]", 4));
+    json_delete(json_decode_finish(&sm));
+}
+
 void test_parse_json_complex_part(void) {
     char test_part[100] = {0};
     int total_len = strlen(complex_json_text);
@@ -1175,3 +1256,85 @@ void test_quote_json_string(void) {
     json_delete(_main);
     json_delete(_body);
 }
+
+void test_json_intern_keys(void) {
+#if defined(PROPERTY_NO_INTERN)
+    TEST_IGNORE_MESSAGE("PROPERTY_NO_INTERN");
+#else
+    int pool = property_intern_count();
+    JsonNode *_main = json_decode("{\"hid\":\"a\",\"info\":{\"hid\":\"b\"},"
+                                  "\"aVeryLongKeyThatIsNotInternedAtAllReally\":1}");
+    TEST_ASSERT(_main);
+    JsonNode *a = json_find_member(_main, p_const("hid"));
+    JsonNode *b = json_find_member(json_find_member(_main, p_const("info")), p_const("hid"));
+    JsonNode *l = json_find_member(_main, p_const("aVeryLongKeyThatIsNotInternedAtAllReally"));
+    TEST_ASSERT(a && b && l);
+    TEST_ASSERT_EQUAL_INT(PROPERTY_INTERN_TAG, PROPERTY_BASE_MASK & a->key.flags);
+    TEST_ASSERT_EQUAL_INT(PROPERTY_JSON_TAG, PROPERTY_BASE_MASK & l->key.flags);
+    TEST_ASSERT( P_VALUE(a->key) == P_VALUE(b->key) );
+    TEST_ASSERT_EQUAL_STRING("hid", P_VALUE(a->key));
+    TEST_ASSERT_EQUAL_INT(pool + 2, property_intern_count());
+    // the streamed decoder shares them too
+    json_parse_machine_t sm;
+    const char *js = "{\"hid\":\"c\"}";
+    json_decode_init(&sm);
+    json_decode_part(&sm, js, strlen(js));
+    JsonNode *_other = json_decode_finish(&sm);
+    TEST_ASSERT(_other);
+    TEST_ASSERT( P_VALUE(_other->children.head->key) == P_VALUE(a->key) );
+    json_delete(_main);
+    TEST_ASSERT_EQUAL_INT(pool + 1, property_intern_count());
+    json_delete(_other);
+    TEST_ASSERT_EQUAL_INT(pool, property_intern_count());
+#endif
+}
+
+#define DEVICES 1000
+
+static char *device_list(void) {
+    SB sb;
+    int i;
+    char dev[512];
+    sb_init(&sb);
+    sb_puts(&sb, "{\"size\":1000,\"data\":[");
+    for ( i = 0; i < DEVICES; i++ ) {
+        snprintf(dev, sizeof(dev), "%s{\"hid\":\"%040x\",\"pri\":\"arw:krn:dev:%040x\","
+                 "\"name\":\"device-%d\",\"type\":\"sensor\",\"uid\":\"uid-%d\","
+                 "\"gatewayHid\":\"ab12cd34\",\"enabled\":true,\"info\":{\"fw\":\"1.0\"},"
+                 "\"properties\":{\"interval\":\"60\"},\"createdDate\":\"2018-05-22T10:08:38.503Z\","
+                 "\"createdBy\":\"admin\",\"lastModifiedDate\":\"2018-05-22T10:08:38.503Z\","
+                 "\"lastModifiedBy\":\"admin\"}", i ? "," : "", i, i, i, i);
+        sb_puts(&sb, dev);
+    }
+    sb_puts(&sb, "],\"page\":0,\"totalSize\":1000,\"totalPages\":1}");
+    return sb_finish(&sb);
+}
+
+// the heap taken by the device list tree and the allocations on the way
+void test_json_device_list_heap(void) {
+    char *list = device_list();
+    long allocs, blocks, bytes;
+    json_parse_machine_t sm;
+    JsonNode *_main;
+
+    allocs = heap_allocs; blocks = heap_blocks; bytes = heap_bytes;
+    _main = json_decode(list);
+    TEST_ASSERT(_main);
+    TEST_ASSERT_NOT_NULL(json_find_element(json_find_member(_main, p_const("data")), DEVICES - 1));
+    printf("json_decode %d devices (%d bytes): %ld allocations, %ld blocks %ld bytes kept by the tree\n",
+           DEVICES, (int)strlen(list), heap_allocs - allocs, heap_blocks - blocks, heap_bytes - bytes);
+    json_delete(_main);
+
+    allocs = heap_allocs; blocks = heap_blocks; bytes = heap_bytes;
+    json_decode_init(&sm);
+    TEST_ASSERT_EQUAL_INT(strlen(list), json_decode_part(&sm, list, strlen(list)));
+    _main = json_decode_finish(&sm);
+    TEST_ASSERT(_main);
+    printf("json_decode_part %d devices: %ld allocations, %ld blocks %ld bytes kept by the tree\n",
+           DEVICES, heap_allocs - allocs, heap_blocks - blocks, heap_bytes - bytes);
+    json_delete(_main);
+#if defined(PROPERTY_NO_INTERN)
+    printf("(the keys aren't interned: PROPERTY_NO_INTERN)\n");
+#endif
+    json_delete_string(list);
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <config.h>
 #include <data/linkedlist.h>
+#include <time.h>
 
 typedef struct _test_ {
   int data;
@@ -177,3 +178,44 @@ void test_check_del_hard(void) {
     }
     TEST_ASSERT( !tmp );
 }
+
+void test_list_head(void) {
+    test_t n[5];
+    test_t *tmp = NULL;
+    int exp_ord[] = {4, 0, 2, 3};
+    int i;
+    arrow_linked_list_head_t head = ARROW_LINKED_LIST_HEAD_INIT;
+    for ( i = 0; i < 5; i++ ) n[i].count = i;
+    TEST_ASSERT( !arrow_linked_list_head_first(&head, test_t) );
+    TEST_ASSERT( !arrow_linked_list_head_del_node_first(&head) );
+    for ( i = 0; i < 4; i++ ) arrow_linked_list_head_add_node_last(&head, n + i);
+    arrow_linked_list_head_add_node_first(&head, n + 4);
+    TEST_ASSERT_EQUAL_INT(5, arrow_linked_list_head_size(&head));
+    TEST_ASSERT_EQUAL_INT(0, arrow_linked_list_head_del_node(&head, n + 1));
+    TEST_ASSERT_EQUAL_INT(-1, arrow_linked_list_head_del_node(&head, n + 1));
+    i = 0;
+    arrow_linked_list_head_for_each(tmp, &head, test_t) {
+        TEST_ASSERT_EQUAL_INT(exp_ord[i++], tmp->count);
+    }
+    TEST_ASSERT_EQUAL_INT(4, i);
+    // the last one goes, the tail is the previous
+    TEST_ASSERT_EQUAL_INT(0, arrow_linked_list_head_del_node(&head, n + 3));
+    TEST_ASSERT( arrow_linked_list_head_last(&head, test_t) == n + 2 );
+    arrow_linked_list_head_add_node_last(&head, n + 1);
+    TEST_ASSERT( n[2].node.next == &n[1].node );
+    TEST_ASSERT( arrow_linked_list_head_del_node_first(&head) == &n[4].node );
+    TEST_ASSERT_EQUAL_INT(3, arrow_linked_list_head_size(&head));
+    // the plain list is taken as it is
+    arrow_linked_list_head_t copy;
+    arrow_linked_list_head_set(&copy, head.first);
+    TEST_ASSERT_EQUAL_INT(3, arrow_linked_list_head_size(&copy));
+    TEST_ASSERT( copy.last == head.last );
+    i = 0;
+    arrow_linked_list_head_for_each_safe(tmp, &head, test_t) {
+        arrow_linked_list_head_del_node(&head, tmp);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_INT(3, i);
+    TEST_ASSERT_EQUAL_INT(0, arrow_linked_list_head_size(&head));
+    TEST_ASSERT( !head.first && !head.last );
+}
@@ -0,0 +1,464 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <json/json.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_filter.h>
+#include <time/time.h>
+#include "acnsdkc_time.h"
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/cbor.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+
+#include "mock_mac.h"
+#include "mock_watchdog.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+#include "fakedns.h"
+
+#define TEST_TOPIC "krs.tel.gts.test"
+
+// fake broker: count the packets and answer PUBACK on every PUBLISH
+static unsigned char sent[8192];
+static int sent_len = 0;
+static int sent_packets = 0;
+static unsigned char ack[4];
+static int ack_len = 0;
+static int ack_pos = 0;
+
+static int packet_left = 0;
+
+static int fake_write(Network *n, unsigned char *buf, int len, int timeout) {
+    (void)n; (void)timeout;
+    if ( !packet_left ) {
+        // the new packet begins with the fixed header
+        int i = 1;
+        int mult = 1;
+        do {
+            packet_left += ( buf[i] & 0x7f ) * mult;
+            mult *= 128;
+        } while ( buf[i++] & 0x80 );
+        packet_left += i;
+        if ( ( buf[0] >> 4 ) == PUBLISH ) {
+            sent_len = 0;
+            sent_packets++;
+            ack[0] = PUBACK << 4;
+            ack[1] = 2;
+            ack[2] = 0;
+            ack[3] = 1;
+            ack_len = 4;
+            ack_pos = 0;
+        }
+    }
+    packet_left -= len;
+    if ( sent_len + len <= (int)sizeof(sent) ) {
+        memcpy(sent + sent_len, buf, len);
+        sent_len += len;
+    }
+    return len;
+}
+
+static int fake_read(Network *n, unsigned char *buf, int len, int timeout) {
+    (void)n; (void)timeout;
+    int i;
+    for ( i = 0; i < len && ack_pos < ack_len; i++ ) {
+        buf[i] = ack[ack_pos++];
+    }
+    return i;
+}
+
+// the telemetry channel over the fake socket: the broker answers CONNACK
+// on the CONNECT and PUBACK on every PUBLISH, it keeps the last payload
+static unsigned char wire[8192];
+static int wire_len = 0;
+static unsigned char answer[64];
+static int answer_len = 0;
+static int answer_pos = 0;
+static int broker_down = 0;
+static int broker_publishes = 0;
+static char broker_payload[4096];
+
+static void broker_answer(const unsigned char *p, int len) {
+    if ( answer_len + len > (int)sizeof(answer) ) return;
+    memcpy(answer + answer_len, p, len);
+    answer_len += len;
+}
+
+static void broker_packet(const unsigned char *p, int head, int rem) {
+    int type = p[0] >> 4;
+    if ( type == CONNECT ) {
+        unsigned char connack[] = { CONNACK << 4, 2, 0, 0 };
+        broker_answer(connack, sizeof(connack));
+    } else if ( type == PUBLISH ) {
+        int qos = ( p[0] >> 1 ) & 0x3;
+        int i = head + 2 + ( ( p[head] << 8 ) | p[head + 1] );
+        int len;
+        if ( qos ) {
+            unsigned char puback[] = { PUBACK << 4, 2, p[i], p[i + 1] };
+            broker_answer(puback, sizeof(puback));
+            i += 2;
+        }
+        len = head + rem - i;
+        if ( len >= (int)sizeof(broker_payload) ) len = sizeof(broker_payload) - 1;
+        memcpy(broker_payload, p + i, len);
+        broker_payload[len] = 0x0;
+        broker_publishes++;
+    } else if ( type == PINGREQ ) {
+        unsigned char pingresp[] = { PINGRESP << 4, 0 };
+        broker_answer(pingresp, sizeof(pingresp));
+    }
+}
+
+static ssize_t broker_send(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    if ( broker_down ) return -1;
+    if ( wire_len + (int)len > (int)sizeof(wire) ) return -1;
+    memcpy(wire + wire_len, buf, len);
+    wire_len += len;
+    for ( ;; ) {
+        int head = 1;
+        int rem = 0;
+        int mult = 1;
+        do {
+            if ( head >= wire_len ) return len;
+            rem += ( wire[head] & 0x7f ) * mult;
+            mult *= 128;
+        } while ( wire[head++] & 0x80 );
+        if ( wire_len < head + rem ) return len;
+        broker_packet(wire, head, rem);
+        wire_len -= head + rem;
+        memmove(wire, wire + head + rem, wire_len);
+    }
+}
+
+static ssize_t broker_recv(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    int size = answer_len - answer_pos;
+    if ( broker_down || !size ) return -1;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, answer + answer_pos, size);
+    answer_pos += size;
+    if ( answer_pos == answer_len ) answer_len = answer_pos = 0;
+    return size;
+}
+
+static int broker_socket(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 3;
+}
+
+static int broker_connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static struct hostent *broker_gethostbyname(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static void broker_close(int sock, int num) {
+    (void)sock; (void)num;
+    wire_len = 0;
+    answer_len = answer_pos = 0;
+}
+
+static int serialized = 0;
+
+static JsonNode *serialize_cb(arrow_device_t *device, void *data, int num) {
+    JsonNode *_node = json_mkobject();
+    (void)device; (void)num;
+    serialized++;
+    json_append_member(_node, p_const(TELEMETRY_DEVICE_HID), json_mkstring("hid"));
+    json_append_member(_node, p_const("i|counter"), json_mknumber(*(int *)data));
+    return _node;
+}
+
+static arrow_gateway_t gateway;
+static arrow_device_t device;
+static arrow_gateway_config_t config;
+
+static Network net;
+static MQTTClient client;
+static unsigned char buf[MQTT_BUF_LEN];
+static unsigned char readbuf[MQTT_RECVBUF_LEN];
+static mqtt_batch_t batch;
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+    net.mqttread = fake_read;
+    net.mqttwrite = fake_write;
+    MQTTClientInit(&client, &net, 1000, buf, sizeof(buf), readbuf, sizeof(readbuf));
+    client.isconnected = 1;
+    // MQTTPublish_part checks the ack in the readbuf
+    readbuf[0] = PUBACK << 4;
+    readbuf[1] = 2;
+    readbuf[2] = 0;
+    readbuf[3] = 1;
+    sent_len = 0;
+    sent_packets = 0;
+    packet_left = 0;
+    socket_StubWithCallback(broker_socket);
+    gethostbyname_StubWithCallback(broker_gethostbyname);
+    connect_StubWithCallback(broker_connect);
+    send_StubWithCallback(broker_send);
+    recv_StubWithCallback(broker_recv);
+    soc_close_StubWithCallback(broker_close);
+    setsockopt_IgnoreAndReturn(0);
+    telemetry_serialize_json_StubWithCallback(serialize_cb);
+    wire_len = 0;
+    answer_len = answer_pos = 0;
+    broker_down = 0;
+    broker_publishes = 0;
+    broker_payload[0] = 0x0;
+    serialized = 0;
+}
+
+void tearDown(void) {
+    mqtt_batch_free(&batch);
+    property_types_deinit();
+}
+
+static void telemetry_open(void) {
+    arrow_gateway_init(&gateway);
+    arrow_device_init(&device);
+    arrow_gateway_config_init(&config);
+    property_copy(&gateway.hid, p_const("gateway"));
+    property_copy(&device.hid, p_const("device"));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_telemetry_connect(&gateway, &device, &config));
+}
+
+static void telemetry_close(void) {
+    mqtt_telemetry_terminate();
+    arrow_device_free(&device);
+    arrow_gateway_free(&gateway);
+    arrow_gateway_config_free(&config);
+}
+
+static JsonNode *sample(int i) {
+    JsonNode *_node = json_mkobject();
+    json_append_member(_node, p_const(TELEMETRY_DEVICE_HID), json_mkstring("hid"));
+    json_append_member(_node, p_const("i|counter"), json_mknumber(i));
+    return _node;
+}
+
+// skip the fixed header, topic and packet id
+static const char *sent_payload(void) {
+    int i = 1;
+    while ( sent[i] & 0x80 ) i++;
+    i++;
+    int topic_len = ( sent[i] << 8 ) | sent[i+1];
+    i += 2 + topic_len + 2;
+    sent[sent_len] = 0x0;
+    return (const char *)sent + i;
+}
+
+void test_mqtt_batch_ready_by_count(void) {
+    mqtt_batch_init(&batch, 3, 1000);
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_is_ready(&batch));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_add(&batch, sample(0)));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_add(&batch, sample(1)));
+    TEST_ASSERT_EQUAL_INT(1, mqtt_batch_add(&batch, sample(2)));
+    TEST_ASSERT_EQUAL_INT(3, batch.count);
+}
+
+void test_mqtt_batch_ready_by_age(void) {
+    mqtt_batch_init(&batch, 50, 20);
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_add(&batch, sample(0)));
+    msleep(30);
+    TEST_ASSERT_EQUAL_INT(1, mqtt_batch_is_ready(&batch));
+}
+
+void test_mqtt_batch_publish_array(void) {
+    mqtt_batch_init(&batch, 2, 1000);
+    mqtt_batch_add(&batch, sample(0));
+    TEST_ASSERT_EQUAL_INT(1, mqtt_batch_add(&batch, sample(1)));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_publish(&client, TEST_TOPIC, &batch, mqtt_payload_json));
+    TEST_ASSERT_EQUAL_INT(1, sent_packets);
+    TEST_ASSERT_EQUAL_STRING("[{\"_|deviceHid\":\"hid\",\"i|counter\":0},"
+                             "{\"_|deviceHid\":\"hid\",\"i|counter\":1}]", sent_payload());
+    TEST_ASSERT_EQUAL_INT(0, batch.count);
+    // empty batch is not sent
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_publish(&client, TEST_TOPIC, &batch, mqtt_payload_json));
+    TEST_ASSERT_EQUAL_INT(1, sent_packets);
+}
+
+void test_mqtt_batch_keep_on_fail(void) {
+    mqtt_batch_init(&batch, 2, 1000);
+    mqtt_batch_add(&batch, sample(0));
+    mqtt_batch_add(&batch, sample(1));
+    client.isconnected = 0;
+    TEST_ASSERT(mqtt_batch_publish(&client, TEST_TOPIC, &batch, mqtt_payload_json) < 0);
+    TEST_ASSERT_EQUAL_INT(2, batch.count);
+    // bounded: the oldest sample is dropped
+    TEST_ASSERT_EQUAL_INT(1, mqtt_batch_add(&batch, sample(2)));
+    TEST_ASSERT_EQUAL_INT(2, batch.count);
+    client.isconnected = 1;
+    TEST_ASSERT_EQUAL_INT(0, mqtt_batch_publish(&client, TEST_TOPIC, &batch, mqtt_payload_json));
+    TEST_ASSERT_EQUAL_STRING("[{\"_|deviceHid\":\"hid\",\"i|counter\":1},"
+                             "{\"_|deviceHid\":\"hid\",\"i|counter\":2}]", sent_payload());
+}
+
+void test_mqtt_batch_defaults(void) {
+    mqtt_batch_init(&batch, -1, -1);
+    TEST_ASSERT_EQUAL_INT(MQTT_BATCH_MAX_SAMPLES, batch.max_samples);
+    TEST_ASSERT_EQUAL_INT(MQTT_BATCH_MAX_AGE, batch.max_age);
+}
+
+void test_mqtt_publish_batch_retry(void) {
+    int i;
+    telemetry_open();
+    TEST_ASSERT_EQUAL_INT(0, mqtt_telemetry_set_batch(2, 60000));
+    i = 0;
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(0, broker_publishes);
+    // the broker is gone on the sending, the samples wait for the next try
+    broker_down = 1;
+    i = 1;
+    TEST_ASSERT(mqtt_publish(&device, &i) < 0);
+    TEST_ASSERT_EQUAL_INT(0, broker_publishes);
+    broker_down = 0;
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish_flush());
+    TEST_ASSERT_EQUAL_INT(1, broker_publishes);
+    TEST_ASSERT_EQUAL_STRING("[{\"_|deviceHid\":\"hid\",\"i|counter\":0},"
+                             "{\"_|deviceHid\":\"hid\",\"i|counter\":1}]", broker_payload);
+    // the flush of the empty batch sends nothing
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish_flush());
+    TEST_ASSERT_EQUAL_INT(1, broker_publishes);
+    telemetry_close();
+}
+
+void test_mqtt_publish_batch_age(void) {
+    int i = 7;
+    telemetry_open();
+    TEST_ASSERT_EQUAL_INT(0, mqtt_telemetry_set_batch(50, 20));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish_poll());
+    TEST_ASSERT_EQUAL_INT(0, broker_publishes);
+    // no new samples, the old batch goes by the poll
+    msleep(30);
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish_poll());
+    TEST_ASSERT_EQUAL_INT(1, broker_publishes);
+    TEST_ASSERT_EQUAL_STRING("[{\"_|deviceHid\":\"hid\",\"i|counter\":7}]", broker_payload);
+    telemetry_close();
+}
+
+void test_mqtt_publish_filter_retry(void) {
+    static telemetry_filter_rule_t rules[] = {
+        TELEMETRY_FILTER_RULE("i|counter", 0.0, 0.0)
+    };
+    static telemetry_filter_t filter;
+    int i = 1;
+    telemetry_open();
+    telemetry_filter_init(&filter, rules, 1, 0, 0);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_register(&device, &filter));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(1, broker_publishes);
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(1, broker_publishes);
+    // the changed sample isn't delivered, so it isn't the reference yet
+    i = 2;
+    broker_down = 1;
+    TEST_ASSERT(mqtt_publish(&device, &i) < 0);
+    broker_down = 0;
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(2, broker_publishes);
+    TEST_ASSERT_EQUAL_STRING("{\"_|deviceHid\":\"hid\",\"i|counter\":2}", broker_payload);
+    telemetry_filter_unregister(&device);
+    telemetry_close();
+}
+
+static int counter_value(void *data, const char *key, double *val) {
+    if ( strcmp(key, "i|counter") ) return -1;
+    *val = *(int *)data;
+    return telemetry_value_number;
+}
+
+void test_mqtt_publish_filter_raw(void) {
+    static telemetry_filter_rule_t rules[] = {
+        TELEMETRY_FILTER_RULE("i|counter", 5.0, 0.0)
+    };
+    static telemetry_filter_t filter;
+    int i = 1;
+    telemetry_open();
+    telemetry_filter_init(&filter, rules, 1, 0, 0);
+    filter.value = counter_value;
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_register(&device, &filter));
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(1, serialized);
+    // the dropped samples aren't serialized
+    for ( i = 2; i < 6; i++ ) TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(1, serialized);
+    TEST_ASSERT_EQUAL_INT(1, broker_publishes);
+    i = 7;
+    TEST_ASSERT_EQUAL_INT(0, mqtt_publish(&device, &i));
+    TEST_ASSERT_EQUAL_INT(2, serialized);
+    TEST_ASSERT_EQUAL_INT(2, broker_publishes);
+    TEST_ASSERT_EQUAL_STRING("{\"_|deviceHid\":\"hid\",\"i|counter\":7}", broker_payload);
+    telemetry_filter_unregister(&device);
+    telemetry_close();
+}
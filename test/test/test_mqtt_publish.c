@@ -0,0 +1,267 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <arrow/mqtt.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include <time/time.h>
+#include "acnsdkc_time.h"
+
+#include "mock_sockdecl.h"
+#include "mock_watchdog.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+#define TEST_TOPIC "krs.tel.gts.test"
+
+// fake broker: keep the stream, count the write calls and the bytes
+// which went through the client send buffer
+static unsigned char stream[70000];
+static int stream_len = 0;
+static int writes = 0;
+static long staged = 0;
+static int max_write = 0;
+
+static Network net;
+static MQTTClient client;
+static unsigned char buf[MQTT_BUF_LEN];
+static unsigned char readbuf[MQTT_RECVBUF_LEN];
+
+static void take(const unsigned char *p, int len) {
+    if ( p >= buf && p < buf + sizeof(buf) ) staged += len;
+    if ( stream_len + len <= (int)sizeof(stream) ) {
+        memcpy(stream + stream_len, p, len);
+        stream_len += len;
+    }
+}
+
+static int fake_write(Network *n, unsigned char *p, int len, int timeout) {
+    (void)n; (void)timeout;
+    writes++;
+    if ( max_write && len > max_write ) len = max_write;
+    take(p, len);
+    return len;
+}
+
+static int fake_writev(Network *n, socket_iovec_t *iov, int cnt, int timeout) {
+    int i;
+    int sent = 0;
+    (void)n; (void)timeout;
+    writes++;
+    for ( i = 0; i < cnt; i++ ) {
+        int len = (int)iov[i].len;
+        if ( max_write && sent + len > max_write ) len = max_write - sent;
+        take((const unsigned char *)iov[i].base, len);
+        sent += len;
+        if ( len < (int)iov[i].len ) break;
+    }
+    return sent;
+}
+
+static int fake_read(Network *n, unsigned char *p, int len, int timeout) {
+    (void)n; (void)p; (void)len; (void)timeout;
+    return 0;
+}
+
+// the encoder writes the payload right into the buffer given
+static const char *drive_src = NULL;
+static int drive_len = 0;
+static int drive_pos = 0;
+
+static int drive_init(void) {
+    drive_pos = 0;
+    return drive_len;
+}
+
+static int drive_part(char *out, int len) {
+    if ( len > drive_len - drive_pos ) len = drive_len - drive_pos;
+    memcpy(out, drive_src + drive_pos, len);
+    drive_pos += len;
+    return len;
+}
+
+static int drive_fin(void) {
+    return 0;
+}
+
+static mqtt_payload_drive_t test_drive = { drive_init, drive_part, drive_fin };
+
+static char payload[65536];
+
+void setUp(void) {
+    int i;
+    net.mqttread = fake_read;
+    net.mqttwrite = fake_write;
+    net.mqttwritev = fake_writev;
+    MQTTClientInit(&client, &net, 1000, buf, sizeof(buf), readbuf, sizeof(readbuf));
+    client.isconnected = 1;
+    for ( i = 0; i < (int)sizeof(payload); i++ ) payload[i] = 'a' + i % 26;
+    stream_len = 0;
+    writes = 0;
+    staged = 0;
+    max_write = 0;
+}
+
+void tearDown(void) {
+}
+
+static int expected_packet(unsigned char *out, int outlen, int len) {
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = TEST_TOPIC;
+    return MQTTSerialize_publish(out, outlen, 0, QOS0, 0, 0, topic,
+                                 (unsigned char *)payload, len);
+}
+
+static int publish(int len) {
+    MQTTMessage msg;
+    memset(&msg, 0x0, sizeof(msg));
+    msg.qos = QOS0;
+    msg.payload = payload;
+    msg.payloadlen = len;
+    return MQTTPublish(&client, TEST_TOPIC, &msg);
+}
+
+static int publish_part(int len) {
+    MQTTMessage msg;
+    memset(&msg, 0x0, sizeof(msg));
+    msg.qos = QOS0;
+    drive_src = payload;
+    drive_len = len;
+    return MQTTPublish_part(&client, TEST_TOPIC, &msg, &test_drive);
+}
+
+void test_mqtt_publish_header(void) {
+    static unsigned char packet[5000];
+    unsigned char head[32];
+    MQTTString topic = MQTTString_initializer;
+    topic.cstring = TEST_TOPIC;
+    int len = expected_packet(packet, sizeof(packet), 4000);
+    int hlen = MQTTSerialize_publishHeader(head, sizeof(head), 0, QOS0, 0, 0, topic, 4000);
+    // 1 byte type, 2 bytes of the remaining length, the topic
+    TEST_ASSERT_EQUAL_INT(1 + 2 + 2 + (int)strlen(TEST_TOPIC), hlen);
+    TEST_ASSERT_EQUAL_INT(len, hlen + 4000);
+    TEST_ASSERT_EQUAL_MEMORY(packet, head, hlen);
+    // the buffer is checked for the header only
+    TEST_ASSERT(MQTTSerialize_publishHeader(head, hlen - 1, 0, QOS0, 0, 0, topic, 4000) <= 0);
+}
+
+void test_mqtt_publish_zero_copy(void) {
+    static unsigned char packet[5000];
+    int len = expected_packet(packet, sizeof(packet), 4000);
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish(4000));
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_INT(len - 4000, staged);
+    TEST_ASSERT_EQUAL_INT(len, stream_len);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+}
+
+void test_mqtt_publish_short_writes(void) {
+    static unsigned char packet[5000];
+    int len = expected_packet(packet, sizeof(packet), 1000);
+    max_write = 7;
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish(1000));
+    TEST_ASSERT_EQUAL_INT(len, stream_len);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+    // no writev: the vectors one by one
+    setUp();
+    net.mqttwritev = NULL;
+    max_write = 7;
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish(1000));
+    TEST_ASSERT_EQUAL_INT(len, stream_len);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+}
+
+void test_mqtt_publish_no_writev(void) {
+    static unsigned char packet[5000];
+    int len = expected_packet(packet, sizeof(packet), 100);
+    // TLS: the small packet is gathered into the one record
+    net.mqttwritev = NULL;
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish(100));
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_INT(len, staged);
+    TEST_ASSERT_EQUAL_INT(len, stream_len);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+    // the larger one than the buffer goes by the vectors
+    setUp();
+    net.mqttwritev = NULL;
+    len = expected_packet(packet, sizeof(packet), 4000);
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish(4000));
+    TEST_ASSERT_EQUAL_INT(2, writes);
+    TEST_ASSERT_EQUAL_INT(len, stream_len);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+}
+
+void test_mqtt_publish_part_with_header(void) {
+    static unsigned char packet[5000];
+    int len = expected_packet(packet, sizeof(packet), 1000);
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish_part(1000));
+    // the header goes with the first part of the payload
+    TEST_ASSERT_EQUAL_INT(( len + MQTT_BUF_LEN - 1 ) / MQTT_BUF_LEN, writes);
+    TEST_ASSERT_EQUAL_INT(len, stream_len);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+    // the small one is the one write
+    setUp();
+    len = expected_packet(packet, sizeof(packet), 100);
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, publish_part(100));
+    TEST_ASSERT_EQUAL_INT(1, writes);
+    TEST_ASSERT_EQUAL_MEMORY(packet, stream, len);
+}
@@ -0,0 +1,418 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <config.h>
+#include <debug.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <bsd/socket.h>
+#include <bsd/byteorder.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <arrow/reactor.h>
+#include <ntp/sync.h>
+#include <data/linkedlist.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+#include "mock_watchdog.h"
+#include "mock_storage.h"
+
+#include "acnsdkc_time.h"
+
+// The NTP client against the server stand-ins on the loopback:
+// a thread per server answers by the local clock and the offset,
+// the answer may be late on the request or the return path.
+
+#define LOCALHOST      "127.0.0.1"
+#define SERVER_OFFSET  2500000LL
+#define WAIT_MS        1000
+
+time_t timegm(struct tm *tm);
+
+// the platform part over the Linux sockets: the SDK sockaddr has the BSD
+// layout (sin_len and the byte of the family) and its own MSG_DONTWAIT
+#define OS_MSG_DONTWAIT 0x40
+#define OS_ADDR_LEN     16
+
+static void addr_to_os(uint8_t *os, const struct sockaddr *a) {
+    uint16_t family = ((const struct sockaddr_in *)a)->sin_family;
+    memcpy(os, a, OS_ADDR_LEN);
+    memcpy(os, &family, sizeof(family));
+}
+
+static void addr_from_os(struct sockaddr *a, const uint8_t *os) {
+    uint16_t family;
+    memcpy(&family, os, sizeof(family));
+    memcpy(a, os, OS_ADDR_LEN);
+    ((struct sockaddr_in *)a)->sin_len = OS_ADDR_LEN;
+    ((struct sockaddr_in *)a)->sin_family = (uint8_t)family;
+}
+
+ssize_t sendto(int sock, const void *buf, size_t len, int flags,
+               const struct sockaddr *to, socklen_t tolen) {
+    uint8_t os[OS_ADDR_LEN];
+    (void)tolen;
+    addr_to_os(os, to);
+    return syscall(SYS_sendto, sock, buf, len, flags ? OS_MSG_DONTWAIT : 0, os, sizeof(os));
+}
+
+ssize_t recvfrom(int sock, void *buf, size_t size, int flags,
+                 struct sockaddr *from, socklen_t *fromlen) {
+    uint8_t os[OS_ADDR_LEN];
+    uint32_t oslen = sizeof(os);
+    ssize_t r = syscall(SYS_recvfrom, sock, buf, size,
+                        ( flags & MSG_DONTWAIT ) ? OS_MSG_DONTWAIT : 0, os, &oslen);
+    if ( r >= 0 && from ) {
+        addr_from_os(from, os);
+        *fromlen = OS_ADDR_LEN;
+    }
+    return r;
+}
+
+int bind(int sock, const struct sockaddr *addr, socklen_t addrlen) {
+    uint8_t os[OS_ADDR_LEN];
+    (void)addrlen;
+    addr_to_os(os, addr);
+    return (int)syscall(SYS_bind, sock, os, sizeof(os));
+}
+
+void soc_close(int sock) {
+    close(sock);
+}
+
+static uint16_t local_port(int sock) {
+    uint8_t os[OS_ADDR_LEN];
+    uint32_t oslen = sizeof(os);
+    if ( syscall(SYS_getsockname, sock, os, &oslen) < 0 ) return 0;
+    return be16_get(os + 2);
+}
+
+static int64_t real_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void ts_put(uint8_t *p, int64_t us) {
+    be32_put(p, (uint32_t)( us / 1000000 + 2208988800LL ));
+    be32_put(p + 4, (uint32_t)( ( (uint64_t)( us % 1000000 ) << 32 ) / 1000000 ));
+}
+
+typedef struct _responder_ {
+    int sock;
+    uint16_t port;
+    int64_t offset_us;
+    int pre_ms;         // the late stamps, the request path
+    int delay_ms[4];    // the late answer by the request, the return path
+    int mute;
+    volatile int requests;
+    volatile int stop;
+    pthread_t th;
+} responder_t;
+
+static responder_t resp[2];
+static ntp_sync_t sync_cli;
+
+static void *responder_loop(void *arg) {
+    responder_t *r = (responder_t *)arg;
+    uint8_t pkt[NTP_PACKET_LEN];
+    struct sockaddr_in from;
+    socklen_t fromlen;
+    struct pollfd pfd;
+    while ( !r->stop ) {
+        int64_t t;
+        int n;
+        pfd.fd = r->sock;
+        pfd.events = POLLIN;
+        if ( poll(&pfd, 1, 20) <= 0 ) continue;
+        fromlen = sizeof(from);
+        if ( recvfrom(r->sock, pkt, sizeof(pkt), 0,
+                      (struct sockaddr *)&from, &fromlen) != NTP_PACKET_LEN ) continue;
+        n = r->requests++;
+        if ( r->mute ) continue;
+        if ( r->pre_ms ) usleep((useconds_t)r->pre_ms * 1000);
+        memcpy(pkt + 24, pkt + 40, 8);
+        pkt[0] = ( 4 << 3 ) | 4;
+        pkt[1] = 2;
+        t = real_us() + r->offset_us;
+        ts_put(pkt + 32, t);
+        ts_put(pkt + 40, t);
+        if ( r->delay_ms[n % 4] ) usleep((useconds_t)r->delay_ms[n % 4] * 1000);
+        sendto(r->sock, pkt, sizeof(pkt), 0, (struct sockaddr *)&from, sizeof(from));
+    }
+    return NULL;
+}
+
+static void responder_start(responder_t *r) {
+    struct sockaddr_in addr;
+    memset(&addr, 0x0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(0x7f000001UL);
+    r->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT(r->sock >= 0);
+    TEST_ASSERT_EQUAL_INT(0, bind(r->sock, (struct sockaddr *)&addr, sizeof(addr)));
+    r->port = local_port(r->sock);
+    TEST_ASSERT(r->port);
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&r->th, NULL, responder_loop, r));
+}
+
+// the poll round by the answers or the timeout
+static void wait_round(ntp_sync_t *s) {
+    uint32_t start = time_mono_ms();
+    struct pollfd pfd;
+    while ( s->polling && time_mono_diff(time_mono_ms(), start) < WAIT_MS ) {
+        pfd.fd = s->sock;
+        pfd.events = POLLIN;
+        if ( poll(&pfd, 1, 10) > 0 ) ntp_sync_input(s);
+        ntp_sync_step(s, time_mono_ms());
+    }
+    TEST_ASSERT_FALSE(s->polling);
+}
+
+static int64_t target_err_us(ntp_sync_t *s, int64_t offset_us) {
+    return ntp_clock_target(&s->clock, time_mono_ms()) - ( real_us() + offset_us );
+}
+
+void setUp(void) {
+    memset(resp, 0x0, sizeof(resp));
+    resp[0].sock = resp[1].sock = -1;
+    ntp_sync_init(&sync_cli);
+}
+
+void tearDown(void) {
+    int i;
+    ntp_sync_set_source(NULL);
+    ntp_sync_close(&sync_cli);
+    for ( i = 0; i < 2; i++ ) {
+        if ( resp[i].sock < 0 ) continue;
+        resp[i].stop = 1;
+        pthread_join(resp[i].th, NULL);
+        close(resp[i].sock);
+    }
+}
+
+// the server of the least delay wins, the other one is late and wrong
+void test_ntp_sync_servers(void) {
+    uint32_t start;
+    resp[0].offset_us = SERVER_OFFSET;
+    resp[1].offset_us = SERVER_OFFSET + 300000;
+    resp[1].pre_ms = 40;
+    responder_start(resp);
+    responder_start(resp + 1);
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[0].port));
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[1].port));
+    TEST_ASSERT_FALSE(ntp_sync_is_synced(&sync_cli));
+
+    // the requests are sent, nothing waits for the answers
+    start = time_mono_ms();
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_poll(&sync_cli));
+    TEST_ASSERT(time_mono_diff(time_mono_ms(), start) < 20);
+    TEST_ASSERT_TRUE(sync_cli.polling);
+    TEST_ASSERT(ntp_sync_input(&sync_cli) >= 0);
+
+    wait_round(&sync_cli);
+    TEST_ASSERT_TRUE(ntp_sync_is_synced(&sync_cli));
+    TEST_ASSERT_EQUAL_INT(1, sync_cli.server[0].reach);
+    TEST_ASSERT_EQUAL_INT(1, sync_cli.server[1].reach);
+    TEST_ASSERT(sync_cli.server[1].sample[0].delay_us >= 35000);
+    TEST_ASSERT_INT_WITHIN(15000, 0, target_err_us(&sync_cli, SERVER_OFFSET));
+    // the first sync is the step
+    TEST_ASSERT_EQUAL_INT(0, (int)sync_cli.clock.slew_us);
+    TEST_ASSERT_INT_WITHIN(50, (int)sync_cli.poll_ms,
+                           time_mono_diff(sync_cli.next_ms, time_mono_ms()));
+}
+
+// the late answers are filtered by the delay, the small offsets are slewed
+void test_ntp_sync_filter(void) {
+    int i;
+    resp[0].offset_us = -1500000LL;
+    resp[0].delay_ms[0] = 80;
+    resp[0].delay_ms[1] = 40;
+    resp[0].delay_ms[2] = 0;
+    resp[0].delay_ms[3] = 60;
+    responder_start(resp);
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[0].port));
+
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_poll(&sync_cli));
+    wait_round(&sync_cli);
+    // the half of the return path is the error
+    TEST_ASSERT_INT_WITHIN(15000, -40000, target_err_us(&sync_cli, resp[0].offset_us));
+
+    for ( i = 1; i < 4; i++ ) {
+        TEST_ASSERT_EQUAL_INT(0, ntp_sync_poll(&sync_cli));
+        wait_round(&sync_cli);
+    }
+    TEST_ASSERT_EQUAL_INT(4, sync_cli.server[0].count);
+    TEST_ASSERT_EQUAL_INT(0xf, sync_cli.server[0].reach);
+    TEST_ASSERT_INT_WITHIN(10000, 0, target_err_us(&sync_cli, resp[0].offset_us));
+    // the clock goes to the target by the slew, it isn't stepped
+    TEST_ASSERT(sync_cli.clock.slew_us > 20000);
+    TEST_ASSERT_INT_WITHIN(2000, (int)sync_cli.clock.slew_us,
+                           (int)( ntp_clock_target(&sync_cli.clock, time_mono_ms()) -
+                                  ntp_clock_now(&sync_cli.clock, time_mono_ms()) ));
+}
+
+void test_ntp_sync_timeout(void) {
+    uint32_t now;
+    resp[0].mute = 1;
+    resp[1].offset_us = SERVER_OFFSET;
+    responder_start(resp);
+    responder_start(resp + 1);
+    sync_cli.timeout_ms = 100;
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[0].port));
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[1].port));
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_poll(&sync_cli));
+    wait_round(&sync_cli);
+    now = time_mono_ms();
+    TEST_ASSERT_TRUE(ntp_sync_is_synced(&sync_cli));
+    TEST_ASSERT_EQUAL_INT(0, sync_cli.server[0].reach);
+    TEST_ASSERT_EQUAL_INT(1, sync_cli.server[1].reach);
+    TEST_ASSERT_INT_WITHIN(15000, 0, target_err_us(&sync_cli, SERVER_OFFSET));
+    TEST_ASSERT_INT_WITHIN(50, (int)sync_cli.poll_ms, time_mono_diff(sync_cli.next_ms, now));
+
+    // no answer at all: the retry comes sooner
+    ntp_sync_close(&sync_cli);
+    ntp_sync_init(&sync_cli);
+    sync_cli.timeout_ms = 100;
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[0].port));
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_poll(&sync_cli));
+    wait_round(&sync_cli);
+    now = time_mono_ms();
+    TEST_ASSERT_FALSE(ntp_sync_is_synced(&sync_cli));
+    TEST_ASSERT_INT_WITHIN(50, NTP_SYNC_RETRY_MS, time_mono_diff(sync_cli.next_ms, now));
+    TEST_ASSERT_EQUAL_INT(2, resp[0].requests);
+}
+
+// the ticks are 50 ppm slow against the server
+static int64_t drift_server_us(uint32_t m) {
+    return 1500000000000000LL + 3000000 + (int64_t)m * 1000 + (int64_t)m * 50 / 1000;
+}
+
+void test_ntp_clock_drift(void) {
+    ntp_clock_t c;
+    int64_t prev;
+    uint32_t m = 0;
+    int k;
+    ntp_clock_init(&c, 1500000000000000LL, 0);
+    TEST_ASSERT_EQUAL_INT(1, ntp_clock_adjust(&c, drift_server_us(0) - ntp_clock_target(&c, 0), 0, 0));
+    for ( k = 1; k <= 20; k++ ) {
+        m = (uint32_t)k * NTP_SYNC_POLL_MS;
+        TEST_ASSERT_EQUAL_INT(0, ntp_clock_adjust(&c, drift_server_us(m) - ntp_clock_target(&c, m), m, m));
+    }
+    TEST_ASSERT_INT_WITHIN(100, 50000, c.freq_ppb);
+
+    // the slew goes the limited rate and the clock never goes back
+    m += 1000;
+    TEST_ASSERT_EQUAL_INT(0, ntp_clock_adjust(&c, -50000, m, m));
+    prev = ntp_clock_now(&c, m);
+    for ( k = 0; k < 10000; k++ ) {
+        int64_t t = ntp_clock_now(&c, ++m);
+        TEST_ASSERT(t - prev >= 999 && t - prev <= 1001);
+        prev = t;
+    }
+    ntp_clock_rebase(&c, m);
+    TEST_ASSERT_INT_WITHIN(10, -45000, (int)c.slew_us);
+    // the rest goes in 90 s
+    m += 90000;
+    TEST_ASSERT_INT_WITHIN(1000, 0, (int)( ntp_clock_now(&c, m) - ( drift_server_us(m) - 50000 ) ));
+    TEST_ASSERT(ntp_clock_now(&c, m) == ntp_clock_target(&c, m));
+
+    // the large offset is stepped
+    TEST_ASSERT_EQUAL_INT(1, ntp_clock_adjust(&c, 1000000, m, m));
+    TEST_ASSERT_INT_WITHIN(1000, 0, (int)( ntp_clock_now(&c, m) - ( drift_server_us(m) + 950000 ) ));
+}
+
+// the reactor polls the server by the timer, the timestamp goes by the client
+void test_ntp_sync_reactor(void) {
+    uint32_t start;
+    struct timeval tv;
+    timestamp_t ts;
+    struct tm tm;
+    int64_t offset = 86400LL * 1000000 + SERVER_OFFSET;
+    resp[0].offset_us = offset;
+    responder_start(resp);
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_add_server(&sync_cli, LOCALHOST, resp[0].port));
+    sync_cli.poll_ms = 300;
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_init());
+    TEST_ASSERT_EQUAL_INT(0, ntp_sync_attach(&sync_cli));
+    start = time_mono_ms();
+    while ( time_mono_diff(time_mono_ms(), start) < 1300 ) {
+        TEST_ASSERT(arrow_reactor_run_once(50) >= 0);
+    }
+    ntp_sync_detach(&sync_cli);
+    arrow_reactor_done();
+    TEST_ASSERT(resp[0].requests >= 3);
+    TEST_ASSERT_TRUE(ntp_sync_is_synced(&sync_cli));
+
+    // the wall clock is the same, the source is the client one
+    ntp_clock_gettimeofday(&tv);
+    TEST_ASSERT_INT_WITHIN(2000000, 0, (int)( (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - real_us() ));
+    ntp_sync_set_source(&sync_cli);
+    ntp_clock_gettimeofday(&tv);
+    TEST_ASSERT_INT_WITHIN(20000, 0, (int)( (int64_t)tv.tv_sec * 1000000 + tv.tv_usec -
+                                             ( real_us() + offset ) ));
+    ntp_clock_timestamp(&ts);
+    memset(&tm, 0x0, sizeof(tm));
+    tm.tm_year = ts.year - 1900;
+    tm.tm_mon = ts.mon - 1;
+    tm.tm_mday = ts.day;
+    tm.tm_hour = ts.hour;
+    tm.tm_min = ts.min;
+    tm.tm_sec = ts.sec;
+    TEST_ASSERT_INT_WITHIN(2, (int)( ( real_us() + offset ) / 1000000 ), (int)timegm(&tm));
+}
@@ -0,0 +1,302 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/routine.h>
+#include <arrow/utf8.h>
+#include <arrow/ota_verify.h>
+#include <arrow/software_release.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_intern.h>
+#include <http/client.h>
+#include <ssl/crypt.h>
+#include <ssl/md5sum.h>
+#include <bsd/socket.h>
+#include <json/property_json.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_api.h>
+#include "api_device_device.h"
+#include "api_gateway_gateway.h"
+#include "api_gateway_info.h"
+#include <arrow/api/device/info.h>
+#include <arrow/api/device/event.h>
+#include <arrow/api/log.h>
+#include <arrow/api/json/page.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_update.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+
+#include "acnsdkc_time.h"
+#include "mock_mac.h"
+#include "mock_watchdog.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+#include "fakedns.h"
+
+// The image is served by the fake socket by the pieces the client asks,
+// the verifier hashes every piece on the way to the download callback.
+
+#define IMAGE_SIZE     ( 256 * 1024 )
+
+static char *image = NULL;
+static char head[256];
+static int head_len = 0;
+static int body_len = 0;
+static int served = 0;
+
+static uint32_t payload_bytes = 0;
+static int payload_calls = 0;
+static int payload_first = 0;
+static int complete_result = -1;
+static int complete_calls = 0;
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 0;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)buf; (void)flags; (void)num;
+    return len;
+}
+
+// the header, then the body of the image
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    int size = head_len + body_len - served;
+    if ( size <= 0 ) return -1;
+    if ( size > (int)len ) size = len;
+    if ( served < head_len ) {
+        if ( size > head_len - served ) size = head_len - served;
+        memcpy(buf, head + served, size);
+    } else {
+        memcpy(buf, image + served - head_len, size);
+    }
+    served += size;
+    return size;
+}
+
+static void serve(int code, int content_length, int len) {
+    head_len = sprintf(head, "HTTP/1.1 %d OK\r\n"
+                             "Content-Type: application/octet-stream\r\n"
+                             "Content-Length: %d\r\n\r\n", code, content_length);
+    body_len = len;
+    served = 0;
+}
+
+static int payload_cb(const char *data, int len, int flag) {
+    (void)data;
+    if ( flag == FW_FIRST ) payload_first++;
+    payload_calls++;
+    payload_bytes += (uint32_t)len;
+    return 0;
+}
+
+static int complete_cb(int result) {
+    complete_calls++;
+    complete_result = result;
+    return result == FW_SUCCESS ? 0 : -1;
+}
+
+static void make_image(int size) {
+    uint32_t x = 0x12345678;
+    int i;
+    for ( i = 0; i < size; i++ ) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        image[i] = (char)x;
+    }
+}
+
+static void sha256_hex(char *hex, int size) {
+    char dig[32];
+    sha256(dig, image, size);
+    hex_encode(hex, dig, 32);
+    hex[64] = 0x0;
+}
+
+static void md5_hex(char *hex, int size) {
+    char dig[16];
+    md5sum(dig, image, size);
+    hex_encode(hex, dig, 16);
+    hex[32] = 0x0;
+}
+
+static int download(const char *checksum) {
+    payload_bytes = 0;
+    payload_calls = 0;
+    payload_first = 0;
+    complete_calls = 0;
+    complete_result = -1;
+    return arrow_software_release_download("token", "trans", checksum);
+}
+
+void setUp(void) {
+    arrow_init();
+    image = malloc(IMAGE_SIZE);
+    make_image(IMAGE_SIZE);
+    arrow_software_release_dowload_set_cb(NULL, payload_cb, complete_cb);
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    soc_close_Ignore();
+    wdt_feed_IgnoreAndReturn(0);
+}
+
+void tearDown(void) {
+    free(image);
+    arrow_deinit();
+}
+
+void test_ota_verify_checksum(void) {
+    ota_verify_t v;
+    char hex[66];
+    TEST_ASSERT_EQUAL_INT(-1, ota_verify_init(&v, "abcdef", 0));
+    TEST_ASSERT_EQUAL_INT(-1, ota_verify_init(&v, NULL, 0));
+    // SHA-256 by the pieces
+    sha256_hex(hex, 1000);
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 0));
+    TEST_ASSERT_EQUAL_INT(ota_hash_sha256, v.hash);
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_begin(&v, 1000));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image, 1));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image + 1, 600));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image + 601, 399));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_final(&v));
+    // MD5
+    md5_hex(hex, 1000);
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 0));
+    TEST_ASSERT_EQUAL_INT(ota_hash_md5, v.hash);
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_begin(&v, 0));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image, 1000));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_final(&v));
+    // one bit
+    image[500] ^= 0x10;
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 0));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_begin(&v, 0));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image, 1000));
+    TEST_ASSERT_EQUAL_INT(-2, ota_verify_final(&v));
+}
+
+void test_ota_verify_size(void) {
+    ota_verify_t v;
+    char hex[66];
+    sha256_hex(hex, 100);
+    // too large by the Content-Length
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 100));
+    TEST_ASSERT_EQUAL_INT(-1, ota_verify_begin(&v, 101));
+    // too large by the data
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 100));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_begin(&v, 0));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image, 60));
+    TEST_ASSERT_EQUAL_INT(-1, ota_verify_update(&v, image + 60, 60));
+    // longer than announced
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 0));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_begin(&v, 50));
+    TEST_ASSERT_EQUAL_INT(-1, ota_verify_update(&v, image, 100));
+    // truncated
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_init(&v, hex, 0));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_begin(&v, 100));
+    TEST_ASSERT_EQUAL_INT(0, ota_verify_update(&v, image, 99));
+    TEST_ASSERT_EQUAL_INT(-1, ota_verify_final(&v));
+}
+
+void test_ota_download(void) {
+    char hex[66];
+    sha256_hex(hex, IMAGE_SIZE);
+    serve(200, IMAGE_SIZE, IMAGE_SIZE);
+    TEST_ASSERT_EQUAL_INT(0, download(hex));
+    TEST_ASSERT_EQUAL_INT(1, complete_calls);
+    TEST_ASSERT_EQUAL_INT(FW_SUCCESS, complete_result);
+    TEST_ASSERT_EQUAL_INT(IMAGE_SIZE, payload_bytes);
+    TEST_ASSERT_EQUAL_INT(1, payload_first);
+    TEST_ASSERT(payload_calls > 1);
+    // the other image
+    md5_hex(hex, IMAGE_SIZE - 1);
+    serve(200, IMAGE_SIZE, IMAGE_SIZE);
+    TEST_ASSERT(download(hex) < 0);
+    TEST_ASSERT_EQUAL_INT(FW_MD5SUM, complete_result);
+}
+
+void test_ota_download_rejected(void) {
+    char hex[66];
+    sha256_hex(hex, IMAGE_SIZE);
+    // the error page isn't passed as the image
+    serve(404, IMAGE_SIZE, IMAGE_SIZE);
+    TEST_ASSERT(download(hex) < 0);
+    TEST_ASSERT_EQUAL_INT(0, payload_calls);
+    TEST_ASSERT_EQUAL_INT(0, complete_calls);
+    // the connection is broken in the middle
+    serve(200, IMAGE_SIZE, IMAGE_SIZE / 2);
+    TEST_ASSERT(download(hex) < 0);
+    TEST_ASSERT(payload_bytes < IMAGE_SIZE);
+    TEST_ASSERT(complete_result != FW_SUCCESS);
+}
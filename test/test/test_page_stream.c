@@ -0,0 +1,357 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/routine.h>
+#include <arrow/api/device/device.h>
+#include <arrow/api/gateway/gateway.h>
+#include <arrow/api/json/page.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <http/client.h>
+#include <bsd/socket.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_api.h>
+#include "api_device_device.h"
+#include "api_gateway_gateway.h"
+#include "api_gateway_info.h"
+#include <arrow/api/device/info.h>
+#include <arrow/api/device/event.h>
+#include <arrow/api/log.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+
+#include "acnsdkc_time.h"
+#include "mock_mac.h"
+#include "mock_watchdog.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+#include "fakedns.h"
+
+// The list pages are made by the fake socket element by element,
+// so the answer isn't kept by the test.
+
+enum { list_devices, list_logs };
+
+// the fake server
+static int list_kind = list_devices;
+static int list_total = 0;
+static int list_size = 0;
+static int list_code = 200;
+static int list_page = 0;
+static int requests = 0;
+static int pages_asked[16];
+static char request_line[256];
+
+static char piece[1024];
+static int piece_len = 0;
+static int piece_pos = 0;
+static int piece_next = 0;
+static int piece_count = 0;
+
+static arrow_device_t dev;
+
+static int total_pages(void) {
+    return ( list_total + list_size - 1 ) / list_size;
+}
+
+static int page_items(void) {
+    int rest = list_total - list_page * list_size;
+    if ( rest < 0 ) return 0;
+    return rest < list_size ? rest : list_size;
+}
+
+static int make_item(char *s, int i) {
+    if ( list_kind == list_logs ) {
+        return sprintf(s, "{\"productName\":\"acn\",\"type\":\"DeviceUpdated\",\"objectHid\":\"hid%06d\","
+                          "\"createdDate\":\"2018-05-21T13:40:32.173Z\",\"createdBy\":\"admin\","
+                          "\"parameters\":{\"n\":%d,\"list\":[]}}", i, i);
+    }
+    // the name with the quotes and the braces
+    return sprintf(s, "{\"hid\":\"hid%06d\",\"uid\":\"uid-%d\",\"name\":\"device \\\"%d\\\" {]\","
+                      "\"type\":\"sensor\",\"gatewayHid\":\"gw\",\"enabled\":true,"
+                      "\"createdDate\":\"2018-05-21T13:40:32.173Z\",\"createdBy\":\"admin\","
+                      "\"lastModifiedDate\":\"2018-05-21T13:40:32.173Z\",\"lastModifiedBy\":\"admin\","
+                      "\"info\":{\"fw\":\"1.%d\",\"tags\":[]},\"properties\":{},\"links\":{}}", i, i, i, i);
+}
+
+// 0 - the top, 1..n - the elements, n+1 - the end
+static int make_piece(char *s, int n) {
+    int items = page_items();
+    if ( n == 0 ) return sprintf(s, "{\"size\":%d,\"page\":%d,\"totalSize\":%d,\"totalPages\":%d,\"data\":[",
+                                 items, list_page, list_total, total_pages());
+    if ( n <= items ) {
+        int len = n > 1 ? sprintf(s, ",") : 0;
+        return len + make_item(s + len, list_page * list_size + n - 1);
+    }
+    return sprintf(s, "]}");
+}
+
+static void answer(void) {
+    int body = 0;
+    int i;
+    piece_count = page_items() + 2;
+    for ( i = 0; i < piece_count; i++ ) body += make_piece(piece, i);
+    piece_len = sprintf(piece, "HTTP/1.1 %d OK\r\nContent-Type: application/json\r\n"
+                               "Content-Length: %d\r\n\r\n", list_code, body);
+    piece_pos = 0;
+    piece_next = 0;
+}
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 0;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    if ( len > 4 && strncmp(buf, "GET ", 4) == 0 ) {
+        int n = len < sizeof(request_line) - 1 ? (int)len : (int)sizeof(request_line) - 1;
+        memcpy(request_line, buf, n);
+        request_line[n] = 0x0;
+        char *p = strstr(request_line, "_page=");
+        list_page = p ? atoi(p + 6) : 0;
+        if ( requests < 16 ) pages_asked[requests] = list_page;
+        requests++;
+        answer();
+    }
+    return len;
+}
+
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    if ( piece_pos >= piece_len ) {
+        if ( piece_next >= piece_count ) return -1;
+        piece_len = make_piece(piece, piece_next++);
+        piece_pos = 0;
+    }
+    int size = piece_len - piece_pos;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, piece + piece_pos, size);
+    piece_pos += size;
+    return size;
+}
+
+static void serve(int kind, int total, int size) {
+    list_kind = kind;
+    list_total = total;
+    list_size = size;
+    list_code = 200;
+    requests = 0;
+}
+
+typedef struct {
+    int count;
+    int stop;
+    int bad;
+} seen_t;
+
+static int device_cb(device_info_t *info, void *arg) {
+    seen_t *s = (seen_t *)arg;
+    char hid[16];
+    char name[32];
+    sprintf(hid, "hid%06d", s->count);
+    sprintf(name, "device \"%d\" {]", s->count);
+    if ( strcmp(hid, P_VALUE(info->hid)) || strcmp(name, P_VALUE(info->name)) ||
+         !info->enabled || !info->info || info->created.date.tm_year != 118 ) s->bad++;
+    s->count++;
+    if ( s->stop && s->count == s->stop ) return -1;
+    return 0;
+}
+
+static int device_log_cb(log_t *log, void *arg) {
+    seen_t *s = (seen_t *)arg;
+    char hid[16];
+    sprintf(hid, "hid%06d", s->count);
+    JsonNode *n = json_find_member(log->parameters, p_const("n"));
+    if ( strcmp(hid, P_VALUE(log->objectHid)) || !n || (int)n->number_ != s->count ) s->bad++;
+    s->count++;
+    return 0;
+}
+
+static int json_cb(JsonNode *item, void *arg) {
+    seen_t *s = (seen_t *)arg;
+    JsonNode *t = json_find_member(item, p_const("id"));
+    if ( !t || (int)t->number_ != s->count ) s->bad++;
+    s->count++;
+    return 0;
+}
+
+void setUp(void) {
+    arrow_init();
+    arrow_device_init(&dev);
+    property_copy(&dev.hid, p_const("devicehid"));
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    soc_close_Ignore();
+    wdt_feed_IgnoreAndReturn(0);
+}
+
+void tearDown(void) {
+    arrow_device_free(&dev);
+    arrow_deinit();
+}
+
+void test_page_stream_parse(void) {
+    const char *text = " {\"size\":3,\"page\":1,\"totalSize\":23,\"skip\":{\"data\":[1]},"
+                       "\"totalPages\":3,\"data\": [ {\"id\":0,\"s\":\"}]\\\"\"} ,"
+                       "{\"id\":1,\"a\":[{},[]]},{\"id\":2}],\"tail\":\"[{\"}";
+    page_stream_t s;
+    seen_t seen;
+    int step;
+    for ( step = 1; step < 16; step++ ) {
+        int pos = 0;
+        memset(&seen, 0x0, sizeof(seen));
+        page_stream_init(&s, json_cb, &seen);
+        while ( text[pos] ) {
+            int len = (int)strlen(text + pos) < step ? (int)strlen(text + pos) : step;
+            TEST_ASSERT_EQUAL_INT(len, page_stream_part(&s, text + pos, len));
+            pos += len;
+        }
+        TEST_ASSERT_EQUAL_INT(0, page_stream_finish(&s));
+        TEST_ASSERT_EQUAL_INT(3, seen.count);
+        TEST_ASSERT_EQUAL_INT(0, seen.bad);
+        TEST_ASSERT_EQUAL_INT(3, s.ps.size);
+        TEST_ASSERT_EQUAL_INT(1, s.ps.page);
+        TEST_ASSERT_EQUAL_INT(23, s.ps.totalSize);
+        TEST_ASSERT_EQUAL_INT(3, s.ps.totalPages);
+    }
+    // the scalars aren't the list elements
+    page_stream_init(&s, json_cb, &seen);
+    TEST_ASSERT_EQUAL_INT(-1, page_stream_part(&s, "{\"data\":[1]}", 12));
+    page_stream_finish(&s);
+    // the broken element
+    page_stream_init(&s, json_cb, &seen);
+    TEST_ASSERT_EQUAL_INT(-1, page_stream_part(&s, "{\"data\":[{\"id\" 1}]}", 19));
+    TEST_ASSERT_EQUAL_INT(-1, page_stream_finish(&s));
+    // the cut answer
+    page_stream_init(&s, json_cb, &seen);
+    TEST_ASSERT_EQUAL_INT(15, page_stream_part(&s, "{\"data\":[{\"id\":", 15));
+    TEST_ASSERT_EQUAL_INT(-1, page_stream_finish(&s));
+}
+
+void test_page_stream_find_by(void) {
+    seen_t seen;
+    memset(&seen, 0x0, sizeof(seen));
+    serve(list_devices, 25, 10);
+    TEST_ASSERT_EQUAL_INT(25, arrow_device_find_by_each(device_cb, &seen, 1, find_by(f_size, "10")));
+    TEST_ASSERT_EQUAL_INT(25, seen.count);
+    TEST_ASSERT_EQUAL_INT(0, seen.bad);
+    TEST_ASSERT_EQUAL_INT(3, requests);
+    TEST_ASSERT_EQUAL_INT(0, pages_asked[0]);
+    TEST_ASSERT_EQUAL_INT(2, pages_asked[2]);
+    TEST_ASSERT_NOT_NULL(strstr(request_line, "_size=10"));
+    // from the page of the caller
+    memset(&seen, 0x0, sizeof(seen));
+    seen.count = 10;
+    serve(list_devices, 25, 10);
+    TEST_ASSERT_EQUAL_INT(15, arrow_device_find_by_each(device_cb, &seen, 2,
+                                                        find_by(f_size, "10"), find_by(f_page, "1")));
+    TEST_ASSERT_EQUAL_INT(2, requests);
+    TEST_ASSERT_EQUAL_INT(1, pages_asked[0]);
+    TEST_ASSERT_EQUAL_INT(0, seen.bad);
+    // the callback stops in the second page
+    memset(&seen, 0x0, sizeof(seen));
+    seen.stop = 15;
+    serve(list_devices, 25, 10);
+    TEST_ASSERT_EQUAL_INT(15, arrow_device_find_by_each(device_cb, &seen, 1, find_by(f_size, "10")));
+    TEST_ASSERT_EQUAL_INT(2, requests);
+    // the error answer
+    memset(&seen, 0x0, sizeof(seen));
+    serve(list_devices, 5, 10);
+    list_code = 404;
+    TEST_ASSERT(arrow_device_find_by_each(device_cb, &seen, 0) < 0);
+    TEST_ASSERT_EQUAL_INT(0, seen.count);
+}
+
+void test_page_stream_lists(void) {
+    seen_t seen;
+    memset(&seen, 0x0, sizeof(seen));
+    serve(list_logs, 7, 5);
+    TEST_ASSERT_EQUAL_INT(7, arrow_list_device_logs_each(&dev, device_log_cb, &seen, 0));
+    TEST_ASSERT_EQUAL_INT(0, seen.bad);
+    TEST_ASSERT_EQUAL_INT(2, requests);
+    TEST_ASSERT_NOT_NULL(strstr(request_line, "devicehid/logs"));
+
+    memset(&seen, 0x0, sizeof(seen));
+    serve(list_devices, 4, 100);
+    TEST_ASSERT_EQUAL_INT(4, arrow_gateway_devices_each("gatehid", device_cb, &seen));
+    TEST_ASSERT_EQUAL_INT(0, seen.bad);
+    TEST_ASSERT_EQUAL_INT(1, requests);
+    TEST_ASSERT_NOT_NULL(strstr(request_line, "gatehid/devices"));
+}
@@ -1,6 +1,7 @@
 #include "unity.h"
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <config.h>
 #include <debug.h>
 #include <data/static_buf.h>
@@ -11,6 +12,7 @@
 #include <data/property_const.h>
 #include <data/property_dynamic.h>
 #include <data/property_stack.h>
+#include <data/property_intern.h>
 #include <json/property_json.h>
 #include <json/json.h>
 #include <sb.h>
@@ -61,7 +63,6 @@ void test_property_size( void ) {
     TEST_ASSERT( !test.name.value );
 }
 
-
 void test_property_copy_dynamic( void ) {
     test_p_t test;
     P_CLEAR(test.name);
@@ -94,3 +95,57 @@ void test_property_json_copy( void ) {
     property_free(&test.name);
     TEST_ASSERT( !test.name.value );
 }
+
+void test_property_type_table( void ) {
+    property_t p;
+    property_copy(&p, p_json("{}"));
+    TEST_ASSERT_EQUAL_INT(PROPERTY_JSON_TAG, PROPERTY_BASE_MASK & p.flags);
+    property_free(&p);
+    TEST_ASSERT( get_property_type(&p) == NULL );
+    // out of the table
+    p = property(NAME, 0x3f | is_owner, 5);
+    TEST_ASSERT( get_property_type(&p) == NULL );
+    property_copy(&p, property(NAME, 0x3f | is_owner, 5));
+    TEST_ASSERT( IS_EMPTY(p) );
+    // the type is gone
+    property_type_del(PROPERTY_JSON_TAG);
+    property_copy(&p, p_json("{}"));
+    TEST_ASSERT( IS_EMPTY(p) );
+    property_type_add(property_type_get_json());
+    property_copy(&p, p_json("{}"));
+    TEST_ASSERT_EQUAL_STRING("{}", P_VALUE(p));
+    property_free(&p);
+}
+
+void test_property_intern( void ) {
+    int pool = property_intern_count();
+    char name[] = NAME;
+    property_t a = property_intern(name, 5);
+    property_t b = property_intern(NAME "xx", 5);
+    property_t c, w;
+    TEST_ASSERT_EQUAL_INT(PROPERTY_INTERN_TAG, PROPERTY_BASE_MASK & a.flags);
+    TEST_ASSERT( P_VALUE(a) == P_VALUE(b) );
+    TEST_ASSERT( P_VALUE(a) != name );
+    TEST_ASSERT_EQUAL_STRING(NAME, P_VALUE(a));
+    TEST_ASSERT_EQUAL_INT(pool + 1, property_intern_count());
+    // the copy is a reference
+    property_copy(&c, a);
+    TEST_ASSERT( P_VALUE(c) == P_VALUE(a) );
+    property_weak_copy(&w, a);
+    property_free(&a);
+    property_free(&b);
+    TEST_ASSERT_EQUAL_INT(pool + 1, property_intern_count());
+    property_free(&w);
+    TEST_ASSERT_EQUAL_INT(pool + 1, property_intern_count());
+    property_move(&a, &c);
+    property_free(&c);
+    TEST_ASSERT_EQUAL_INT(pool + 1, property_intern_count());
+    property_free(&a);
+    TEST_ASSERT_EQUAL_INT(pool, property_intern_count());
+    // too long for the pool
+    char lng[PROPERTY_INTERN_MAX_LEN + 2];
+    memset(lng, 'a', sizeof(lng) - 1);
+    lng[sizeof(lng) - 1] = 0x0;
+    a = property_intern(lng, strlen(lng));
+    TEST_ASSERT( IS_EMPTY(a) );
+}
@@ -0,0 +1,252 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <http/client.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <sys/mem.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/reactor.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <json/json.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <bsd/socket.h>
+#include <bsd/sockpoll.h>
+#include <mqtt/client/client.h>
+#include <ssl/crypt.h>
+#include <time/time.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <data/find_by.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include "socket_weak.h"
+#include "mock_storage.h"
+
+#include "acnsdkc_ssl.h"
+#include "acnsdkc_time.h"
+
+// The event loop over the real sockets (the unix socket pairs).
+
+#define TEST_TOPIC       "test/ch"
+
+int socketpair(int domain, int type, int protocol, int sv[2]);
+#define UNIX_DOMAIN      1
+#define UNIX_STREAM      1
+
+void soc_close(int socket) {
+    close(socket);
+}
+
+typedef struct {
+    Network net;
+    MQTTClient client;
+    unsigned char buf[128];
+    unsigned char readbuf[128];
+    int peer;
+    int packets;
+    int failed;
+} channel_t;
+
+static void channel_init(channel_t *ch, int keepalive) {
+    int sv[2];
+    memset(ch, 0x0, sizeof(channel_t));
+    TEST_ASSERT_EQUAL_INT(0, socketpair(UNIX_DOMAIN, UNIX_STREAM, 0, sv));
+    NetworkInit(&ch->net);
+    ch->net.my_socket = sv[0];
+    ch->peer = sv[1];
+    MQTTClientInit(&ch->client, &ch->net, 1000,
+                   ch->buf, sizeof(ch->buf),
+                   ch->readbuf, sizeof(ch->readbuf));
+    ch->client.keepAliveInterval = keepalive;
+    ch->client.isconnected = 1;
+}
+
+static void channel_close(channel_t *ch) {
+    arrow_reactor_del_mqtt(&ch->client);
+    close(ch->net.my_socket);
+    close(ch->peer);
+}
+
+static void channel_event(MQTTClient *c, int rc, void *arg) {
+    channel_t *ch = (channel_t *)arg;
+    (void)c;
+    if ( rc < 0 ) ch->failed++;
+    else ch->packets++;
+}
+
+void setUp(void) {
+    property_types_init();
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_init());
+}
+
+void tearDown(void) {
+    arrow_reactor_done();
+    property_types_deinit();
+}
+
+static int ticks = 0;
+static int shots = 0;
+
+static int on_tick(void *arg) {
+    (void)arg;
+    ticks++;
+    return 0;
+}
+
+static int on_shot(void *arg) {
+    (void)arg;
+    shots++;
+    return -1;
+}
+
+void test_reactor_timers(void) {
+    ticks = 0;
+    shots = 0;
+    int t = arrow_reactor_timer_add(5, on_tick, NULL);
+    TEST_ASSERT(t >= 0);
+    TEST_ASSERT(arrow_reactor_timer_add(12, on_shot, NULL) >= 0);
+    uint32_t end = time_mono_ms() + 52;
+    int left;
+    while ( (left = (int)time_mono_diff(end, time_mono_ms())) > 0 ) arrow_reactor_run_once(left);
+    TEST_ASSERT_EQUAL_INT(1, shots);
+    // the period is counted from the callback, so it may lag on a busy host
+    TEST_ASSERT(ticks >= 5 && ticks <= 10);
+    arrow_reactor_timer_del(t);
+    int last = ticks;
+    arrow_reactor_run_once(10);
+    TEST_ASSERT_EQUAL_INT(last, ticks);
+}
+
+static int io_calls = 0;
+
+static int on_read(int sock, uint32_t events, void *arg) {
+    char c;
+    (void)arg;
+    if ( events & SOCK_POLL_IN ) {
+        if ( read(sock, &c, 1) == 1 ) io_calls++;
+    }
+    return 0;
+}
+
+void test_reactor_socket(void) {
+    int sv[2];
+    io_calls = 0;
+    TEST_ASSERT_EQUAL_INT(0, socketpair(UNIX_DOMAIN, UNIX_STREAM, 0, sv));
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_add(sv[0], SOCK_POLL_IN, on_read, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, arrow_reactor_add(sv[0], SOCK_POLL_IN, on_read, NULL));
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_run_once(10));
+    TEST_ASSERT_EQUAL_INT(1, write(sv[1], "x", 1));
+    TEST_ASSERT_EQUAL_INT(1, arrow_reactor_run_once(100));
+    TEST_ASSERT_EQUAL_INT(1, io_calls);
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_del(sv[0]));
+    TEST_ASSERT_EQUAL_INT(1, write(sv[1], "x", 1));
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_run_once(10));
+    TEST_ASSERT_EQUAL_INT(1, io_calls);
+    close(sv[0]);
+    close(sv[1]);
+}
+
+void test_reactor_mqtt_keepalive(void) {
+    channel_t ch;
+    unsigned char ping[2] = {0};
+    unsigned char pingresp[2] = { 0xd0, 0x00 };
+    channel_init(&ch, 1);
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_add_mqtt(&ch.client, channel_event, &ch));
+    // the first tick finds the keepalive interval expired
+    arrow_reactor_run_once(ARROW_REACTOR_KEEPALIVE_TICK + 100);
+    TEST_ASSERT_EQUAL_INT(2, read(ch.peer, ping, 2));
+    TEST_ASSERT_EQUAL_HEX8(0xc0, ping[0]);
+    TEST_ASSERT_EQUAL_INT(1, ch.client.ping_outstanding);
+    TEST_ASSERT_EQUAL_INT(2, write(ch.peer, pingresp, 2));
+    arrow_reactor_run_once(100);
+    TEST_ASSERT_EQUAL_INT(1, ch.packets);
+    TEST_ASSERT_EQUAL_INT(0, ch.client.ping_outstanding);
+    // the broker is gone
+    close(ch.peer);
+    arrow_reactor_run_once(100);
+    TEST_ASSERT_EQUAL_INT(1, ch.failed);
+    TEST_ASSERT_EQUAL_INT(-1, arrow_reactor_del_mqtt(&ch.client));
+    close(ch.net.my_socket);
+}
+
+void test_reactor_mqtt_partial_packet(void) {
+    channel_t ch;
+    unsigned char pingresp[2] = { 0xd0, 0x00 };
+    channel_init(&ch, 0);
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_add_mqtt(&ch.client, channel_event, &ch));
+    // the half of the packet doesn't block the loop
+    TEST_ASSERT_EQUAL_INT(1, write(ch.peer, pingresp, 1));
+    TEST_ASSERT_EQUAL_INT(1, arrow_reactor_run_once(100));
+    TEST_ASSERT_EQUAL_INT(0, ch.packets);
+    TEST_ASSERT_EQUAL_INT(0, ch.failed);
+    TEST_ASSERT_EQUAL_INT(1, write(ch.peer, pingresp + 1, 1));
+    TEST_ASSERT_EQUAL_INT(1, arrow_reactor_run_once(100));
+    TEST_ASSERT_EQUAL_INT(1, ch.packets);
+    channel_close(&ch);
+}
+
+void test_reactor_mqtt_write_queue(void) {
+    channel_t ch;
+    static unsigned char fill[4096];
+    unsigned char packet[64];
+    MQTTMessage msg;
+    int filled = 0;
+    int r;
+    channel_init(&ch, 0);
+    TEST_ASSERT_EQUAL_INT(0, arrow_reactor_add_mqtt(&ch.client, channel_event, &ch));
+    // the peer doesn't read, the socket isn't ready for the publish
+    while ( ( r = write(ch.net.my_socket, fill, sizeof(fill)) ) > 0 ) filled += r;
+    memset(&msg, 0x0, sizeof(msg));
+    msg.qos = QOS0;
+    msg.payload = "queued";
+    msg.payloadlen = 6;
+    TEST_ASSERT_EQUAL_INT(MQTT_SUCCESS, MQTTPublish(&ch.client, TEST_TOPIC, &msg));
+    // the loop sends it when the peer reads
+    while ( filled > 0 ) {
+        arrow_reactor_run_once(0);
+        r = read(ch.peer, fill, filled < (int)sizeof(fill) ? filled : (int)sizeof(fill));
+        TEST_ASSERT(r > 0);
+        filled -= r;
+    }
+    arrow_reactor_run_once(10);
+    r = read(ch.peer, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_INT(4 + (int)strlen(TEST_TOPIC) + 6, r);
+    TEST_ASSERT_EQUAL_HEX8(0x30, packet[0]);
+    TEST_ASSERT_EQUAL_MEMORY("queued", packet + r - 6, 6);
+    TEST_ASSERT_EQUAL_INT(0, ch.failed);
+    channel_close(&ch);
+}
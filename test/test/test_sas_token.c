@@ -0,0 +1,86 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <arrow/utf8.h>
+#include <arrow/sas_token.h>
+#include <ssl/crypt.h>
+#include "wolfssl/wolfcrypt/coding.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <time/time.h>
+#include <ntp/clock.h>
+#include <time/monotonic.h>
+
+#include "acnsdkc_time.h"
+
+#define TEST_RESOURCE "hub.azure-devices.net/devices/gw-test"
+// "the device primary key of the test"
+#define TEST_KEY      "dGhlIGRldmljZSBwcmltYXJ5IGtleSBvZiB0aGUgdGVzdA=="
+#define TEST_NOW      1500000000
+
+static sas_token_t tok;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+    sas_token_free(&tok);
+}
+
+void test_sas_token_vector(void) {
+    TEST_ASSERT_EQUAL_INT(0, sas_token_init(&tok, TEST_RESOURCE, TEST_KEY, 3600));
+    TEST_ASSERT_EQUAL_STRING("SharedAccessSignature sr=" TEST_RESOURCE
+                             "&sig=ojxPPH4txAoDqUWe8ZtV43XKuH00Idmsv%2btuNrCeaOk%3d"
+                             "&se=1500003600",
+                             sas_token_get(&tok, TEST_NOW));
+    TEST_ASSERT_EQUAL_INT((int)strlen(tok.token), tok.len);
+}
+
+void test_sas_token_bad_args(void) {
+    char resource[SAS_RESOURCE_LEN + 1];
+    TEST_ASSERT(sas_token_init(&tok, TEST_RESOURCE, "not base64!", 3600) < 0);
+    TEST_ASSERT_NULL(sas_token_get(&tok, TEST_NOW));
+    memset(resource, 'a', sizeof(resource) - 1);
+    resource[sizeof(resource) - 1] = 0x0;
+    TEST_ASSERT(sas_token_init(&tok, resource, TEST_KEY, 3600) < 0);
+}
+
+// the fake clock is the now passed
+void test_sas_token_refresh(void) {
+    time_t now = TEST_NOW;
+    char first[SAS_TOKEN_LEN];
+    TEST_ASSERT_EQUAL_INT(0, sas_token_init(&tok, TEST_RESOURCE, TEST_KEY, 3600));
+    TEST_ASSERT_EQUAL_INT(1, sas_token_refresh(&tok, now));
+    TEST_ASSERT_EQUAL_INT(TEST_NOW + 3600, tok.expiry);
+    strcpy(first, tok.token);
+
+    // the reconnections up to the margin before the expiry take the same token
+    for ( now = TEST_NOW; now < TEST_NOW + 3600 - SAS_TOKEN_MARGIN; now += 60 ) {
+        TEST_ASSERT_EQUAL_INT(0, sas_token_refresh(&tok, now));
+    }
+    TEST_ASSERT_EQUAL_INT(0, sas_token_refresh(&tok, TEST_NOW + 3600 - SAS_TOKEN_MARGIN - 1));
+    TEST_ASSERT_EQUAL_STRING(first, sas_token_get(&tok, TEST_NOW + 3600 - SAS_TOKEN_MARGIN - 1));
+
+    // the timer is late: the new token lives from the now
+    now = TEST_NOW + 3600 - SAS_TOKEN_MARGIN + 10;
+    TEST_ASSERT_EQUAL_INT(1, sas_token_refresh(&tok, now));
+    TEST_ASSERT_EQUAL_INT(now + 3600, tok.expiry);
+    TEST_ASSERT(strcmp(first, tok.token) != 0);
+    TEST_ASSERT_EQUAL_INT(0, sas_token_refresh(&tok, now + 1));
+
+    // the expired one is replaced by the get
+    now += 2 * 3600;
+    TEST_ASSERT_NOT_NULL(sas_token_get(&tok, now));
+    TEST_ASSERT_EQUAL_INT(now + 3600, tok.expiry);
+}
+
+void test_sas_token_short_ttl(void) {
+    TEST_ASSERT_EQUAL_INT(0, sas_token_init(&tok, TEST_RESOURCE, TEST_KEY, 100));
+    // the margin is the quarter of the short life time
+    TEST_ASSERT_EQUAL_INT(25, tok.margin);
+    TEST_ASSERT_EQUAL_INT(1, sas_token_refresh(&tok, TEST_NOW));
+    TEST_ASSERT_EQUAL_INT(0, sas_token_refresh(&tok, TEST_NOW + 74));
+    TEST_ASSERT_EQUAL_INT(1, sas_token_refresh(&tok, TEST_NOW + 75));
+}
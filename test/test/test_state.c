@@ -0,0 +1,328 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+// the short window for the test
+#define ARROW_STATE_COALESCE_MS 50
+#include <config.h>
+#include <debug.h>
+#include <sys/mem.h>
+#include <arrow/routine.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <http/client.h>
+#include <bsd/socket.h>
+#include <arrow/mqtt.h>
+#include <arrow/device.h>
+#include <arrow/gateway.h>
+#include <arrow/telemetry_api.h>
+#include "api_device_device.h"
+#include "api_gateway_gateway.h"
+#include "api_gateway_info.h"
+#include <arrow/api/device/info.h>
+#include <arrow/api/device/event.h>
+#include <arrow/api/log.h>
+#include <arrow/api/json/page.h>
+#include <data/linkedlist.h>
+#include <data/property_dynamic.h>
+#include <data/ringbuffer.h>
+#include <data/propmap.h>
+#include <data/find_by.h>
+#include <json/json.h>
+#include <json/cbor.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <arrow/utf8.h>
+#include <arrow/sign.h>
+#include <arrow/gateway_payload_sign.h>
+#include <arrow/events.h>
+#include <arrow/state.h>
+#include <arrow/device_command.h>
+#include <arrow/software_release.h>
+#include <arrow/software_update.h>
+#include <arrow/ota_verify.h>
+#include <arrow/reactor.h>
+#include <arrow/supervisor.h>
+#include <arrow/telemetry_filter.h>
+#include <arrow/api/json/parse.h>
+#include <http/client_mqtt.h>
+#include <http/request.h>
+#include <http/response.h>
+#include <http/inflate.h>
+#include <http/pool.h>
+#include <bsd/sockpoll.h>
+#include <ssl/crypt.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <arrow_mqtt_client.h>
+#include <mqtt/client/delivery.h>
+#include <network.h>
+#include "timer.h"
+#include <MQTTClient.h>
+#include <MQTTPacket.h>
+#include <MQTTConnect.h>
+#include <MQTTPublish.h>
+#include "MQTTConnectClient.h"
+#include "MQTTDeserializePublish.h"
+#include "MQTTSerializePublish.h"
+#include "MQTTSubscribeClient.h"
+#include "MQTTUnsubscribeClient.h"
+#include <wolfssl/wolfcrypt/sha256.h>
+#include <wolfssl/wolfcrypt/md5.h>
+#include <acn.h>
+#include "http_routine.h"
+#include "acnsdkc_ssl.h"
+#include "socket_weak.h"
+
+#include "acnsdkc_time.h"
+#include "mock_mac.h"
+#include "mock_watchdog.h"
+#include "mock_sockdecl.h"
+#include "mock_storage.h"
+#include "mock_telemetry.h"
+
+#include "fakedns.h"
+
+// The state table is built in here to check its lists and the body
+// against the JsonNode tree of the previous post; the linked module is
+// shadowed by this copy (the link flags of project.yml).
+#include "../../src/arrow/state.c"
+
+#define STATES      1000
+
+// the posted requests are caught by the fake socket, the answer is 200
+static const char answer[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+static int answered = 0;
+static int no_answer = 0;
+static char *sent = NULL;
+static int sent_len = 0;
+static int posts = 0;
+static long post_bytes = 0;
+
+static arrow_device_t dev;
+static char names[STATES][16];
+
+static int socket_cb(int protocol_family, int socket_type, int protocol, int num) {
+    (void)protocol_family; (void)socket_type; (void)protocol; (void)num;
+    return 0;
+}
+
+static struct hostent *gethostbyname_cb(const char *host, int num) {
+    (void)num;
+    return dns_fake(0xc0a80001, host);
+}
+
+static int connect_cb(int sockfd, const struct sockaddr *addr, socklen_t addrlen, int num) {
+    (void)sockfd; (void)addr; (void)addrlen; (void)num;
+    return 0;
+}
+
+static ssize_t send_cb(int sockfd, const void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    if ( len > 5 && strncmp(buf, "POST ", 5) == 0 ) {
+        posts++;
+        sent_len = 0;
+        answered = 0;
+    }
+    memcpy(sent + sent_len, buf, len);
+    sent_len += len;
+    sent[sent_len] = 0x0;
+    post_bytes += len;
+    return len;
+}
+
+static ssize_t recv_cb(int sockfd, void *buf, size_t len, int flags, int num) {
+    (void)sockfd; (void)flags; (void)num;
+    int size = (int)sizeof(answer) - 1 - answered;
+    if ( size <= 0 || no_answer ) return -1;
+    if ( size > (int)len ) size = len;
+    memcpy(buf, answer + answered, size);
+    answered += size;
+    return size;
+}
+
+static const char *sent_body(void) {
+    char *body = strstr(sent, "\r\n\r\n");
+    return body ? body + 4 : "";
+}
+
+static int starts(const char *s, const char *prefix) {
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static void add_states(int n) {
+    int i;
+    for ( i = 0; i < n; i++ ) {
+        sprintf(names[i], "state_%04d", i);
+        arrow_device_state_init(1, state_pr(p_stack(names[i]), i % 3 == 0 ? JSON_BOOL :
+                                                               i % 3 == 1 ? JSON_NUMBER : JSON_STRING));
+    }
+}
+
+static void set_state(int i, int v) {
+    char str[16];
+    switch ( i % 3 ) {
+    case 0: arrow_device_state_set_bool(p_stack(names[i]), v & 1); break;
+    case 1: arrow_device_state_set_number(p_stack(names[i]), v); break;
+    default:
+        sprintf(str, "v%d", v);
+        arrow_device_state_set_string(p_stack(names[i]), p_stack(str));
+    }
+}
+
+// the previous post body: the whole tree for every post
+static property_t old_payload(void) {
+    JsonNode *_main = json_mkobject();
+    JsonNode *_states = json_mkobject();
+    arrow_state_list_t *tmp = NULL;
+    arrow_linked_list_head_for_each( tmp, &__state_list , arrow_state_list_t ) {
+        JsonNode *value = NULL;
+        switch ( tmp->tag ) {
+        case JSON_BOOL: value = json_mkbool(tmp->value._bool); break;
+        case JSON_NUMBER: value = json_mknumber(tmp->value._number); break;
+        // the tree can't take the empty one
+        default: value = json_mkstring(IS_EMPTY(tmp->value._property) ? "" : P_VALUE(tmp->value._property));
+        }
+        // the tree took the dynamic names away, the weak ones are here
+        property_t name;
+        property_weak_copy(&name, tmp->name);
+        json_append_member(_states, name, value);
+    }
+    json_append_member(_main, p_const("states"), _states);
+    if ( !timestamp_is_empty(&_last_modify) ) {
+        char ts[30];
+        timestamp_string(&_last_modify, ts);
+        json_append_member(_main, p_const("timestamp"), json_mkstring(ts));
+    }
+    property_t p = json_encode_property(_main);
+    json_delete(_main);
+    return p;
+}
+
+void setUp(void) {
+    arrow_init();
+    sent = malloc(256 * 1024);
+    sent[0] = 0x0;
+    sent_len = 0;
+    posts = 0;
+    no_answer = 0;
+    arrow_device_init(&dev);
+    property_copy(&dev.hid, p_const("devicehid"));
+    socket_StubWithCallback(socket_cb);
+    gethostbyname_StubWithCallback(gethostbyname_cb);
+    connect_StubWithCallback(connect_cb);
+    send_StubWithCallback(send_cb);
+    recv_StubWithCallback(recv_cb);
+    setsockopt_IgnoreAndReturn(0);
+    soc_close_Ignore();
+    wdt_feed_IgnoreAndReturn(0);
+}
+
+void tearDown(void) {
+    arrow_device_state_free();
+    arrow_device_free(&dev);
+    free(sent);
+    arrow_deinit();
+}
+
+void test_state_payload(void) {
+    arrow_device_state_init(3, state_pr(p_const("led"), JSON_BOOL),
+                               state_pr(p_const("delay"), JSON_NUMBER),
+                               state_pr(p_const("msg"), JSON_STRING));
+    arrow_device_state_set_bool(p_const("led"), true);
+    arrow_device_state_set_number(p_const("delay"), 250);
+    arrow_device_state_set_string(p_const("msg"), p_stack("say \"hi\"\n"));
+    // the same as the tree
+    property_t old = old_payload();
+    property_t body = state_payload(0);
+    TEST_ASSERT_EQUAL_STRING(P_VALUE(old), P_VALUE(body));
+    TEST_ASSERT(starts(P_VALUE(body), "{\"states\":{\"led\":true,\"delay\":250,\"msg\":\"say \\\"hi\\\"\\n\"},\"timestamp\":"));
+    property_free(&old);
+    property_free(&body);
+    // through the client
+    TEST_ASSERT_EQUAL_INT(0, arrow_post_state_update(&dev));
+    TEST_ASSERT_EQUAL_INT(1, posts);
+    TEST_ASSERT_NOT_NULL(strstr(sent, "/devicehid/state/update"));
+    TEST_ASSERT_NOT_NULL(strstr(sent_body(), "\"delay\":250"));
+}
+
+void test_state_delta(void) {
+    add_states(30);
+    TEST_ASSERT_NULL(state_find(p_const("nope")));
+    TEST_ASSERT_NOT_NULL(state_find(p_const("state_0029")));
+    // nothing to post
+    TEST_ASSERT_EQUAL_INT(0, arrow_post_state_delta(&dev));
+    TEST_ASSERT_EQUAL_INT(0, posts);
+    set_state(4, 7);
+    set_state(5, 8);
+    TEST_ASSERT_EQUAL_INT(2, _dirty_count);
+    TEST_ASSERT_EQUAL_INT(0, arrow_post_state_delta(&dev));
+    TEST_ASSERT_EQUAL_INT(1, posts);
+    TEST_ASSERT(starts(sent_body(), "{\"states\":{\"state_0004\":7,\"state_0005\":\"v8\"},"));
+    TEST_ASSERT_EQUAL_INT(0, _dirty_count);
+    // the same values aren't changes
+    set_state(4, 7);
+    set_state(5, 8);
+    TEST_ASSERT_EQUAL_INT(0, _dirty_count);
+    TEST_ASSERT_EQUAL_INT(0, arrow_post_state_delta(&dev));
+    TEST_ASSERT_EQUAL_INT(1, posts);
+    // the full post cleans the changes too
+    set_state(9, 1);
+    TEST_ASSERT_EQUAL_INT(0, arrow_post_state_update(&dev));
+    TEST_ASSERT_EQUAL_INT(0, _dirty_count);
+}
+
+void test_state_version(void) {
+    add_states(3);
+    set_state(1, 1);
+    set_state(2, 2);
+    property_t body = state_payload(1);
+    property_free(&body);
+    // changed after the serialization: it waits for the next post
+    set_state(1, 5);
+    state_set_posted();
+    TEST_ASSERT_EQUAL_INT(1, _dirty_count);
+    TEST_ASSERT_EQUAL_INT(1, state_find(p_const("state_0001"))->dirty);
+    TEST_ASSERT_EQUAL_INT(0, state_find(p_const("state_0002"))->dirty);
+    // the failed post keeps them
+    no_answer = 1;
+    TEST_ASSERT(arrow_post_state_delta(&dev) < 0);
+    TEST_ASSERT_EQUAL_INT(1, _dirty_count);
+}
+
+void test_state_sync(void) {
+    int i;
+    add_states(30);
+    TEST_ASSERT_EQUAL_INT(0, arrow_device_state_sync(&dev));
+    for ( i = 0; i < 10; i++ ) {
+        // the numbers: every set is a change
+        set_state(3 * i + 1, 100 + i);
+        int left = arrow_device_state_sync(&dev);
+        TEST_ASSERT(left > 0 && left <= ARROW_STATE_COALESCE_MS);
+    }
+    TEST_ASSERT_EQUAL_INT(0, posts);
+    msleep(ARROW_STATE_COALESCE_MS + 5);
+    TEST_ASSERT_EQUAL_INT(0, arrow_device_state_sync(&dev));
+    // the ten changes in one post
+    TEST_ASSERT_EQUAL_INT(1, posts);
+    TEST_ASSERT_NOT_NULL(strstr(sent_body(), "\"state_0028\":109"));
+    TEST_ASSERT_EQUAL_INT(0, arrow_device_state_sync(&dev));
+    TEST_ASSERT_EQUAL_INT(1, posts);
+}
+
+void test_state_handler(void) {
+    add_states(30);
+    JsonNode *states = json_decode("{\"state_0001\":{\"value\":\"42\",\"timestamp\":\"2030-05-22T10:08:38.503Z\"},"
+                                   "\"other\":{\"value\":\"1\",\"timestamp\":\"2030-05-22T10:08:38.503Z\"},"
+                                   "\"state_0002\":{\"value\":\"text\",\"timestamp\":\"2030-05-22T10:08:38.503Z\"}}");
+    TEST_ASSERT_NOT_NULL(states);
+    TEST_ASSERT_EQUAL_INT(0, arrow_device_state_handler(states));
+    TEST_ASSERT(state_find(p_const("state_0001"))->value._number == 42.0);
+    TEST_ASSERT_EQUAL_STRING("text", P_VALUE(state_find(p_const("state_0002"))->value._property));
+}
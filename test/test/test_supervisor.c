@@ -0,0 +1,233 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <debug.h>
+#include <time/monotonic.h>
+#include <arrow/supervisor.h>
+
+// The supervisor is driven by the fake time passed to every call.
+
+#define FLEET          1000
+#define OUTAGE         60000
+
+static conn_supervisor_t sv;
+static uint32_t now = 0;
+
+void setUp(void) {
+    now = 5000;
+    conn_supervisor_init(&sv, MQTT_KEEPALIVE, now);
+}
+
+void tearDown(void) {
+}
+
+void test_supervisor_first_attempt(void) {
+    TEST_ASSERT_EQUAL_INT(conn_state_retry, sv.state);
+    TEST_ASSERT_EQUAL_INT(0, conn_supervisor_wait_ms(&sv, now));
+    conn_supervisor_connected(&sv, now + 100);
+    TEST_ASSERT_EQUAL_INT(conn_state_up, sv.state);
+    TEST_ASSERT_EQUAL_INT(1, conn_supervisor_metrics(&sv)->attempts);
+    // the first connection isn't the reconnection
+    TEST_ASSERT_EQUAL_INT(0, conn_supervisor_metrics(&sv)->reconnects);
+}
+
+void test_supervisor_backoff(void) {
+    int i;
+    uint32_t cap = ARROW_RETRY_DELAY;
+    for ( i = 1; i < ARROW_BREAKER_FAILURES; i++ ) {
+        int delay = conn_supervisor_failed(&sv, now);
+        TEST_ASSERT(delay >= 0 && (uint32_t)delay <= cap);
+        TEST_ASSERT_EQUAL_INT(delay, conn_supervisor_wait_ms(&sv, now));
+        TEST_ASSERT_EQUAL_INT(conn_state_retry, sv.state);
+        now += (uint32_t)delay;
+        TEST_ASSERT_EQUAL_INT(0, conn_supervisor_wait_ms(&sv, now));
+        cap = cap * 2 < ARROW_RETRY_MAX_DELAY ? cap * 2 : ARROW_RETRY_MAX_DELAY;
+    }
+    TEST_ASSERT_EQUAL_INT(ARROW_BREAKER_FAILURES - 1, sv.failures);
+}
+
+void test_supervisor_backoff_spread(void) {
+    // many delays of the same step cover the whole range
+    int i;
+    int low = 0, high = 0;
+    for ( i = 0; i < 200; i++ ) {
+        conn_supervisor_init(&sv, 0, now + (uint32_t)i);
+        int delay = conn_supervisor_failed(&sv, now);
+        if ( delay < ARROW_RETRY_DELAY / 4 ) low++;
+        if ( delay > ARROW_RETRY_DELAY * 3 / 4 ) high++;
+    }
+    TEST_ASSERT(low > 20);
+    TEST_ASSERT(high > 20);
+}
+
+void test_supervisor_breaker(void) {
+    int i, delay = 0;
+    for ( i = 0; i < ARROW_BREAKER_FAILURES; i++ ) delay = conn_supervisor_failed(&sv, now);
+    TEST_ASSERT_EQUAL_INT(conn_state_open, sv.state);
+    TEST_ASSERT_EQUAL_INT(1, conn_supervisor_metrics(&sv)->trips);
+    TEST_ASSERT(delay >= ARROW_BREAKER_OPEN / 2 && delay <= ARROW_BREAKER_OPEN);
+    TEST_ASSERT(conn_supervisor_wait_ms(&sv, now + ARROW_BREAKER_OPEN / 2 - 1) > 0);
+    // the probe failed
+    now += ARROW_BREAKER_OPEN;
+    TEST_ASSERT_EQUAL_INT(0, conn_supervisor_wait_ms(&sv, now));
+    delay = conn_supervisor_failed(&sv, now);
+    TEST_ASSERT_EQUAL_INT(conn_state_open, sv.state);
+    TEST_ASSERT_EQUAL_INT(2, conn_supervisor_metrics(&sv)->trips);
+    TEST_ASSERT(delay >= ARROW_BREAKER_OPEN / 2);
+    // the probe passed
+    now += ARROW_BREAKER_OPEN;
+    conn_supervisor_connected(&sv, now);
+    TEST_ASSERT_EQUAL_INT(conn_state_up, sv.state);
+    TEST_ASSERT_EQUAL_INT(0, sv.failures);
+    TEST_ASSERT_EQUAL_INT(0, conn_supervisor_wait_ms(&sv, now));
+}
+
+void test_supervisor_metrics(void) {
+    conn_supervisor_connected(&sv, now);
+    now += 60000;
+    conn_supervisor_lost(&sv, now);
+    TEST_ASSERT_EQUAL_INT(conn_state_retry, sv.state);
+    TEST_ASSERT(conn_supervisor_wait_ms(&sv, now) <= ARROW_RETRY_DELAY);
+    // the second loss report is the same outage
+    conn_supervisor_lost(&sv, now + 10);
+    now += 3000;
+    conn_supervisor_failed(&sv, now);
+    now += 4000;
+    conn_supervisor_failed(&sv, now);
+    now += 5000;
+    conn_supervisor_connected(&sv, now);
+    conn_metrics_t *m = conn_supervisor_metrics(&sv);
+    TEST_ASSERT_EQUAL_INT(1, m->reconnects);
+    TEST_ASSERT_EQUAL_INT(3, m->last_attempts);
+    TEST_ASSERT_EQUAL_INT(12000, m->last_latency);
+    TEST_ASSERT_EQUAL_INT(12000, m->max_latency);
+    TEST_ASSERT_EQUAL_INT(4, m->attempts);
+    now += 60000;
+    conn_supervisor_lost(&sv, now);
+    now += 500;
+    conn_supervisor_connected(&sv, now);
+    TEST_ASSERT_EQUAL_INT(2, m->reconnects);
+    TEST_ASSERT_EQUAL_INT(500, m->last_latency);
+    TEST_ASSERT_EQUAL_INT(12000, m->max_latency);
+}
+
+// the link of no traffic is lost the keepalive interval and a bit after
+// the last packet: the ping isn't answered
+static void idle_drop(uint32_t quiet) {
+    conn_supervisor_connected(&sv, now);
+    now += quiet;
+    conn_supervisor_traffic(&sv, now);
+    now += conn_supervisor_keepalive(&sv) * 1000 + 500;
+    conn_supervisor_lost(&sv, now);
+}
+
+void test_supervisor_keepalive(void) {
+    int i;
+    TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE, conn_supervisor_keepalive(&sv));
+    // the long sessions raise it up to the max
+    for ( i = 0; i < 10; i++ ) {
+        conn_supervisor_connected(&sv, now);
+        now += MQTT_KEEPALIVE_STABLE;
+        conn_supervisor_lost(&sv, now);
+    }
+    TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE_MAX, conn_supervisor_keepalive(&sv));
+    // the idle link is dropped in a few minutes
+    idle_drop(60000);
+    TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE_MAX / 2, conn_supervisor_keepalive(&sv));
+    // the drop right after the connection says nothing about the keepalive
+    conn_supervisor_connected(&sv, now);
+    now += 1000;
+    conn_supervisor_lost(&sv, now);
+    TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE_MAX / 2, conn_supervisor_keepalive(&sv));
+    // nor the link quiet longer than two intervals, the pings weren't sent
+    conn_supervisor_connected(&sv, now);
+    now += MQTT_KEEPALIVE_MAX * 2000 + 1000;
+    conn_supervisor_lost(&sv, now);
+    TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE_MAX / 2, conn_supervisor_keepalive(&sv));
+    for ( i = 0; i < 10; i++ ) idle_drop(600000);
+    TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE_MIN, conn_supervisor_keepalive(&sv));
+    // the REST supervisor doesn't adapt it
+    conn_supervisor_init(&sv, 0, now);
+    conn_supervisor_connected(&sv, now);
+    conn_supervisor_lost(&sv, now + MQTT_KEEPALIVE_STABLE);
+    TEST_ASSERT_EQUAL_INT(0, conn_supervisor_keepalive(&sv));
+}
+
+// the broker restarts in the middle of the sessions of ten minutes:
+// the link isn't the problem, the keepalive stays
+void test_supervisor_broker_restart(void) {
+    int i;
+    uint32_t t;
+    for ( i = 0; i < 5; i++ ) {
+        conn_supervisor_connected(&sv, now);
+        // the telemetry every 2 s, the ack is the traffic
+        for ( t = 0; t < 600000; t += 2000 ) conn_supervisor_traffic(&sv, now + t);
+        now += 600000 + 1500;
+        conn_supervisor_lost(&sv, now);
+        TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE, conn_supervisor_keepalive(&sv));
+        now += (uint32_t)conn_supervisor_failed(&sv, now);
+    }
+    // the quiet device lives by the pings, the restart comes between them
+    for ( i = 0; i < 5; i++ ) {
+        conn_supervisor_connected(&sv, now);
+        for ( t = 0; t <= 600000; t += MQTT_KEEPALIVE * 1000 ) conn_supervisor_traffic(&sv, now + t);
+        now += 600000 + MQTT_KEEPALIVE * 500;
+        conn_supervisor_lost(&sv, now);
+        TEST_ASSERT_EQUAL_INT(MQTT_KEEPALIVE, conn_supervisor_keepalive(&sv));
+    }
+    // the old packet doesn't move the traffic back
+    conn_supervisor_connected(&sv, now);
+    conn_supervisor_traffic(&sv, now + 5000);
+    conn_supervisor_traffic(&sv, now + 1000);
+    TEST_ASSERT_EQUAL_INT(now + 5000, sv.traffic_at);
+}
+
+// the broker is down for a minute, every device tries again:
+// count the attempts per second, the fixed delay brings them all at once
+void test_supervisor_fleet(void) {
+    static conn_supervisor_t fleet[FLEET];
+    static uint32_t fixed_peak[(OUTAGE + ARROW_RETRY_MAX_DELAY) / 1000];
+    static uint32_t jitter_peak[(OUTAGE + ARROW_RETRY_MAX_DELAY) / 1000];
+    int i;
+    uint32_t t;
+    uint32_t fixed_max = 0, jitter_max = 0, fixed_total = 0, jitter_total = 0;
+    memset(fixed_peak, 0x0, sizeof(fixed_peak));
+    memset(jitter_peak, 0x0, sizeof(jitter_peak));
+    for ( i = 0; i < FLEET; i++ ) {
+        conn_supervisor_init(&fleet[i], MQTT_KEEPALIVE, (uint32_t)i * 7);
+        conn_supervisor_connected(&fleet[i], 0);
+        conn_supervisor_lost(&fleet[i], 100000);
+    }
+    for ( t = 100000; t < 100000 + OUTAGE + ARROW_RETRY_MAX_DELAY; t += 10 ) {
+        int broker_up = t >= 100000 + OUTAGE;
+        for ( i = 0; i < FLEET; i++ ) {
+            conn_supervisor_t *s = &fleet[i];
+            if ( s->state == conn_state_up || conn_supervisor_wait_ms(s, t) ) continue;
+            jitter_peak[(t - 100000) / 1000]++;
+            jitter_total++;
+            if ( broker_up ) conn_supervisor_connected(s, t);
+            else conn_supervisor_failed(s, t);
+        }
+    }
+    // the fixed ARROW_RETRY_DELAY from the same moment
+    for ( t = 0; t < OUTAGE + ARROW_RETRY_DELAY; t += ARROW_RETRY_DELAY ) {
+        fixed_peak[t / 1000] += FLEET;
+        fixed_total += FLEET;
+    }
+    // the broker is back: the fixed delay brings the whole fleet in one second
+    for ( i = OUTAGE / 1000; i < (int)(sizeof(fixed_peak) / sizeof(fixed_peak[0])); i++ ) {
+        if ( fixed_peak[i] > fixed_max ) fixed_max = fixed_peak[i];
+        if ( jitter_peak[i] > jitter_max ) jitter_max = jitter_peak[i];
+    }
+    uint32_t max_latency = 0;
+    for ( i = 0; i < FLEET; i++ ) {
+        TEST_ASSERT_EQUAL_INT(conn_state_up, fleet[i].state);
+        if ( fleet[i].metrics.last_latency > max_latency ) max_latency = fleet[i].metrics.last_latency;
+    }
+    printf("fleet of %d, %d s outage: fixed delay %u attempts (%u/s on recovery), "
+           "jittered backoff %u attempts (%u/s on recovery), max reconnect latency %u ms\n",
+           FLEET, OUTAGE / 1000, fixed_total, fixed_max, jitter_total, jitter_max, max_latency);
+    TEST_ASSERT(jitter_total < fixed_total / 2);
+    TEST_ASSERT(jitter_max < fixed_max / 10);
+}
@@ -0,0 +1,221 @@
+#include "unity.h"
+#include <config.h>
+#include <debug.h>
+#include <data/static_buf.h>
+#include <data/static_alloc.h>
+#include <data/linkedlist.h>
+#include <data/property.h>
+#include <data/property_base.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/property_json.h>
+#include <json/json.h>
+#include <arrow/device.h>
+#include <arrow/telemetry_filter.h>
+#include <sb.h>
+#include <encode.h>
+#include <decode.h>
+#include <time/monotonic.h>
+
+static telemetry_filter_rule_t rules[] = {
+    TELEMETRY_FILTER_RULE(TELEMETRY_TEMPERATURE, 0.5, 0.0),
+    TELEMETRY_FILTER_RULE(TELEMETRY_HUMIDITY, 0.0, 0.1),
+    TELEMETRY_FILTER_RULE("b|alarm", 0.0, 0.0),
+    TELEMETRY_FILTER_RULE("s|state", 0.0, 0.0)
+};
+static telemetry_filter_t filter;
+
+void setUp(void) {
+    property_types_init();
+    property_type_add(property_type_get_json());
+}
+
+void tearDown(void) {
+    property_types_deinit();
+}
+
+static JsonNode *sample(double t, double h, int alarm, const char *state) {
+    JsonNode *_node = json_mkobject();
+    json_append_member(_node, p_const(TELEMETRY_DEVICE_HID), json_mkstring("hid"));
+    json_append_member(_node, p_const(TELEMETRY_TEMPERATURE), json_mknumber(t));
+    json_append_member(_node, p_const(TELEMETRY_HUMIDITY), json_mknumber(h));
+    json_append_member(_node, p_const("b|alarm"), json_mkbool(alarm));
+    json_append_member(_node, p_const("s|state"), json_mkstring(state));
+    return _node;
+}
+
+static int apply(double t, double h, int alarm, const char *state, uint32_t now) {
+    JsonNode *_node = sample(t, h, alarm, state);
+    int ret = telemetry_filter_apply(&filter, _node, now);
+    json_delete(_node);
+    return ret;
+}
+
+void test_telemetry_filter_first_sample(void) {
+    telemetry_filter_init(&filter, rules, 4, 0, 0);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 50.0, 0, "idle", 100));
+}
+
+void test_telemetry_filter_abs_deadband(void) {
+    telemetry_filter_init(&filter, rules, 4, 0, 0);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.4, 50.0, 0, "idle", 1));
+    TEST_ASSERT_EQUAL_INT(1, apply(19.5, 50.0, 0, "idle", 2));
+    // the reference is the last sent value, slow drift is caught
+    TEST_ASSERT_EQUAL_INT(0, apply(20.6, 50.0, 0, "idle", 3));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.2, 50.0, 0, "idle", 4));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 5));
+}
+
+void test_telemetry_filter_rel_deadband(void) {
+    telemetry_filter_init(&filter, rules, 4, 0, 0);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 54.9, 0, "idle", 1));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 45.1, 0, "idle", 2));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 55.1, 0, "idle", 3));
+    // 10% of 55.1
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 60.5, 0, "idle", 4));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 60.7, 0, "idle", 5));
+}
+
+void test_telemetry_filter_exact_fields(void) {
+    telemetry_filter_init(&filter, rules, 4, 0, 0);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 1, "idle", 1));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 50.0, 1, "idle", 2));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 1, "run", 3));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 50.0, 1, "run", 4));
+}
+
+void test_telemetry_filter_heartbeat(void) {
+    telemetry_filter_init(&filter, rules, 4, 1000, 0);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 5000));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 50.0, 0, "idle", 5999));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 6000));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.1, 50.0, 0, "idle", 6500));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.1, 50.0, 0, "idle", 7000));
+    // msec counter overflow
+    telemetry_filter_reset(&filter);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0xffffff00UL));
+    TEST_ASSERT_EQUAL_INT(1, apply(20.0, 50.0, 0, "idle", 0x100));
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0x300));
+}
+
+void test_telemetry_filter_changed_only(void) {
+    telemetry_filter_init(&filter, rules, 4, 1000, 1);
+    JsonNode *_node = sample(20.0, 50.0, 0, "idle");
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_apply(&filter, _node, 0));
+    char *str = json_encode(_node);
+    TEST_ASSERT_EQUAL_STRING("{\"_|deviceHid\":\"hid\",\"f|temperature\":20,\"f|humidity\":50,"
+                             "\"b|alarm\":false,\"s|state\":\"idle\"}", str);
+    free(str);
+    json_delete(_node);
+
+    _node = sample(21.0, 51.0, 0, "idle");
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_apply(&filter, _node, 10));
+    str = json_encode(_node);
+    TEST_ASSERT_EQUAL_STRING("{\"_|deviceHid\":\"hid\",\"f|temperature\":21}", str);
+    free(str);
+    json_delete(_node);
+
+    // heartbeat sends the whole sample
+    _node = sample(21.0, 51.0, 0, "idle");
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_apply(&filter, _node, 1010));
+    str = json_encode(_node);
+    TEST_ASSERT_EQUAL_STRING("{\"_|deviceHid\":\"hid\",\"f|temperature\":21,\"f|humidity\":51,"
+                             "\"b|alarm\":false,\"s|state\":\"idle\"}", str);
+    free(str);
+    json_delete(_node);
+}
+
+void test_telemetry_filter_device_table(void) {
+    static telemetry_filter_t other;
+    arrow_device_t dev1;
+    arrow_device_t dev2;
+    arrow_device_init(&dev1);
+    arrow_device_init(&dev2);
+    property_copy(&dev1.hid, p_const("dev1"));
+    property_copy(&dev2.hid, p_const("dev2"));
+    telemetry_filter_init(&filter, rules, 4, 0, 0);
+    telemetry_filter_init(&other, rules, 2, 0, 0);
+    TEST_ASSERT(!telemetry_filter_find(&dev1));
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_register(&dev1, &filter));
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_filter_register(&dev1, &other));
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_register(&dev2, &other));
+    TEST_ASSERT_EQUAL_PTR(&filter, telemetry_filter_find(&dev1));
+    TEST_ASSERT_EQUAL_PTR(&other, telemetry_filter_find(&dev2));
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_unregister(&dev1));
+    TEST_ASSERT(!telemetry_filter_find(&dev1));
+    TEST_ASSERT_EQUAL_PTR(&other, telemetry_filter_find(&dev2));
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_unregister(&dev2));
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_filter_unregister(&dev2));
+    arrow_device_free(&dev1);
+    arrow_device_free(&dev2);
+}
+
+static int check(double t, double h, int alarm, const char *state, uint32_t now) {
+    JsonNode *_node = sample(t, h, alarm, state);
+    int ret = telemetry_filter_check(&filter, _node, now);
+    json_delete(_node);
+    return ret;
+}
+
+void test_telemetry_filter_commit(void) {
+    telemetry_filter_init(&filter, rules, 4, 1000, 0);
+    TEST_ASSERT_EQUAL_INT(0, apply(20.0, 50.0, 0, "idle", 0));
+    // the send failed, the reference is the same and the heartbeat isn't moved
+    TEST_ASSERT_EQUAL_INT(0, check(21.0, 50.0, 0, "idle", 10));
+    TEST_ASSERT_EQUAL_INT(1, check(20.4, 50.0, 0, "idle", 20));
+    TEST_ASSERT_EQUAL_INT(0, check(20.6, 50.0, 0, "idle", 30));
+    telemetry_filter_commit(&filter);
+    TEST_ASSERT_EQUAL_INT(1, check(21.0, 50.0, 0, "idle", 40));
+    TEST_ASSERT_EQUAL_INT(0, check(21.2, 50.0, 0, "idle", 1030));
+    // only the checked sample is committed
+    telemetry_filter_commit(&filter);
+    telemetry_filter_commit(&filter);
+    TEST_ASSERT_EQUAL_INT(1, check(21.2, 50.0, 0, "idle", 1040));
+    TEST_ASSERT_EQUAL_INT(0, check(20.6, 50.0, 0, "idle", 1050));
+}
+
+typedef struct {
+    double t;
+    double h;
+    int alarm;
+} raw_sample_t;
+
+static int raw_value(void *data, const char *key, double *val) {
+    raw_sample_t *r = (raw_sample_t *)data;
+    if ( strcmp(key, TELEMETRY_TEMPERATURE) == 0 ) *val = r->t;
+    else if ( strcmp(key, TELEMETRY_HUMIDITY) == 0 ) *val = r->h;
+    else if ( strcmp(key, "b|alarm") == 0 ) {
+        *val = r->alarm;
+        return telemetry_value_exact;
+    } else return -1;
+    return telemetry_value_number;
+}
+
+void test_telemetry_filter_raw(void) {
+    raw_sample_t r = { 20.0, 50.0, 0 };
+    telemetry_filter_init(&filter, rules, 4, 0, 1);
+    // no reader, nothing is dropped before the serialization
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_check_data(&filter, &r, 0));
+    filter.value = raw_value;
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_check_data(&filter, &r, 0));
+    telemetry_filter_commit(&filter);
+    r.t = 20.4;
+    TEST_ASSERT_EQUAL_INT(1, telemetry_filter_check_data(&filter, &r, 1));
+    r.alarm = 1;
+    TEST_ASSERT_EQUAL_INT(0, telemetry_filter_check_data(&filter, &r, 2));
+    // the same key set as the JSON check: the unchanged keys are stripped
+    JsonNode *_node = sample(20.4, 50.0, 1, "idle");
+    telemetry_filter_strip(&filter, _node);
+    char *str = json_encode(_node);
+    TEST_ASSERT_EQUAL_STRING("{\"_|deviceHid\":\"hid\",\"b|alarm\":true,\"s|state\":\"idle\"}", str);
+    free(str);
+    json_delete(_node);
+    telemetry_filter_commit(&filter);
+    TEST_ASSERT_EQUAL_INT(1, telemetry_filter_check_data(&filter, &r, 3));
+}
@@ -0,0 +1,131 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <config.h>
+#include <debug.h>
+#include <time/monotonic.h>
+#include <time/timer_wheel.h>
+#include <ntp/clock.h>
+#include <network.h>
+#include "timer.h"
+#include "acnsdkc_ssl.h"
+#include "mock_sockdecl.h"
+#include "socket_weak.h"
+
+// The MQTT timers and the timer wheel over the fake clock.
+
+static uint32_t fake_now = 0;
+
+uint32_t time_mono_ms(void) {
+    return fake_now;
+}
+
+typedef struct {
+    timer_node_t node;
+    int id;
+} test_timer_t;
+
+static timer_wheel_t wheel;
+
+void setUp(void) {
+    fake_now = 1000;
+    timer_wheel_init(&wheel, fake_now);
+}
+
+void tearDown(void) {
+}
+
+void test_timer_interval(void) {
+    TimerInterval t;
+    TimerInit(&t);
+    TEST_ASSERT(TimerIsExpired(&t));
+    TEST_ASSERT_EQUAL_INT(0, TimerLeftMS(&t));
+    TimerCountdownMS(&t, 250);
+    TEST_ASSERT(!TimerIsExpired(&t));
+    TEST_ASSERT_EQUAL_INT(250, TimerLeftMS(&t));
+    fake_now += 249;
+    TEST_ASSERT(!TimerIsExpired(&t));
+    TEST_ASSERT_EQUAL_INT(1, TimerLeftMS(&t));
+    fake_now += 1;
+    TEST_ASSERT(TimerIsExpired(&t));
+    TimerCountdown(&t, 2);
+    TEST_ASSERT_EQUAL_INT(2000, TimerLeftMS(&t));
+}
+
+void test_timer_interval_wrap(void) {
+    TimerInterval t;
+    fake_now = 0xffffff00;
+    TimerCountdownMS(&t, 1000);
+    TEST_ASSERT(!TimerIsExpired(&t));
+    fake_now += 999;
+    TEST_ASSERT_EQUAL_INT(1, TimerLeftMS(&t));
+    fake_now += 1;
+    TEST_ASSERT(TimerIsExpired(&t));
+    TEST_ASSERT_EQUAL_INT(0, TimerLeftMS(&t));
+}
+
+void test_timer_wheel_order(void) {
+    test_timer_t t[4];
+    // the last one is due after the full round of the wheel
+    uint32_t due[4] = { 30, 5, 2000, 5 };
+    int i;
+    for ( i = 0; i < 4; i++ ) {
+        t[i].id = i;
+        timer_wheel_add(&wheel, &t[i].node, fake_now + due[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(4, wheel.count);
+    TEST_ASSERT_EQUAL_INT(5, timer_wheel_next_ms(&wheel, fake_now, 10000));
+    TEST_ASSERT_NULL(timer_wheel_expired(&wheel, fake_now + 4));
+    fake_now += 5;
+    test_timer_t *a = (test_timer_t *)timer_wheel_expired(&wheel, fake_now);
+    test_timer_t *b = (test_timer_t *)timer_wheel_expired(&wheel, fake_now);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL_INT(4, a->id + b->id);
+    TEST_ASSERT(!timer_wheel_pending(&a->node));
+    TEST_ASSERT_NULL(timer_wheel_expired(&wheel, fake_now));
+    TEST_ASSERT_EQUAL_INT(25, timer_wheel_next_ms(&wheel, fake_now, 10000));
+    TEST_ASSERT_EQUAL_INT(10, timer_wheel_next_ms(&wheel, fake_now, 10));
+    fake_now += 1000;
+    TEST_ASSERT_EQUAL_PTR(&t[0], timer_wheel_expired(&wheel, fake_now));
+    TEST_ASSERT_NULL(timer_wheel_expired(&wheel, fake_now));
+    // 995 ms left to the last one, the wheel round is 1024 ms
+    TEST_ASSERT_EQUAL_INT(995, timer_wheel_next_ms(&wheel, fake_now, 10000));
+    fake_now += 995;
+    TEST_ASSERT_EQUAL_PTR(&t[2], timer_wheel_expired(&wheel, fake_now));
+    TEST_ASSERT_EQUAL_INT(0, wheel.count);
+    TEST_ASSERT_EQUAL_INT(100, timer_wheel_next_ms(&wheel, fake_now, 100));
+}
+
+void test_timer_wheel_del(void) {
+    test_timer_t t[3];
+    int i;
+    for ( i = 0; i < 3; i++ ) {
+        t[i].id = i;
+        timer_wheel_add(&wheel, &t[i].node, fake_now + 10);
+    }
+    timer_wheel_del(&wheel, &t[1].node);
+    timer_wheel_del(&wheel, &t[1].node);
+    TEST_ASSERT_EQUAL_INT(2, wheel.count);
+    fake_now += 10;
+    test_timer_t *a = (test_timer_t *)timer_wheel_expired(&wheel, fake_now);
+    test_timer_t *b = (test_timer_t *)timer_wheel_expired(&wheel, fake_now);
+    TEST_ASSERT_EQUAL_INT(2, a->id + b->id);
+    TEST_ASSERT_NULL(timer_wheel_expired(&wheel, fake_now));
+    // the past due time is taken on the next step
+    timer_wheel_add(&wheel, &t[1].node, fake_now - 50);
+    TEST_ASSERT_EQUAL_INT(0, timer_wheel_next_ms(&wheel, fake_now, 100));
+    TEST_ASSERT_EQUAL_PTR(&t[1], timer_wheel_expired(&wheel, fake_now));
+}
+
+void test_timer_wheel_sleep(void) {
+    test_timer_t t[2];
+    timer_wheel_add(&wheel, &t[0].node, fake_now + 100);
+    timer_wheel_add(&wheel, &t[1].node, fake_now + 7000);
+    // the clock went over several rounds at once
+    fake_now += 60000;
+    TEST_ASSERT_NOT_NULL(timer_wheel_expired(&wheel, fake_now));
+    TEST_ASSERT_NOT_NULL(timer_wheel_expired(&wheel, fake_now));
+    TEST_ASSERT_NULL(timer_wheel_expired(&wheel, fake_now));
+    TEST_ASSERT_EQUAL_INT(0, wheel.count);
+}
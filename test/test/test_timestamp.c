@@ -0,0 +1,202 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <debug.h>
+#include <sb.h>
+#include <data/property.h>
+#include <data/property_const.h>
+#include <data/property_dynamic.h>
+#include <data/property_stack.h>
+#include <data/property_intern.h>
+#include <json/json.h>
+#include <arrow/utf8.h>
+#include <arrow/api/json/parse.h>
+#include <time/time.h>
+
+#include "acnsdkc_time.h"
+
+#define FUZZ_ROUNDS  200000
+
+static const char mutate_chars[] = "0123456789-T:.Z+ x";
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// the parser and the formatter as they were
+
+static int timestamp_parse_old(timestamp_t *t, const char *s) {
+    int tmp;
+    char *p = copy_till_to_int(s, "-", &tmp);
+    if ( !p ) return -1;
+    t->year = tmp;
+    p = copy_till_to_int(p, "-", &tmp);
+    if ( !p ) return -1;
+    t->mon = tmp;
+    p = copy_till_to_int(p, "T", &tmp);
+    if ( !p ) return -1;
+    t->day = tmp;
+    p = copy_till_to_int(p, ":", &tmp);
+    if ( !p ) return -1;
+    t->hour = tmp;
+    p = copy_till_to_int(p, ":", &tmp);
+    if ( !p ) return -1;
+    t->min = tmp;
+    p = copy_till_to_int(p, ".", &tmp);
+    if ( !p ) return -1;
+    t->sec = tmp;
+    p = copy_till_to_int(p, "Z", &tmp);
+    if ( !p ) return -1;
+    t->msec = tmp;
+    return 0;
+}
+
+static void timestamp_string_old(timestamp_t *ts, char *s) {
+    snprintf(s, 25,
+             "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+             ts->year,
+             ts->mon,
+             ts->day,
+             ts->hour,
+             ts->min,
+             ts->sec,
+             ts->msec);
+}
+
+static void random_ts(timestamp_t *t) {
+    memset(t, 0x0, sizeof(timestamp_t));
+    t->year = 1970 + rand() % 130;
+    t->mon = 1 + rand() % 12;
+    t->day = 1 + rand() % 28;
+    t->hour = rand() % 24;
+    t->min = rand() % 60;
+    t->sec = rand() % 60;
+    t->msec = rand() % 1000;
+}
+
+#define ASSERT_TS(y, mo, d, h, mi, s, ms, t) do { \
+    TEST_ASSERT_EQUAL_INT(y, (t).year); \
+    TEST_ASSERT_EQUAL_INT(mo, (t).mon); \
+    TEST_ASSERT_EQUAL_INT(d, (t).day); \
+    TEST_ASSERT_EQUAL_INT(h, (t).hour); \
+    TEST_ASSERT_EQUAL_INT(mi, (t).min); \
+    TEST_ASSERT_EQUAL_INT(s, (t).sec); \
+    TEST_ASSERT_EQUAL_INT(ms, (t).msec); \
+  } while (0)
+
+#define ASSERT_TS_EQUAL(a, b) \
+    ASSERT_TS((a).year, (a).mon, (a).day, (a).hour, (a).min, (a).sec, (a).msec, b)
+
+void test_timestamp_string_same(void) {
+    char s_old[32];
+    char s_new[32];
+    timestamp_t t;
+    int i;
+    srand(3);
+    for ( i = 0; i < FUZZ_ROUNDS; i++ ) {
+        uint32_t *raw = (uint32_t *)&t;
+        // all the bit fields, the year up to 23 bits and the msec up to 1023
+        raw[0] = ( (uint32_t)rand() << 16 ) ^ (uint32_t)rand();
+        raw[1] = ( (uint32_t)rand() << 16 ) ^ (uint32_t)rand();
+        if ( i % 2 ) t.year = rand() % 10000;
+        memset(s_old, 'x', sizeof(s_old));
+        memset(s_new, 'x', sizeof(s_new));
+        timestamp_string_old(&t, s_old);
+        timestamp_string(&t, s_new);
+        TEST_ASSERT_EQUAL_MEMORY(s_old, s_new, sizeof(s_old));
+    }
+}
+
+void test_timestamp_parse_same(void) {
+    char s[32];
+    timestamp_t t, t_old, t_new;
+    int i;
+    srand(5);
+    for ( i = 0; i < FUZZ_ROUNDS; i++ ) {
+        random_ts(&t);
+        timestamp_string(&t, s);
+        memset(&t_old, 0x0, sizeof(timestamp_t));
+        memset(&t_new, 0x0, sizeof(timestamp_t));
+        TEST_ASSERT_EQUAL_INT(0, timestamp_parse_old(&t_old, s));
+        TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t_new, s));
+        ASSERT_TS_EQUAL(t, t_new);
+        TEST_ASSERT_EQUAL_MEMORY(&t_old, &t_new, sizeof(timestamp_t));
+    }
+}
+
+// the broken strings: the new parser takes the layout only if the old one
+// takes it the same way (the old one takes some more, as the month 19),
+// the other taken ones are the zone offsets or the short fractions
+void test_timestamp_parse_fuzz(void) {
+    char s[32];
+    timestamp_t t, t_old, t_new;
+    int i, j;
+    int taken = 0;
+    int extended = 0;
+    srand(11);
+    for ( i = 0; i < FUZZ_ROUNDS; i++ ) {
+        int n = 1 + rand() % 3;
+        random_ts(&t);
+        timestamp_string(&t, s);
+        for ( j = 0; j < n; j++ ) {
+            s[rand() % 24] = mutate_chars[rand() % ( sizeof(mutate_chars) - 1 )];
+        }
+        if ( rand() % 8 == 0 ) s[rand() % 25] = 0x0;
+        memset(&t_old, 0x0, sizeof(timestamp_t));
+        memset(&t_new, 0x0, sizeof(timestamp_t));
+        if ( timestamp_parse(&t_new, s) == 0 ) {
+            if ( strlen(s) == 24 && s[19] == '.' && s[23] == 'Z' ) {
+                TEST_ASSERT_EQUAL_INT_MESSAGE(0, timestamp_parse_old(&t_old, s), s);
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&t_old, &t_new, sizeof(timestamp_t), s);
+                taken++;
+            } else {
+                TEST_ASSERT_MESSAGE(strpbrk(s + 19, "+-Z") != NULL, s);
+                extended++;
+            }
+        }
+    }
+    TEST_ASSERT(taken > 0);
+    TEST_ASSERT(extended > 0);
+}
+
+void test_timestamp_parse_iso(void) {
+    timestamp_t t;
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-05-21T13:40:32Z"));
+    ASSERT_TS(2018, 5, 21, 13, 40, 32, 0, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-05-21T13:40:32.1Z"));
+    ASSERT_TS(2018, 5, 21, 13, 40, 32, 100, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-05-21T13:40:32.17Z"));
+    ASSERT_TS(2018, 5, 21, 13, 40, 32, 170, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-05-21T13:40:32.123456789Z"));
+    ASSERT_TS(2018, 5, 21, 13, 40, 32, 123, t);
+    // the zone offsets are taken to the UTC
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-05-21T13:40:32.173+02:00"));
+    ASSERT_TS(2018, 5, 21, 11, 40, 32, 173, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-05-21T13:40:32-0530"));
+    ASSERT_TS(2018, 5, 21, 19, 10, 32, 0, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2019-01-01T01:00:00.5+03"));
+    ASSERT_TS(2018, 12, 31, 22, 0, 0, 500, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2020-03-01T00:30:00+01:00"));
+    ASSERT_TS(2020, 2, 29, 23, 30, 0, 0, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2019-02-28T23:30:00-01:00"));
+    ASSERT_TS(2019, 3, 1, 0, 30, 0, 0, t);
+    TEST_ASSERT_EQUAL_INT(0, timestamp_parse(&t, "2018-12-31T23:59:60,999Z"));
+    ASSERT_TS(2018, 12, 31, 23, 59, 60, 999, t);
+
+    // the failed parse doesn't touch the timestamp
+    TEST_ASSERT(timestamp_parse(&t, "2018-13-21T13:40:32.173Z") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T24:40:32.173Z") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T13:40:32.Z") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T13:40:32.173") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T13:40:32.173Zx") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21 13:40:32.173Z") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T13:40:32+2") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T13:40:32+19:00") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "2018-05-21T13:40") < 0);
+    TEST_ASSERT(timestamp_parse(&t, "") < 0);
+    ASSERT_TS(2018, 12, 31, 23, 59, 60, 999, t);
+}
@@ -0,0 +1,149 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <config.h>
+#include <sys/mem.h>
+#include <arrow/utf8.h>
+
+// The table encoders against the previous sprintf/strtol/branching ones,
+// these are built with -Os as the library is.
+// Build the library with -mssse3 to check the SSSE3 hex_encode.
+
+__attribute__((optimize("Os")))
+static void old_hex_encode(char *dst, const char *src, int size) {
+    int i;
+    for (i=0; i<size; i++)
+        sprintf(dst+i*2, "%02x", (unsigned char)(src[i]));
+}
+
+__attribute__((optimize("Os")))
+static void old_hex_decode(char *dst, const char *src, int size) {
+    int i = 0;
+    for (i=0; i<size; i++) {
+        char d[3] = { *(src+i*2), *(src+i*2 + 1), '\0' };
+        dst[i] = (uint8_t)strtol(d, NULL, 16);
+    }
+}
+
+// the old one indexed the digits by the signed char: ASCII only
+__attribute__((optimize("Os")))
+static void old_urlencode(char *dst, char *src, int len) {
+    char *hex = "0123456789abcdef";
+    char *src_p = src;
+    char *dst_p = dst;
+    if (!len) len = (int)strlen(src);
+    while( src_p && len-- ){
+        if( ('a' <= *src_p && *src_p <= 'z')
+            || ('A' <= *src_p && *src_p <= 'Z')
+            || ('0' <= *src_p && *src_p <= '9')
+            || ( *src_p == '-' )
+            || ( *src_p == '_' )
+            ){
+            *dst_p++ = *src_p++;
+        } else {
+            *dst_p++ = ('%');
+            *dst_p++ = (hex[*src_p >> 4]);
+            *dst_p++ = (hex[*src_p & 15]);
+            src_p++;
+        }
+    }
+    *dst_p = '\0';
+}
+
+void setUp(void) {
+    srand(1);
+}
+
+void tearDown(void) {
+}
+
+void test_hex_encode(void) {
+    static char src[256 + 16];
+    char a[600], b[600];
+    int i, len, off;
+    for ( i = 0; i < (int)sizeof(src); i++ ) src[i] = (char)(i * 167 + 13);
+    // every byte value
+    for ( i = 0; i < 256; i++ ) src[i] = (char)i;
+    memset(a, 'x', sizeof(a));
+    memset(b, 'x', sizeof(b));
+    old_hex_encode(a, src, 256);
+    hex_encode(b, src, 256);
+    TEST_ASSERT_EQUAL_MEMORY(a, b, 513);
+    // every length around the 16 bytes blocks and every alignment
+    for ( off = 0; off < 16; off++ ) {
+        for ( len = 0; len <= 70; len++ ) {
+            memset(a, 'x', sizeof(a));
+            memset(b, 'x', sizeof(b));
+            old_hex_encode(a, src + off, len);
+            if ( !len ) a[0] = '\0';
+            hex_encode(b, src + off, len);
+            TEST_ASSERT_EQUAL_MEMORY(a, b, len * 2 + 2);
+        }
+    }
+}
+
+void test_hex_decode(void) {
+    char src[3] = { 0, 0, 0 };
+    char a[4], b[4];
+    int hi, lo;
+    // every pair of characters, the non hex ones as strtol takes them
+    for ( hi = 0; hi < 256; hi++ ) {
+        for ( lo = 0; lo < 256; lo++ ) {
+            src[0] = (char)hi;
+            src[1] = (char)lo;
+            a[0] = b[0] = 0x55;
+            old_hex_decode(a, src, 1);
+            hex_decode(b, src, 1);
+            if ( a[0] != b[0] ) {
+                char msg[32];
+                sprintf(msg, "pair %02x %02x", hi, lo);
+                TEST_FAIL_MESSAGE(msg);
+            }
+        }
+    }
+    const char *hex = "00ff7F80a5DEADbeef";
+    char c[16], d[16];
+    old_hex_decode(c, hex, 9);
+    hex_decode(d, hex, 9);
+    TEST_ASSERT_EQUAL_MEMORY(c, d, 9);
+}
+
+void test_urlencode(void) {
+    char src[256];
+    char a[800], b[800];
+    int i, n;
+    // every ASCII character
+    for ( i = 1; i < 128; i++ ) {
+        src[0] = (char)i;
+        src[1] = '\0';
+        old_urlencode(a, src, 0);
+        urlencode(b, src, 0);
+        TEST_ASSERT_EQUAL_STRING(a, b);
+    }
+    // the bytes above 0x7f are escaped now too
+    src[0] = (char)0xc3;
+    src[1] = (char)0xa9;
+    urlencode(b, src, 2);
+    TEST_ASSERT_EQUAL_STRING("%c3%a9", b);
+    // the random strings, whole and by the length
+    for ( n = 0; n < 2000; n++ ) {
+        int len = rand() % 200;
+        for ( i = 0; i < len; i++ ) {
+            // mostly the plain runs as in the tokens
+            src[i] = rand() % 4 ? "abcXYZ019-_"[rand() % 11] : (char)(1 + rand() % 127);
+        }
+        src[len] = '\0';
+        old_urlencode(a, src, 0);
+        urlencode(b, src, 0);
+        TEST_ASSERT_EQUAL_STRING(a, b);
+        if ( len ) {
+            int part = 1 + rand() % len;
+            old_urlencode(a, src, part);
+            urlencode(b, src, part);
+            TEST_ASSERT_EQUAL_STRING(a, b);
+        }
+    }
+    urlencode(b, NULL, 5);
+    TEST_ASSERT_EQUAL_STRING("", b);
+}